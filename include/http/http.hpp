@@ -148,6 +148,12 @@ namespace CIM::http
     // 将HttpStatus枚举值转换为描述字符串
     const char *HttpStatusToString(const HttpStatus &s);
 
+    /**
+     * @brief 返回当前时间的Date响应头，形如"Date: Sat, 17 Oct 2026 08:00:00 GMT\r\n"
+     * @details 每个线程缓存一份，秒数变化时才重新格式化
+     */
+    const std::string &GetHttpDateHeader();
+
     /**
      * @brief 忽略大小写比较仿函数
      */
@@ -215,6 +221,85 @@ namespace CIM::http
         return def;
     }
 
+    /**
+     * @brief 忽略大小写的头部名哈希(FNV-1a)，编译期计算，用于常用头部的预先哈希
+     * @details 按位或0x20把大写字母转成小写，其他字符可能因此冲突，查找时仍需比较名字
+     */
+    constexpr uint32_t HttpHeaderHashConst(const char *s, uint32_t h = 2166136261u)
+    {
+        return *s ? HttpHeaderHashConst(s + 1, (h ^ (uint8_t)(*s | 0x20)) * 16777619u) : h;
+    }
+
+    /**
+     * @brief 运行时计算忽略大小写的头部名哈希，与HttpHeaderHashConst结果一致
+     */
+    uint32_t HttpHeaderHash(const char *s, size_t len);
+
+    /**
+     * @brief 常用请求头名的预先哈希
+     */
+    namespace HttpHeaderHashes
+    {
+        constexpr uint32_t CONTENT_LENGTH = HttpHeaderHashConst("content-length");
+        constexpr uint32_t CONNECTION = HttpHeaderHashConst("connection");
+        constexpr uint32_t AUTHORIZATION = HttpHeaderHashConst("authorization");
+        constexpr uint32_t UPGRADE = HttpHeaderHashConst("upgrade");
+        constexpr uint32_t TRANSFER_ENCODING = HttpHeaderHashConst("transfer-encoding");
+        constexpr uint32_t EXPECT = HttpHeaderHashConst("expect");
+    }
+
+    /**
+     * @brief 请求头的扁平存储
+     * @details 名字和值依次拷贝到同一块内存，按(偏移, 长度)记录，整个请求头只需要两次内存分配。
+     * 解析器每次执行后都会把未处理的数据移到读缓冲开头，头部也可能跨越多次读取，
+     * 因此不能直接引用连接的读缓冲，而是引用这块按请求分配的内存。
+     * 查找时先比较名字哈希再忽略大小写比较名字，请求头通常只有一二十个，线性查找即可
+     */
+    class HttpHeaderList
+    {
+    public:
+        /**
+         * @brief 一个头部在存储中的位置
+         */
+        struct Entry
+        {
+            uint32_t hash;      /// 名字的HttpHeaderHash
+            uint32_t name;      /// 名字的偏移
+            uint32_t name_len;  /// 名字的长度
+            uint32_t value;     /// 值的偏移
+            uint32_t value_len; /// 值的长度
+        };
+
+        /**
+         * @brief 追加一个头部，同名头部不合并，查找时返回最后一个
+         */
+        void add(const char *name, size_t name_len, const char *value, size_t value_len);
+
+        /**
+         * @brief 查找头部
+         * @param[in] key 名字
+         * @param[in] len 名字长度
+         * @param[in] hash HttpHeaderHash(key, len)
+         * @return 不存在时返回nullptr
+         */
+        const Entry *find(const char *key, size_t len, uint32_t hash) const;
+
+        /**
+         * @brief 返回偏移对应的地址
+         */
+        const char *at(uint32_t offset) const { return m_data.data() + offset; }
+
+        const std::vector<Entry> &getEntries() const { return m_entries; }
+        bool empty() const { return m_entries.empty(); }
+        void clear();
+
+    private:
+        /// 名字和值
+        std::string m_data;
+        /// 头部位置
+        std::vector<Entry> m_entries;
+    };
+
     class HttpResponse;
     /**
      * @brief HTTP请求结构
@@ -263,6 +348,7 @@ namespace CIM::http
 
         /**
          * @brief 返回HTTP请求的消息头MAP
+         * @details 头部以扁平方式存储时先转换成MAP，之后的头部操作都走MAP
          */
         const MapType &getHeaders() const;
 
@@ -421,6 +507,22 @@ namespace CIM::http
          */
         bool hasHeader(const std::string &key, std::string *val = nullptr);
 
+        /**
+         * @brief 以扁平方式追加一个解析得到的头部，不构造std::string
+         * @details 之前已经通过setHeader等接口使用MAP存储时直接写入MAP
+         */
+        void appendHeader(const char *field, size_t flen, const char *value, size_t vlen);
+
+        /**
+         * @brief 查找头部，不构造std::string
+         * @param[in] key 名字
+         * @param[in] key_len 名字长度
+         * @param[in] hash HttpHeaderHash(key, key_len)，常用头部使用HttpHeaderHashes中的常量
+         * @param[out] len 值的长度
+         * @return 值的起始地址，请求对象修改头部前有效；不存在时返回nullptr
+         */
+        const char *findHeader(const char *key, size_t key_len, uint32_t hash, size_t &len) const;
+
         /**
          * @brief 判断HTTP请求的请求参数是否存在
          * @param[in] key 关键字
@@ -448,7 +550,23 @@ namespace CIM::http
         template <class T>
         bool checkGetHeaderAs(const std::string &key, T &val, const T &def = T())
         {
-            return checkGetAs(m_headers, key, val, def);
+            size_t len = 0;
+            const char *v = findHeader(key.c_str(), key.size(), HttpHeaderHash(key.c_str(), key.size()), len);
+            if (!v)
+            {
+                val = def;
+                return false;
+            }
+            try
+            {
+                val = boost::lexical_cast<T>(v, len);
+                return true;
+            }
+            catch (...)
+            {
+                val = def;
+            }
+            return false;
         }
 
         /**
@@ -461,7 +579,9 @@ namespace CIM::http
         template <class T>
         T getHeaderAs(const std::string &key, const T &def = T())
         {
-            return getAs(m_headers, key, def);
+            T val;
+            checkGetHeaderAs(key, val, def);
+            return val;
         }
 
         /**
@@ -531,6 +651,13 @@ namespace CIM::http
          */
         std::ostream &dump(std::ostream &os) const;
 
+        /**
+         * @brief 只序列化请求行和头部(含结尾空行)，不含请求体
+         * @param[in, out] os 输出流
+         * @return 输出流
+         */
+        std::ostream &dumpHead(std::ostream &os) const;
+
         /**
          * @brief 转成字符串类型
          * @return 字符串
@@ -549,15 +676,22 @@ namespace CIM::http
         void initCookies();
 
     private:
-        HttpMethod m_method;    /// HTTP方法
-        std::string m_path;     /// 请求路径
-        std::string m_query;    /// 查询参数
-        uint8_t m_version;      /// HTTP版本
-        MapType m_headers;      /// 请求头
-        MapType m_cookies;      /// Cookie
-        std::string m_body;     /// 请求体
-        MapType m_params;       /// 请求参数
-        std::string m_fragment; /// Fragment
+        /**
+         * @brief 把扁平存储的头部转换到MAP
+         */
+        void materializeHeaders() const;
+
+    private:
+        HttpMethod m_method;                 /// HTTP方法
+        std::string m_path;                  /// 请求路径
+        std::string m_query;                 /// 查询参数
+        uint8_t m_version;                   /// HTTP版本
+        mutable MapType m_headers;           /// 请求头
+        mutable HttpHeaderList m_headerList; /// 扁平存储的请求头，非空时m_headers为空
+        MapType m_cookies;                   /// Cookie
+        std::string m_body;                  /// 请求体
+        MapType m_params;                    /// 请求参数
+        std::string m_fragment;              /// Fragment
 
         bool m_close;              /// 是否自动关闭
         bool m_websocket;          /// 是否为websocket
@@ -716,6 +850,23 @@ namespace CIM::http
          */
         std::ostream &dump(std::ostream &os) const;
 
+        /**
+         * @brief 只序列化状态行和头部(含结尾空行)，不含响应体
+         * @details 发送时头部与m_body作为两个片段交给writev，响应体不再拷贝
+         * @param[in, out] os 输出流
+         * @return 输出流
+         */
+        std::ostream &dumpHead(std::ostream &os) const;
+
+        /**
+         * @brief 把状态行和头部(含结尾空行)直接追加到out，不经过std::ostream
+         * @details 输出内容与dumpHead相同，extra插在结尾空行之前，用于追加预先格式化好的公共头部
+         * @param[in, out] out 输出缓冲，通常由连接复用
+         * @param[in] extra 预先格式化好的头部(每行以\r\n结尾)，可以为空
+         * @param[in] extra_len extra的长度
+         */
+        void serializeHead(std::string &out, const char *extra = nullptr, size_t extra_len = 0) const;
+
         /**
          * @brief 转成字符串
          */
@@ -25,6 +25,12 @@ namespace CIM::http
          */
         size_t execute(char *data, size_t len);
 
+        /**
+         * @brief 重置解析状态，准备解析下一个请求
+         * @details 错误码清零，getData返回新的HttpRequest，上一个请求对象仍归调用者所有
+         */
+        void reset();
+
         /**
          * @brief 是否解析完成
          * @return 是否解析完成
@@ -53,6 +59,16 @@ namespace CIM::http
          */
         uint64_t getContentLength();
 
+        /**
+         * @brief 消息体是否为分块传输编码(Transfer-Encoding的最后一个编码为chunked)
+         */
+        bool isChunked();
+
+        /**
+         * @brief 客户端是否在等待100 Continue后才发送消息体
+         */
+        bool isExpectContinue();
+
         /**
          * @brief 获取http_parser结构体
          */
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <map>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include "http.hpp"
 #include "http_session.hpp"
+#include "servlet_router.hpp"
 #include "thread.hpp"
 #include "util.hpp"
 #include "lock.hpp"
@@ -49,9 +52,23 @@ namespace CIM::http
          */
         const std::string &getName() const;
 
+        /**
+         * @brief 是否按流读取请求体
+         * @details 返回true时HttpServer在handle之前不读取请求体，servlet通过
+         * HttpSession::getBodyStream边读边处理(如上传文件直接写盘)，handle返回后未读完的部分被丢弃
+         */
+        virtual bool isStreamBody(HttpRequest::ptr request) { return m_streamBody; }
+
+        /**
+         * @brief 设置是否按流读取请求体
+         */
+        void setStreamBody(bool v) { m_streamBody = v; }
+
     protected:
         /// 名称
         std::string m_name;
+        /// 是否按流读取请求体
+        bool m_streamBody;
     };
 
     /**
@@ -134,6 +151,10 @@ namespace CIM::http
 
     /**
      * @brief Servlet分发器
+     * @details 路由表修改后作废当前的ServletRouter快照，下一次查找时重新编译。
+     * 查找只读取原子指针指向的快照，不加锁。查找期间线程登记进入时的全局纪元，
+     * 被替换的快照记下摘除时的纪元，修改路由时释放早于所有登记中纪元的快照，
+     * 其余的留到之后的修改或析构时释放。
      */
     class ServletDispatch : public Servlet
     {
@@ -148,10 +169,20 @@ namespace CIM::http
          */
         ServletDispatch();
 
+        /**
+         * @brief 析构函数
+         */
+        ~ServletDispatch();
+
         virtual int32_t handle(HttpRequest::ptr request,
                                HttpResponse::ptr response,
                                HttpSession::ptr session) override;
 
+        /**
+         * @brief 由请求匹配到的servlet决定是否按流读取请求体
+         */
+        virtual bool isStreamBody(HttpRequest::ptr request) override;
+
         /**
          * @brief 添加servlet
          * @param[in] uri uri
@@ -180,7 +211,24 @@ namespace CIM::http
          */
         void addGlobServlet(const std::string &uri, FunctionServlet::callback cb);
 
+        /**
+         * @brief 添加只处理指定方法的servlet
+         * @param[in] method HTTP方法
+         * @param[in] uri uri，以':'开头的段为路径参数，如 /api/v1/group/:id
+         * @param[in] slt servlet
+         */
+        void addServlet(HttpMethod method, const std::string &uri, Servlet::ptr slt);
+
+        /**
+         * @brief 添加只处理指定方法的servlet
+         * @param[in] method HTTP方法
+         * @param[in] uri uri
+         * @param[in] cb FunctionServlet回调函数
+         */
+        void addServlet(HttpMethod method, const std::string &uri, FunctionServlet::callback cb);
+
         void addServletCreator(const std::string &uri, IServletCreator::ptr creator);
+        void addServletCreator(HttpMethod method, const std::string &uri, IServletCreator::ptr creator);
         void addGlobServletCreator(const std::string &uri, IServletCreator::ptr creator);
 
         template <class T>
@@ -201,6 +249,13 @@ namespace CIM::http
          */
         void delServlet(const std::string &uri);
 
+        /**
+         * @brief 删除只处理指定方法的servlet
+         * @param[in] method HTTP方法
+         * @param[in] uri uri
+         */
+        void delServlet(HttpMethod method, const std::string &uri);
+
         /**
          * @brief 删除模糊匹配servlet
          * @param[in] uri uri
@@ -239,18 +294,49 @@ namespace CIM::http
          */
         Servlet::ptr getMatchedServlet(const std::string &uri);
 
+        /**
+         * @brief 按方法和uri获取servlet
+         * @param[in] method HTTP方法，INVALID_METHOD时只匹配不区分方法的servlet
+         * @param[in] uri uri
+         * @param[in] request 不为空时把路径参数写入请求参数
+         * @return 优先级见ServletRouter，都没匹配到时返回默认
+         */
+        Servlet::ptr getMatchedServlet(HttpMethod method, const std::string &uri,
+                                       HttpRequest::ptr request = nullptr);
+
+        /**
+         * @brief 列出精准匹配servlet，区分方法的以"METHOD uri"为键
+         */
         void listAllServletCreator(std::map<std::string, IServletCreator::ptr> &infos);
         void listAllGlobServletCreator(std::map<std::string, IServletCreator::ptr> &infos);
 
+    private:
+        /**
+         * @brief 作废当前路由快照并释放已没有读者的旧快照，调用方需持有写锁
+         */
+        void invalidateRouter();
+
+        /**
+         * @brief 返回当前路由快照，不存在时编译
+         */
+        const ServletRouter *getRouter();
+
     private:
         /// 精准匹配servlet MAP
         /// uri(/CIM/xxx) -> servlet
         std::unordered_map<std::string, IServletCreator::ptr> m_datas;
+        /// 区分方法的servlet MAP
+        /// (GET, /CIM/xxx) -> servlet
+        std::map<std::pair<HttpMethod, std::string>, IServletCreator::ptr> m_methodDatas;
         /// 模糊匹配servlet 数组
         /// uri(/CIM/*) -> servlet
         std::vector<std::pair<std::string, IServletCreator::ptr>> m_globs;
         Servlet::ptr m_default; /// 默认servlet，所有路径都没匹配到时使用
         RWMutexType m_mutex;    /// 读写互斥量
+        /// 当前路由快照，为空表示需要重新编译
+        std::atomic<ServletRouter *> m_router;
+        /// 被替换但可能仍有读者的路由快照及其摘除时的纪元
+        std::vector<std::pair<ServletRouter *, uint64_t>> m_garbage;
     };
 
     /**
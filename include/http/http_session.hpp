@@ -5,8 +5,16 @@
 
 namespace CIM::http
 {
+    class HttpRequestParser;
+
     /**
      * @brief HTTPSession封装
+     * @details 每个会话持有一个读缓冲和一个请求解析器，请求之间只重置不重新分配。
+     * 解析完一个请求后读缓冲中剩余的数据（流水线中的下一个请求、升级为WebSocket后紧跟的帧）
+     * 保留到下一次读取，read先返回这些数据再读socket
+     *
+     * 请求体可以整体读入HttpRequest(recvRequest/recvBody)，也可以由servlet通过getBodyStream
+     * 边读边处理，两种方式都支持Content-Length和分块传输编码，并受http.request.max_body_size限制
      */
     class HttpSession : public SocketStream
     {
@@ -25,17 +33,184 @@ namespace CIM::http
          * @brief 接收HTTP请求
          * @return 返回HttpRequest对象的智能指针
          * @details 该函数负责从Socket中接收HTTP请求数据，并将其解析为HttpRequest对象
-         *          包括解析HTTP请求行、请求头和请求体
+         *          包括解析HTTP请求行、请求头和请求体。读缓冲中已有完整请求时不读socket
          */
         HttpRequest::ptr recvRequest();
 
+        /**
+         * @brief 只接收请求行和请求头
+         * @return 返回HttpRequest对象的智能指针，请求体留在连接上，
+         *         之后用recvBody整体读取或用readBody/getBodyStream按流读取
+         */
+        HttpRequest::ptr recvRequestHead();
+
+        /**
+         * @brief 读取当前请求的全部请求体并设置到request
+         * @param[in] request recvRequestHead返回的请求
+         * @return 是否成功，失败时连接不能继续使用
+         */
+        bool recvBody(HttpRequest::ptr request);
+
+        /**
+         * @brief 读取当前请求的请求体
+         * @param[out] buffer 接收数据的内存
+         * @param[in] length 内存大小
+         * @return >0 读取的字节数
+         *         =0 请求体已读完
+         *         <0 连接异常、分块格式错误或超过http.request.max_body_size
+         * @details 分块传输编码时返回解码后的数据
+         */
+        int readBody(void *buffer, size_t length);
+
+        /**
+         * @brief 返回当前请求的请求体流
+         * @details 流只在处理当前请求期间有效，read等价于readBody，不支持写
+         */
+        Stream::ptr getBodyStream();
+
+        /**
+         * @brief 当前请求的请求体是否已读完
+         */
+        bool isBodyFinished() const { return m_bodyState == BODY_DONE; }
+
+        /**
+         * @brief 当前请求的请求体是否因超过http.request.max_body_size而无法读取
+         * @details 此时应回复413并关闭连接
+         */
+        bool isBodyTooLarge() const { return m_bodyState == BODY_TOO_LARGE; }
+
+        /**
+         * @brief 丢弃当前请求未读的请求体，使连接可以接收下一个请求
+         * @return >0 成功
+         *         <=0 无法继续使用连接（读取失败，或客户端还在等待100 Continue）
+         */
+        int discardBody();
+
         /**
          * @brief 发送HTTP响应
          * @param[in] rsp HTTP响应
          * @return >0 发送成功
          *         =0 对方关闭
          *         <0 Socket异常
+         * @details 队列中有排队的响应时一起发出，保证响应顺序与请求顺序一致
          */
         int sendResponse(HttpResponse::ptr rsp);
+
+        /**
+         * @brief 把响应排入发送队列
+         * @param[in] rsp HTTP响应
+         * @return >0 已排队或发送成功
+         *         =0 对方关闭
+         *         <0 Socket异常
+         * @details 读缓冲中还有流水线请求时先不发送，等到需要从socket读取、
+         * 队列达到http.pipeline.max_queued或调用flushResponses时用一次writev发出
+         */
+        int queueResponse(HttpResponse::ptr rsp);
+
+        /**
+         * @brief 发出所有排队的响应
+         * @return >0 发送成功（队列为空时返回1）
+         *         =0 对方关闭
+         *         <0 Socket异常
+         */
+        int flushResponses();
+
+        /**
+         * @brief 设置Server响应头的值，预先格式化，响应自己设置了Server时不输出
+         */
+        void setServerName(const std::string &v);
+
+        /**
+         * @brief 读缓冲中是否还有上次请求之后的数据
+         */
+        bool hasBufferedData() const { return m_offset > 0; }
+
+        /**
+         * @brief 读取数据，先返回读缓冲中剩余的数据
+         */
+        virtual int read(void *buffer, size_t length) override;
+
+        /**
+         * @brief 读取数据到ByteArray，先返回读缓冲中剩余的数据
+         */
+        virtual int read(ByteArray::ptr ba, size_t length) override;
+
+    private:
+        /**
+         * @brief 从socket读取，读之前先发出排队的响应，避免对端等待响应时双方互相等待
+         */
+        int readSocket(void *buffer, size_t length);
+
+        /**
+         * @brief 从读缓冲头部取出length字节，剩余数据前移
+         */
+        void consumeBuffer(size_t length);
+
+        /**
+         * @brief 读缓冲中凑齐一行(以\n结尾)
+         * @return 行的长度(含\n)，<=0表示连接异常或行太长
+         */
+        int fillLine();
+
+        /**
+         * @brief 解析分块的长度行、块尾的CRLF或结尾的trailer，直到可以读数据或请求体结束
+         * @return 是否成功
+         */
+        bool readChunkHead();
+
+        /**
+         * @brief 首次需要从socket读取请求体时回复100 Continue
+         */
+        int sendContinue();
+
+    private:
+        /// 请求体读取状态
+        enum BodyState
+        {
+            BODY_DONE,        /// 没有请求体或已读完
+            BODY_DATA,        /// 读取Content-Length或当前分块的数据
+            BODY_CHUNK_SIZE,  /// 等待分块长度行
+            BODY_CHUNK_CRLF,  /// 等待分块数据后的CRLF
+            BODY_TRAILER,     /// 等待最后一个分块之后的trailer
+            BODY_ERROR,       /// 出错，连接不能继续使用
+            BODY_TOO_LARGE    /// 超过http.request.max_body_size，连接不能继续使用
+        };
+
+        /// 请求解析器，每个请求前重置
+        std::shared_ptr<HttpRequestParser> m_parser;
+        /// 读缓冲，大小为http.request.buffer_size
+        std::vector<char> m_buffer;
+        /// 读缓冲中未处理数据的长度
+        size_t m_offset;
+        /// 排队待发送的响应：头部在m_head中的位置和响应本身(持有响应体)
+        struct PendingResponse
+        {
+            size_t offset;
+            size_t length;
+            HttpResponse::ptr rsp;
+        };
+
+        /// 排队待发送的响应
+        std::vector<PendingResponse> m_pending;
+        /// 排队响应的状态行和头部，连续存放，发送后清空复用
+        std::string m_head;
+        /// 发送时组装的片段，复用避免每次分配
+        std::vector<BufferSlice> m_slices;
+        /// 公共头部(Date、Server)的拼接缓冲
+        std::string m_extra;
+        /// 预先格式化的Server头
+        std::string m_serverHeader;
+        /// 请求体读取状态
+        BodyState m_bodyState;
+        /// 是否分块传输编码
+        bool m_bodyChunked;
+        /// 客户端在等待100 Continue
+        bool m_expectContinue;
+        /// Content-Length或当前分块剩余未读的字节数
+        uint64_t m_bodyLeft;
+        /// 已接收(分块时为已声明)的请求体大小
+        uint64_t m_bodySize;
+        /// 请求体流，按需创建，请求之间复用
+        Stream::ptr m_bodyStream;
     };
 }
\ No newline at end of file
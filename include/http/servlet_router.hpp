@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "http.hpp"
+
+namespace CIM::http
+{
+    class IServletCreator;
+
+    /**
+     * @brief 压缩前缀树(radix tree)路由表
+     * @details 由ServletDispatch在路由变化后编译生成，生成后只读，可以被多个线程同时查找。
+     * 支持的路由形式：
+     * 1. 精确路径：/api/v1/user/login
+     * 2. 路径参数：/api/v1/group/:id，参数匹配到下一个'/'为止，参数值写入params
+     * 3. 前缀通配：/wss/\*，\*只出现在结尾时匹配任意后缀(包括'/')，与fnmatch的行为一致
+     * 4. 其他通配符(?、[]、中间的*)无法放入树中，按添加顺序用fnmatch逐个匹配
+     *
+     * 匹配优先级：静态路径 > 路径参数 > 前缀通配(越长越优先) > fnmatch通配
+     *
+     * 不含参数的路径另外记录在哈希表中，精确命中时不需要逐层遍历树，
+     * 不区分方法的处理器直接存在表项中，不需要再访问树节点
+     */
+    class ServletRouter
+    {
+    public:
+        /// 路由处理器
+        typedef std::shared_ptr<IServletCreator> Handler;
+        /// 路径参数(名字, 值)
+        typedef std::vector<std::pair<std::string, std::string>> Params;
+
+        ServletRouter();
+        ~ServletRouter();
+
+        /**
+         * @brief 添加精确路由，路径中以':'开头的段为路径参数
+         * @param[in] path 路径
+         * @param[in] handler 处理器
+         * @param[in] method HTTP方法，INVALID_METHOD表示匹配任意方法
+         */
+        void add(const std::string &path, Handler handler, HttpMethod method = HttpMethod::INVALID_METHOD);
+
+        /**
+         * @brief 添加通配路由
+         * @details 只在结尾有一个'*'的模式放入树中作为前缀匹配，其余用fnmatch
+         * @param[in] pattern fnmatch模式
+         * @param[in] handler 处理器
+         */
+        void addGlob(const std::string &pattern, Handler handler);
+
+        /**
+         * @brief 查找路由
+         * @param[in] method HTTP方法，INVALID_METHOD时只匹配不区分方法的路由
+         * @param[in] path 请求路径
+         * @param[out] params 路径参数，可以为空
+         * @return 没有匹配的路由时返回空，返回值的生命周期与路由表相同
+         */
+        IServletCreator *match(HttpMethod method, const std::string &path, Params *params = nullptr) const;
+
+    private:
+        struct Node;
+
+        /**
+         * @brief 插入静态路径片段，返回片段结束处的节点
+         */
+        Node *insertStatic(Node *n, const char *s, size_t len);
+
+        /**
+         * @brief 从节点n开始匹配[p, end)，先试静态子节点，再试参数子节点，最后用本节点的前缀通配
+         */
+        bool find(const Node *n, HttpMethod method, const char *p, const char *end,
+                  Params *params, const Handler *&handler) const;
+
+    private:
+        /// 根节点，前缀为空
+        std::unique_ptr<Node> m_root;
+        /// 不含参数的路径在哈希表中的记录
+        struct Static
+        {
+            const Node *node = nullptr;     /// 树中对应的节点
+            IServletCreator *any = nullptr; /// 节点上不区分方法的处理器
+            bool hasMethods = false;        /// 节点上是否有按方法区分的处理器
+        };
+
+        /// 不含参数的路径 -> 记录
+        std::unordered_map<std::string, Static> m_statics;
+        /// 无法放入树中的通配路由，按添加顺序匹配
+        std::vector<std::pair<std::string, Handler>> m_globs;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+/**
+ * @file    ws_co_session.hpp
+ * @brief   WebSocket消息收发的co_await版本，基于C++20无栈协程。
+ * @note    需要C++20，仅在CMake选项 CIM_CO_AWAIT 打开时参与编译(CIM_co 库)。
+ *          空闲连接只占用协程帧，不再为每个连接保留一个有栈协程。
+ */
+
+#ifndef __CIM_HTTP_WS_CO_SESSION_HPP__
+#define __CIM_HTTP_WS_CO_SESSION_HPP__
+
+#include "co_io.hpp"
+#include "ws_session.hpp"
+
+namespace CIM::http {
+
+/**
+ * @brief   以co_await方式从会话接收一条WebSocket消息
+ * @param   session 会话，协程执行期间保持其存活
+ * @param   client  是否为客户端模式
+ * @return  WSFrameMessage智能指针，失败或连接关闭返回nullptr（此时会话已被关闭）
+ * @note    语义与 WSSession::recvMessage 一致：PING 自动回复 PONG，分片消息自动拼接
+ */
+co::Task<WSFrameMessage::ptr> WSCoRecvMessage(WSSession::ptr session, bool client = false);
+
+/**
+ * @brief   以co_await方式发送一条WebSocket消息
+ * @param   session 会话
+ * @param   msg     消息对象
+ * @param   client  是否为客户端模式
+ * @param   fin     是否为消息最后一帧
+ * @return  实际发送字节数，失败返回负值（此时会话已被关闭）
+ */
+co::Task<int32_t> WSCoSendMessage(WSSession::ptr session, WSFrameMessage::ptr msg,
+                                  bool client = false, bool fin = true);
+
+/**
+ * @brief   以co_await方式发送PONG帧
+ * @param   session 会话
+ * @return  发送结果，失败返回负值（此时会话已被关闭）
+ */
+co::Task<int32_t> WSCoPong(WSSession::ptr session);
+
+}  // namespace CIM::http
+
+#endif  // __CIM_HTTP_WS_CO_SESSION_HPP__
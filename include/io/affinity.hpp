@@ -0,0 +1,117 @@
+/**
+ * @file affinity.hpp
+ * @brief 线程CPU亲和性与NUMA内存策略
+ * @author CIM
+ *
+ * 工作线程池(WorkerManager)可以通过 workers.yaml 中的 cpu_set / numa_node / pin
+ * 控制线程放置：
+ * - cpu_set：线程允许运行的CPU列表，如 "0-7,16-23"
+ * - numa_node：内存优先从该节点分配(set_mempolicy MPOL_PREFERRED)；
+ *   未指定 cpu_set 时取该节点的全部CPU
+ * - pin：为true时第i个线程固定到 cpu_set 中的第 i % n 个CPU，否则线程可在 cpu_set 内迁移
+ *
+ * 策略在工作线程进入 Scheduler::run 时应用于线程自身，此后该线程分配的协程栈、
+ * FdContext 等内存在首次访问时都落在本地节点。NUMA相关接口直接使用系统调用和sysfs，
+ * 不依赖libnuma；内核不支持时仅记录日志，不影响运行。
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace CIM
+{
+    /**
+     * @brief 线程放置策略
+     */
+    struct ThreadAffinity
+    {
+        std::vector<int> cpus; /// 允许运行的CPU列表，空表示不限制
+        int numa_node = -1;    /// 内存优先分配的NUMA节点，-1表示不设置
+        bool pin = false;      /// 是否将每个线程固定到单个CPU
+
+        /**
+         * @brief 是否未设置任何策略
+         */
+        bool empty() const { return cpus.empty() && numa_node < 0; }
+
+        /**
+         * @brief 转为可读字符串，如 "cpus=0-3 node=0 pin=1"
+         */
+        std::string toString() const;
+
+        /**
+         * @brief 由配置项构造
+         * @param[in] cpu_set CPU列表字符串，空表示不指定
+         * @param[in] numa_node NUMA节点，-1表示不指定
+         * @param[in] pin 是否每线程固定到单个CPU
+         * @return ThreadAffinity 指定了numa_node而未指定cpu_set时，cpus为该节点的全部CPU
+         */
+        static ThreadAffinity Create(const std::string &cpu_set, int numa_node, bool pin);
+
+        /**
+         * @brief 将策略应用到调用线程
+         * @param[in] index 线程在线程池中的序号，pin模式下用于选择CPU
+         * @return 全部设置成功返回true
+         */
+        bool apply(size_t index) const;
+    };
+
+    /**
+     * @brief 解析CPU列表字符串
+     * @param[in] str 形如 "0-3,8,10-11" 的列表
+     * @return 升序去重后的CPU编号，格式错误的片段被忽略
+     */
+    std::vector<int> ParseCpuList(const std::string &str);
+
+    /**
+     * @brief CPU列表转为紧凑字符串，如 {0,1,2,3,8} -> "0-3,8"
+     */
+    std::string CpuListToString(const std::vector<int> &cpus);
+
+    /**
+     * @brief 获取NUMA节点上的CPU列表
+     * @param[in] node 节点编号
+     * @return 节点不存在时返回空
+     */
+    std::vector<int> GetNumaNodeCpus(int node);
+
+    /**
+     * @brief 获取CPU所属的NUMA节点
+     * @param[in] cpu CPU编号
+     * @return 节点编号，无法确定时返回-1
+     */
+    int GetCpuNumaNode(int cpu);
+
+    /**
+     * @brief 获取线程最近一次运行所在的CPU
+     * @param[in] tid 本进程内的线程ID
+     * @return CPU编号，失败返回-1
+     */
+    int GetThreadCpu(pid_t tid);
+
+    /**
+     * @brief 设置调用线程的内存分配策略
+     * @param[in] node 优先分配内存的NUMA节点，小于0时恢复为系统默认策略
+     * @return 成功返回true
+     */
+    bool SetThreadMemoryNode(int node);
+
+    /**
+     * @brief 在作用域内临时将调用线程的内存优先分配到指定节点，析构时恢复默认策略
+     */
+    class ScopedMemoryNode
+    {
+    public:
+        /**
+         * @param[in] node NUMA节点，小于0时不做任何事
+         */
+        explicit ScopedMemoryNode(int node);
+        ~ScopedMemoryNode();
+
+    private:
+        bool m_set; /// 是否修改了内存策略
+    };
+}
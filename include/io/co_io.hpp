@@ -0,0 +1,148 @@
+/**
+ * @file co_io.hpp
+ * @brief 基于 IOManager 的 co_await IO 原语
+ * @author CIM
+ *
+ * - whenReadable / whenWritable：挂起直到fd可读/可写，底层使用 IOManager::addEvent，
+ *   超时使用定时器堆中的条件定时器，语义与hook中的do_io一致
+ * - sleep：挂起指定毫秒数，使用 IOManager::addTimer
+ * - read / write / readFixSize / writeFixSize：在Socket上收发数据，直接调用未被hook的
+ *   recv/send(MSG_DONTWAIT)，遇到EAGAIN时 co_await 等待事件，不会让出有栈协程
+ *
+ * 所有原语必须在 IOManager 的调度线程上的 co::Task 中使用（通常由 co::spawn 启动）。
+ * 仅支持明文Socket，SSLSocket 的读写仍需使用有栈接口。
+ */
+
+#pragma once
+
+#include "co_task.hpp"
+#include "iomanager.hpp"
+#include "socket.hpp"
+#include <atomic>
+#include <memory>
+
+namespace CIM::co
+{
+    /**
+     * @brief 等待fd上的IO事件
+     */
+    class EventAwaiter
+    {
+    public:
+        /**
+         * @brief 构造函数
+         * @param[in] fd 文件描述符
+         * @param[in] event 等待的事件(READ / WRITE)
+         * @param[in] timeout_ms 超时时间(毫秒)，-1表示不超时
+         */
+        EventAwaiter(int fd, IOManager::Event event, uint64_t timeout_ms);
+
+        bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief 注册超时定时器和IO事件后挂起
+         * @return false 注册失败，不挂起，await_resume 返回错误码
+         */
+        bool await_suspend(std::coroutine_handle<> h);
+
+        /**
+         * @brief 恢复时取消超时定时器
+         * @return 0 事件就绪；ETIMEDOUT 超时；其他值为注册失败的错误码
+         */
+        int await_resume();
+
+    private:
+        /// 超时定时器与等待者之间共享的状态，定时器通过weak_ptr判断等待是否仍然有效；
+        /// 定时器回调与恢复后的协程可能在不同线程，cancelled 使用原子变量
+        struct State
+        {
+            std::atomic<int> cancelled{0};
+        };
+
+        IOManager *m_iom;               ///< 当前线程的IOManager
+        int m_fd;                       ///< 文件描述符
+        IOManager::Event m_event;       ///< 等待的事件
+        uint64_t m_timeout;             ///< 超时时间(毫秒)
+        std::shared_ptr<State> m_state; ///< 超时状态
+        Timer::ptr m_timer;             ///< 超时定时器
+        int m_error = 0;                ///< 注册失败时的错误码
+    };
+
+    /**
+     * @brief 等待定时器到期
+     */
+    class SleepAwaiter
+    {
+    public:
+        explicit SleepAwaiter(uint64_t ms)
+            : m_ms(ms)
+        {
+        }
+
+        bool await_ready() const noexcept { return m_ms == 0; }
+        bool await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept {}
+
+    private:
+        uint64_t m_ms; ///< 休眠时间(毫秒)
+    };
+
+    /**
+     * @brief 挂起直到fd可读
+     * @param[in] fd 文件描述符
+     * @param[in] timeout_ms 超时时间(毫秒)，-1表示不超时
+     */
+    inline EventAwaiter whenReadable(int fd, uint64_t timeout_ms = -1)
+    {
+        return EventAwaiter(fd, IOManager::READ, timeout_ms);
+    }
+
+    /**
+     * @brief 挂起直到fd可写
+     * @param[in] fd 文件描述符
+     * @param[in] timeout_ms 超时时间(毫秒)，-1表示不超时
+     */
+    inline EventAwaiter whenWritable(int fd, uint64_t timeout_ms = -1)
+    {
+        return EventAwaiter(fd, IOManager::WRITE, timeout_ms);
+    }
+
+    /**
+     * @brief 挂起指定毫秒数
+     * @param[in] ms 休眠时间(毫秒)
+     */
+    inline SleepAwaiter sleep(uint64_t ms)
+    {
+        return SleepAwaiter(ms);
+    }
+
+    /**
+     * @brief 从Socket读取数据，超时时间取Socket的接收超时
+     * @param[in] sock 套接字
+     * @param[out] buffer 接收缓冲区
+     * @param[in] length 缓冲区大小
+     * @return >0 读取的字节数；=0 对端关闭；<0 出错(errno为错误码，超时为ETIMEDOUT)
+     */
+    Task<int> read(Socket::ptr sock, void *buffer, size_t length);
+
+    /**
+     * @brief 向Socket写入数据，超时时间取Socket的发送超时
+     * @param[in] sock 套接字
+     * @param[in] buffer 待发送数据
+     * @param[in] length 数据长度
+     * @return >0 写入的字节数；<0 出错
+     */
+    Task<int> write(Socket::ptr sock, const void *buffer, size_t length);
+
+    /**
+     * @brief 读取固定长度的数据
+     * @return 成功返回length；<=0 对端关闭或出错
+     */
+    Task<int> readFixSize(Socket::ptr sock, void *buffer, size_t length);
+
+    /**
+     * @brief 写入固定长度的数据
+     * @return 成功返回length；<=0 出错
+     */
+    Task<int> writeFixSize(Socket::ptr sock, const void *buffer, size_t length);
+}
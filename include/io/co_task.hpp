@@ -0,0 +1,221 @@
+/**
+ * @file co_task.hpp
+ * @brief 基于C++20无栈协程(co_await)的任务类型
+ * @author CIM
+ *
+ * 与 Coroutine 的有栈协程不同，co::Task 的协程帧只保存跨越 co_await 存活的局部变量，
+ * 挂起时不占用独立的栈空间。协程在 IOManager 的调度线程上被恢复，
+ * 恢复时借用当前回调协程的栈执行，因此大量空闲连接只需要各自的协程帧。
+ *
+ * 需要C++20，仅在CMake选项 CIM_CO_AWAIT 打开时参与编译(CIM_co 库)。
+ *
+ * 用法：
+ * @code
+ *   CIM::co::Task<int> foo();
+ *   CIM::co::Task<> bar()
+ *   {
+ *       int v = co_await foo();
+ *       co_await CIM::co::sleep(100);
+ *   }
+ *   CIM::co::spawn(bar(), iom);
+ * @endcode
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "co_task.hpp requires C++20 coroutines, build with CMake option CIM_CO_AWAIT=ON"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace CIM
+{
+    class Scheduler;
+}
+
+namespace CIM::co
+{
+    template <class T = void>
+    class Task;
+
+    namespace detail
+    {
+        /**
+         * @brief Task 协程promise的公共部分
+         * @details 协程创建后先挂起(惰性启动)，被 co_await 时才开始执行；
+         *          结束时通过对称转移直接恢复等待者，不经过调度器
+         */
+        struct PromiseBase
+        {
+            /**
+             * @brief 结束时切回等待者
+             */
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template <class P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+                {
+                    std::coroutine_handle<> cont = h.promise().continuation;
+                    return cont ? cont : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() { exception = std::current_exception(); }
+
+            std::coroutine_handle<> continuation; ///< 等待本任务完成的协程
+            std::exception_ptr exception;         ///< 协程体内抛出的异常，在等待者处重新抛出
+        };
+
+        template <class T>
+        struct Promise : PromiseBase
+        {
+            Task<T> get_return_object() noexcept;
+
+            template <class U>
+            void return_value(U &&v)
+            {
+                value.emplace(std::forward<U>(v));
+            }
+
+            T result()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+                return std::move(*value);
+            }
+
+            std::optional<T> value; ///< co_return 的结果
+        };
+
+        template <>
+        struct Promise<void> : PromiseBase
+        {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+
+            void result()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+        };
+    }
+
+    /**
+     * @brief 无栈协程任务
+     * @details 独占协程帧的所有权，析构时销毁协程帧。只能移动，且只能被 co_await 一次
+     * @tparam T co_return 的结果类型
+     */
+    template <class T>
+    class Task
+    {
+    public:
+        using promise_type = detail::Promise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+
+        explicit Task(handle_type h)
+            : m_handle(h)
+        {
+        }
+
+        Task(Task &&other) noexcept
+            : m_handle(std::exchange(other.m_handle, nullptr))
+        {
+        }
+
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_handle)
+                {
+                    m_handle.destroy();
+                }
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        ~Task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        /**
+         * @brief 是否持有协程帧
+         */
+        bool valid() const { return (bool)m_handle; }
+
+        /**
+         * @brief 等待任务完成并获取结果
+         * @details 挂起当前协程并直接切入任务协程执行，任务结束后恢复当前协程
+         */
+        auto operator co_await() const noexcept
+        {
+            struct Awaiter
+            {
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume() { return handle.promise().result(); }
+
+                handle_type handle;
+            };
+            return Awaiter{m_handle};
+        }
+
+    private:
+        handle_type m_handle = nullptr; ///< 协程帧句柄
+    };
+
+    namespace detail
+    {
+        template <class T>
+        inline Task<T> Promise<T>::get_return_object() noexcept
+        {
+            return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> Promise<void>::get_return_object() noexcept
+        {
+            return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+        }
+    }
+
+    /**
+     * @brief 在调度器上启动一个顶层任务
+     * @details 任务首先作为回调被投递到调度器，之后每次挂起/恢复都发生在该调度器的线程上；
+     *          任务结束后自动释放协程帧，未捕获的异常会被记录到日志
+     * @param[in] task 顶层任务
+     * @param[in] scheduler 目标调度器，为空时使用当前线程的调度器
+     */
+    void spawn(Task<void> task, Scheduler *scheduler = nullptr);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file context.hpp
+ * @brief 协程上下文切换后端
+ * @author CIM
+ *
+ * 提供两种协程上下文切换实现，编译期通过 CMake 选项 CIM_ASM_CONTEXT 选择：
+ * - 汇编后端(x86_64 / aarch64)：只保存被调用者保存寄存器，切换不经过系统调用
+ * - ucontext后端：基于 getcontext/makecontext/swapcontext，每次切换都会调用
+ *   rt_sigprocmask 保存/恢复信号掩码，作为不支持架构上的兜底实现
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(CIM_USE_ASM_CONTEXT) && (defined(__x86_64__) || defined(__aarch64__))
+#define CIM_CONTEXT_ASM 1
+#else
+#include <ucontext.h>
+#endif
+
+namespace CIM
+{
+    /**
+     * @brief 协程上下文
+     */
+    struct CoContext
+    {
+#ifdef CIM_CONTEXT_ASM
+        void *sp = nullptr; /// 切出时保存的栈顶指针，寄存器保存在该栈上
+#else
+        ucontext_t uc; /// ucontext上下文
+#endif
+    };
+
+    /**
+     * @brief 获取当前上下文切换后端名称
+     * @return "asm" 或 "ucontext"
+     */
+    const char *ContextBackendName();
+
+    /**
+     * @brief 初始化代表当前执行流的上下文（用于线程主协程）
+     * @param[out] ctx 上下文
+     * @return 成功返回true
+     */
+    bool ContextInit(CoContext *ctx);
+
+    /**
+     * @brief 在给定栈上构造一个新上下文，首次切入时执行fn
+     * @param[out] ctx 上下文
+     * @param[in] stack 栈空间起始地址（低地址）
+     * @param[in] size 栈空间大小
+     * @param[in] fn 入口函数，不允许返回
+     * @return 成功返回true
+     */
+    bool ContextMake(CoContext *ctx, void *stack, size_t size, void (*fn)());
+
+    /**
+     * @brief 保存当前上下文到from，并切换到to
+     * @param[out] from 保存当前上下文
+     * @param[in] to 目标上下文
+     * @return 成功返回true
+     */
+    bool ContextSwap(CoContext *from, CoContext *to);
+}
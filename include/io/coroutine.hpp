@@ -3,13 +3,16 @@
  * @brief 协程实现模块
  *
  * 该文件提供了协程的实现，包括协程的创建、切换、状态管理等功能。
- * 基于ucontext实现协程上下文切换，支持协程的挂起、恢复等操作。
+ * 上下文切换由context.hpp提供，编译期选择汇编实现或ucontext实现，
+ * 支持协程的挂起、恢复等操作。
  */
 
 #pragma once
 
 #include "noncopyable.hpp"
-#include <ucontext.h>
+#include "context.hpp"
+#include "task_function.hpp"
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -19,7 +22,7 @@ namespace CIM
      * @brief 协程类
      *
      * 实现了协程的基本功能，包括创建、执行、挂起、恢复等操作。
-     * 使用ucontext_t保存和恢复协程上下文，通过状态机管理协程生命周期。
+     * 使用CoContext保存和恢复协程上下文，通过状态机管理协程生命周期。
      */
     class Coroutine : public std::enable_shared_from_this<Coroutine>, Noncopyable
     {
@@ -53,7 +56,7 @@ namespace CIM
          * @param[in] stack_size 协程栈大小，默认为0表示使用默认大小
          * @param[in] use_caller 是否使用调用者上下文，默认为false
          */
-        Coroutine(std::function<void()> cb, size_t stack_size = 0, bool use_caller = false);
+        Coroutine(TaskFunction cb, size_t stack_size = 0, bool use_caller = false);
 
         /**
          * @brief 析构函数
@@ -64,7 +67,7 @@ namespace CIM
          * @brief 重置协程函数，并重置状态
          * @param[in] cb 新的协程执行回调函数
          */
-        void reset(std::function<void()> cb);
+        void reset(TaskFunction cb);
 
         /**
          * @brief 切换到当前协程执行
@@ -93,17 +96,31 @@ namespace CIM
         uint64_t getId() const;
 
         /**
-         * @brief 获取协程状态
+         * @brief 获取协程状态(acquire)
          * @return 协程状态
          */
         State getState() const;
 
         /**
-         * @brief 设置协程状态
+         * @brief 设置协程状态(release)
          * @param[in] state 协程状态
          */
         void setState(State state);
 
+        /**
+         * @brief 获取调度优先级
+         * @return Scheduler::Priority 的取值
+         */
+        int getPriority() const { return m_priority; }
+
+        /**
+         * @brief 设置调度优先级
+         * @details 调度器执行协程前记录其任务的优先级，协程在IO等待、定时器之后重新入队时沿用；
+         *          协程内也可直接设置，之后的每次恢复都按该优先级调度
+         * @param[in] priority Scheduler::Priority 的取值
+         */
+        void setPriority(int priority) { m_priority = (uint8_t)priority; }
+
     public:
         /**
          * @brief 设置当前协程
@@ -127,6 +144,23 @@ namespace CIM
          */
         static void YieldToHold();
 
+        /**
+         * @brief 从当前线程的协程池取出一个协程并绑定回调
+         * @details 池中没有可用协程时新建一个默认栈大小的协程
+         * @param[in] cb 协程执行的回调函数
+         * @return 处于INIT状态的协程
+         */
+        static Coroutine::ptr Acquire(TaskFunction cb);
+
+        /**
+         * @brief 将已结束的协程放回当前线程的协程池
+         * @details 仅回收默认栈大小、处于TERM/EXCEPT状态、且调用方持有唯一引用的协程，
+         *          池大小受 coroutine.pool_size 限制
+         * @param[in] co 协程
+         * @return true 已放入池中
+         */
+        static bool Recycle(const Coroutine::ptr &co);
+
         /**
          * @brief 获取协程总数
          * @return 协程总数
@@ -152,10 +186,13 @@ namespace CIM
     private:
         uint64_t m_id = 0;           /// 协程id
         uint32_t m_stack_size = 0;   /// 协程栈大小
-        State m_state = State::INIT; /// 协程当前状态
-        ucontext_t m_ctx;            /// 协程上下文，用于保存和切换上下文环境
+        /// 协程当前状态；切出后由调度线程置为HOLD，其他线程据此判断能否恢复，
+        /// release/acquire 保证看到HOLD时上下文已保存完毕
+        std::atomic<State> m_state{State::INIT};
+        uint8_t m_priority = 1;      /// 调度优先级，默认Scheduler::NORMAL
+        CoContext m_ctx;             /// 协程上下文，用于保存和切换上下文环境
         void *m_stack = nullptr;     /// 协程栈空间
-        std::function<void()> m_cb;  /// 协程要执行的回调函数
+        TaskFunction m_cb;           /// 协程要执行的回调函数
     };
 
     /**
@@ -180,4 +217,50 @@ namespace CIM
          */
         static void Dealloc(void *ptr, size_t size);
     };
+
+    /**
+     * @brief 协程栈池统计信息
+     */
+    struct StackPoolStats
+    {
+        uint64_t live = 0;           /// 正在被协程使用的栈数量
+        uint64_t pooled = 0;         /// 已归还、缓存在空闲链表中的栈数量
+        uint64_t bytes_reserved = 0; /// mmap保留的虚拟地址空间总字节数(含保护页)
+        uint64_t bytes_mapped = 0;   /// 使用中与未被madvise回收的缓存栈的可用空间字节数，是栈常驻内存的上限
+        uint64_t bytes_resident = 0; /// 栈实际驻留物理内存的字节数，GetStats时用mincore统计
+    };
+
+    /**
+     * @brief 基于mmap的池化协程栈分配器
+     *
+     * - 每个栈通过mmap单独映射，并在低地址端放置一个PROT_NONE保护页，
+     *   栈溢出会立即触发SIGSEGV，而不是悄悄破坏堆内存
+     * - 释放的栈进入线程本地空闲链表，下次分配时直接复用，避免频繁mmap/munmap
+     * - 空闲链表超过高水位(coroutine.stack_pool.high_water)的栈通过
+     *   madvise(MADV_DONTNEED)归还物理内存，但保留地址空间以便复用；
+     *   缓存达到上限(coroutine.stack_pool.max_cached)后归还的栈直接munmap
+     */
+    class StackPool : public Noncopyable
+    {
+    public:
+        /**
+         * @brief 分配栈空间
+         * @param[in] size 栈大小(会向上对齐到页大小)
+         * @return 分配的栈空间指针(保护页之上的可用区域起始地址)
+         */
+        static void *Alloc(size_t size);
+
+        /**
+         * @brief 归还栈空间到当前线程的空闲链表
+         * @param[in] ptr 栈空间指针
+         * @param[in] size 栈大小(与Alloc时传入的一致)
+         */
+        static void Dealloc(void *ptr, size_t size);
+
+        /**
+         * @brief 获取全局统计信息
+         * @return StackPoolStats 统计快照
+         */
+        static StackPoolStats GetStats();
+    };
 }
\ No newline at end of file
@@ -7,15 +7,48 @@
  * 继承自Scheduler（协程调度器）和TimerManager（定时器管理器）。
  * IOManager能够监听文件描述符上的读写事件，并在事件就绪时自动调度
  * 相应的协程或回调函数执行，从而实现高效的异步IO编程。
+ *
+ * 唤醒机制：所有线程共享一个 eventfd，tickle 通过原子标志合并——已有一次唤醒尚未被
+ * 空闲线程消费时不再写 eventfd，每次写入只唤醒一个 epoll_wait 中的线程。被唤醒的线程
+ * 取到任务后若队列中仍有任务，再唤醒下一个空闲线程（逐个接力），
+ * 从而只唤醒与新任务数量相当的线程，避免惊群；事件循环自身调度的任务由该线程返回后执行，
+ * 不额外唤醒；停止时各线程退出前同样接力唤醒下一个。
+ *
+ * 注册模式(iomanager.epoll_mode)：
+ * - rearm：每次等待 epoll_ctl 添加对应事件，触发后再 MOD/DEL 去掉，每次读写等待至少两次系统调用
+ * - persistent：fd 首次等待时以 EPOLLIN|EPOLLOUT|EPOLLET 注册一次，此后只在用户态登记等待者，
+ *   到达时没有等待者的事件记为就绪，下次 addEvent 直接触发；注册只在 cancelAll 中移除。
+ *   fd 号被复用时 FdManager 重新打开 FdCtx 会清除注册状态，下次等待重新 EPOLL_CTL_ADD
+ *   （原打开文件仍被 dup 引用、内核注册未移除时改为 MOD）；hook 的 close 会依次调用
+ *   FdManager::del 与 cancelAll。绕过 hook 直接关闭已等待过的 fd 时 FdCtx 不会重新打开，
+ *   该模式下必须先调用 cancelAll 或 FdManager::del
+ *
+ * io_uring 后端(workers.yaml 中 backend: uring)：hook 的 read/recv/recvmsg/accept/connect
+ * 不再先尝试系统调用，而是直接填写 SQE 并挂起协程；send/sendmsg/writev 通常能立即完成，
+ * 仍先直接调用，返回 EAGAIN 时才提交 SQE。有空闲线程时 SQE 立即提交，所有线程都在忙时
+ * 留到线程进入 idle 时一次 io_uring_enter 批量提交；io_uring 的 fd 加入 epoll，完成时由
+ * idle 收取 CQE 并恢复协程。
+ * 超时通过链接的 LINK_TIMEOUT 交给内核，cancelEvent/cancelAll 通过 ASYNC_CANCEL 取消进行中的请求。
+ * 其余 fd 事件仍走 epoll；内核不支持时回退为纯 epoll。
+ *
+ * 事件循环：每个线程的 epoll_event 数组从 64 起，一次等待返回满数组时翻倍，
+ * 上限 iomanager.max_events；就绪 fd 的协程/回调与到期定时器回调收集后一次加锁批量入队。
+ * 内核支持 epoll_pwait2 时(iomanager.epoll_pwait2)按纳秒等待到最近定时器的到期时刻，
+ * 否则向上取整到毫秒。
  */
 
 #pragma once
 
 #include "scheduler.hpp"
 #include "timer.hpp"
+#include <memory>
+
+struct epoll_event;
 
 namespace CIM
 {
+    class IoUring;
+
     /**
      * @brief IO事件管理器
      * @details IOManager是一个基于epoll的I/O多路复用事件管理器，继承自Scheduler和TimerManager。
@@ -39,10 +72,56 @@ namespace CIM
             WRITE = 0x4, /// 写事件(EPOLLOUT)
         };
 
-    private:
+        /**
+         * @brief IO后端
+         */
+        enum Backend
+        {
+            EPOLL = 0, /// epoll就绪通知 + 非阻塞系统调用
+            URING = 1, /// hook的IO直接提交到io_uring
+        };
+
+        /**
+         * @brief 从字符串解析IO后端，"uring"/"io_uring" 为 URING，其余为 EPOLL
+         */
+        static Backend BackendFromString(const std::string &str);
+
+        /**
+         * @brief IO后端名称
+         */
+        static const char *BackendToString(Backend backend);
+
+        struct FdContext;
+
+        /**
+         * @brief io_uring请求
+         * @details 由发起请求的协程持有（通常在协程栈上），在完成并恢复协程之前必须保持有效。
+         *          opcode/addr/len/off/op_flags 对应SQE的同名字段，其余由IOManager填写。
+         */
+        struct IORequest
+        {
+            uint8_t opcode = 0;       /// 操作码 IORING_OP_*
+            uint64_t addr = 0;        /// 缓冲区、地址或msghdr
+            uint32_t len = 0;         /// 长度
+            uint64_t off = 0;         /// accept的地址长度指针、connect的地址长度
+            uint32_t op_flags = 0;    /// msg_flags / accept_flags
+            uint64_t timeout = ~0ull; /// 超时(毫秒)，到期由内核取消请求，~0ull表示不超时
+            int result = 0;           /// 完成结果，失败时为 -errno
+            bool cancelled = false;   /// 是否被cancelEvent/cancelAll取消
+
+            Event event = NONE;             /// 请求所属方向
+            FdContext *context = nullptr;   /// 所属fd上下文
+            Scheduler *scheduler = nullptr; /// 完成后恢复协程的调度器
+            Coroutine::ptr coroutine;       /// 等待完成的协程
+            int64_t ts[2] = {0, 0};         /// LINK_TIMEOUT 使用的 __kernel_timespec
+        };
+
         /**
          * @brief 文件描述符上下文结构体
-         * @details 管理特定文件描述符上的事件信息，包括读写事件上下文和当前监听的事件类型
+         * @details 管理特定文件描述符上的事件信息，包括读写事件上下文和当前监听的事件类型。
+         *          它是FdManager中每个fd的记录FdCtx的基类，与hook所需的属性合在同一条记录中，
+         *          记录不移动，不需要额外的表和锁。事件属于首个等待它的IOManager(owner)，
+         *          owner上没有等待者时，其他IOManager等待该fd会把注册迁移过去。
          */
         struct FdContext
         {
@@ -57,6 +136,7 @@ namespace CIM
                 Scheduler *scheduler = nullptr; /// 指定执行事件的调度器
                 Coroutine::ptr coroutine;       /// 绑定到事件的协程对象
                 std::function<void()> cb;       /// 事件触发时执行的回调函数
+                IORequest *request = nullptr;   /// 该方向上进行中的io_uring请求
             };
 
             /**
@@ -78,11 +158,14 @@ namespace CIM
              */
             void triggerEvent(Event event);
 
-            int fd = 0;          /// 事件绑定的文件描述符
-            EventContext read;   /// 读事件上下文
-            EventContext write;  /// 写事件上下文
-            Event events = NONE; /// 当前监听的事件类型
-            MutexType mutex;     /// 保护该上下文的互斥锁
+            int fd = 0;                 /// 事件绑定的文件描述符
+            EventContext read;          /// 读事件上下文
+            EventContext write;         /// 写事件上下文
+            Event events = NONE;        /// 当前监听的事件类型
+            Event ready = NONE;         /// 持久注册模式下到达时没有等待者的事件
+            bool registered = false;    /// 持久注册模式下是否已注册到epoll
+            IOManager *owner = nullptr; /// 事件注册所在的IOManager
+            MutexType mutex;            /// 保护该上下文的互斥锁
         };
 
     public:
@@ -91,8 +174,13 @@ namespace CIM
          * @param[in] threads 线程数量
          * @param[in] use_caller 是否使用调用线程作为调度线程之一
          * @param[in] name 调度器名称
+         * @param[in] mode 任务队列模式
+         * @param[in] affinity 工作线程的CPU亲和性与NUMA内存策略
+         * @param[in] backend IO后端，URING在内核不支持时回退为EPOLL
          */
-        IOManager(size_t threads = 1, bool use_caller = true, const std::string &name = "");
+        IOManager(size_t threads = 1, bool use_caller = true, const std::string &name = "",
+                  QueueMode mode = GLOBAL, const ThreadAffinity &affinity = ThreadAffinity(),
+                  Backend backend = EPOLL);
 
         /**
          * @brief 析构函数
@@ -108,6 +196,11 @@ namespace CIM
          */
         bool addEvent(int fd, Event event, std::function<void()> cb = nullptr);
 
+        /**
+         * @brief 添加事件监听，fd上下文已由调用者取得（hook中即FdCtx），省去一次查找
+         */
+        bool addEvent(FdContext *fd_ctx, Event event, std::function<void()> cb = nullptr);
+
         /**
          * @brief 删除事件监听
          * @param[in] fd 文件描述符
@@ -124,6 +217,11 @@ namespace CIM
          */
         bool cancelEvent(int fd, Event event);
 
+        /**
+         * @brief 取消事件监听并触发事件处理，fd上下文已由调用者取得
+         */
+        bool cancelEvent(FdContext *fd_ctx, Event event);
+
         /**
          * @brief 取消指定文件描述符上的所有事件监听
          * @param[in] fd 文件描述符
@@ -131,12 +229,126 @@ namespace CIM
          */
         bool cancelAll(int fd);
 
+        /**
+         * @brief 向io_uring提交一个请求，由当前协程等待完成
+         * @details 与addEvent相同，返回true后调用者应调用Coroutine::YieldToHold()，
+         *          完成时协程被重新调度，结果在req.result中。有空闲线程时请求立即提交，
+         *          否则在下一个进入idle的线程中批量提交。
+         *          同一fd的同一方向同时只能有一个请求。
+         * @param[in] fd 文件描述符
+         * @param[in] event 请求所属方向，cancelEvent(fd, event)可取消该请求
+         * @param[in,out] req 请求
+         * @return bool 非io_uring后端、提交队列已满或该方向已有请求时返回false
+         */
+        bool submitIO(int fd, Event event, IORequest &req);
+
+        /**
+         * @brief 向io_uring提交一个请求，fd上下文已由调用者取得
+         */
+        bool submitIO(FdContext *fd_ctx, Event event, IORequest &req);
+
         /**
          * @brief 获取当前线程的IOManager实例
          * @return IOManager* 当前线程的IOManager实例指针
          */
         static IOManager *GetThis();
 
+        /**
+         * @brief 唤醒统计
+         */
+        struct TickleStats
+        {
+            uint64_t calls = 0;     /// 存在空闲线程时的tickle调用次数（即改用eventfd前的写管道次数）
+            uint64_t coalesced = 0; /// 被合并的次数：已有未消费的唤醒，或由事件循环线程自行执行
+            uint64_t writes = 0;    /// eventfd写入次数
+            uint64_t reads = 0;     /// eventfd读取次数
+        };
+
+        /**
+         * @brief 获取唤醒统计
+         * @return TickleStats 统计快照
+         */
+        TickleStats getTickleStats() const;
+
+        /**
+         * @brief epoll注册统计
+         */
+        struct EpollStats
+        {
+            uint64_t ctls = 0;  /// epoll_ctl调用次数
+            uint64_t waits = 0; /// epoll_wait调用次数
+            uint64_t ready = 0; /// addEvent时事件已就绪、直接触发的次数（仅持久注册模式）
+        };
+
+        /**
+         * @brief 获取epoll注册统计
+         * @return EpollStats 统计快照
+         */
+        EpollStats getEpollStats() const;
+
+        /**
+         * @brief 是否为持久注册模式
+         */
+        bool isPersistentEpoll() const { return m_persistentEpoll; }
+
+        /**
+         * @brief 事件循环统计，用于调整批量大小与观察循环延迟
+         */
+        struct LoopStats
+        {
+            uint64_t wakeups = 0;   /// epoll_wait返回次数（不含被信号中断）
+            uint64_t events = 0;    /// 返回的事件总数，events/wakeups 为每次唤醒的事件数
+            uint64_t maxEvents = 0; /// 单次唤醒的最大事件数
+            uint64_t timers = 0;    /// 到期定时器回调数
+            uint64_t grows = 0;     /// 事件数组扩容次数
+            uint64_t loopUs = 0;    /// 从epoll_wait返回到任务全部入队的累计耗时(微秒)
+            uint64_t maxLoopUs = 0; /// 单次分发的最大耗时(微秒)
+        };
+
+        /**
+         * @brief 获取事件循环统计
+         * @return LoopStats 统计快照
+         */
+        LoopStats getLoopStats() const;
+
+        /**
+         * @brief 是否使用epoll_pwait2按纳秒等待（iomanager.epoll_pwait2且内核支持）
+         */
+        bool isPreciseWait() const;
+
+        /**
+         * @brief io_uring统计
+         */
+        struct UringStats
+        {
+            uint64_t enters = 0; /// io_uring_enter调用次数
+            uint64_t sqes = 0;   /// 提交的SQE数
+            uint64_t cqes = 0;   /// 收取的CQE数
+        };
+
+        /**
+         * @brief 获取io_uring统计
+         * @return UringStats 统计快照
+         */
+        UringStats getUringStats() const;
+
+        /**
+         * @brief 实际使用的IO后端
+         */
+        Backend getBackend() const { return m_uring ? URING : EPOLL; }
+
+        /**
+         * @brief 是否使用io_uring后端
+         */
+        bool isUring() const { return m_uring != nullptr; }
+
+        /**
+         * @brief 输出调度器信息、唤醒、epoll注册及io_uring统计
+         * @param os 输出流
+         * @return std::ostream& 输出流
+         */
+        std::ostream &dump(std::ostream &os) override;
+
     protected:
         /**
          * @brief 唤醒空闲线程
@@ -159,24 +371,72 @@ namespace CIM
          */
         void onTimerInsertedAtFront() override;
 
-        /**
-         * @brief 调整文件描述符上下文数组大小
-         * @param[in] size 新的数组大小
-         */
-        void contextResize(size_t size);
-
         /**
          * @brief 带超时时间的停止判断函数
-         * @param[out] timeout 超时时间
+         * @param[out] timeout 距最近定时器到期的时间(纳秒)，没有定时器时为~0ull
          * @return bool true表示应该停止
          */
         bool stopping(uint64_t &timeout);
 
     private:
+        /**
+         * @brief 调用epoll_ctl并计数，失败时记录错误日志
+         * @return int epoll_ctl的返回值
+         */
+        int epollCtl(int op, int fd, epoll_event &ev);
+
+        /**
+         * @brief 获取fd的上下文（FdManager中的记录），fd超出范围时返回nullptr
+         */
+        static FdContext *GetFdContext(int fd);
+
+        /**
+         * @brief 使fd的事件归属本IOManager，调用者持有fd_ctx->mutex
+         * @details 原owner上仍有等待者时返回false；没有时从原owner的epoll中移除注册
+         */
+        bool acquire(FdContext *fd_ctx);
+
+        /**
+         * @brief 取消fd_ctx上指定方向进行中的io_uring请求，调用者持有fd_ctx->mutex
+         * @return bool 该方向有进行中的请求时返回true
+         */
+        bool cancelIO(FdContext *fd_ctx, Event event);
+
+        /**
+         * @brief 提交已填写的SQE
+         */
+        void flushIO();
+
+        /**
+         * @brief 收取完成的CQE并恢复等待的协程
+         */
+        void reapIO();
+
         int m_epfd = 0;                                /// epoll文件描述符
-        int m_tickleFds[2];                            /// 用于唤醒epoll_wait的管道文件描述符
+        int m_tickleFd = -1;                           /// 用于唤醒epoll_wait的eventfd
+        std::atomic<bool> m_tickled = {false};         /// 已写入eventfd但尚未被空闲线程消费
+        std::atomic<uint64_t> m_tickleCalls = {0};     /// tickle调用次数（存在空闲线程时）
+        std::atomic<uint64_t> m_tickleCoalesced = {0}; /// 被合并的tickle次数
+        std::atomic<uint64_t> m_tickleWrites = {0};    /// eventfd写入次数
+        std::atomic<uint64_t> m_tickleReads = {0};     /// eventfd读取次数
+        bool m_persistentEpoll = false;                /// fd是否持久注册到epoll
+        bool m_pwait2 = true;                          /// 是否尝试epoll_pwait2
+        std::atomic<uint64_t> m_epollCtls = {0};       /// epoll_ctl调用次数
+        std::atomic<uint64_t> m_epollReady = {0};      /// addEvent时直接触发的已就绪事件数
+        std::atomic<uint64_t> m_epollWaits = {0};      /// epoll_wait调用次数
+        std::atomic<uint64_t> m_loopWakeups = {0};     /// epoll_wait返回次数
+        std::atomic<uint64_t> m_loopEvents = {0};      /// 返回的事件总数
+        std::atomic<uint64_t> m_loopMaxEvents = {0};   /// 单次唤醒的最大事件数
+        std::atomic<uint64_t> m_loopTimers = {0};      /// 到期定时器回调数
+        std::atomic<uint64_t> m_loopGrows = {0};       /// 事件数组扩容次数
+        std::atomic<uint64_t> m_loopUs = {0};          /// 分发累计耗时(微秒)
+        std::atomic<uint64_t> m_loopMaxUs = {0};       /// 单次分发最大耗时(微秒)
+        std::unique_ptr<IoUring> m_uring;              /// io_uring实例，EPOLL后端为空
+        Mutex m_sqMutex;                               /// 保护io_uring提交队列
+        Mutex m_cqMutex;                               /// 保护io_uring完成队列
+        std::atomic<uint64_t> m_uringEnters = {0};     /// io_uring_enter调用次数
+        std::atomic<uint64_t> m_uringSqes = {0};       /// 提交的SQE数
+        std::atomic<uint64_t> m_uringCqes = {0};       /// 收取的CQE数
         std::atomic<size_t> m_pendingEventCount = {0}; /// 待处理的事件数量
-        RWMutexType m_mutex;                           /// 保护文件描述符上下文数组的读写锁
-        std::vector<FdContext *> m_fdContexts;         /// 文件描述符上下文数组
     };
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file latency_histogram.hpp
+ * @brief 无锁对数分桶延迟直方图
+ * @author CIM
+ *
+ * 第0个桶记录 0us，第i个桶记录 [2^(i-1), 2^i) us，最后一个桶收纳所有更大的值。
+ * 记录只需一次原子加，可在多个线程上并发调用；分位数取所在桶的上界，误差不超过2倍，
+ * 用于观察调度延迟这类跨数量级分布的指标足够。
+ */
+
+#pragma once
+
+#include "noncopyable.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace CIM
+{
+    /**
+     * @brief 延迟直方图（单位：微秒）
+     */
+    class LatencyHistogram : public Noncopyable
+    {
+    public:
+        /// 桶数量，最后一个桶的下界约为 1073 秒
+        static const int kBuckets = 32;
+
+        LatencyHistogram()
+        {
+            reset();
+        }
+
+        /**
+         * @brief 记录一个样本
+         * @param[in] us 延迟(微秒)
+         */
+        void record(uint64_t us)
+        {
+            int idx = us == 0 ? 0 : 64 - __builtin_clzll(us);
+            if (idx >= kBuckets)
+            {
+                idx = kBuckets - 1;
+            }
+            m_buckets[idx].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        /**
+         * @brief 样本总数
+         */
+        uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 最大样本
+         */
+        uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 计算分位数
+         * @param[in] p 分位(0, 1]，如 0.99
+         * @return 分位数所在桶的上界(微秒)，不超过最大样本；无样本时返回0
+         */
+        uint64_t percentile(double p) const
+        {
+            uint64_t counts[kBuckets];
+            uint64_t total = 0;
+            for (int i = 0; i < kBuckets; ++i)
+            {
+                counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+                total += counts[i];
+            }
+            if (total == 0)
+            {
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(p * total);
+            if (rank == 0)
+            {
+                rank = 1;
+            }
+            uint64_t seen = 0;
+            uint64_t bound = 0;
+            for (int i = 0; i < kBuckets; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                {
+                    bound = i == 0 ? 0 : (1ULL << i) - 1;
+                    break;
+                }
+            }
+            uint64_t mx = max();
+            return bound < mx ? bound : mx;
+        }
+
+        /**
+         * @brief 清空所有样本
+         */
+        void reset()
+        {
+            for (int i = 0; i < kBuckets; ++i)
+            {
+                m_buckets[i].store(0, std::memory_order_relaxed);
+            }
+            m_count.store(0, std::memory_order_relaxed);
+            m_max.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> m_buckets[kBuckets]; ///< 各桶样本数
+        std::atomic<uint64_t> m_count;             ///< 样本总数
+        std::atomic<uint64_t> m_max;               ///< 最大样本
+    };
+}
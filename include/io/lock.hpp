@@ -193,6 +193,8 @@ namespace CIM
         ~Mutex();
 
         void lock();
+        /// 尝试加锁，锁已被占用时立即返回false
+        bool trylock();
         void unlock();
 
     private:
@@ -14,7 +14,11 @@
 #include "coroutine.hpp"
 #include "thread.hpp"
 #include "noncopyable.hpp"
+#include "work_steal_queue.hpp"
+#include "affinity.hpp"
+#include "latency_histogram.hpp"
 #include <list>
+#include <memory>
 #include <vector>
 
 /*
@@ -59,7 +63,7 @@
                         v                             v
               +------------------+       +------------------+
               |  任务队列        |<----->|  线程同步机制    |
-              |  m_taskQueue     |       |  (互斥锁等)      |
+              |  m_taskQueues    |       |  (互斥锁等)      |
               | (线程安全共享)   |       +------------------+
               +------------------+
 
@@ -86,8 +90,9 @@
    - 保持线程活跃状态
 
 5. 回调协程 (Callback Coroutine):
-   - 用于执行 std::function 回调函数
-   - 可复用以减少协程创建开销
+   - 用于执行 TaskFunction 回调函数（小对象内联存储，投递时不分配堆内存）
+   - 可复用以减少协程创建开销，需要新建时从线程本地协程池(Coroutine::Acquire)获取，
+     已结束的任务协程由 Coroutine::Recycle 放回池中
    - 执行完回调后根据状态处理后续逻辑
 
 线程执行流程：
@@ -105,6 +110,22 @@
 统一的调度模型:
   所有线程(包括调用线程和工作线程)都执行相同的 run 方法，
   从共享任务队列中竞争获取任务执行，实现了统一的工作线程模型。
+
+工作窃取模式 (QueueMode::WORK_STEALING):
+  每个工作线程拥有一个 Chase-Lev 无锁双端队列和一个指定线程任务收件箱。
+  - 工作线程内部 schedule 的任务压入自身队列底部，无需加锁
+  - 外部线程 schedule 的任务进入共享注入队列 m_taskQueues
+  - 指定了线程ID的任务进入目标线程的收件箱
+  取任务顺序: 收件箱 -> 本地队列 -> 注入队列 -> 从随机线程的队列顶部窃取
+
+优先级 (Priority):
+  任务分为 realtime / normal / background 三个优先级，共享队列按优先级分为三条链表。
+  每个线程按权重轮转(默认 8:4:1，配置项 scheduler.priority_weights)：一轮中各优先级
+  最多取权重个任务，高优先级的额度用完或为空时才轮到低优先级，background 不会被饿死。
+  任务可带期限(deadline)，过期后回调任务可直接丢弃，其余降级到 background。
+  工作窃取模式下只有无期限的 normal 任务进入本地队列，本地队列视为 normal 参与轮转。
+  协程记录所属任务的优先级(Coroutine::setPriority)，IO等待、定时器或让出后重新入队时沿用。
+  每个优先级统计从入队到被取出的调度延迟直方图，dump 输出 p50/p99/max。
  */
 
 namespace CIM
@@ -121,13 +142,74 @@ namespace CIM
         /// 互斥锁类型定义
         using MutexType = Mutex;
 
+        /**
+         * @brief 任务队列模式
+         */
+        enum QueueMode
+        {
+            GLOBAL = 0,       /// 全局共享队列 - 所有线程竞争同一把锁下的任务链表
+            WORK_STEALING = 1 /// 工作窃取 - 每线程无锁本地队列，空闲时从其他线程窃取
+        };
+
+        /**
+         * @brief 任务优先级
+         */
+        enum Priority
+        {
+            REALTIME = 0,  /// 延迟敏感任务，如WebSocket心跳与消息投递
+            NORMAL = 1,    /// 默认优先级
+            BACKGROUND = 2 /// 耗时且不敏感的任务，如批量查询
+        };
+
+        /// 优先级数量
+        static const int kPriorityCount = 3;
+
+        /**
+         * @brief 任务调度属性
+         */
+        struct TaskAttr
+        {
+            Priority priority; /// 优先级
+            uint64_t deadline; /// 期限(毫秒)，从入队开始计算，0表示不设置
+            bool dropExpired;  /// 过期后是否丢弃；协程任务不会被丢弃，总是降级到background
+            pid_t thread;      /// 指定执行线程，-1表示任意线程
+
+            /**
+             * @brief 构造函数
+             * @param[in] p 优先级
+             * @param[in] deadline_ms 期限(毫秒)，0表示不设置
+             * @param[in] drop 过期后是否丢弃，否则降级到background
+             * @param[in] tid 指定执行线程
+             */
+            explicit TaskAttr(Priority p = NORMAL, uint64_t deadline_ms = 0, bool drop = false, pid_t tid = -1)
+                : priority(p), deadline(deadline_ms), dropExpired(drop), thread(tid)
+            {
+            }
+        };
+
+        /**
+         * @brief 单个优先级的调度统计
+         */
+        struct PriorityStats
+        {
+            uint64_t count = 0;   /// 已取出的任务数
+            uint64_t p50 = 0;     /// 调度延迟中位数(微秒)
+            uint64_t p99 = 0;     /// 调度延迟p99(微秒)
+            uint64_t max = 0;     /// 最大调度延迟(微秒)
+            uint64_t dropped = 0; /// 过期丢弃的任务数
+            uint64_t demoted = 0; /// 过期降级的任务数
+        };
+
         /**
          * @brief 构造函数
          * @param[in] threads 线程数量，默认为1
          * @param[in] use_caller 是否使用调用线程作为调度线程，默认为true
          * @param[in] name 调度器名称，默认为空
+         * @param[in] mode 任务队列模式，默认为全局共享队列
+         * @param[in] affinity 工作线程的CPU亲和性与NUMA内存策略，默认不设置
          */
-        Scheduler(size_t threads = 1, bool use_caller = true, const std::string &name = "");
+        Scheduler(size_t threads = 1, bool use_caller = true, const std::string &name = "",
+                  QueueMode mode = GLOBAL, const ThreadAffinity &affinity = ThreadAffinity());
 
         /**
          * @brief 析构函数
@@ -140,6 +222,66 @@ namespace CIM
          */
         const std::string &getName() const;
 
+        /**
+         * @brief 获取任务队列模式
+         * @return QueueMode 任务队列模式
+         */
+        QueueMode getQueueMode() const { return m_queueMode; }
+
+        /**
+         * @brief 获取工作线程的放置策略
+         * @return const ThreadAffinity& 放置策略
+         */
+        const ThreadAffinity &getAffinity() const { return m_affinity; }
+
+        /**
+         * @brief 获取工作线程ID列表，顺序与线程序号一致（使用调用线程时首个为调用线程）
+         * @pre 调度器已启动
+         * @return const std::vector<pid_t>& 线程ID列表
+         */
+        const std::vector<pid_t> &getThreadIds() const { return m_threadIds; }
+
+        /**
+         * @brief 任务队列模式转字符串
+         * @param[in] mode 任务队列模式
+         * @return const char* 模式名称
+         */
+        static const char *QueueModeToString(QueueMode mode);
+
+        /**
+         * @brief 字符串转任务队列模式
+         * @param[in] str 模式名称（global / work_steal）
+         * @return QueueMode 无法识别时返回GLOBAL
+         */
+        static QueueMode QueueModeFromString(const std::string &str);
+
+        /**
+         * @brief 优先级转字符串
+         * @param[in] priority 优先级
+         * @return const char* realtime / normal / background
+         */
+        static const char *PriorityToString(Priority priority);
+
+        /**
+         * @brief 字符串转优先级
+         * @param[in] str 优先级名称
+         * @return Priority 无法识别时返回NORMAL
+         */
+        static Priority PriorityFromString(const std::string &str);
+
+        /**
+         * @brief 获取某个优先级的调度统计
+         * @param[in] priority 优先级
+         * @return PriorityStats 统计快照
+         */
+        PriorityStats getPriorityStats(Priority priority) const;
+
+        /**
+         * @brief 获取等待执行的任务数（共享队列、本地队列与收件箱之和），无锁的近似值
+         * @return size_t 任务数
+         */
+        size_t getQueuedTaskCount() const;
+
         /**
          * @brief 获取当前线程的调度器实例
          * @return Scheduler* 当前线程的调度器实例
@@ -172,9 +314,14 @@ namespace CIM
         void schedule(CoroutineOrcb cb, uint64_t tid = -1)
         {
             bool need_tickle = false; // 用于标记是否需要唤醒工作线程
+            if (m_queueMode == WORK_STEALING)
+            {
+                need_tickle = scheduleStealing(Task(std::move(cb), tid));
+            }
+            else
             {
                 MutexType::Lock lock(m_mutex);
-                need_tickle = scheduleNolock(cb, tid);
+                need_tickle = scheduleNolock(std::move(cb), tid);
             }
             if (need_tickle)
             {
@@ -182,6 +329,32 @@ namespace CIM
             }
         }
 
+        /**
+         * @brief 按指定优先级、期限调度单个协程或回调函数
+         *
+         * @param cb 要调度的协程或回调函数
+         * @param attr 调度属性
+         */
+        template <class CoroutineOrcb>
+        void schedule(CoroutineOrcb cb, const TaskAttr &attr)
+        {
+            Task task(std::move(cb), attr.thread);
+            scheduleTask(std::move(task), attr);
+        }
+
+        /**
+         * @brief 按指定优先级调度单个协程或回调函数
+         * @details 单独提供该重载，避免优先级被隐式转换为线程ID匹配到 schedule(cb, tid)
+         *
+         * @param cb 要调度的协程或回调函数
+         * @param priority 优先级
+         */
+        template <class CoroutineOrcb>
+        void schedule(CoroutineOrcb cb, Priority priority)
+        {
+            schedule(std::move(cb), TaskAttr(priority));
+        }
+
         /**
          * @brief 用于批量调度协程或回调函数
          *
@@ -192,6 +365,15 @@ namespace CIM
         void schedule(InputIterator begin, InputIterator end)
         {
             bool need_tickle = false; // 用于标记是否需要唤醒工作线程
+            if (m_queueMode == WORK_STEALING)
+            {
+                while (begin != end)
+                {
+                    need_tickle = scheduleStealing(Task(&*begin, -1)) || need_tickle;
+                    ++begin;
+                }
+            }
+            else
             {
                 MutexType::Lock lock(m_mutex);
                 while (begin != end)
@@ -218,7 +400,7 @@ namespace CIM
          * @param os 输出流
          * @return std::ostream& 输出流
          */
-        std::ostream &dump(std::ostream &os);
+        virtual std::ostream &dump(std::ostream &os);
 
     protected:
         /**
@@ -253,6 +435,15 @@ namespace CIM
          */
         bool hasIdleThreads();
 
+        /**
+         * @brief 一次加锁批量调度协程与回调
+         * @details 供事件循环把一轮中就绪的协程与到期的定时器回调一起入队，最多唤醒一次。
+         *          元素被移入任务队列后清空两个容器，容器保留容量以便下一轮复用。
+         * @param[in,out] coroutines 待调度的协程
+         * @param[in,out] cbs 待调度的回调
+         */
+        void scheduleBatch(std::vector<Coroutine::ptr> &coroutines, std::vector<std::function<void()>> &cbs);
+
     private:
         /**
          * @brief 用于在不加锁的情况下将协程或回调函数添加到调度队列中
@@ -267,11 +458,11 @@ namespace CIM
         {
             // 如果队列不为空，说明有其他任务正在等待处理，工作线程应该已经在运行或即将运行
             // 如果队列为空，工作线程可能处于空闲状态，需要主动唤醒以处理新任务
-            bool need_tickle = m_taskQueue.empty();
-            Task task(cb, tid);
+            bool need_tickle = taskQueueEmptyNolock();
+            Task task(std::move(cb), tid);
             if (task.coroutine || task.cb)
             {
-                m_taskQueue.push_back(task);
+                pushTaskNolock(std::move(task));
             }
             return need_tickle;
         }
@@ -284,17 +475,26 @@ namespace CIM
         struct Task
         {
             Coroutine::ptr coroutine; ///< 协程智能指针，存储待执行的协程对象
-            std::function<void()> cb; ///< 回调函数，存储待执行的普通函数对象
+            TaskFunction cb;          ///< 回调函数，小对象直接内联存储，不额外分配堆内存
             pid_t threadId;           ///< 线程ID，指定该任务应在哪个线程上执行，-1表示任意线程
+            uint8_t priority = NORMAL; ///< 优先级
+            bool dropExpired = false;  ///< 过期后是否丢弃
+            uint64_t enqueueUs = 0;    ///< 入队时间(微秒)，用于统计调度延迟
+            uint64_t deadlineUs = 0;   ///< 过期时间(微秒)，0表示不设置
 
             /**
              * @brief 构造函数，使用协程指针和线程ID初始化
+             * @details 优先级沿用协程上次执行时的优先级，IO与定时器唤醒不会把协程降为normal
              * @param[in] c 协程智能指针
              * @param[in] tid 线程ID
              */
             Task(Coroutine::ptr c, uint64_t tid)
                 : coroutine(c), threadId(tid)
             {
+                if (coroutine)
+                {
+                    priority = coroutine->getPriority();
+                }
             }
 
             /**
@@ -306,6 +506,10 @@ namespace CIM
                 : threadId(tid)
             {
                 coroutine.swap(*c);
+                if (coroutine)
+                {
+                    priority = coroutine->getPriority();
+                }
             }
 
             /**
@@ -313,8 +517,8 @@ namespace CIM
              * @param[in] f 回调函数
              * @param[in] tid 线程ID
              */
-            Task(std::function<void()> f, uint64_t tid)
-                : cb(f), threadId(tid)
+            Task(TaskFunction f, uint64_t tid)
+                : cb(std::move(f)), threadId(tid)
             {
             }
 
@@ -324,9 +528,19 @@ namespace CIM
              * @param[in] tid 线程ID
              */
             Task(std::function<void()> *f, uint64_t tid)
-                : threadId(tid)
+                : cb(std::move(*f)), threadId(tid)
+            {
+                *f = nullptr;
+            }
+
+            /**
+             * @brief 构造函数，使用回调函数引用和线程ID初始化
+             * @param[in] f 回调函数引用
+             * @param[in] tid 线程ID
+             */
+            Task(TaskFunction *f, uint64_t tid)
+                : cb(std::move(*f)), threadId(tid)
             {
-                cb.swap(*f);
             }
 
             /**
@@ -345,15 +559,148 @@ namespace CIM
                 coroutine = nullptr;
                 cb = nullptr;
                 threadId = -1;
+                priority = NORMAL;
+                dropExpired = false;
+                enqueueUs = 0;
+                deadlineUs = 0;
             }
         };
 
+        /**
+         * @brief 工作窃取模式下每个工作线程的任务队列
+         */
+        struct WorkerQueue
+        {
+            WorkStealQueue<Task *> local;        ///< 本地无锁双端队列，仅拥有者线程push/pop
+            MutexType mutex;                     ///< 保护收件箱
+            std::list<Task> pinned;              ///< 指定由该线程执行的任务收件箱
+            std::atomic<size_t> pinnedCount{0};  ///< 收件箱任务数，用于无锁快速判断
+            std::atomic<pid_t> threadId{-1};     ///< 拥有者线程ID，线程进入run后设置
+        };
+
+        /**
+         * @brief 工作窃取模式下将任务放入合适的队列
+         * @details 指定线程的任务进入目标线程收件箱；当前线程属于本调度器时压入本地队列；
+         *          否则进入共享注入队列
+         * @param[in] task 待调度的任务
+         * @return true 需要唤醒工作线程
+         */
+        bool scheduleStealing(Task &&task);
+
+        /**
+         * @brief 按调度属性放入队列并在需要时唤醒工作线程
+         * @param[in] task 待调度的任务
+         * @param[in] attr 调度属性
+         */
+        void scheduleTask(Task &&task, const TaskAttr &attr);
+
+        /**
+         * @brief 共享队列是否为空，调用方需持有m_mutex
+         */
+        bool taskQueueEmptyNolock() const;
+
+        /**
+         * @brief 将任务追加到共享队列尾部，调用方需持有m_mutex
+         * @details 链表节点优先从当前线程的空闲节点缓存中摘取，避免每次入队分配内存
+         * @param[in] task 待调度的任务
+         */
+        void pushTaskNolock(Task &&task);
+
+        /**
+         * @brief 从共享队列取出一个任务，调用方需持有m_mutex
+         * @details 取出后的链表节点放入当前线程的空闲节点缓存
+         * @param[in] queue 任务所在的优先级队列
+         * @param[in] it 任务所在位置
+         * @param[out] task 取出的任务
+         */
+        void takeTaskNolock(std::list<Task> &queue, std::list<Task>::iterator it, Task &task);
+
+        /**
+         * @brief 从指定优先级的共享队列中取出当前线程可执行的第一个任务，调用方需持有m_mutex
+         * @details 过期任务按其属性移入 expired（丢弃）或 background 队列尾部（降级）
+         * @param[in] priority 优先级
+         * @param[in] now 当前时间(微秒)
+         * @param[out] task 取出的任务
+         * @param[out] tickle_me 存在指定给其他线程的任务时置为true
+         * @param[out] expired 被丢弃的任务，由调用方在释放锁后销毁
+         * @return 是否取到任务
+         */
+        bool takePriorityNolock(int priority, uint64_t now, Task &task, bool &tickle_me,
+                                std::list<Task> &expired);
+
+        /**
+         * @brief 按权重轮转从共享队列取出一个任务，调用方需持有m_mutex（全局队列模式）
+         * @param[in] now 当前时间(微秒)
+         * @param[out] task 取出的任务
+         * @param[out] tickle_me 存在指定给其他线程的任务时置为true
+         * @param[out] expired 被丢弃的任务，由调用方在释放锁后销毁
+         * @return 是否取到任务
+         */
+        bool selectTaskNolock(uint64_t now, Task &task, bool &tickle_me, std::list<Task> &expired);
+
+        /**
+         * @brief 销毁过期丢弃的任务，链表节点归还当前线程缓存；不能持有m_mutex调用
+         * @param[in] expired 被丢弃的任务
+         */
+        static void ReleaseExpired(std::list<Task> &expired);
+
+        /**
+         * @brief 当前线程缓存的空闲链表节点
+         */
+        static std::list<Task> &FreeTaskNodes();
+
+        /**
+         * @brief 当前线程缓存的空闲任务对象（工作窃取队列使用）
+         */
+        static std::vector<std::unique_ptr<Task>> &FreeTasks();
+
+        /**
+         * @brief 为工作窃取队列分配任务对象，优先复用当前线程缓存
+         * @param[in] task 待调度的任务
+         */
+        static Task *NewTask(Task &&task);
+
+        /**
+         * @brief 取出任务对象中的内容并将其归还到当前线程缓存
+         * @param[in] t 任务对象
+         * @param[out] task 取出的任务
+         */
+        static void ReleaseTask(Task *t, Task &task);
+
+        /**
+         * @brief 工作窃取模式下获取一个可执行任务
+         * @param[out] task 取到的任务
+         * @param[out] tickle_me 是否存在需要其他线程处理的任务
+         * @param[in] now 当前时间(微秒)，用于判断共享队列中的任务是否过期
+         * @return true 成功取到任务
+         */
+        bool takeTaskStealing(Task &task, bool &tickle_me, uint64_t now);
+
+        /**
+         * @brief 根据线程ID查找工作线程队列
+         * @param[in] tid 线程ID
+         * @return WorkerQueue* 找不到（线程尚未进入run）时返回nullptr
+         */
+        WorkerQueue *findWorkerQueue(pid_t tid);
+
     private:
         MutexType m_mutex;                  ///< 互斥锁，保护协程队列和线程安全
         std::vector<Thread::ptr> m_threads; ///< 线程池，存储所有工作线程
-        std::list<Task> m_taskQueue;        ///< 待执行的协程队列，存储待调度的协程和回调函数
+        std::list<Task> m_taskQueues[kPriorityCount]; ///< 按优先级划分的共享任务队列，存储待调度的协程和回调函数
         Coroutine::ptr m_rootCoroutine;     ///< 主协程，调度器的根协程，负责调度其他协程
         std::string m_name;                 ///< 协程调度器的名称
+        QueueMode m_queueMode;              ///< 任务队列模式
+        ThreadAffinity m_affinity;          ///< 工作线程的CPU亲和性与NUMA内存策略
+        std::atomic<size_t> m_nextAffinityIndex = {0}; ///< 下一个进入run的工作线程在pin模式下的序号
+
+        std::vector<WorkerQueue *> m_workerQueues;      ///< 工作窃取模式下每个线程的队列
+        std::atomic<size_t> m_nextWorkerIndex = {0};    ///< 下一个进入run的线程分配到的队列下标
+        std::atomic<size_t> m_stealingTaskCount = {0};  ///< 本地队列与收件箱中的任务总数
+
+        std::atomic<size_t> m_queuedCount[kPriorityCount];    ///< 各优先级共享队列的任务数，用于无锁跳过空队列
+        LatencyHistogram m_delayHist[kPriorityCount];         ///< 各优先级的调度延迟直方图
+        std::atomic<uint64_t> m_expiredDropped[kPriorityCount]; ///< 各优先级过期丢弃的任务数
+        std::atomic<uint64_t> m_expiredDemoted[kPriorityCount]; ///< 各优先级过期降级的任务数
 
     protected:
         std::vector<pid_t> m_threadIds;                ///< 线程ID列表，存储工作线程的ID
@@ -0,0 +1,251 @@
+/**
+ * @file task_function.hpp
+ * @brief 带小对象优化的任务回调封装
+ * @author CIM
+ *
+ * TaskFunction 与 std::function<void()> 语义一致（可拷贝、可移动、可判空），
+ * 区别在于内联缓冲区更大：libstdc++ 的 std::function 只能内联存放 16 字节且
+ * 可平凡拷贝的对象，捕获一个 shared_ptr 的 lambda 或 std::bind 都会落到堆上。
+ * TaskFunction 可以内联存放 kInlineSize 字节以内、移动构造不抛异常的可调用对象，
+ * 调度器投递此类任务时不再为回调本身分配堆内存。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace CIM
+{
+    /**
+     * @brief 无参无返回值的可调用对象封装，内置小对象缓冲区
+     */
+    class TaskFunction
+    {
+    public:
+        /// 内联缓冲区大小，足以容纳捕获若干智能指针的lambda和常见的std::bind结果
+        static const size_t kInlineSize = 64;
+
+        /**
+         * @brief 构造空回调
+         */
+        TaskFunction() {}
+
+        /**
+         * @brief 构造空回调
+         */
+        TaskFunction(std::nullptr_t) {}
+
+        /**
+         * @brief 由任意可调用对象构造
+         * @param[in] f 可调用对象，空的函数指针或std::function得到空回调
+         */
+        template <class F, class D = typename std::decay<F>::type,
+                  class = typename std::enable_if<!std::is_same<D, TaskFunction>::value>::type,
+                  class = decltype(std::declval<D &>()())>
+        TaskFunction(F &&f)
+        {
+            if (!IsNull(f))
+            {
+                init<D>(std::forward<F>(f), FitsInline<D>());
+            }
+        }
+
+        TaskFunction(const TaskFunction &other)
+        {
+            if (other.m_ops)
+            {
+                other.m_ops->copy(&other.m_storage, &m_storage);
+                m_ops = other.m_ops;
+            }
+        }
+
+        TaskFunction(TaskFunction &&other) noexcept
+        {
+            moveFrom(other);
+        }
+
+        ~TaskFunction()
+        {
+            clear();
+        }
+
+        TaskFunction &operator=(const TaskFunction &other)
+        {
+            if (this != &other)
+            {
+                TaskFunction tmp(other);
+                clear();
+                moveFrom(tmp);
+            }
+            return *this;
+        }
+
+        TaskFunction &operator=(TaskFunction &&other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        TaskFunction &operator=(std::nullptr_t)
+        {
+            clear();
+            return *this;
+        }
+
+        template <class F, class D = typename std::decay<F>::type,
+                  class = typename std::enable_if<!std::is_same<D, TaskFunction>::value>::type,
+                  class = decltype(std::declval<D &>()())>
+        TaskFunction &operator=(F &&f)
+        {
+            TaskFunction tmp(std::forward<F>(f));
+            clear();
+            moveFrom(tmp);
+            return *this;
+        }
+
+        /**
+         * @brief 调用回调，空回调抛出std::bad_function_call
+         */
+        void operator()() const
+        {
+            if (!m_ops)
+            {
+                throw std::bad_function_call();
+            }
+            m_ops->invoke(&m_storage);
+        }
+
+        /**
+         * @brief 是否非空
+         */
+        explicit operator bool() const { return m_ops != nullptr; }
+
+        /**
+         * @brief 交换两个回调
+         */
+        void swap(TaskFunction &other)
+        {
+            TaskFunction tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        /**
+         * @brief 回调是否存放在内联缓冲区中（未分配堆内存）
+         */
+        bool isInline() const { return m_ops && m_ops->is_inline; }
+
+    private:
+        using Storage = typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type;
+
+        /**
+         * @brief 按存储方式分派的操作表
+         */
+        struct Ops
+        {
+            void (*invoke)(void *p);
+            void (*copy)(const void *src, void *dst);
+            void (*move)(void *src, void *dst); ///< 移动到dst并销毁src
+            void (*destroy)(void *p);
+            bool is_inline;
+        };
+
+        template <class D>
+        struct InlineOps
+        {
+            static void invoke(void *p) { (*static_cast<D *>(p))(); }
+            static void copy(const void *src, void *dst) { new (dst) D(*static_cast<const D *>(src)); }
+            static void move(void *src, void *dst)
+            {
+                new (dst) D(std::move(*static_cast<D *>(src)));
+                static_cast<D *>(src)->~D();
+            }
+            static void destroy(void *p) { static_cast<D *>(p)->~D(); }
+            static const Ops ops;
+        };
+
+        template <class D>
+        struct HeapOps
+        {
+            static void invoke(void *p) { (**static_cast<D **>(p))(); }
+            static void copy(const void *src, void *dst)
+            {
+                *static_cast<D **>(dst) = new D(**static_cast<D *const *>(src));
+            }
+            static void move(void *src, void *dst) { *static_cast<D **>(dst) = *static_cast<D **>(src); }
+            static void destroy(void *p) { delete *static_cast<D **>(p); }
+            static const Ops ops;
+        };
+
+        /// 满足大小、对齐且移动构造不抛异常的对象才内联存放
+        template <class D>
+        struct FitsInline
+            : std::integral_constant<bool, sizeof(D) <= kInlineSize &&
+                                               alignof(D) <= alignof(Storage) &&
+                                               std::is_nothrow_move_constructible<D>::value>
+        {
+        };
+
+        template <class D, class F>
+        void init(F &&f, std::true_type)
+        {
+            new (&m_storage) D(std::forward<F>(f));
+            m_ops = &InlineOps<D>::ops;
+        }
+
+        template <class D, class F>
+        void init(F &&f, std::false_type)
+        {
+            *reinterpret_cast<D **>(&m_storage) = new D(std::forward<F>(f));
+            m_ops = &HeapOps<D>::ops;
+        }
+
+        template <class F>
+        static bool IsNull(const F &) { return false; }
+        template <class R>
+        static bool IsNull(R (*const &f)()) { return f == nullptr; }
+        template <class R>
+        static bool IsNull(const std::function<R()> &f) { return !f; }
+
+        void moveFrom(TaskFunction &other)
+        {
+            if (other.m_ops)
+            {
+                other.m_ops->move(&other.m_storage, &m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+
+        void clear()
+        {
+            if (m_ops)
+            {
+                m_ops->destroy(&m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    private:
+        mutable Storage m_storage;   ///< 内联对象或指向堆上对象的指针
+        const Ops *m_ops = nullptr;  ///< 为空表示空回调
+    };
+
+    template <class D>
+    const TaskFunction::Ops TaskFunction::InlineOps<D>::ops = {
+        &TaskFunction::InlineOps<D>::invoke, &TaskFunction::InlineOps<D>::copy,
+        &TaskFunction::InlineOps<D>::move, &TaskFunction::InlineOps<D>::destroy, true};
+
+    template <class D>
+    const TaskFunction::Ops TaskFunction::HeapOps<D>::ops = {
+        &TaskFunction::HeapOps<D>::invoke, &TaskFunction::HeapOps<D>::copy,
+        &TaskFunction::HeapOps<D>::move, &TaskFunction::HeapOps<D>::destroy, false};
+}
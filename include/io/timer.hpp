@@ -5,13 +5,17 @@
  * @date 2025-10-24
  * 
  * 该模块实现了基于时间事件的定时器功能，支持一次性定时器和周期性定时器。
- * 定时器使用最小堆(std::set)进行管理，通过回调函数的方式处理超时事件。
+ * 定时器有两种管理方式，由配置 timer.type 在TimerManager构造时选择：
+ * - wheel（默认）：分层时间轮，毫秒精度，插入/取消O(1)；每个IO线程一个分片，
+ *   外部线程共用一个共享分片，IO线程上的超时定时器只竞争本线程的分片锁
+ * - set：按执行时间排序的std::set，所有线程共用一把读写锁
  * Timer类表示单个定时器实例，TimerManager类负责管理多个定时器。
  */
 
  #pragma once
 
 #include "lock.hpp"
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <set>
@@ -20,6 +24,7 @@
 namespace CIM
 {
     class TimerManager;
+    class TimerWheel;
 
     /**
      * @brief 定时器类
@@ -30,6 +35,7 @@ namespace CIM
     class Timer : public std::enable_shared_from_this<Timer>, public Noncopyable
     {
         friend class TimerManager;
+        friend class TimerWheel;
 
     public:
         /// 智能指针类型定义
@@ -65,7 +71,7 @@ namespace CIM
          */
         bool reset(uint64_t ms, bool from_now);
 
-    private:
+    protected:
         /**
          * @brief 构造函数
          * 
@@ -104,6 +110,22 @@ namespace CIM
         /// 定时器管理器指针
         TimerManager *m_manager = nullptr;
 
+        /// 所在的时间轮分片（时间轮模式），在分片间迁移期间短暂为nullptr
+        std::atomic<TimerWheel *> m_wheel{nullptr};
+
+        /// 所在时间轮层级，-1表示未挂在任何槽上
+        int8_t m_wheelLevel = -1;
+
+        /// 所在槽下标
+        uint8_t m_wheelSlot = 0;
+
+        /// 槽内双向链表指针
+        Timer *m_wheelPrev = nullptr;
+        Timer *m_wheelNext = nullptr;
+
+        /// 挂在时间轮上时持有自身引用，与std::set持有Timer::ptr的语义一致
+        Timer::ptr m_wheelRef;
+
     private:
         /**
          * @brief 定时器比较仿函数
@@ -134,11 +156,22 @@ namespace CIM
     class TimerManager : public Noncopyable
     {
         friend class Timer;
+        friend class TimerWheel;
 
     public:
         /// 读写锁类型定义
         using RWMutexType = RWMutex;
 
+        /**
+         * @brief 定时器操作计数
+         */
+        struct TimerStats
+        {
+            uint64_t added = 0;     ///< 添加次数
+            uint64_t cancelled = 0; ///< 成功取消次数
+            uint64_t expired = 0;   ///< 到期触发次数（周期定时器每次触发都计数）
+        };
+
         /**
          * @brief 构造函数
          */
@@ -147,7 +180,7 @@ namespace CIM
         /**
          * @brief 析构函数
          */
-        virtual ~TimerManager()=default;
+        virtual ~TimerManager();
 
         /**
          * @brief 添加定时器
@@ -186,6 +219,15 @@ namespace CIM
          */
         uint64_t getNextTimer();
 
+        /**
+         * @brief 获取距离最近定时器执行的时间(纳秒)
+         * 
+         * 按定时器所用时钟精确计算到期时刻，不受当前时间毫秒取整的影响，供纳秒精度的等待使用。
+         * 
+         * @return uint64_t 距离最近定时器执行的时间(纳秒)，如果无定时器则返回~0ull
+         */
+        uint64_t getNextTimerNS();
+
         /**
          * @brief 获取并处理超时的定时器回调
          * 
@@ -202,6 +244,16 @@ namespace CIM
          */
         bool hasTimer();
 
+        /**
+         * @brief 是否使用时间轮实现
+         */
+        bool isTimerWheel() const { return m_useWheel; }
+
+        /**
+         * @brief 获取定时器操作计数
+         */
+        TimerStats getTimerStats();
+
     protected:
         /**
          * @brief 当有定时器被插入到队列头部时调用
@@ -218,6 +270,52 @@ namespace CIM
          */
         void addTimer(Timer::ptr val, RWMutexType::WriteLock &lock);
 
+        /**
+         * @brief 为工作线程创建时间轮分片
+         *
+         * 须在工作线程启动前调用；set实现下为空操作。
+         *
+         * @param count 分片数量（工作线程数）
+         */
+        void initTimerWheels(size_t count);
+
+        /**
+         * @brief 将当前线程绑定到一个时间轮分片
+         *
+         * 绑定后该线程添加/刷新的定时器进入自己的分片，由自己负责到期处理。
+         * 分片用尽时不绑定，线程退回到共享分片。
+         */
+        void bindTimerWheel();
+
+        /**
+         * @brief 解除当前线程的分片绑定
+         */
+        void unbindTimerWheel();
+
+    private:
+        /**
+         * @brief 定时器起算时间(毫秒)，时间轮使用向上取整的单调时钟，set使用系统时间
+         */
+        uint64_t currentMS() const;
+
+        /**
+         * @brief 最近定时器的到期时刻(毫秒，与currentMS同一时钟)，无定时器返回~0ull
+         */
+        uint64_t nextExpire();
+
+        /**
+         * @brief 当前线程应当使用的分片：已绑定的自有分片，否则为共享分片
+         */
+        TimerWheel *selectWheel() const;
+
+        /**
+         * @brief 将已从旧分片摘下的定时器挂到当前线程的分片上
+         *
+         * @param timer 定时器
+         * @param locked 已加锁的旧分片，函数内解锁
+         */
+        void relinkTimer(Timer *timer, TimerWheel *locked);
+
     private:
         /**
          * @brief 检测系统时钟是否回退
@@ -241,5 +339,20 @@ namespace CIM
         
         /// 上次检查时间，用于检测系统时钟回退
         uint64_t m_previouseTime = 0;
+
+        /// set实现下的操作计数，受m_mutex保护
+        TimerStats m_stats;
+
+        /// 是否使用时间轮
+        bool m_useWheel = false;
+
+        /// 时间轮分片，[0]为共享分片，其余按工作线程绑定
+        std::vector<TimerWheel *> m_wheels;
+
+        /// 下一个待绑定的分片下标
+        std::atomic<size_t> m_nextWheel{1};
+
+        /// 所有分片中的定时器总数
+        std::atomic<size_t> m_wheelCount{0};
     };
 }
\ No newline at end of file
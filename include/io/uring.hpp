@@ -0,0 +1,113 @@
+/**
+ * @file uring.hpp
+ * @brief io_uring 提交/完成队列的最小封装
+ * @author CIM
+ *
+ * 直接使用 io_uring_setup / io_uring_enter 系统调用与 mmap 的共享队列，不依赖liburing。
+ * 本类只负责队列本身，不做任何同步：提交队列与完成队列分别由调用者加锁保护
+ * （IOManager 中多个线程共享一个实例）。
+ *
+ * 内核不支持 io_uring、被 io_uring_disabled 禁用或缺少所需操作码时 Create 返回空，
+ * 调用者回退到 epoll。
+ */
+
+#pragma once
+
+#include "noncopyable.hpp"
+#include <linux/io_uring.h>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace CIM
+{
+    class IoUring : public Noncopyable
+    {
+    public:
+        using ptr = std::unique_ptr<IoUring>;
+
+        /**
+         * @brief 创建io_uring实例
+         * @param[in] entries 提交队列长度（向上取整为2的幂），完成队列为其两倍
+         * @param[in] opcodes 必须支持的操作码
+         * @return ptr 不支持时返回空
+         */
+        static ptr Create(uint32_t entries, const std::vector<uint8_t> &opcodes);
+
+        ~IoUring();
+
+        /**
+         * @brief io_uring的文件描述符，完成队列非空时可读，可加入epoll
+         */
+        int getFd() const { return m_fd; }
+
+        /**
+         * @brief 提交队列剩余空位
+         */
+        uint32_t space() const;
+
+        /**
+         * @brief 取一个空闲的SQE并清零，需先用space()确认有空位
+         */
+        io_uring_sqe *getSqe();
+
+        /**
+         * @brief 已填写但尚未提交给内核的SQE数量
+         */
+        uint32_t pending() const { return m_sqeTail - m_submitted; }
+
+        /**
+         * @brief 将已填写的SQE提交给内核（一次io_uring_enter）
+         * @return int 提交的数量，失败时为 -errno
+         */
+        int submit();
+
+        /**
+         * @brief 逐个取出完成队列中的CQE
+         * @param[in] cb 回调，参数为CQE
+         * @return size_t 取出的数量
+         */
+        template <typename Callback>
+        size_t reap(Callback cb)
+        {
+            uint32_t head = *m_cqHead;
+            uint32_t tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            size_t count = 0;
+            while (head != tail)
+            {
+                cb(m_cqes[head & m_cqMask]);
+                ++head;
+                ++count;
+                if (head == tail)
+                {
+                    // 回调期间可能有新的完成，一并取出
+                    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+                    tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+                }
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+            return count;
+        }
+
+    private:
+        IoUring() = default;
+
+    private:
+        int m_fd = -1;                    /// io_uring文件描述符
+        void *m_ring = nullptr;           /// 提交/完成队列的映射
+        size_t m_ringSize = 0;            /// 队列映射大小
+        io_uring_sqe *m_sqes = nullptr;   /// SQE数组的映射
+        size_t m_sqesSize = 0;            /// SQE数组映射大小
+        uint32_t *m_sqHead = nullptr;     /// 内核已消费的位置
+        uint32_t *m_sqTail = nullptr;     /// 已提交给内核的位置
+        uint32_t *m_sqArray = nullptr;    /// 提交队列索引数组
+        uint32_t m_sqMask = 0;            /// 提交队列掩码
+        uint32_t m_sqEntries = 0;         /// 提交队列长度
+        uint32_t m_sqeTail = 0;           /// 已填写的位置（尚未发布给内核）
+        uint32_t m_submitted = 0;         /// 已发布给内核的位置
+        uint32_t *m_cqHead = nullptr;     /// 已取出的位置
+        uint32_t *m_cqTail = nullptr;     /// 内核写入的位置
+        uint32_t m_cqMask = 0;            /// 完成队列掩码
+        io_uring_cqe *m_cqes = nullptr;   /// CQE数组
+    };
+}
@@ -0,0 +1,203 @@
+/**
+ * @file work_steal_queue.hpp
+ * @brief Chase-Lev 无锁工作窃取双端队列
+ * @author CIM
+ *
+ * 该文件实现了 Chase-Lev 工作窃取队列（参考 "Correct and Efficient Work-Stealing
+ * for Weak Memory Models", PPoPP'13）。队列的拥有者线程在底部(bottom)执行
+ * push/pop，其他线程只能在顶部(top)执行 steal，三者均无需加锁。
+ * 调度器在工作窃取模式下为每个工作线程分配一个该队列。
+ */
+
+#pragma once
+
+#include "noncopyable.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace CIM
+{
+    /**
+     * @brief 工作窃取队列
+     * @tparam T 元素类型，必须可平凡拷贝（通常为指针）
+     * @details push/pop 只能由拥有者线程调用，steal 可由任意线程调用。
+     *          队列满时自动扩容为原来的两倍，旧的环形数组保留到队列析构时才释放，
+     *          以保证并发 steal 读取旧数组时的内存安全。
+     */
+    template <class T>
+    class WorkStealQueue : public Noncopyable
+    {
+    private:
+        /**
+         * @brief 环形数组
+         */
+        struct Array
+        {
+            int64_t capacity;      ///< 容量（2的幂）
+            int64_t mask;          ///< 下标掩码
+            std::atomic<T> *items; ///< 元素存储
+
+            explicit Array(int64_t c)
+                : capacity(c), mask(c - 1), items(new std::atomic<T>[c])
+            {
+            }
+
+            ~Array()
+            {
+                delete[] items;
+            }
+
+            void put(int64_t i, T v)
+            {
+                items[i & mask].store(v, std::memory_order_relaxed);
+            }
+
+            T get(int64_t i)
+            {
+                return items[i & mask].load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief 扩容并拷贝 [t, b) 区间内的元素
+             */
+            Array *grow(int64_t b, int64_t t)
+            {
+                Array *a = new Array(capacity * 2);
+                for (int64_t i = t; i != b; ++i)
+                {
+                    a->put(i, get(i));
+                }
+                return a;
+            }
+        };
+
+    public:
+        /**
+         * @brief 构造函数
+         * @param[in] capacity 初始容量，必须为2的幂
+         */
+        explicit WorkStealQueue(int64_t capacity = 256)
+            : m_top(0), m_bottom(0), m_array(new Array(capacity))
+        {
+        }
+
+        ~WorkStealQueue()
+        {
+            for (auto a : m_garbage)
+            {
+                delete a;
+            }
+            delete m_array.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 压入元素（仅拥有者线程）
+         * @param[in] item 元素
+         */
+        void push(T item)
+        {
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_acquire);
+            Array *a = m_array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1)
+            {
+                Array *tmp = a->grow(b, t);
+                m_garbage.push_back(a);
+                a = tmp;
+                m_array.store(a, std::memory_order_release);
+            }
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 从底部弹出元素（仅拥有者线程，LIFO，缓存局部性更好）
+         * @param[out] item 弹出的元素
+         * @return 队列为空或与窃取者竞争失败时返回false
+         */
+        bool pop(T &item)
+        {
+            int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            Array *a = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // 队列为空，恢复 bottom
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = a->get(b);
+            if (t == b)
+            {
+                // 仅剩最后一个元素，需要与窃取者竞争
+                bool won = m_top.compare_exchange_strong(t, t + 1,
+                                                         std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /**
+         * @brief 从顶部窃取元素（任意线程，FIFO）
+         * @param[out] item 窃取到的元素
+         * @return 队列为空或竞争失败时返回false
+         */
+        bool steal(T &item)
+        {
+            int64_t t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = m_bottom.load(std::memory_order_acquire);
+
+            if (t >= b)
+            {
+                return false;
+            }
+
+            Array *a = m_array.load(std::memory_order_acquire);
+            T x = a->get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1,
+                                               std::memory_order_seq_cst,
+                                               std::memory_order_relaxed))
+            {
+                return false;
+            }
+            item = x;
+            return true;
+        }
+
+        /**
+         * @brief 队列是否为空（近似值，仅供参考）
+         */
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /**
+         * @brief 队列元素个数（近似值，仅供参考）
+         */
+        size_t size() const
+        {
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+            return b > t ? (size_t)(b - t) : 0;
+        }
+
+    private:
+        // top 与 bottom 分别由窃取者与拥有者频繁修改，用填充字节隔开避免伪共享
+        std::atomic<int64_t> m_top;                        ///< 窃取端下标
+        char m_pad0[64 - sizeof(std::atomic<int64_t>)];    ///< 缓存行填充
+        std::atomic<int64_t> m_bottom;                     ///< 拥有者端下标
+        char m_pad1[64 - sizeof(std::atomic<int64_t>)];    ///< 缓存行填充
+        std::atomic<Array *> m_array;                      ///< 当前环形数组
+        std::vector<Array *> m_garbage;                    ///< 扩容后淘汰的旧数组
+    };
+}
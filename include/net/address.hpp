@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <sys/socket.h>
@@ -21,6 +22,7 @@
 namespace CIM
 {
     class IPAddress;
+    class IOManager;
 
     /**
      * @brief 网络地址基类
@@ -44,6 +46,8 @@ namespace CIM
 
         /**
          * @brief 通过主机名解析出地址列表
+         * @details IP字面量直接转换；其他主机名由DnsResolver(DnsMgr)解析，
+         * 在IOManager的协程中调用时等待DNS应答只挂起当前协程，不会阻塞IO线程
          * @param[out] result 解析结果存储容器
          * @param[in] host 主机名，可以是域名或IP地址
          * @param[in] family 协议族，如AF_INET、AF_INET6等
@@ -54,6 +58,22 @@ namespace CIM
         static bool Lookup(std::vector<Address::ptr> &result, const std::string &host,
                            int family = AF_INET, int type = 0, int protocol = 0);
 
+        /**
+         * @brief 异步解析主机名
+         * @details 在iom上调度一个协程执行Lookup，完成后在该协程中回调cb；
+         * iom为空时使用当前线程的IOManager，都没有时同步解析后回调
+         * @param[in] host 主机名，格式同Lookup
+         * @param[in] cb 回调，参数为是否成功和地址列表
+         * @param[in] family 协议族
+         * @param[in] type socket类型
+         * @param[in] protocol 协议类型
+         * @param[in] iom 执行解析的调度器
+         */
+        static void LookupAsync(const std::string &host,
+                                std::function<void(bool, const std::vector<Address::ptr> &)> cb,
+                                int family = AF_INET, int type = 0, int protocol = 0,
+                                IOManager *iom = nullptr);
+
         /**
          * @brief 解析任意地址
          * @param[in] host 主机名
@@ -0,0 +1,170 @@
+/**
+ * @file dns.hpp
+ * @brief 非阻塞DNS解析器
+ *
+ * 直接向resolv.conf中的DNS服务器发送UDP查询，替代阻塞的getaddrinfo：
+ * 在IOManager的协程中调用时，等待应答期间挂起的是当前协程，线程继续处理其他任务；
+ * 在普通线程中调用时按SO_RCVTIMEO阻塞等待。
+ *
+ * 主要特性:
+ * - 优先查/etc/hosts，文件变化后自动重新加载
+ * - 按应答TTL缓存结果，NXDOMAIN/无记录按SOA的最小TTL做否定缓存
+ * - 同一名字的并发查询合并为一次，其余调用者等待首个调用者的结果
+ * - 支持resolv.conf的search/domain，多服务器依次重试
+ * - 没有可用的nameserver时退回getaddrinfo
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "address.hpp"
+#include "lock.hpp"
+#include "noncopyable.hpp"
+#include "singleton.hpp"
+
+namespace CIM
+{
+    /**
+     * @brief DNS解析器
+     * @details 全局实例见DnsMgr，Address::Lookup对非IP字面量的主机名使用它解析；
+     * 测试或特殊用途可以单独创建实例并通过setServers指定服务器
+     */
+    class DnsResolver : public Noncopyable
+    {
+    public:
+        typedef std::shared_ptr<DnsResolver> ptr;
+
+        /**
+         * @brief 解析统计
+         */
+        struct Stats
+        {
+            uint64_t hits = 0;         /// 命中肯定缓存
+            uint64_t negativeHits = 0; /// 命中否定缓存
+            uint64_t hostsHits = 0;    /// 命中hosts文件
+            uint64_t coalesced = 0;    /// 合并到进行中查询的调用
+            uint64_t queries = 0;      /// 发出的UDP查询数(含重试)
+            uint64_t timeouts = 0;     /// 等待应答超时次数
+            uint64_t failures = 0;     /// 解析失败的调用
+        };
+
+        /**
+         * @brief 构造函数，加载dns.resolv_conf与dns.hosts_file
+         */
+        DnsResolver();
+
+        /**
+         * @brief 解析主机名
+         * @param[in] name 主机名，IP字面量直接返回
+         * @param[in] family AF_INET查询A记录，AF_INET6查询AAAA记录，AF_UNSPEC两者都查
+         * @param[out] result 解析出的地址，端口为0
+         * @return 是否解析成功
+         */
+        bool resolve(const std::string &name, int family, std::vector<IPAddress::ptr> &result);
+
+        /**
+         * @brief 指定DNS服务器，替换resolv.conf中的nameserver
+         * @param[in] servers 服务器地址，未设置端口时使用53
+         */
+        void setServers(const std::vector<IPAddress::ptr> &servers);
+
+        /**
+         * @brief 获取当前使用的DNS服务器
+         */
+        std::vector<IPAddress::ptr> getServers();
+
+        /**
+         * @brief 加载resolv.conf中的nameserver和search/domain
+         * @param[in] path 文件路径
+         * @return 是否读取成功
+         */
+        bool loadResolvConf(const std::string &path);
+
+        /**
+         * @brief 加载hosts文件
+         * @param[in] path 文件路径
+         * @return 是否读取成功
+         */
+        bool loadHosts(const std::string &path);
+
+        /**
+         * @brief 解析主机名，返回第一个地址的字符串形式(不含端口)
+         * @details 供只接受主机名字符串的客户端库(MySQL、hiredis)预先解析，避免库内部的getaddrinfo阻塞线程
+         * @param[in] name 主机名
+         * @param[in] family 协议族
+         * @return 解析失败时返回原名字，由客户端库自行处理
+         */
+        std::string resolveToString(const std::string &name, int family = AF_INET);
+
+        /**
+         * @brief 清空解析缓存
+         */
+        void clearCache();
+
+        /**
+         * @brief 获取解析统计
+         */
+        Stats getStats() const;
+
+    private:
+        /// 缓存项，addrs为空表示否定缓存
+        struct CacheEntry
+        {
+            std::vector<IPAddress::ptr> addrs;
+            uint64_t expire = 0; /// 过期时间(单调时钟毫秒)
+        };
+
+        /// 进行中的查询，同名的后续调用在其上等待
+        struct Pending;
+
+        /**
+         * @brief 查hosts文件，文件修改后重新加载
+         */
+        bool lookupHosts(const std::string &name, int family, std::vector<IPAddress::ptr> &result);
+
+        /**
+         * @brief 按search列表依次查询，不经过缓存
+         * @param[out] ttl 结果的缓存时间(秒)
+         * @return 1成功，0名字不存在，-1查询失败(不缓存)
+         */
+        int resolveUncached(const std::string &name, int family, std::vector<IPAddress::ptr> &result, uint32_t &ttl);
+
+        /**
+         * @brief 向服务器查询单个名字的一种记录
+         * @param[in] type DNS记录类型，1为A，28为AAAA
+         * @param[out] ttl 结果的缓存时间(秒)；否定应答为SOA的最小TTL
+         * @return 1有记录，0名字不存在或无该类型记录，-1所有服务器均超时或出错
+         */
+        int query(const std::string &name, uint16_t type, std::vector<IPAddress::ptr> &result, uint32_t &ttl);
+
+    private:
+        RWMutex m_mutex;                                        /// 保护服务器、search与hosts
+        std::vector<IPAddress::ptr> m_servers;                  /// DNS服务器
+        std::vector<std::string> m_search;                      /// search域
+        std::string m_hostsPath;                                /// hosts文件路径
+        time_t m_hostsMtime = 0;                                /// hosts文件修改时间
+        uint64_t m_hostsChecked = 0;                            /// 上次检查hosts文件的时间(单调时钟毫秒)
+        std::unordered_map<std::string, std::vector<IPAddress::ptr>> m_hosts; /// 小写主机名 -> 地址
+
+        RWMutex m_cacheMutex;                                   /// 保护m_cache
+        std::unordered_map<std::string, CacheEntry> m_cache;    /// family:小写主机名 -> 结果
+
+        Mutex m_pendingMutex;                                   /// 保护m_pending
+        std::unordered_map<std::string, std::shared_ptr<Pending>> m_pending; /// 进行中的查询
+
+        std::atomic<uint64_t> m_hits{0};                        /// 命中肯定缓存
+        std::atomic<uint64_t> m_negativeHits{0};                /// 命中否定缓存
+        std::atomic<uint64_t> m_hostsHits{0};                   /// 命中hosts文件
+        std::atomic<uint64_t> m_coalesced{0};                   /// 合并的调用
+        std::atomic<uint64_t> m_queries{0};                     /// 发出的UDP查询
+        std::atomic<uint64_t> m_timeouts{0};                    /// 等待应答超时
+        std::atomic<uint64_t> m_failures{0};                    /// 解析失败的调用
+    };
+
+    using DnsMgr = Singleton<DnsResolver>; ///< 全局DNS解析器
+}
@@ -12,7 +12,9 @@
  * 主要功能：
  * - 管理文件描述符的初始化状态、类型(socket或普通文件)、阻塞模式等属性
  * - 提供文件描述符超时时间的设置和获取
- * - 实现线程安全的文件描述符获取和删除操作
+ * - 空闲超时（截止时间模式）：读等待只记录截止时间，由线程级巡检定时器统一取消
+ * - 实现线程安全的文件描述符获取和删除操作：记录按块分配在两级数组中，分配后不再移动，
+ *   查找只需两次 acquire 读，不加锁；每条记录同时是 IOManager 的 fd 上下文
  * - 提供RAII机制自动管理文件描述符生命周期
  */
 
@@ -20,6 +22,8 @@
 #define __CIM_FD_MANAGER_H__
 
 #include "memory"
+#include <atomic>
+#include <functional>
 #include "lock.hpp"
 #include "iomanager.hpp"
 #include "singleton.hpp"
@@ -30,23 +34,21 @@ namespace CIM
     /**
      * @brief 文件描述符上下文类
      * @details 用于存储和管理单个文件描述符的相关信息，
-     *          包括初始化状态、是否为socket、阻塞模式、超时时间等
+     *          包括初始化状态、是否为socket、阻塞模式、超时时间等；
+     *          基类部分是IOManager的事件上下文，hook的一次系统调用只需查找一次，且位于相邻的缓存行。
+     *          记录由FdManager持有，不移动也不释放：fd关闭后标记为已关闭，复用时原地重新初始化并递增代数，
+     *          持有旧指针的一方通过isClose()/getGeneration()识别fd已经关闭或复用。
      */
-    class FdCtx : public std::enable_shared_from_this<FdCtx>
+    class alignas(64) FdCtx : public IOManager::FdContext, public Noncopyable
     {
-    public:
-        using ptr = std::shared_ptr<FdCtx>; ///< 智能指针类型定义
+        friend class FdManager;
 
+    public:
         /**
-         * @brief 构造函数
+         * @brief 构造函数，记录处于关闭状态，由FdManager::get(fd, true)初始化
          * @param[in] fd 文件描述符
          */
-        FdCtx(int fd);
-
-        /**
-         * @brief 析构函数
-         */
-        ~FdCtx()=default;
+        explicit FdCtx(int fd);
 
         /**
          * @brief 初始化文件描述符上下文
@@ -67,11 +69,16 @@ namespace CIM
         bool isSocket() const;
 
         /**
-         * @brief 检查文件描述符是否已关闭
+         * @brief 检查文件描述符是否已关闭（已被FdManager::del，或尚未初始化）
          * @return 已关闭返回true，否则返回false
          */
         bool isClose() const;
 
+        /**
+         * @brief 代数，每次fd被重新初始化时递增
+         */
+        uint32_t getGeneration() const;
+
         /**
          * @brief 关闭文件描述符
          * @return 操作成功返回true，失败返回false
@@ -116,49 +123,134 @@ namespace CIM
          */
         uint64_t getTimeout(int type) const;
 
+        /**
+         * @brief 设置空闲超时（截止时间模式）
+         * @details 设置后hook的读操作阻塞时不再逐次添加/取消条件定时器，
+         *          只记录本次等待的截止时间，由线程级巡检定时器统一检查并取消超时的等待，
+         *          超时精度为巡检间隔(tcp.idle_sweep_interval)。优先于SO_RCVTIMEO。
+         * @param[in] v 超时时间(毫秒)，-1表示关闭
+         */
+        void setIdleTimeout(uint64_t v);
+
+        /**
+         * @brief 获取空闲超时
+         * @return 超时时间(毫秒)，-1表示未启用
+         */
+        uint64_t getIdleTimeout() const;
+
+        /**
+         * @brief 开始一次读等待，记录截止时间
+         * @param[in] iom 等待所在的IOManager
+         * @param[in] deadline 截止时间(单调时钟毫秒)
+         */
+        void beginIdleWait(IOManager *iom, uint64_t deadline);
+
+        /**
+         * @brief 结束读等待
+         * @return 本次等待是否因超时被取消
+         */
+        bool endIdleWait();
+
+        /**
+         * @brief 巡检：正在等待且已过截止时间时取消读事件，唤醒等待的协程
+         * @param[in] now 当前时间(单调时钟毫秒)
+         * @return 是否取消了等待
+         */
+        bool checkIdleDeadline(uint64_t now);
+
+        /**
+         * @brief 是否正在进行截止时间模式的读等待
+         */
+        bool isIdleWaiting() const;
+
+        /**
+         * @brief 标记是否已登记到巡检器
+         * @return 之前的标记
+         */
+        bool exchangeIdleWatched(bool v);
+
+    private:
+        /**
+         * @brief fd打开（或复用）时重新初始化记录，调用者持有mutex
+         */
+        void open();
+
     private:
         bool m_isInit : 1;       // 占用1个bit，表示对象是否已初始化
         bool m_isSocket : 1;     // 占用1个bit，表示是否为socket文件描述符
         bool m_sysNonBlock : 1;  // 占用1个bit，表示系统层面是否设置了非阻塞模式
         bool m_userNonBlock : 1; // 占用1个bit，表示用户是否设置了非阻塞模式
-        bool m_isClosed : 1;     // 占用1个bit，表示文件描述符是否已关闭
-        int m_fd;                // 文件描述符
+        std::atomic<bool> m_isClosed{true};      // 文件描述符是否已关闭
+        std::atomic<uint32_t> m_generation{0};   // 代数，每次open递增
         uint64_t m_recvTimeout;  // 接收超时时间
         uint64_t m_sendTimeout;  // 发送超时时间
+        uint64_t m_idleTimeout;  // 空闲超时时间，-1表示未启用
+        /// 本次读等待的截止时间；0表示未在等待，kIdleTimedOut表示已被巡检取消
+        std::atomic<uint64_t> m_idleDeadline{0};
+        std::atomic<IOManager *> m_idleIom{nullptr}; // 读等待所在的IOManager
+        std::atomic<bool> m_idleWatched{false};      // 是否已登记到巡检器
     };
 
     /**
      * @brief 文件描述符管理器类
-     * @details 全局管理所有文件描述符的上下文信息，提供线程安全的访问接口
+     * @details 全局管理所有文件描述符的上下文信息，提供线程安全的访问接口。
+     *          记录存放在两级数组中：第一级是固定大小的块指针数组，第二级每块 kChunkSize 条记录，
+     *          块在首次用到时分配（CAS发布），之后不移动、不释放，查找不加锁。
      */
-    class FdManager
+    class FdManager : public Noncopyable
     {
     public:
         using ptr = std::shared_ptr<FdManager>; ///< 智能指针类型定义
-        using RWMutexType = RWMutex;            ///< 读写锁类型定义
+
+        static const int kChunkBits = 8;                    ///< 每块 256 条记录
+        static const int kChunkSize = 1 << kChunkBits;      ///< 每块记录数
+        static const int kMaxChunks = (1 << 20) / kChunkSize; ///< 支持的fd上限 1<<20
 
         /**
          * @brief 构造函数
          */
         FdManager();
 
+        /**
+         * @brief 析构函数，释放所有块
+         */
+        ~FdManager();
+
         /**
          * @brief 获取文件描述符上下文
          * @param[in] fd 文件描述符
-         * @param[in] auto_create 是否自动创建，默认为false
-         * @return 文件描述符上下文智能指针
+         * @param[in] auto_create 未打开时是否初始化，默认为false
+         * @return 文件描述符上下文，未打开且不自动创建、或fd超出上限时返回nullptr
+         */
+        FdCtx *get(int fd, bool auto_create = false);
+
+        /**
+         * @brief 获取fd的记录，不论是否已打开，所在的块不存在时分配
+         * @details 供IOManager登记事件，不会像get(fd, true)那样检测fd类型或修改阻塞模式
+         * @return 记录，fd超出上限时返回nullptr
          */
-        FdCtx::ptr get(int fd, bool auto_create = false);
+        FdCtx *getSlot(int fd);
 
         /**
-         * @brief 删除文件描述符上下文
+         * @brief 删除文件描述符上下文，记录标记为已关闭
          * @param[in] fd 文件描述符
          */
         void del(int fd);
 
+        /**
+         * @brief 遍历所有已分配的记录
+         */
+        void foreach(const std::function<void(FdCtx *)> &cb);
+
+    private:
+        /**
+         * @brief 获取第index块
+         * @param[in] create 块不存在时是否分配
+         */
+        FdCtx *chunk(int index, bool create);
+
     private:
-        std::vector<FdCtx::ptr> m_fdCtxs; ///< 文件描述符上下文容器
-        RWMutexType m_mutex;              ///< 读写锁，保护容器访问安全
+        std::atomic<FdCtx *> m_chunks[kMaxChunks]; ///< 块指针数组
     };
 
     using FdMgr = Singleton<FdManager>; ///< 全局单例模式的文件描述符管理器
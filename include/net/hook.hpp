@@ -51,11 +51,13 @@ extern "C"
     typedef ssize_t (*sendto_fun)(int sockfd, const void *buf, size_t len, int flags,
                                   const struct sockaddr *dest_addr, socklen_t addrlen);
     typedef ssize_t (*sendmsg_fun)(int sockfd, const struct msghdr *msg, int flags);
+    typedef ssize_t (*sendfile_fun)(int out_fd, int in_fd, off_t *offset, size_t count);
     extern write_fun write_f;
     extern writev_fun writev_f;
     extern send_fun send_f;
     extern sendto_fun sendto_f;
     extern sendmsg_fun sendmsg_f;
+    extern sendfile_fun sendfile_f;
 
     // close
     typedef int (*close_fun)(int fd);
@@ -0,0 +1,251 @@
+/**
+ * @file ring_byte_array.hpp
+ * @brief 连续环形字节数组类定义文件
+ * @details 该文件定义了RingByteArray类，读写接口与ByteArray保持一致（writeFint32、readUint64等），
+ * 但底层使用一块容量为2的幂的连续内存，按环形方式寻址。
+ *
+ * 与ByteArray的区别：
+ * 1. 读写最多两次memcpy，不需要逐个节点遍历
+ * 2. setPosition为O(1)，不需要从根节点查找
+ * 3. getReadBuffers/getWriteBuffers最多返回两个iovec
+ * 4. consume丢弃已读数据后空间可以循环复用，不需要重新分配
+ * 5. slice返回共享底层内存的视图，O(1)且不拷贝数据
+ * 6. reserve一次性分配连续内存，避免碎片
+ *
+ * 设计特点：
+ * - 底层内存由shared_ptr持有，切片与原对象共享；任一方写入前若内存被共享则先拷贝一份（写时复制），
+ *   因此切片内容不会被原对象后续的写入改变
+ * - 线程不安全，需要外部同步机制
+ */
+
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+namespace CIM
+{
+    /**
+     * @brief 连续环形字节数组类
+     * @details 逻辑位置0对应环形缓冲区中的m_begin，逻辑位置i对应物理下标(m_begin + i) & (capacity - 1)。
+     */
+    class RingByteArray
+    {
+    public:
+        using ptr = std::shared_ptr<RingByteArray>;
+
+        /**
+         * @brief 构造函数
+         * @param[in] base_size 初始容量，向上取整为2的幂，默认为4096字节
+         */
+        RingByteArray(size_t base_size = 4096);
+
+        void writeFint8(int8_t value);
+        void writeFuint8(uint8_t value);
+        void writeFint16(int16_t value);
+        void writeFuint16(uint16_t value);
+        void writeFint32(int32_t value);
+        void writeFuint32(uint32_t value);
+        void writeFint64(int64_t value);
+        void writeFuint64(uint64_t value);
+
+        /**
+         * @brief 写入32位有符号整数（Zigzag编码+变长编码）
+         */
+        void writeInt32(int32_t value);
+        /**
+         * @brief 写入32位无符号整数（变长编码）
+         */
+        void writeUint32(uint32_t value);
+        /**
+         * @brief 写入64位有符号整数（Zigzag编码+变长编码）
+         */
+        void writeInt64(int64_t value);
+        /**
+         * @brief 写入64位无符号整数（变长编码）
+         */
+        void writeUint64(uint64_t value);
+
+        void writeFloat(float value);
+        void writeDouble(double value);
+
+        void writeStringF16(const std::string &value);
+        void writeStringF32(const std::string &value);
+        void writeStringF64(const std::string &value);
+        void writeStringVint(const std::string &value);
+        void writeStringWithoutLength(const std::string &value);
+
+        int8_t readFint8();
+        uint8_t readFuint8();
+        int16_t readFint16();
+        uint16_t readFuint16();
+        int32_t readFint32();
+        uint32_t readFuint32();
+        int64_t readFint64();
+        uint64_t readFuint64();
+
+        int32_t readInt32();
+        uint32_t readUint32();
+        int64_t readInt64();
+        uint64_t readUint64();
+
+        float readFloat();
+        double readDouble();
+
+        std::string readString16();
+        std::string readString32();
+        std::string readString64();
+        std::string readStringVint();
+
+        /**
+         * @brief 清空字节数组
+         * @details 重置读写位置和数据大小，保留已分配的内存（被切片共享时下次写入再分配）
+         */
+        void clear();
+
+        /**
+         * @brief 写入数据到字节数组
+         * @param[in] buf 数据缓冲区指针
+         * @param[in] size 数据大小（字节数）
+         */
+        void write(const void *buf, size_t size);
+
+        /**
+         * @brief 从字节数组读取数据
+         * @param[out] buf 数据缓冲区指针
+         * @param[in] size 要读取的数据大小（字节数）
+         * @exception std::out_of_range 可读数据不足时抛出
+         */
+        void read(void *buf, size_t size);
+
+        /**
+         * @brief 从指定位置读取数据（不改变当前读写位置）
+         * @param[out] buf 数据缓冲区指针
+         * @param[in] size 要读取的数据大小（字节数）
+         * @param[in] position 起始读取位置
+         * @exception std::out_of_range 可读数据不足时抛出
+         */
+        void read(void *buf, size_t size, size_t position) const;
+
+        size_t getPosition() const { return m_position; }
+
+        /**
+         * @brief 设置读写位置，O(1)
+         * @param[in] v 新的读写位置
+         * @exception std::out_of_range v超过容量时抛出
+         */
+        void setPosition(size_t v);
+
+        bool writeToFile(const std::string &path) const;
+        bool readFromFile(const std::string &path);
+
+        /**
+         * @brief 获取当前容量
+         */
+        size_t getCapacity() const;
+        size_t getReadSize() const { return m_data_size - m_position; }
+        size_t getDataSize() const { return m_data_size; }
+
+        bool isLittleEndian() const;
+        void setIsLittleEndian(bool val);
+
+        std::string toString() const;
+        std::string toHexString() const;
+
+        /**
+         * @brief 获取当前可读数据的缓冲区列表
+         * @param[out] buffer 存储缓冲区的iovec结构列表，最多追加两项
+         * @param[in] len 请求读取的最大长度
+         * @return 实际可读的字节数
+         */
+        uint64_t getReadBuffers(std::vector<iovec> &buffer, uint64_t len = ~0ull) const;
+
+        /**
+         * @brief 获取指定位置的可读数据缓冲区列表
+         * @param[out] buffer 存储缓冲区的iovec结构列表，最多追加两项
+         * @param[in] len 请求读取的最大长度
+         * @param[in] position 起始读取位置
+         * @return 实际可读的字节数
+         */
+        uint64_t getReadBuffers(std::vector<iovec> &buffer, uint64_t len, uint64_t position) const;
+
+        /**
+         * @brief 获取当前可写数据的缓冲区列表
+         * @param[out] buffer 存储缓冲区的iovec结构列表，最多追加两项
+         * @param[in] len 请求写入的最大长度
+         * @return 实际可写的字节数
+         * @details 与ByteArray一样不移动position，数据写入后由调用者setPosition
+         */
+        uint64_t getWriteBuffers(std::vector<iovec> &buffer, uint64_t len);
+
+        /**
+         * @brief 保证从当前位置起至少还能写入size字节
+         * @details 容量不足时一次分配足够的连续内存（2的幂）并把现有数据线性拷贝过去
+         */
+        void reserve(size_t size);
+
+        /**
+         * @brief 取[position, position + len)的只读视图
+         * @return 与本对象共享底层内存的新对象，读写位置为0，字节序与本对象相同
+         * @exception std::out_of_range 范围超出数据大小时抛出
+         * @details O(1)，不拷贝数据；切片与本对象任一方之后的写入都会先复制底层内存
+         */
+        ptr slice(size_t position, size_t len) const;
+
+        /**
+         * @brief 丢弃当前位置之前的数据，O(1)
+         * @details 逻辑起点移到当前位置，position归零，被丢弃的空间可被后续写入循环复用
+         */
+        void consume();
+
+    private:
+        /**
+         * @brief 底层连续内存
+         */
+        struct Buffer
+        {
+            Buffer(size_t s);
+            ~Buffer();
+
+            char *ptr;      //!< 数据指针
+            size_t size;    //!< 大小，2的幂
+        };
+
+        /**
+         * @brief 准备写入[m_position, m_position + size)
+         * @details 容量不足时扩容，内存被切片共享时先复制
+         */
+        void prepareWrite(size_t size);
+
+        /**
+         * @brief 把现有数据线性拷贝到容量为capacity的新内存
+         */
+        void relocate(size_t capacity);
+
+        /**
+         * @brief 逻辑位置对应的物理下标
+         */
+        size_t index(size_t position) const { return (m_begin + position) & (m_buffer->size - 1); }
+
+        /**
+         * @brief 把[position, position + size)拷贝到buf，调用者保证范围有效
+         */
+        void copyOut(void *buf, size_t size, size_t position) const;
+
+        /**
+         * @brief 把[position, position + size)对应的iovec追加到buffer
+         */
+        void appendBuffers(std::vector<iovec> &buffer, size_t size, size_t position) const;
+
+    private:
+        std::shared_ptr<Buffer> m_buffer;   //!< 底层内存，切片之间共享
+        size_t m_begin;                     //!< 逻辑位置0对应的物理下标
+        size_t m_position;                  //!< 当前读写位置
+        size_t m_data_size;                 //!< 数据总大小
+        int8_t m_endian;                    //!< 字节序（CIM_LITTLE_ENDIAN 或 CIM_BIG_ENDIAN）
+    };
+}
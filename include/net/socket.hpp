@@ -155,6 +155,20 @@ namespace CIM
          */
         void setRecvTimeout(int64_t v);
 
+        /**
+         * @brief 获取空闲超时时间(毫秒)
+         * @return 返回空闲超时时间(毫秒)，-1表示未启用
+         */
+        int64_t getIdleTimeout();
+
+        /**
+         * @brief 设置空闲超时时间(毫秒)，截止时间模式
+         * @details 读等待不再逐次创建定时器，由线程级巡检定时器按截止时间取消，
+         *          精度为巡检间隔；启用后读操作忽略接收超时
+         * @param[in] v 超时时间(毫秒)，-1表示关闭
+         */
+        void setIdleTimeout(int64_t v);
+
         /**
          * @brief 获取sockopt @see getsockopt
          * @param[in] level 级别
@@ -211,6 +225,32 @@ namespace CIM
          */
         virtual Socket::ptr accept();
 
+        /**
+         * @brief 非阻塞地接收一个连接，不让出协程
+         * @details 使用accept4(SOCK_NONBLOCK|SOCK_CLOEXEC)，新fd已登记到FdManager，
+         *          由adopt()封装为Socket。用于一次唤醒后排空监听队列
+         * @param[out] addr 对端地址，可为nullptr
+         * @param[in,out] addrlen 地址长度，可为nullptr
+         * @return 新连接的fd，失败返回-1并设置errno，没有待接收的连接时errno为EAGAIN
+         * @pre Socket必须 bind , listen  成功
+         */
+        int tryAccept(sockaddr *addr = nullptr, socklen_t *addrlen = nullptr);
+
+        /**
+         * @brief 将tryAccept()得到的fd封装为与监听socket同类型的Socket
+         * @details SSLSocket在此完成握手，可以放到处理连接的协程中执行，不阻塞接收循环
+         * @param[in] fd 新连接的fd
+         * @return 成功返回新连接的socket，失败返回nullptr，此时fd已关闭
+         */
+        virtual Socket::ptr adopt(int fd);
+
+        /**
+         * @brief 开启SO_REUSEPORT，未创建socket时先创建
+         * @pre 必须在bind之前调用
+         * @return 是否设置成功
+         */
+        bool setReusePort();
+
         /**
          * @brief 绑定地址
          * @param[in] addr 地址
@@ -271,6 +311,16 @@ namespace CIM
          */
         virtual int send(const iovec *buffers, size_t length, int flags = 0);
 
+        /**
+         * @brief 发送文件内容
+         * @param[in] fd 文件描述符
+         * @param[in] offset 文件偏移
+         * @param[in] length 发送的字节数
+         * @return 实际发送的字节数，文件提前结束时小于length；出错返回-1
+         * @details 使用sendfile，文件内容不经过用户态
+         */
+        virtual int64_t sendFile(int fd, off_t offset, size_t length);
+
         /**
          * @brief 发送数据到指定地址
          * @param[in] buffer 待发送数据的内存
@@ -510,6 +560,13 @@ namespace CIM
          */
         Socket::ptr accept() override;
 
+        /**
+         * @brief 将tryAccept()得到的fd封装为SSLSocket并完成握手
+         * @param[in] fd 新连接的fd
+         * @return 成功返回新连接的socket，失败返回nullptr，此时fd已关闭
+         */
+        Socket::ptr adopt(int fd) override;
+
         /**
          * @brief 绑定地址
          * @param[in] addr 地址
@@ -560,9 +617,17 @@ namespace CIM
          *      @retval >0 发送成功对应大小的数据
          *      @retval =0 socket被关闭
          *      @retval <0 socket出错
+         * @details 未启用kTLS发送时，小于ssl.write_coalesce的片段先拼接再SSL_write，
+         *          每条TLS记录尽量装满，避免每个片段一条记录、一次系统调用
          */
         int send(const iovec *buffers, size_t length, int flags = 0) override;
 
+        /**
+         * @brief 发送文件内容
+         * @details 启用kTLS发送时由内核加密，直接sendfile；否则读入用户态后SSL_write
+         */
+        int64_t sendFile(int fd, off_t offset, size_t length) override;
+
         /**
          * @brief 发送数据到指定地址
          * @param[in] buffer 待发送数据的内存
@@ -644,9 +709,53 @@ namespace CIM
          * @param[in] cert_file 证书文件路径
          * @param[in] key_file 私钥文件路径
          * @return 是否加载成功
+         * @details 同时按ssl.session_*配置服务端会话缓存与session ticket
          */
         bool loadCertificates(const std::string &cert_file, const std::string &key_file);
 
+        /**
+         * @brief 获取SSL上下文
+         */
+        std::shared_ptr<SSL_CTX> getContext() const { return m_ctx; }
+
+        /**
+         * @brief 设置SSL上下文
+         * @details 同一端口的多个监听socket共用一个上下文，会话缓存和ticket密钥才能互相识别；
+         *          客户端socket在connect前设置时使用该上下文，否则使用全局共享的客户端上下文
+         */
+        void setContext(std::shared_ptr<SSL_CTX> ctx) { m_ctx = ctx; }
+
+        /**
+         * @brief 握手是否复用了之前的会话
+         */
+        bool isSessionReused() const;
+
+        /**
+         * @brief 发送方向是否已交给内核加密(kTLS)
+         */
+        bool isKtlsSend() const { return m_ktlsSend; }
+
+        /**
+         * @brief 接收方向是否已交给内核解密(kTLS)
+         */
+        bool isKtlsRecv() const { return m_ktlsRecv; }
+
+        /**
+         * @brief 握手统计
+         */
+        struct Stats
+        {
+            uint64_t handshakes = 0; /// 完成的握手
+            uint64_t resumed = 0;    /// 其中复用会话的握手
+            uint64_t ktlsSend = 0;   /// 发送方向启用kTLS的连接
+            uint64_t ktlsRecv = 0;   /// 接收方向启用kTLS的连接
+        };
+
+        /**
+         * @brief 获取全局握手统计
+         */
+        static Stats GetStats();
+
         /**
          * @brief 输出信息到流中
          * @param[in,out] os 输出流
@@ -662,9 +771,22 @@ namespace CIM
          */
         bool init(int sock) override;
 
+    private:
+        /**
+         * @brief 握手完成后记录会话复用与kTLS状态
+         */
+        void onHandshake();
+
+        /**
+         * @brief 客户端收到新会话(TLS1.3为NewSessionTicket)时的回调，按服务端地址缓存
+         */
+        static int OnNewSession(SSL *ssl, SSL_SESSION *session);
+
     private:
         std::shared_ptr<SSL_CTX> m_ctx; /// SSL上下文
         std::shared_ptr<SSL> m_ssl;     /// SSL对象
+        bool m_ktlsSend = false;        /// 发送方向使用kTLS
+        bool m_ktlsRecv = false;        /// 接收方向使用kTLS
     };
 
     /**
@@ -1,10 +1,42 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 #include "byte_array.hpp"
 
 namespace CIM
 {
+    /**
+     * @brief 引用计数的内存片段，用于Stream::writev
+     *
+     * owner持有data所在的对象：零拷贝发送时内核在writev返回后仍会读取这段内存，
+     * 直到发送完成前owner都不会释放。owner为空的片段只保证在writev返回前有效，
+     * 零拷贝发送时会先拷贝一份
+     */
+    struct BufferSlice
+    {
+        std::shared_ptr<const void> owner; /// 内存持有者，可以为空
+        const void *data = nullptr;        /// 数据起始地址
+        size_t size = 0;                   /// 数据长度
+
+        BufferSlice() {}
+
+        BufferSlice(const void *d, size_t s, std::shared_ptr<const void> o = nullptr)
+            : owner(std::move(o)), data(d), size(s)
+        {
+        }
+
+        /**
+         * @brief 接管字符串，片段持有它直到发送完成
+         */
+        static BufferSlice FromString(std::string &&str)
+        {
+            std::shared_ptr<std::string> holder = std::make_shared<std::string>(std::move(str));
+            return BufferSlice(holder->data(), holder->size(), holder);
+        }
+    };
+
     /**
      * @brief 抽象流接口类，定义了流的基本操作
      *
@@ -105,6 +137,17 @@ namespace CIM
          */
         virtual int writeFixSize(ByteArray::ptr ba, size_t length);
 
+        /**
+         * @brief 按顺序写出一组内存片段
+         * @param[in] slices 内存片段
+         * @param[in] more 后面还有紧接着的数据，允许底层合并到同一个报文
+         * @return 写入的总字节数，0表示流已关闭，负数表示出错
+         *
+         * @note 默认实现对每个片段调用writeFixSize；SocketStream用一次sendmsg发送整组片段，
+         *       大数据量时使用MSG_ZEROCOPY
+         */
+        virtual int writev(const std::vector<BufferSlice> &slices, bool more = false);
+
         /**
          * @brief 关闭流
          *
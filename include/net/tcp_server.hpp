@@ -13,16 +13,21 @@
  * - SSL/TLS加密连接支持
  * - 可配置的超时时间和keepalive机制
  * - 灵活的工作线程模型
+ * - reuseport模式：io_worker每个线程一个SO_REUSEPORT监听socket，在io_worker上直接接收并处理连接
+ * - 批量接收：一次可读排空监听队列，全局/单IP连接数上限，io_worker积压时暂停接收
  */
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <unordered_map>
 
 #include "address.hpp"
 #include "config.hpp"
 #include "iomanager.hpp"
+#include "lock.hpp"
 #include "noncopyable.hpp"
 #include "socket.hpp"
 
@@ -37,7 +42,14 @@ struct TcpServerConf {
     std::vector<std::string> address;         /// 监听地址列表
     int keepalive = 0;                        /// keepalive选项
     int timeout = 1000 * 2 * 60;              /// 超时时间(毫秒)，默认4分钟
+    std::string timeout_mode = "timer";       /// 超时模式："timer"每次读等待一个定时器，"deadline"截止时间+线程巡检
     int ssl = 0;                              /// 是否启用SSL
+    bool reuseport = false;                   /// 是否为io_worker的每个线程打开一个SO_REUSEPORT监听socket
+    std::string reuseport_steering = "none";  /// reuseport连接分发："none"内核哈希，"cpu"SO_INCOMING_CPU，"cbpf"按CPU选择的BPF程序
+    int max_connections = 0;                  /// 最大活跃连接数，0不限制
+    int max_connections_per_ip = 0;           /// 单个来源IP的最大活跃连接数，0不限制
+    int accept_batch = 64;                    /// 一次可读最多接收的连接数，达到后让出再继续排空
+    int accept_pause_queue = 0;               /// io_worker等待的任务数超过该值时暂停接收，0不暂停
     std::string id;                           /// 服务器唯一标识
     std::string type = "http";                /// 服务器类型，如"http", "ws", "rock"
     std::string name;                         /// 服务器名称
@@ -60,8 +72,11 @@ struct TcpServerConf {
          * @return true表示相等
          */
     bool operator==(const TcpServerConf& oth) const {
-        return address == oth.address && keepalive == oth.keepalive && timeout == oth.timeout && name == oth.name &&
-               ssl == oth.ssl && cert_file == oth.cert_file && key_file == oth.key_file &&
+        return address == oth.address && keepalive == oth.keepalive && timeout == oth.timeout &&
+               timeout_mode == oth.timeout_mode && name == oth.name &&
+               ssl == oth.ssl && reuseport == oth.reuseport && reuseport_steering == oth.reuseport_steering &&
+               max_connections == oth.max_connections && max_connections_per_ip == oth.max_connections_per_ip &&
+               accept_batch == oth.accept_batch && accept_pause_queue == oth.accept_pause_queue && cert_file == oth.cert_file && key_file == oth.key_file &&
                accept_worker == oth.accept_worker && io_worker == oth.io_worker &&
                process_worker == oth.process_worker && args == oth.args && id == oth.id && type == oth.type;
     }
@@ -77,8 +92,15 @@ class LexicalCast<std::string, TcpServerConf> {
         conf.type = node["type"].as<std::string>(conf.type);
         conf.keepalive = node["keepalive"].as<int>(conf.keepalive);
         conf.timeout = node["timeout"].as<int>(conf.timeout);
+        conf.timeout_mode = node["timeout_mode"].as<std::string>(conf.timeout_mode);
         conf.name = node["name"].as<std::string>(conf.name);
         conf.ssl = node["ssl"].as<int>(conf.ssl);
+        conf.reuseport = node["reuseport"].as<bool>(conf.reuseport);
+        conf.reuseport_steering = node["reuseport_steering"].as<std::string>(conf.reuseport_steering);
+        conf.max_connections = node["max_connections"].as<int>(conf.max_connections);
+        conf.max_connections_per_ip = node["max_connections_per_ip"].as<int>(conf.max_connections_per_ip);
+        conf.accept_batch = node["accept_batch"].as<int>(conf.accept_batch);
+        conf.accept_pause_queue = node["accept_pause_queue"].as<int>(conf.accept_pause_queue);
         conf.cert_file = node["cert_file"].as<std::string>(conf.cert_file);
         conf.key_file = node["key_file"].as<std::string>(conf.key_file);
         conf.accept_worker = node["accept_worker"].as<std::string>();
@@ -104,7 +126,14 @@ class LexicalCast<TcpServerConf, std::string> {
         node["name"] = conf.name;
         node["keepalive"] = conf.keepalive;
         node["timeout"] = conf.timeout;
+        node["timeout_mode"] = conf.timeout_mode;
         node["ssl"] = conf.ssl;
+        node["reuseport"] = conf.reuseport;
+        node["reuseport_steering"] = conf.reuseport_steering;
+        node["max_connections"] = conf.max_connections;
+        node["max_connections_per_ip"] = conf.max_connections_per_ip;
+        node["accept_batch"] = conf.accept_batch;
+        node["accept_pause_queue"] = conf.accept_pause_queue;
         node["cert_file"] = conf.cert_file;
         node["key_file"] = conf.key_file;
         node["accept_worker"] = conf.accept_worker;
@@ -142,6 +171,17 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, Noncopyable {
    public:
     typedef std::shared_ptr<TcpServer> ptr;
 
+    /**
+         * @brief 连接接收统计
+         */
+    struct AcceptStats {
+        uint64_t accepted = 0;    /// 接收并放行的连接数
+        uint64_t rejected = 0;    /// 超过max_connections被拒绝的连接数
+        uint64_t rejectedIp = 0;  /// 超过max_connections_per_ip被拒绝的连接数
+        uint64_t paused = 0;      /// 因io_worker积压暂停接收的次数
+        int64_t active = 0;       /// 当前活跃连接数
+    };
+
     /**
          * @brief 构造函数
          * @param[in] worker socket客户端工作的协程调度器
@@ -211,6 +251,58 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, Noncopyable {
          */
     void setRecvTimeout(uint64_t v);
 
+    /// 读超时是否使用截止时间模式（Socket::setIdleTimeout）
+    bool isIdleDeadline() const;
+
+    void setIdleDeadline(bool v);
+
+    /**
+         * @brief 设置reuseport模式，须在bind之前调用
+         * @details 开启后bind为io_worker的每个线程各打开一个SO_REUSEPORT监听socket，
+         * 由内核在它们之间分发连接，每个监听socket有自己的接收队列；
+         * 每个监听socket一个排空循环运行在io_worker上，一次唤醒用accept4接收到队列为空，
+         * 新连接从接收它的线程调度，不经过accept_worker。
+         * 排空循环不固定线程：io_worker的所有线程共用一个epoll，固定线程的任务只能由该线程取走，
+         * 而它可能一直阻塞在epoll_wait中
+         * @param[in] v 是否开启
+         * @param[in] steering 连接分发方式：
+         * - "none"：内核按四元组哈希
+         * - "cpu"：第i个监听socket设置SO_INCOMING_CPU为io_worker第i个线程固定的CPU，需要io_worker按pin固定线程
+         * - "cbpf"：挂载经典BPF程序，收包CPU等于第i个线程的CPU时选第i个监听socket，同样需要固定线程
+         */
+    void setReusePort(bool v, const std::string& steering = "none");
+
+    /// 是否为reuseport模式
+    bool isReusePort() const;
+
+    /**
+         * @brief 设置连接数上限
+         * @details 超过上限的连接接收后立即以RST关闭，不进入handleClient。
+         * 活跃连接按客户端Socket的生命周期计数，handleClient返回后仍被持有的连接继续占用名额
+         * @param[in] max 最大活跃连接数，0不限制
+         * @param[in] per_ip 单个来源IP的最大活跃连接数，0不限制
+         */
+    void setConnectionLimits(uint32_t max, uint32_t per_ip);
+
+    /**
+         * @brief 设置一次可读最多接收的连接数
+         * @details 达到后让出协程再继续排空，避免连接风暴时接收循环独占线程
+         */
+    void setAcceptBatch(uint32_t v);
+
+    /**
+         * @brief 设置暂停接收的io_worker积压阈值
+         * @details io_worker等待执行的任务数超过v时，接收循环休眠tcp_server.accept_pause_interval毫秒后再检查，
+         * 新连接留在内核的监听队列中；0表示不暂停
+         */
+    void setAcceptPauseQueue(uint32_t v);
+
+    /**
+         * @brief 获取连接接收统计
+         * @return AcceptStats 统计快照
+         */
+    AcceptStats getAcceptStats() const;
+
     /**
          * @brief 设置服务器名称
          * @param[in] v 服务器名称
@@ -250,7 +342,7 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, Noncopyable {
 
     /**
          * @brief 获取监听套接字列表
-         * @return 套接字列表
+         * @return 套接字列表，reuseport模式下同一地址有多个
          */
     std::vector<Socket::ptr> getSocks() const;
 
@@ -264,20 +356,73 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, Noncopyable {
 
     /**
          * @brief 开始接受连接
+         * @details 每次可读后用accept4批量排空监听队列，每批最多m_acceptBatch个，再等待下一次可读；
+         * reuseport监听socket的循环运行在io_worker上，其余运行在accept_worker上
          * @param[in] sock 监听Socket
          */
     virtual void startAccept(Socket::ptr sock);
 
+    /**
+         * @brief 封装startAccept接收的fd并处理连接
+         * @param[in] sock 监听Socket
+         * @param[in] fd 新连接的fd
+         * @param[in] ip 来源IP的原始字节，未开启单IP上限时为空
+         */
+    void handleAccepted(Socket::ptr sock, int fd, const std::string& ip);
+
+    /**
+         * @brief 按连接数上限放行或拒绝新连接
+         * @param[in] ip 来源IP的原始字节，未开启单IP上限时为空
+         * @return 放行返回true，同时占用一个名额
+         */
+    bool admitConnection(const std::string& ip);
+
+    /**
+         * @brief 归还admitConnection占用的名额
+         * @param[in] ip 来源IP的原始字节
+         */
+    void releaseConnection(const std::string& ip);
+
+    /**
+         * @brief 为新连接设置读超时
+         * @param[in] client 客户端Socket
+         */
+    void initClient(Socket::ptr client);
+
+    /**
+         * @brief 按m_steering为一组reuseport监听socket设置连接分发
+         * @param[in] socks 同一地址的监听socket，第i个对应io_worker第i个线程
+         */
+    void steerReusePort(const std::vector<Socket::ptr>& socks);
+
    protected:
     std::vector<Socket::ptr> m_socks;  /// 监听Socket数组
     IOManager* m_worker;               /// 新连接的Socket工作的调度器
     IOManager* m_ioWorker;             /// IO操作的调度器
     IOManager* m_acceptWorker;         /// 服务器创建新连接的调度器
     uint64_t m_recvTimeout;            /// 接收超时时间(毫秒)
+    bool m_idleDeadline = false;       /// 接收超时是否使用截止时间模式
+    bool m_reusePort = false;          /// 是否为reuseport模式
+    std::string m_steering = "none";   /// reuseport连接分发方式
+    std::vector<bool> m_reuseSocks;    /// reuseport模式下m_socks中每个监听socket是否为SO_REUSEPORT组成员
+    uint32_t m_maxConnections = 0;     /// 最大活跃连接数，0不限制
+    uint32_t m_maxConnectionsPerIp = 0;  /// 单IP最大活跃连接数，0不限制
+    uint32_t m_acceptBatch = 64;       /// 一次可读最多接收的连接数
+    uint32_t m_acceptPauseQueue = 0;   /// 暂停接收的io_worker积压阈值，0不暂停
+    std::atomic<int64_t> m_activeConnections{0};  /// 当前活跃连接数
+    std::atomic<uint64_t> m_accepted{0};          /// 放行的连接数
+    std::atomic<uint64_t> m_rejected{0};          /// 超过全局上限拒绝的连接数
+    std::atomic<uint64_t> m_rejectedIp{0};        /// 超过单IP上限拒绝的连接数
+    std::atomic<uint64_t> m_acceptPaused{0};      /// 暂停接收的次数
+    Mutex m_ipMutex;                              /// 保护m_ipConnections
+    std::unordered_map<std::string, uint32_t> m_ipConnections;  /// 来源IP(原始字节) -> 活跃连接数
     std::string m_name;                /// 服务器名称
     std::string m_type = "tcp";        /// 服务器类型
     bool m_isRun;                      /// 服务是否运行
     bool m_ssl = false;                /// 是否启用SSL
     TcpServerConf::ptr m_conf;         /// 服务器配置
+
+   private:
+    struct ConnectionRef;
 };
 }  // namespace CIM
\ No newline at end of file
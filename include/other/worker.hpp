@@ -141,6 +141,43 @@ namespace CIM
             }
         }
 
+        /**
+         * @brief   按优先级/期限向指定调度器调度单个任务
+         * @tparam  FiberOrCb  协程或回调类型
+         * @param   name       调度器名称
+         * @param   fc         协程或回调
+         * @param   attr       调度属性（优先级、期限、指定线程）
+         * @note    若调度器不存在会记录错误日志
+         */
+        template <class FiberOrCb>
+        void schedule(const std::string &name, FiberOrCb fc, const Scheduler::TaskAttr &attr)
+        {
+            auto s = get(name);
+            if (s)
+            {
+                s->schedule(fc, attr);
+            }
+            else
+            {
+                static Logger::ptr s_logger = CIM_LOG_NAME("system");
+                CIM_LOG_ERROR(s_logger) << "schedule name=" << name
+                                        << " not exists";
+            }
+        }
+
+        /**
+         * @brief   按优先级向指定调度器调度单个任务
+         * @tparam  FiberOrCb  协程或回调类型
+         * @param   name       调度器名称
+         * @param   fc         协程或回调
+         * @param   priority   优先级
+         */
+        template <class FiberOrCb>
+        void schedule(const std::string &name, FiberOrCb fc, Scheduler::Priority priority)
+        {
+            schedule(name, fc, Scheduler::TaskAttr(priority));
+        }
+
         /**
          * @brief   向指定调度器批量调度任务
          * @tparam  Iter  迭代器类型
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include "stream.hpp"
 #include "socket.hpp"
 #include "iomanager.hpp"
@@ -23,7 +24,7 @@ namespace CIM
 
         /**
          * @brief 析构函数，负责关闭套接字
-         * @details 如果m_owner=true,则close
+         * @details 先有限等待未完成的零拷贝发送，如果m_owner=true,则close
          */
         ~SocketStream();
 
@@ -71,6 +72,26 @@ namespace CIM
          */
         virtual int write(ByteArray::ptr ba, size_t length) override;
 
+        /**
+         * @brief 用sendmsg一次写出一组内存片段，不拼接
+         * @details 片段总长不小于socket_stream.zerocopy_threshold的TCP连接使用MSG_ZEROCOPY：
+         * 内核直接引用片段所在的页，片段的owner保留到错误队列上报发送完成为止，
+         * 完成通知在之后的writev中回收；内核上报已退化为拷贝(如回环地址)时本连接不再使用零拷贝。
+         * SSL连接和未完成回收的字节数超过socket_stream.zerocopy_max_pending时按普通发送处理
+         * @param[in] slices 内存片段
+         * @param[in] more 后面还有紧接着的数据，发送时带MSG_MORE与后续数据合并成报文
+         * @return
+         *      @retval >0 写入的总字节数
+         *      @retval =0 socket被远端关闭
+         *      @retval <0 socket错误
+         */
+        virtual int writev(const std::vector<BufferSlice> &slices, bool more = false) override;
+
+        /**
+         * @brief 返回已交给内核零拷贝发送、尚未确认完成的字节数
+         */
+        size_t getZeroCopyPending() const;
+
         /**
          * @brief 关闭socket
          */
@@ -107,7 +128,30 @@ namespace CIM
         std::string getLocalAddressString();
 
     protected:
-        Socket::ptr m_socket; /// Socket类
-        bool m_owner;         /// 是否主控
+        /**
+         * @brief 从错误队列读取零拷贝完成通知，释放已完成发送的片段
+         */
+        void reapZeroCopy();
+
+        /**
+         * @brief 关闭前有限等待未完成的零拷贝发送，超时后把片段交给定时器延后释放
+         */
+        void releaseZeroCopy();
+
+    protected:
+        /// 一次零拷贝writev占用的片段，内核确认序号到id为止的发送完成后释放
+        struct ZeroCopyPending
+        {
+            uint32_t id;
+            size_t bytes;
+            std::vector<std::shared_ptr<const void>> owners;
+        };
+
+        Socket::ptr m_socket;                     /// Socket类
+        bool m_owner;                             /// 是否主控
+        int m_zeroCopy = 0;                       /// 零拷贝状态：0未尝试，1已开启SO_ZEROCOPY，-1不可用
+        uint32_t m_zeroCopyId = 0;                /// 下一次零拷贝发送的序号，与内核的计数保持一致
+        size_t m_zeroCopyBytes = 0;               /// 未完成的零拷贝字节数
+        std::deque<ZeroCopyPending> m_zeroCopyPending;  /// 未完成的零拷贝发送
     };
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "mysql.hpp"
 #include "macro.hpp"
 #include "config.hpp"
+#include "dns.hpp"
 #include "time_util.hpp"
 #include "string_util.hpp"
 
@@ -84,6 +85,13 @@ namespace CIM
         std::string passwd = GetParamValue<std::string>(params, "passwd");
         std::string dbname = GetParamValue<std::string>(params, "dbname");
 
+        // 主机名先由DnsResolver解析，libmysqlclient内部的getaddrinfo会阻塞IO线程；
+        // localhost表示走Unix域socket，保持原样
+        if (!host.empty() && host != "localhost")
+        {
+            host = DnsMgr::GetInstance()->resolveToString(host);
+        }
+
         if (mysql_real_connect(mysql, host.c_str(), user.c_str(), passwd.c_str(), dbname.c_str(), port, NULL, 0) == nullptr)
         {
             CIM_LOG_ERROR(g_logger) << "mysql_real_connect(" << host
@@ -2,6 +2,7 @@
 #include "macro.hpp"
 #include "hash_util.hpp"
 #include "config.hpp"
+#include "dns.hpp"
 
 namespace CIM
 {
@@ -102,7 +103,9 @@ namespace CIM
             return true;
         }
         timeval tv = {(int)ms / 1000, (int)ms % 1000 * 1000};
-        auto c = redisConnectWithTimeout(ip.c_str(), port, tv);
+        // 主机名先由DnsResolver解析，hiredis内部的getaddrinfo会阻塞IO线程
+        std::string addr = DnsMgr::GetInstance()->resolveToString(ip);
+        auto c = redisConnectWithTimeout(addr.c_str(), port, tv);
         if (c)
         {
             if (m_cmdTimeout.tv_sec || m_cmdTimeout.tv_usec)
@@ -687,7 +690,8 @@ namespace CIM
         {
             return true;
         }
-        auto ctx = redisAsyncConnect(m_host.c_str(), m_port);
+        std::string addr = DnsMgr::GetInstance()->resolveToString(m_host);
+        auto ctx = redisAsyncConnect(addr.c_str(), m_port);
         if (!ctx)
         {
             CIM_LOG_ERROR(g_logger) << "redisAsyncConnect (" << m_host << ":" << m_port
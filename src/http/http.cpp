@@ -1,4 +1,6 @@
 #include "http.hpp"
+#include <string.h>
+#include <time.h>
 
 namespace CIM::http
 {
@@ -82,6 +84,38 @@ namespace CIM::http
         }
     }
 
+    const std::string &GetHttpDateHeader()
+    {
+        static thread_local time_t s_last = 0;
+        static thread_local std::string s_header;
+        time_t now = time(0);
+        if (now != s_last)
+        {
+            struct tm tm;
+            gmtime_r(&now, &tm);
+            char buf[64];
+            size_t n = strftime(buf, sizeof(buf), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+            s_header.assign(buf, n);
+            s_last = now;
+        }
+        return s_header;
+    }
+
+    /**
+     * @brief 把无符号整数的十进制文本追加到out
+     */
+    static void AppendUint(std::string &out, uint64_t v)
+    {
+        char buf[24];
+        char *p = buf + sizeof(buf);
+        do
+        {
+            *--p = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        out.append(p, buf + sizeof(buf) - p);
+    }
+
     std::ostream &operator<<(std::ostream &os, const HttpRequest &req)
     {
         return req.dump(os);
@@ -97,6 +131,54 @@ namespace CIM::http
         return strcasecmp(lhs.c_str(), rhs.c_str()) < 0;
     }
 
+    uint32_t HttpHeaderHash(const char *s, size_t len)
+    {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; ++i)
+        {
+            h = (h ^ (uint8_t)(s[i] | 0x20)) * 16777619u;
+        }
+        return h;
+    }
+
+    void HttpHeaderList::add(const char *name, size_t name_len, const char *value, size_t value_len)
+    {
+        if (m_entries.empty())
+        {
+            // 一般请求头不超过几百字节、十几个，一次预留避免逐个增长
+            m_data.reserve(512);
+            m_entries.reserve(16);
+        }
+        Entry e;
+        e.hash = HttpHeaderHash(name, name_len);
+        e.name = m_data.size();
+        e.name_len = name_len;
+        m_data.append(name, name_len);
+        e.value = m_data.size();
+        e.value_len = value_len;
+        m_data.append(value, value_len);
+        m_entries.push_back(e);
+    }
+
+    const HttpHeaderList::Entry *HttpHeaderList::find(const char *key, size_t len, uint32_t hash) const
+    {
+        // 从后往前找，同名头部以最后一个为准，与MAP存储时后者覆盖前者一致
+        for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+        {
+            if (it->hash == hash && it->name_len == len && strncasecmp(at(it->name), key, len) == 0)
+            {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    void HttpHeaderList::clear()
+    {
+        m_data.clear();
+        m_entries.clear();
+    }
+
     HttpRequest::HttpRequest(uint8_t version, bool close)
         : m_method(HttpMethod::GET),
           m_path("/"),
@@ -135,6 +217,7 @@ namespace CIM::http
     }
     const HttpRequest::MapType &HttpRequest::getHeaders() const
     {
+        materializeHeaders();
         return m_headers;
     }
     const HttpRequest::MapType &HttpRequest::getParams() const
@@ -187,6 +270,7 @@ namespace CIM::http
     }
     void HttpRequest::setHeaders(const MapType &v)
     {
+        m_headerList.clear();
         m_headers = v;
     }
     void HttpRequest::setParams(const MapType &v)
@@ -199,8 +283,9 @@ namespace CIM::http
     }
     std::string HttpRequest::getHeader(const std::string &key, const std::string &def) const
     {
-        auto it = m_headers.find(key);
-        return it == m_headers.end() ? def : it->second;
+        size_t len = 0;
+        const char *v = findHeader(key.c_str(), key.size(), HttpHeaderHash(key.c_str(), key.size()), len);
+        return v ? std::string(v, len) : def;
     }
 
     std::string HttpRequest::getParam(const std::string &key, const std::string &def) const
@@ -217,6 +302,7 @@ namespace CIM::http
 
     void HttpRequest::setHeader(const std::string &key, const std::string &val)
     {
+        materializeHeaders();
         m_headers[key] = val;
     }
 
@@ -232,6 +318,7 @@ namespace CIM::http
 
     void HttpRequest::delHeader(const std::string &key)
     {
+        materializeHeaders();
         auto it = m_headers.find(key);
         if (it != m_headers.end())
         {
@@ -259,18 +346,65 @@ namespace CIM::http
 
     bool HttpRequest::hasHeader(const std::string &key, std::string *val)
     {
-        auto it = m_headers.find(key);
-        if (it == m_headers.end())
+        size_t len = 0;
+        const char *v = findHeader(key.c_str(), key.size(), HttpHeaderHash(key.c_str(), key.size()), len);
+        if (!v)
         {
             return false;
         }
         if (val)
         {
-            *val = it->second;
+            val->assign(v, len);
         }
         return true;
     }
 
+    void HttpRequest::appendHeader(const char *field, size_t flen, const char *value, size_t vlen)
+    {
+        if (!m_headers.empty())
+        {
+            m_headers[std::string(field, flen)] = std::string(value, vlen);
+            return;
+        }
+        m_headerList.add(field, flen, value, vlen);
+    }
+
+    const char *HttpRequest::findHeader(const char *key, size_t key_len, uint32_t hash, size_t &len) const
+    {
+        if (!m_headerList.empty())
+        {
+            const HttpHeaderList::Entry *e = m_headerList.find(key, key_len, hash);
+            if (!e)
+            {
+                return nullptr;
+            }
+            len = e->value_len;
+            return m_headerList.at(e->value);
+        }
+        auto it = m_headers.find(std::string(key, key_len));
+        if (it == m_headers.end())
+        {
+            return nullptr;
+        }
+        len = it->second.size();
+        return it->second.data();
+    }
+
+    void HttpRequest::materializeHeaders() const
+    {
+        if (m_headerList.empty())
+        {
+            return;
+        }
+        // MAP中同名头部只保留一个，与逐个setHeader的结果保持一致(后出现的覆盖前面的)
+        for (auto &i : m_headerList.getEntries())
+        {
+            m_headers[std::string(m_headerList.at(i.name), i.name_len)] =
+                std::string(m_headerList.at(i.value), i.value_len);
+        }
+        m_headerList.clear();
+    }
+
     bool HttpRequest::hasParam(const std::string &key, std::string *val)
     {
         auto it = m_params.find(key);
@@ -317,7 +451,7 @@ namespace CIM::http
      *
      *      请求体
      */
-    std::ostream &HttpRequest::dump(std::ostream &os) const
+    std::ostream &HttpRequest::dumpHead(std::ostream &os) const
     {
         // 输出请求行: 方法 URI HTTP版本
         os << HttpMethodToString(m_method) << " "
@@ -347,20 +481,31 @@ namespace CIM::http
             }
             os << i.first << ": " << i.second << "\r\n";
         }
-
-        // 输出请求体及长度
-        if (!m_body.empty())
+        for (auto &i : m_headerList.getEntries())
         {
-            os << "content-length: " << m_body.size() << "\r\n\r\n"
-               << m_body;
+            if (!m_websocket && i.hash == HttpHeaderHashes::CONNECTION && i.name_len == 10 &&
+                strncasecmp(m_headerList.at(i.name), "connection", i.name_len) == 0)
+            {
+                continue;
+            }
+            os.write(m_headerList.at(i.name), i.name_len) << ": ";
+            os.write(m_headerList.at(i.value), i.value_len) << "\r\n";
         }
-        else
+
+        // 输出请求体长度
+        if (!m_body.empty())
         {
-            os << "\r\n";
+            os << "content-length: " << m_body.size() << "\r\n";
         }
+        os << "\r\n";
         return os;
     }
 
+    std::ostream &HttpRequest::dump(std::ostream &os) const
+    {
+        return dumpHead(os) << m_body;
+    }
+
     std::string HttpRequest::toString() const
     {
         std::stringstream ss;
@@ -370,6 +515,38 @@ namespace CIM::http
 
     void HttpRequest::init()
     {
+        // Connection是逗号分隔的选项列表(如"keep-alive, Upgrade")：
+        // HTTP/1.1默认长连接，只有close选项时关闭；HTTP/1.0默认短连接，只有keep-alive选项时保持
+        bool has_close = false;
+        bool has_keep_alive = false;
+        size_t len = 0;
+        const char *conn = findHeader("connection", 10, HttpHeaderHashes::CONNECTION, len);
+        const char *end = conn ? conn + len : nullptr;
+        while (conn && conn < end)
+        {
+            const char *comma = (const char *)memchr(conn, ',', end - conn);
+            const char *token_end = comma ? comma : end;
+            while (conn < token_end && (*conn == ' ' || *conn == '\t'))
+            {
+                ++conn;
+            }
+            const char *last = token_end;
+            while (last > conn && (last[-1] == ' ' || last[-1] == '\t'))
+            {
+                --last;
+            }
+            size_t n = last - conn;
+            if (n == 5 && strncasecmp(conn, "close", 5) == 0)
+            {
+                has_close = true;
+            }
+            else if (n == 10 && strncasecmp(conn, "keep-alive", 10) == 0)
+            {
+                has_keep_alive = true;
+            }
+            conn = comma ? comma + 1 : end;
+        }
+        m_close = m_version >= 0x11 ? has_close : !has_keep_alive;
     }
 
     void HttpRequest::initParam()
@@ -489,7 +666,7 @@ namespace CIM::http
      * @param[in, out] os 输出流
      * @return 输出流
      */
-    std::ostream &HttpResponse::dump(std::ostream &os) const
+    std::ostream &HttpResponse::dumpHead(std::ostream &os) const
     {
         // 输出状态行: HTTP版本 状态码 原因短语
         os << "HTTP/"
@@ -525,17 +702,83 @@ namespace CIM::http
             os << "connection: " << (m_close ? "close" : "keep-alive") << "\r\n";
         }
 
-        // 如果有响应体，则输出Content-Length头和响应体，否则只输出结尾CRLF
+        // 如果有响应体，则输出Content-Length头，最后是结尾CRLF
         if (!m_body.empty())
         {
-            os << "content-length: " << m_body.size() << "\r\n\r\n"
-               << m_body;
+            os << "content-length: " << m_body.size() << "\r\n";
+        }
+        os << "\r\n";
+        return os;
+    }
+
+    void HttpResponse::serializeHead(std::string &out, const char *extra, size_t extra_len) const
+    {
+        // 状态行: HTTP版本 状态码 原因短语
+        out.append("HTTP/", 5);
+        out.push_back('0' + (m_version >> 4));
+        out.push_back('.');
+        out.push_back('0' + (m_version & 0x0F));
+        out.push_back(' ');
+        AppendUint(out, (uint32_t)m_status);
+        out.push_back(' ');
+        if (m_reason.empty())
+        {
+            out.append(HttpStatusToString(m_status));
         }
         else
         {
-            os << "\r\n";
+            out.append(m_reason);
         }
-        return os;
+        out.append("\r\n", 2);
+
+        // 响应头，WebSocket连接时跳过connection头
+        for (auto &i : m_headers)
+        {
+            if (!m_websocket && strcasecmp(i.first.c_str(), "connection") == 0)
+            {
+                continue;
+            }
+            out.append(i.first);
+            out.append(": ", 2);
+            out.append(i.second);
+            out.append("\r\n", 2);
+        }
+
+        for (auto &i : m_cookies)
+        {
+            out.append("Set-Cookie: ", 12);
+            out.append(i);
+            out.append("\r\n", 2);
+        }
+
+        if (!m_websocket)
+        {
+            if (m_close)
+            {
+                out.append("connection: close\r\n", 19);
+            }
+            else
+            {
+                out.append("connection: keep-alive\r\n", 24);
+            }
+        }
+
+        if (!m_body.empty())
+        {
+            out.append("content-length: ", 16);
+            AppendUint(out, m_body.size());
+            out.append("\r\n", 2);
+        }
+        if (extra_len)
+        {
+            out.append(extra, extra_len);
+        }
+        out.append("\r\n", 2);
+    }
+
+    std::ostream &HttpResponse::dump(std::ostream &os) const
+    {
+        return dumpHead(os) << m_body;
     }
 
     std::string HttpResponse::toString() const
@@ -242,10 +242,12 @@ namespace CIM::http
     int HttpConnection::sendRequest(HttpRequest::ptr rsp)
     {
         std::stringstream ss;
-        ss << *rsp;
-        std::string data = ss.str();
-        // std::cout << ss.str() << std::endl;
-        return writeFixSize(data.c_str(), data.size());
+        rsp->dumpHead(ss);
+        std::vector<BufferSlice> slices;
+        slices.push_back(BufferSlice::FromString(ss.str()));
+        const std::string &body = rsp->getBody();
+        slices.push_back(BufferSlice(body.data(), body.size(), rsp));
+        return writev(slices);
     }
 
     HttpResult::ptr HttpConnection::DoGet(const std::string &url, uint64_t timeout_ms, const std::map<std::string, std::string> &headers, const std::string &body)
@@ -16,12 +16,15 @@ namespace CIM::http
         CIM::Config::Lookup("http.response.buffer_size", (uint64_t)(4 * 1024), "http response buffer size");
     static auto g_http_response_max_body_size =
         CIM::Config::Lookup("http.response.max_body_size", (uint64_t)(64 * 1024 * 1024), "http response max body size");
+    static auto g_http_request_header_view =
+        CIM::Config::Lookup("http.request.header_view", true, "store http request headers in a flat list instead of a map");
 
     // 用于保存配置值，提升性能
     static uint64_t s_http_request_buffer_size = 0;
     static uint64_t s_http_request_max_body_size = 0;
     static uint64_t s_http_response_buffer_size = 0;
     static uint64_t s_http_response_max_body_size = 0;
+    static bool s_http_request_header_view = true;
 
     uint64_t HttpRequestParser::GetHttpRequestBufferSize()
     {
@@ -55,6 +58,7 @@ namespace CIM::http
                 s_http_request_max_body_size = g_http_request_max_body_size->getValue();
                 s_http_response_buffer_size = g_http_response_buffer_size->getValue();
                 s_http_response_max_body_size = g_http_response_max_body_size->getValue();
+                s_http_request_header_view = g_http_request_header_view->getValue();
 
                 // 设置配置修改时的回调函数
                 g_http_request_buffer_size->addListener(
@@ -80,6 +84,12 @@ namespace CIM::http
                     {
                         s_http_response_max_body_size = new_val;
                     });
+
+                g_http_request_header_view->addListener(
+                    [](const bool &old_val, const bool &new_val)
+                    {
+                        s_http_request_header_view = new_val;
+                    });
             }
         };
         static _RequestSizeIniter _init;
@@ -204,7 +214,8 @@ namespace CIM::http
      * @param[in] vlen HTTP头部字段值长度
      *
      * @details 该函数用于解析HTTP请求中的头部字段，将字段名和字段值作为键值对
-     * 设置到对应的HttpRequest对象中。如果字段名长度为0，则记录警告日志
+     * 设置到对应的HttpRequest对象中。如果字段名长度为0，则记录警告日志。
+     * http.request.header_view开启时追加到扁平存储，不为每个字段构造std::string和MAP节点
      */
     void on_request_http_field(void *data, const char *field, size_t flen, const char *value, size_t vlen)
     {
@@ -215,7 +226,14 @@ namespace CIM::http
             // parser->setError(1002);
             return;
         }
-        parser->getData()->setHeader(std::string(field, flen), std::string(value, vlen));
+        if (s_http_request_header_view)
+        {
+            parser->getData()->appendHeader(field, flen, value, vlen);
+        }
+        else
+        {
+            parser->getData()->setHeader(std::string(field, flen), std::string(value, vlen));
+        }
     }
 
     HttpRequestParser::HttpRequestParser()
@@ -234,11 +252,59 @@ namespace CIM::http
         m_parser.data = this;
     }
 
+    void HttpRequestParser::reset()
+    {
+        m_error = 0;
+        m_data.reset(new CIM::http::HttpRequest);
+        // 只重置状态机，回调和data指针保持不变
+        http_parser_init(&m_parser);
+    }
+
     void HttpRequestParser::setError(int v) { m_error = v; }
 
     uint64_t HttpRequestParser::getContentLength()
     {
-        return m_data->getHeaderAs<uint64_t>("content-length", 0);
+        size_t len = 0;
+        const char *v = m_data->findHeader("content-length", 14, HttpHeaderHashes::CONTENT_LENGTH, len);
+        if (!v)
+        {
+            return 0;
+        }
+        try
+        {
+            return boost::lexical_cast<uint64_t>(v, len);
+        }
+        catch (...)
+        {
+        }
+        return 0;
+    }
+
+    bool HttpRequestParser::isChunked()
+    {
+        size_t len = 0;
+        const char *v = m_data->findHeader("transfer-encoding", 17, HttpHeaderHashes::TRANSFER_ENCODING, len);
+        if (!v)
+        {
+            return false;
+        }
+        // 取最后一个编码，如 "gzip, chunked"
+        while (len > 0 && (v[len - 1] == ' ' || v[len - 1] == '\t'))
+        {
+            --len;
+        }
+        if (len < 7 || strncasecmp(v + len - 7, "chunked", 7) != 0)
+        {
+            return false;
+        }
+        return len == 7 || v[len - 8] == ',' || v[len - 8] == ' ' || v[len - 8] == '\t';
+    }
+
+    bool HttpRequestParser::isExpectContinue()
+    {
+        size_t len = 0;
+        const char *v = m_data->findHeader("expect", 6, HttpHeaderHashes::EXPECT, len);
+        return v && len == 12 && strncasecmp(v, "100-continue", 12) == 0;
     }
 
     const http_parser &HttpRequestParser::getParser() const { return m_parser; }
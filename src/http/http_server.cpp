@@ -30,11 +30,12 @@ namespace CIM::http
         CIM_LOG_DEBUG(g_logger) << "handleClient " << *client;
         /* 创建 HTTP 会话 */
         HttpSession::ptr session(new HttpSession(client));
+        session->setServerName(getName());
         do
         {
             /* 接收 HTTP 请求 */
             CIM_LOG_DEBUG(g_logger) << "waiting for http request from " << *client;
-            auto req = session->recvRequest();
+            auto req = session->recvRequestHead();
             if (!req)
             {
                 CIM_LOG_DEBUG(g_logger) << "recv http request fail, errno="
@@ -43,14 +44,51 @@ namespace CIM::http
                 break;
             }
 
+            /* 路由只查找一次，请求体的读取方式和处理都交给同一个servlet实例 */
+            Servlet::ptr slt = m_dispatch->getMatchedServlet(req->getMethod(), req->getPath(), req);
+
+            /* 接收请求体：servlet选择按流读取时留给servlet，否则整体读入请求 */
+            if (!session->isBodyFinished() && !(slt && slt->isStreamBody(req)) && !session->recvBody(req))
+            {
+                CIM_LOG_DEBUG(g_logger) << "recv http request body fail, errno="
+                                        << errno << " errstr=" << strerror(errno)
+                                        << " cliet:" << *client;
+                /* 请求体超过http.request.max_body_size时告知客户端后再关闭 */
+                if (session->isBodyTooLarge())
+                {
+                    HttpResponse::ptr rsp(new HttpResponse(req->getVersion(), true));
+                    rsp->setStatus(HttpStatus::PAYLOAD_TOO_LARGE);
+                    session->sendResponse(rsp);
+                }
+                break;
+            }
+
             /* 处理 HTTP 请求 */
             HttpResponse::ptr rsp(new HttpResponse(req->getVersion(), req->isClose() || !m_isKeepalive));
-            rsp->setHeader("Server", getName());
-            m_dispatch->handle(req, rsp, session); // 路由分发
-            session->sendResponse(rsp);            // 发送响应数据
+            if (slt)
+            {
+                slt->handle(req, rsp, session);
+            }
+
+            /* servlet没读完的请求体要丢弃才能解析下一个请求，丢弃不了就在响应后关闭连接 */
+            if (!session->isBodyFinished() && session->discardBody() <= 0)
+            {
+                rsp->setClose(true);
+                session->sendResponse(rsp);
+                break;
+            }
 
             /* 如果不是长连接或者客户端关闭，则关闭会话 */
             if (!m_isKeepalive || req->isClose())
+            {
+                session->sendResponse(rsp);
+                break;
+            }
+
+            /* HTTP/1.1流水线：读缓冲中已有后续请求时响应先排队，按请求顺序与后面的响应一起发出 */
+            int rt = session->hasBufferedData() ? session->queueResponse(rsp)
+                                                : session->sendResponse(rsp);
+            if (rt <= 0)
             {
                 break;
             }
@@ -1,9 +1,107 @@
 #include "http_servlet.hpp"
-
-#include <fnmatch.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
 
 namespace CIM::http {
-Servlet::Servlet(const std::string& name) : m_name(name) {}
+namespace {
+
+/**
+ * @brief 路由快照的读者记录
+ * @details 每个线程第一次查找时领取一条，线程退出后归还复用，记录本身不释放。
+ * epoch为0表示不在查找中，否则为进入查找时的全局纪元
+ */
+struct RouterReader {
+    alignas(64) std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> used{false};
+    uint32_t depth = 0;  /// 嵌套深度，只由持有线程访问
+    RouterReader* next = nullptr;
+};
+
+/// 全局纪元，每作废一个快照加一
+std::atomic<uint64_t> s_routerEpoch{1};
+/// 所有读者记录，只增不减
+std::atomic<RouterReader*> s_routerReaders{nullptr};
+
+RouterReader* AcquireRouterReader() {
+    for (RouterReader* r = s_routerReaders.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->used.load(std::memory_order_relaxed) &&
+            r->used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    // 记录按缓存行对齐，C++17之前的new不保证扩展对齐
+    void* mem = nullptr;
+    if (posix_memalign(&mem, alignof(RouterReader), sizeof(RouterReader))) {
+        throw std::bad_alloc();
+    }
+    RouterReader* r = new (mem) RouterReader;
+    r->used.store(true, std::memory_order_relaxed);
+    r->next = s_routerReaders.load(std::memory_order_relaxed);
+    while (!s_routerReaders.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+    }
+    return r;
+}
+
+/**
+ * @brief 线程持有的读者记录，线程退出时归还
+ */
+struct RouterReaderHolder {
+    RouterReader* reader = AcquireRouterReader();
+    ~RouterReaderHolder() { reader->used.store(false, std::memory_order_release); }
+};
+
+/// 本线程的读者记录，普通指针的thread_local访问不经过初始化检查
+thread_local RouterReader* t_routerReader = nullptr;
+
+RouterReader* GetRouterReader() {
+    if (!t_routerReader) {
+        static thread_local RouterReaderHolder s_holder;
+        t_routerReader = s_holder.reader;
+    }
+    return t_routerReader;
+}
+
+/**
+ * @brief 查找期间登记当前纪元，登记期间作废的快照不会被释放，可以嵌套
+ */
+class RouterReadGuard {
+public:
+    RouterReadGuard() : m_reader(GetRouterReader()) {
+        if (m_reader->depth++ == 0) {
+            // 与作废快照时的exchange和扫描构成先登记后读指针、先摘除后扫描，需要seq_cst
+            m_reader->epoch.store(s_routerEpoch.load(std::memory_order_relaxed));
+        }
+    }
+    ~RouterReadGuard() {
+        if (--m_reader->depth == 0) {
+            m_reader->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+private:
+    RouterReader* m_reader;
+};
+
+/**
+ * @brief 正在查找的读者中最小的纪元，没有读者时为UINT64_MAX
+ */
+uint64_t MinActiveRouterEpoch() {
+    uint64_t min = UINT64_MAX;
+    for (RouterReader* r = s_routerReaders.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t e = r->epoch.load();
+        if (e && e < min) {
+            min = e;
+        }
+    }
+    return min;
+}
+
+}  // namespace
+
+Servlet::Servlet(const std::string& name) : m_name(name), m_streamBody(false) {}
 Servlet::~Servlet() {}
 FunctionServlet::FunctionServlet(callback cb) : Servlet("FunctionServlet"), m_cb(cb) {}
 
@@ -12,27 +110,57 @@ int32_t FunctionServlet::handle(HttpRequest::ptr request, HttpResponse::ptr resp
     return m_cb(request, response, session);
 }
 
-ServletDispatch::ServletDispatch() : Servlet("ServletDispatch") {
+ServletDispatch::ServletDispatch() : Servlet("ServletDispatch"), m_router(nullptr) {
     m_default.reset(new NotFoundServlet("CIM/1.0"));
 }
 
+ServletDispatch::~ServletDispatch() {
+    delete m_router.load();
+    for (auto& i : m_garbage) {
+        delete i.first;
+    }
+}
+
 int32_t ServletDispatch::handle(HttpRequest::ptr request, http::HttpResponse::ptr response,
                                 HttpSession::ptr session) {
-    auto slt = getMatchedServlet(request->getPath());
+    auto slt = getMatchedServlet(request->getMethod(), request->getPath(), request);
     if (slt) {
         slt->handle(request, response, session);
     }
     return 0;
 }
 
+bool ServletDispatch::isStreamBody(HttpRequest::ptr request) {
+    auto slt = getMatchedServlet(request->getMethod(), request->getPath());
+    return slt && slt->isStreamBody(request);
+}
+
 void ServletDispatch::addServlet(const std::string& uri, Servlet::ptr slt) {
     RWMutexType::WriteLock lock(m_mutex);
     m_datas[uri] = std::make_shared<HoldServletCreator>(slt);
+    invalidateRouter();
+}
+
+void ServletDispatch::addServlet(HttpMethod method, const std::string& uri, Servlet::ptr slt) {
+    addServletCreator(method, uri, std::make_shared<HoldServletCreator>(slt));
+}
+
+void ServletDispatch::addServlet(HttpMethod method, const std::string& uri,
+                                 FunctionServlet::callback cb) {
+    addServlet(method, uri, std::make_shared<FunctionServlet>(cb));
 }
 
 void ServletDispatch::addServletCreator(const std::string& uri, IServletCreator::ptr creator) {
     RWMutexType::WriteLock lock(m_mutex);
     m_datas[uri] = creator;
+    invalidateRouter();
+}
+
+void ServletDispatch::addServletCreator(HttpMethod method, const std::string& uri,
+                                        IServletCreator::ptr creator) {
+    RWMutexType::WriteLock lock(m_mutex);
+    m_methodDatas[std::make_pair(method, uri)] = creator;
+    invalidateRouter();
 }
 
 void ServletDispatch::addGlobServletCreator(const std::string& uri, IServletCreator::ptr creator) {
@@ -44,11 +172,13 @@ void ServletDispatch::addGlobServletCreator(const std::string& uri, IServletCrea
         }
     }
     m_globs.push_back(std::make_pair(uri, creator));
+    invalidateRouter();
 }
 
 void ServletDispatch::addServlet(const std::string& uri, FunctionServlet::callback cb) {
     RWMutexType::WriteLock lock(m_mutex);
     m_datas[uri] = std::make_shared<HoldServletCreator>(std::make_shared<FunctionServlet>(cb));
+    invalidateRouter();
 }
 
 void ServletDispatch::addGlobServlet(const std::string& uri, Servlet::ptr slt) {
@@ -60,6 +190,7 @@ void ServletDispatch::addGlobServlet(const std::string& uri, Servlet::ptr slt) {
         }
     }
     m_globs.push_back(std::make_pair(uri, std::make_shared<HoldServletCreator>(slt)));
+    invalidateRouter();
 }
 
 void ServletDispatch::addGlobServlet(const std::string& uri, FunctionServlet::callback cb) {
@@ -69,6 +200,13 @@ void ServletDispatch::addGlobServlet(const std::string& uri, FunctionServlet::ca
 void ServletDispatch::delServlet(const std::string& uri) {
     RWMutexType::WriteLock lock(m_mutex);
     m_datas.erase(uri);
+    invalidateRouter();
+}
+
+void ServletDispatch::delServlet(HttpMethod method, const std::string& uri) {
+    RWMutexType::WriteLock lock(m_mutex);
+    m_methodDatas.erase(std::make_pair(method, uri));
+    invalidateRouter();
 }
 
 void ServletDispatch::delGlobServlet(const std::string& uri) {
@@ -79,6 +217,7 @@ void ServletDispatch::delGlobServlet(const std::string& uri) {
             break;
         }
     }
+    invalidateRouter();
 }
 
 Servlet::ptr ServletDispatch::getServlet(const std::string& uri) {
@@ -98,22 +237,70 @@ Servlet::ptr ServletDispatch::getGlobServlet(const std::string& uri) {
 }
 
 Servlet::ptr ServletDispatch::getMatchedServlet(const std::string& uri) {
-    RWMutexType::ReadLock lock(m_mutex);
-    // 精准匹配
-    auto mit = m_datas.find(uri);
-    if (mit != m_datas.end()) {
-        return mit->second->get();
+    return getMatchedServlet(HttpMethod::INVALID_METHOD, uri);
+}
+
+Servlet::ptr ServletDispatch::getMatchedServlet(HttpMethod method, const std::string& uri,
+                                                HttpRequest::ptr request) {
+    // 快照和其中的creator在guard析构前都不会被释放
+    RouterReadGuard guard;
+    const ServletRouter* router = getRouter();
+    ServletRouter::Params params;
+    auto creator = router->match(method, uri, request ? &params : nullptr);
+    if (!creator) {
+        // 返回默认值
+        return m_default;
+    }
+    for (auto& i : params) {
+        request->setParam(i.first, i.second);
     }
+    return creator->get();
+}
 
-    // 模糊匹配
-    for (auto it = m_globs.begin(); it != m_globs.end(); ++it) {
-        if (!fnmatch(it->first.c_str(), uri.c_str(), 0)) {
-            return it->second->get();
+void ServletDispatch::invalidateRouter() {
+    ServletRouter* old = m_router.exchange(nullptr);
+    if (old) {
+        // 其他线程可能还在用旧快照查找，记下摘除时的纪元，之后登记的读者看不到它
+        m_garbage.push_back(std::make_pair(old, s_routerEpoch.fetch_add(1)));
+    }
+    // 比所有正在查找的读者都早摘除的快照已经没有人引用
+    if (!m_garbage.empty()) {
+        uint64_t min = MinActiveRouterEpoch();
+        size_t n = 0;
+        for (auto& i : m_garbage) {
+            if (i.second < min) {
+                delete i.first;
+            } else {
+                m_garbage[n++] = i;
+            }
         }
+        m_garbage.resize(n);
+    }
+}
+
+const ServletRouter* ServletDispatch::getRouter() {
+    ServletRouter* router = m_router.load();
+    if (router) {
+        return router;
     }
 
-    // 返回默认值
-    return m_default;
+    RWMutexType::WriteLock lock(m_mutex);
+    router = m_router.load(std::memory_order_acquire);
+    if (router) {
+        return router;
+    }
+    router = new ServletRouter;
+    for (auto& i : m_datas) {
+        router->add(i.first, i.second);
+    }
+    for (auto& i : m_methodDatas) {
+        router->add(i.first.second, i.second, i.first.first);
+    }
+    for (auto& i : m_globs) {
+        router->addGlob(i.first, i.second);
+    }
+    m_router.store(router, std::memory_order_release);
+    return router;
 }
 
 void ServletDispatch::listAllServletCreator(std::map<std::string, IServletCreator::ptr>& infos) {
@@ -121,6 +308,9 @@ void ServletDispatch::listAllServletCreator(std::map<std::string, IServletCreato
     for (auto& i : m_datas) {
         infos[i.first] = i.second;
     }
+    for (auto& i : m_methodDatas) {
+        infos[std::string(HttpMethodToString(i.first.first)) + " " + i.first.second] = i.second;
+    }
 }
 
 void ServletDispatch::listAllGlobServletCreator(
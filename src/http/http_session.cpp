@@ -1,116 +1,502 @@
 #include "http_session.hpp"
 #include "http_parser.hpp"
+#include "config.hpp"
+#include "macro.hpp"
 
 namespace CIM::http
 {
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    static auto g_http_pipeline_max_queued =
+        CIM::Config::Lookup("http.pipeline.max_queued", (uint32_t)16, "http pipeline max queued responses");
+
+    /**
+     * @brief 请求体流，读取转发到HttpSession::readBody
+     */
+    class HttpBodyStream : public Stream
+    {
+    public:
+        HttpBodyStream(HttpSession *session)
+            : m_session(session)
+        {
+        }
+
+        int read(void *buffer, size_t length) override
+        {
+            return m_session->readBody(buffer, length);
+        }
+
+        int read(ByteArray::ptr ba, size_t length) override
+        {
+            std::vector<iovec> iovs;
+            ba->getWriteBuffers(iovs, length);
+            if (iovs.empty())
+            {
+                return 0;
+            }
+            int rt = m_session->readBody(iovs[0].iov_base, iovs[0].iov_len);
+            if (rt > 0)
+            {
+                ba->setPosition(ba->getPosition() + rt);
+            }
+            return rt;
+        }
+
+        int write(const void *buffer, size_t length) override { return -1; }
+        int write(ByteArray::ptr ba, size_t length) override { return -1; }
+        void close() override {}
+
+    private:
+        /// 所属会话，流由会话持有
+        HttpSession *m_session;
+    };
+
     HttpSession::HttpSession(Socket::ptr sock, bool owner)
-        : SocketStream(sock, owner)
+        : SocketStream(sock, owner),
+          m_parser(new HttpRequestParser),
+          m_offset(0),
+          m_bodyState(BODY_DONE),
+          m_bodyChunked(false),
+          m_expectContinue(false),
+          m_bodyLeft(0),
+          m_bodySize(0)
     {
     }
 
     HttpRequest::ptr HttpSession::recvRequest()
     {
-        // 创建HTTP请求解析器实例，用于解析接收到的数据
-        HttpRequestParser::ptr parser(new HttpRequestParser);
+        HttpRequest::ptr req = recvRequestHead();
+        if (!req || !recvBody(req))
+        {
+            close();
+            return nullptr;
+        }
+        return req;
+    }
+
+    HttpRequest::ptr HttpSession::recvRequestHead()
+    {
+        // 重置解析器，复用上一个请求的解析器和读缓冲
+        m_parser->reset();
         // 获取HTTP请求缓冲区大小配置，用于控制每次读取数据的大小（防止恶意数据）
         uint64_t buff_size = HttpRequestParser::GetHttpRequestBufferSize();
-        // uint64_t buff_size = 100;
-        // 分配缓冲区内存，使用智能指针管理内存自动释放
-        std::shared_ptr<char> buffer(new char[buff_size], [](char *ptr)
-                                     { delete[] ptr; });
-        char *data = buffer.get();
-        int offset = 0; // 记录缓冲区中未处理数据的偏移量
+        // 缓冲区只在第一次使用或配置变化时分配，缩小时不能丢掉已缓存的数据
+        if (m_buffer.size() != buff_size && m_offset <= buff_size)
+        {
+            m_buffer.resize(buff_size);
+        }
+        buff_size = m_buffer.size();
+        char *data = &m_buffer[0];
 
+        // 读缓冲中有上次剩余的数据时先解析，流水线请求不需要再读socket
+        bool need_read = (m_offset == 0);
         // 循环读取数据直到解析完成或出错
         do
         {
-            // 从socket中读取数据，读取大小为缓冲区剩余空间大小
-            int len = read(data + offset, buff_size - offset);
-            // 如果读取失败或连接关闭，则关闭会话并返回空指针
-            if (len <= 0)
+            if (need_read)
             {
-                close();
-                return nullptr;
+                // 从socket中读取数据，读取大小为缓冲区剩余空间大小
+                int len = readSocket(data + m_offset, buff_size - m_offset);
+                // 如果读取失败或连接关闭，则关闭会话并返回空指针
+                if (len <= 0)
+                {
+                    close();
+                    return nullptr;
+                }
+                // 计算缓冲区中总的数据长度
+                m_offset += len;
             }
+            need_read = true;
 
-            // 计算缓冲区中总的数据长度
-            len += offset;
             // 执行解析操作，返回已解析的数据长度
-            size_t nparse = parser->execute(data, len);
-            // 如果解析过程中出现错误，则关闭会话并返回空指针
-            if (parser->hasError())
+            size_t nparse = m_parser->execute(data, m_offset);
+            // 如果解析过程中出现错误，则关闭会话并返回空指针（之前排队的响应照常发出）
+            if (m_parser->hasError())
             {
+                flushResponses();
                 close();
                 return nullptr;
             }
 
             // 更新偏移量，保留未解析的数据供下次处理
-            offset = len - nparse;
+            m_offset -= nparse;
             // 如果缓冲区已满但还未解析完成，说明请求过大，关闭连接
-            if (offset == (int)buff_size)
+            if (m_offset == buff_size)
             {
+                flushResponses();
                 close();
                 return nullptr;
             }
             // 如果解析完成（请求头解析完毕），则跳出循环
-            if (parser->isFinished())
+            if (m_parser->isFinished())
             {
                 break;
             }
         } while (true);
 
-        // 获取请求体长度
-        int64_t length = parser->getContentLength();
-        // 如果存在请求体数据
-        if (length > 0)
+        // 初始化HTTP请求对象（解析请求头中的信息）
+        m_parser->getData()->init();
+
+        // 请求体留在连接上，由recvBody或readBody读取。Transfer-Encoding优先于Content-Length
+        m_bodySize = 0;
+        m_bodyLeft = 0;
+        m_bodyChunked = m_parser->isChunked();
+        if (m_bodyChunked)
+        {
+            m_bodyState = BODY_CHUNK_SIZE;
+        }
+        else
+        {
+            m_bodyLeft = m_parser->getContentLength();
+            m_bodySize = m_bodyLeft;
+            m_bodyState = m_bodyLeft > 0 ? BODY_DATA : BODY_DONE;
+            if (m_bodySize > HttpRequestParser::GetHttpRequestMaxBodySize())
+            {
+                CIM_LOG_WARN(g_logger) << "http request body too large, content-length=" << m_bodySize;
+                m_bodyState = BODY_TOO_LARGE;
+            }
+        }
+        m_expectContinue = m_bodyState != BODY_DONE && m_parser->isExpectContinue();
+        // 返回解析得到的HTTP请求对象
+        return m_parser->getData();
+    }
+
+    bool HttpSession::recvBody(HttpRequest::ptr request)
+    {
+        if (m_bodyState == BODY_DONE)
+        {
+            return true;
+        }
+        // 定长请求体一次分配，分块时按需扩大
+        std::string body;
+        body.resize(m_bodyChunked ? 0 : m_bodyLeft);
+        size_t pos = 0;
+        while (true)
+        {
+            if (pos == body.size())
+            {
+                if (!m_bodyChunked)
+                {
+                    break;
+                }
+                body.resize(std::max(body.size() * 2, (size_t)4096));
+            }
+            int rt = readBody(&body[pos], body.size() - pos);
+            if (rt < 0)
+            {
+                return false;
+            }
+            if (rt == 0)
+            {
+                break;
+            }
+            pos += rt;
+        }
+        body.resize(pos);
+        // 设置解析得到的HTTP请求对象的请求体
+        request->setBody(body);
+        return true;
+    }
+
+    int HttpSession::readBody(void *buffer, size_t length)
+    {
+        while (m_bodyState != BODY_DATA)
+        {
+            if (m_bodyState == BODY_DONE)
+            {
+                return 0;
+            }
+            if (m_bodyState == BODY_ERROR || m_bodyState == BODY_TOO_LARGE || !readChunkHead())
+            {
+                return -1;
+            }
+        }
+        if (length == 0)
+        {
+            return 0;
+        }
+
+        if (m_offset == 0 && m_expectContinue && sendContinue() <= 0)
+        {
+            m_bodyState = BODY_ERROR;
+            return -1;
+        }
+        // read先取读缓冲中的数据，不足的部分再从socket读取，多出的数据留给下一个请求
+        int rt = read(buffer, std::min((uint64_t)length, m_bodyLeft));
+        if (rt <= 0)
+        {
+            // 请求体没读完连接就断开也算出错
+            m_bodyState = BODY_ERROR;
+            return -1;
+        }
+        m_bodyLeft -= rt;
+        if (m_bodyLeft == 0)
+        {
+            m_bodyState = m_bodyChunked ? BODY_CHUNK_CRLF : BODY_DONE;
+        }
+        return rt;
+    }
+
+    Stream::ptr HttpSession::getBodyStream()
+    {
+        if (!m_bodyStream)
+        {
+            m_bodyStream.reset(new HttpBodyStream(this));
+        }
+        return m_bodyStream;
+    }
+
+    int HttpSession::discardBody()
+    {
+        if (m_bodyState == BODY_DONE)
+        {
+            return 1;
+        }
+        // 客户端还没发送请求体，不能用100 Continue引出一个不需要的请求体，只能关闭连接
+        if (m_expectContinue)
+        {
+            return 0;
+        }
+        char buf[4096];
+        int rt = 0;
+        while ((rt = readBody(buf, sizeof(buf))) > 0)
         {
-            // 创建存储请求体的字符串
-            std::string body;
-            body.resize(length); // 调整字符串大小以容纳请求体数据
+        }
+        return rt == 0 ? 1 : rt;
+    }
 
-            int len = 0; // 已读取的请求体长度
-            // 如果请求体长度大于等于缓冲区中已有的数据量
-            if (length >= offset)
+    int HttpSession::fillLine()
+    {
+        const char *data = &m_buffer[0];
+        size_t searched = 0;
+        while (true)
+        {
+            const char *p = (const char *)memchr(data + searched, '\n', m_offset - searched);
+            if (p)
+            {
+                return p - data + 1;
+            }
+            searched = m_offset;
+            if (m_offset == m_buffer.size())
             {
-                // 将缓冲区中的数据复制到请求体中
-                memcpy(&body[0], data, offset);
-                len = offset; // 更新已读取长度
+                return -1;
             }
-            else
+            if (m_expectContinue && sendContinue() <= 0)
             {
-                // 只复制需要的部分数据
-                memcpy(&body[0], data, length);
-                len = length; // 更新已读取长度
+                return -1;
             }
+            int rt = readSocket(&m_buffer[0] + m_offset, m_buffer.size() - m_offset);
+            if (rt <= 0)
+            {
+                return -1;
+            }
+            m_offset += rt;
+        }
+    }
+
+    bool HttpSession::readChunkHead()
+    {
+        int len = fillLine();
+        if (len <= 0)
+        {
+            m_bodyState = BODY_ERROR;
+            return false;
+        }
+        const char *line = &m_buffer[0];
+        // 去掉行尾的CRLF
+        size_t n = len - 1;
+        if (n > 0 && line[n - 1] == '\r')
+        {
+            --n;
+        }
 
-            // 计算剩余需要读取的请求体长度
-            length -= offset;
-            // 如果还有剩余数据需要读取
-            if (length > 0)
+        if (m_bodyState == BODY_CHUNK_SIZE)
+        {
+            // 分块长度为十六进制，后面可以跟";扩展"
+            uint64_t size = 0;
+            size_t i = 0;
+            for (; i < n; ++i)
             {
-                // 读取固定大小的数据到请求体剩余部分
-                if (readFixSize(&body[len], length) <= 0)
+                int c = line[i];
+                int v = c >= '0' && c <= '9'   ? c - '0'
+                        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                               : -1;
+                if (v < 0)
                 {
-                    // 如果读取失败，则关闭连接并返回空指针
-                    close();
-                    return nullptr;
+                    break;
                 }
+                if (size >> 60)
+                {
+                    i = 0;
+                    break;
+                }
+                size = (size << 4) | v;
             }
-            // 设置解析得到的HTTP请求对象的请求体
-            parser->getData()->setBody(body);
+            if (i == 0 || (i < n && line[i] != ';' && line[i] != ' ' && line[i] != '\t'))
+            {
+                CIM_LOG_WARN(g_logger) << "invalid http chunk size line: " << std::string(line, n);
+                m_bodyState = BODY_ERROR;
+                return false;
+            }
+            if (size > HttpRequestParser::GetHttpRequestMaxBodySize() - m_bodySize)
+            {
+                CIM_LOG_WARN(g_logger) << "http request body too large, chunked size>" << m_bodySize + size;
+                m_bodyState = BODY_TOO_LARGE;
+                return false;
+            }
+            m_bodySize += size;
+            m_bodyLeft = size;
+            m_bodyState = size > 0 ? BODY_DATA : BODY_TRAILER;
         }
+        else if (m_bodyState == BODY_CHUNK_CRLF)
+        {
+            if (n != 0)
+            {
+                CIM_LOG_WARN(g_logger) << "invalid http chunk, missing CRLF after data";
+                m_bodyState = BODY_ERROR;
+                return false;
+            }
+            m_bodyState = BODY_CHUNK_SIZE;
+        }
+        else if (n == 0)
+        {
+            // trailer以空行结束，trailer中的头部忽略
+            m_bodyState = BODY_DONE;
+        }
+        consumeBuffer(len);
+        return true;
+    }
 
-        // 初始化HTTP请求对象（解析请求头中的信息）
-        parser->getData()->init();
-        // 返回解析得到的HTTP请求对象
-        return parser->getData();
+    int HttpSession::sendContinue()
+    {
+        m_expectContinue = false;
+        // 之前排队的响应要先发出
+        int rt = flushResponses();
+        if (rt <= 0)
+        {
+            return rt;
+        }
+        static const char s_continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        return writeFixSize(s_continue, sizeof(s_continue) - 1);
     }
 
     int HttpSession::sendResponse(HttpResponse::ptr rsp)
     {
-        std::stringstream ss;
-        ss << *rsp;
-        std::string data = ss.str();
-        return writeFixSize(data.c_str(), data.size());
+        int rt = queueResponse(rsp);
+        if (rt <= 0)
+        {
+            return rt;
+        }
+        return flushResponses();
+    }
+
+    int HttpSession::queueResponse(HttpResponse::ptr rsp)
+    {
+        // Date、Server头预先格式化，响应自己设置了的不重复输出
+        const HttpResponse::MapType &headers = rsp->getHeaders();
+        m_extra.clear();
+        if (!headers.count("date"))
+        {
+            m_extra.append(GetHttpDateHeader());
+        }
+        if (!m_serverHeader.empty() && !headers.count("server"))
+        {
+            m_extra.append(m_serverHeader);
+        }
+
+        // 状态行和头部直接写入连接的头部缓冲，响应体不拷贝，由rsp持有到发送完成
+        PendingResponse pending;
+        pending.offset = m_head.size();
+        rsp->serializeHead(m_head, m_extra.data(), m_extra.size());
+        pending.length = m_head.size() - pending.offset;
+        pending.rsp = rsp;
+        m_pending.push_back(pending);
+
+        if (m_pending.size() >= g_http_pipeline_max_queued->getValue())
+        {
+            return flushResponses();
+        }
+        return 1;
+    }
+
+    int HttpSession::flushResponses()
+    {
+        if (m_pending.empty())
+        {
+            return 1;
+        }
+        // 头部片段指向m_head，不带owner，零拷贝发送时由writev复制一份，返回后即可复用
+        m_slices.clear();
+        for (auto &i : m_pending)
+        {
+            m_slices.push_back(BufferSlice(m_head.data() + i.offset, i.length));
+            const std::string &body = i.rsp->getBody();
+            if (!body.empty())
+            {
+                m_slices.push_back(BufferSlice(body.data(), body.size(), i.rsp));
+            }
+        }
+        int rt = SocketStream::writev(m_slices);
+        m_slices.clear();
+        m_pending.clear();
+        m_head.clear();
+        return rt;
+    }
+
+    void HttpSession::setServerName(const std::string &v)
+    {
+        m_serverHeader = "Server: " + v + "\r\n";
+    }
+
+    int HttpSession::read(void *buffer, size_t length)
+    {
+        if (m_offset == 0)
+        {
+            return readSocket(buffer, length);
+        }
+        size_t n = std::min(length, m_offset);
+        memcpy(buffer, &m_buffer[0], n);
+        consumeBuffer(n);
+        return n;
+    }
+
+    int HttpSession::read(ByteArray::ptr ba, size_t length)
+    {
+        if (m_offset == 0)
+        {
+            int rt = flushResponses();
+            if (rt <= 0)
+            {
+                return rt;
+            }
+            return SocketStream::read(ba, length);
+        }
+        size_t n = std::min(length, m_offset);
+        ba->write(&m_buffer[0], n);
+        consumeBuffer(n);
+        return n;
+    }
+
+    int HttpSession::readSocket(void *buffer, size_t length)
+    {
+        if (!m_pending.empty())
+        {
+            int rt = flushResponses();
+            if (rt <= 0)
+            {
+                return rt;
+            }
+        }
+        return SocketStream::read(buffer, length);
+    }
+
+    void HttpSession::consumeBuffer(size_t length)
+    {
+        m_offset -= length;
+        if (m_offset > 0)
+        {
+            memmove(&m_buffer[0], &m_buffer[length], m_offset);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "servlet_router.hpp"
+#include "macro.hpp"
+#include <fnmatch.h>
+#include <string.h>
+
+namespace CIM::http
+{
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    /**
+     * @brief 树节点
+     * @details prefix为从父节点到本节点的静态路径片段，静态子节点的首字符互不相同，记录在indices中
+     */
+    struct ServletRouter::Node
+    {
+        std::string prefix;                                  /// 静态路径片段
+        std::string indices;                                 /// 静态子节点的首字符
+        std::vector<std::unique_ptr<Node>> children;         /// 静态子节点
+        std::unique_ptr<Node> param;                         /// 路径参数子节点
+        std::string paramName;                               /// 路径参数名
+        Handler any;                                         /// 不区分方法的处理器
+        std::vector<std::pair<HttpMethod, Handler>> methods; /// 按方法区分的处理器
+        Handler catchAll;                                    /// 本节点之后任意后缀的处理器
+
+        /**
+         * @brief 返回本节点上与方法对应的处理器，方法不匹配时使用不区分方法的处理器
+         */
+        const Handler &handlerFor(HttpMethod method) const
+        {
+            if (method != HttpMethod::INVALID_METHOD)
+            {
+                for (auto &i : methods)
+                {
+                    if (i.first == method)
+                    {
+                        return i.second;
+                    }
+                }
+            }
+            return any;
+        }
+    };
+
+    ServletRouter::ServletRouter()
+        : m_root(new Node)
+    {
+    }
+
+    ServletRouter::~ServletRouter()
+    {
+    }
+
+    ServletRouter::Node *ServletRouter::insertStatic(Node *n, const char *s, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t idx = n->indices.find(s[0]);
+            if (idx == std::string::npos)
+            {
+                std::unique_ptr<Node> child(new Node);
+                child->prefix.assign(s, len);
+                n->indices.push_back(s[0]);
+                n->children.push_back(std::move(child));
+                return n->children.back().get();
+            }
+
+            Node *c = n->children[idx].get();
+            size_t common = 0;
+            size_t max = std::min(len, c->prefix.size());
+            while (common < max && c->prefix[common] == s[common])
+            {
+                ++common;
+            }
+            if (common < c->prefix.size())
+            {
+                // 公共前缀比子节点短，拆出中间节点
+                std::unique_ptr<Node> mid(new Node);
+                mid->prefix = c->prefix.substr(0, common);
+                c->prefix.erase(0, common);
+                mid->indices.push_back(c->prefix[0]);
+                mid->children.push_back(std::move(n->children[idx]));
+                n->children[idx] = std::move(mid);
+                c = n->children[idx].get();
+            }
+            n = c;
+            s += common;
+            len -= common;
+        }
+        return n;
+    }
+
+    void ServletRouter::add(const std::string &path, Handler handler, HttpMethod method)
+    {
+        Node *n = m_root.get();
+        bool has_param = false;
+        size_t pos = 0;
+        while (pos < path.size())
+        {
+            // 路径参数只出现在段首
+            size_t colon = pos;
+            while (colon < path.size() && !(path[colon] == ':' && colon > 0 && path[colon - 1] == '/'))
+            {
+                ++colon;
+            }
+            n = insertStatic(n, path.c_str() + pos, colon - pos);
+            if (colon == path.size())
+            {
+                break;
+            }
+
+            size_t end = path.find('/', colon);
+            if (end == std::string::npos)
+            {
+                end = path.size();
+            }
+            has_param = true;
+            std::string name = path.substr(colon + 1, end - colon - 1);
+            if (!n->param)
+            {
+                n->param.reset(new Node);
+                n->paramName = name;
+            }
+            else if (n->paramName != name)
+            {
+                // 同一位置只能有一个参数名，沿用先添加的
+                CIM_LOG_WARN(g_logger) << "ServletRouter route " << path << " param :" << name
+                                       << " conflicts with :" << n->paramName;
+            }
+            n = n->param.get();
+            pos = end;
+        }
+        if (method == HttpMethod::INVALID_METHOD)
+        {
+            n->any = handler;
+        }
+        else
+        {
+            auto it = n->methods.begin();
+            while (it != n->methods.end() && it->first != method)
+            {
+                ++it;
+            }
+            if (it != n->methods.end())
+            {
+                it->second = handler;
+            }
+            else
+            {
+                n->methods.push_back(std::make_pair(method, handler));
+            }
+        }
+
+        if (!has_param)
+        {
+            // 同一静态路径总是落在同一个节点上，每次添加后刷新索引中的处理器
+            Static &st = m_statics[path];
+            st.node = n;
+            st.any = n->any.get();
+            st.hasMethods = !n->methods.empty();
+        }
+    }
+
+    void ServletRouter::addGlob(const std::string &pattern, Handler handler)
+    {
+        size_t meta = pattern.find_first_of("*?[\\");
+        if (meta == pattern.size() - 1 && pattern[meta] == '*')
+        {
+            Node *n = insertStatic(m_root.get(), pattern.c_str(), pattern.size() - 1);
+            n->catchAll = handler;
+            return;
+        }
+        m_globs.push_back(std::make_pair(pattern, handler));
+    }
+
+    bool ServletRouter::find(const Node *n, HttpMethod method, const char *p, const char *end,
+                             Params *params, const Handler *&handler) const
+    {
+        // 沿静态节点循环下降，记录最深的前缀通配；只有遇到路径参数需要回溯时才递归
+        const Handler *fallback = nullptr;
+        while (true)
+        {
+            if (n->catchAll)
+            {
+                fallback = &n->catchAll;
+            }
+            if (p == end)
+            {
+                const Handler &h = n->handlerFor(method);
+                if (h)
+                {
+                    handler = &h;
+                    return true;
+                }
+                break;
+            }
+
+            // 静态子节点
+            const Node *c = nullptr;
+            for (size_t i = 0; i < n->indices.size(); ++i)
+            {
+                if (n->indices[i] == *p)
+                {
+                    c = n->children[i].get();
+                    break;
+                }
+            }
+            if (c)
+            {
+                size_t len = c->prefix.size();
+                const char *s = c->prefix.data();
+                if ((size_t)(end - p) < len)
+                {
+                    c = nullptr;
+                }
+                else
+                {
+                    for (size_t i = 1; i < len; ++i)
+                    {
+                        if (p[i] != s[i])
+                        {
+                            c = nullptr;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (!n->param)
+            {
+                if (!c)
+                {
+                    break;
+                }
+                p += c->prefix.size();
+                n = c;
+                continue;
+            }
+
+            if (c && find(c, method, p + c->prefix.size(), end, params, handler))
+            {
+                return true;
+            }
+            // 路径参数子节点，匹配到下一个'/'为止，不能为空
+            const char *q = p;
+            while (q < end && *q != '/')
+            {
+                ++q;
+            }
+            if (q > p)
+            {
+                size_t mark = params ? params->size() : 0;
+                if (params)
+                {
+                    params->push_back(std::make_pair(n->paramName, std::string(p, q - p)));
+                }
+                if (find(n->param.get(), method, q, end, params, handler))
+                {
+                    return true;
+                }
+                if (params)
+                {
+                    params->resize(mark);
+                }
+            }
+            break;
+        }
+
+        if (fallback)
+        {
+            handler = fallback;
+            return true;
+        }
+        return false;
+    }
+
+    IServletCreator *ServletRouter::match(HttpMethod method, const std::string &path, Params *params) const
+    {
+        // 查找过程不复制shared_ptr，避免多线程争用同一个引用计数
+        const Handler *handler = nullptr;
+        auto it = m_statics.find(path);
+        if (it != m_statics.end())
+        {
+            // 没有按方法区分的处理器时不需要访问树节点
+            const Static &st = it->second;
+            IServletCreator *creator = st.hasMethods ? st.node->handlerFor(method).get() : st.any;
+            if (creator)
+            {
+                return creator;
+            }
+        }
+        if (find(m_root.get(), method, path.c_str(), path.c_str() + path.size(), params, handler))
+        {
+            return handler->get();
+        }
+        for (auto &i : m_globs)
+        {
+            if (!fnmatch(i.first.c_str(), path.c_str(), 0))
+            {
+                return i.second.get();
+            }
+        }
+        return nullptr;
+    }
+}
\ No newline at end of file
@@ -85,6 +85,17 @@ namespace CIM::http
         XX("main_running_time") << format_used_time(time(0) - ProcessInfoMgr::GetInstance()->main_start_time) << std::endl;
         ss << "===================================================" << std::endl;
         XX("fibers") << Coroutine::TotalCoroutines() << std::endl;
+        StackPoolStats stack_stats = StackPool::GetStats();
+        XX("stack_live") << stack_stats.live << std::endl;
+        XX("stack_pooled") << stack_stats.pooled << std::endl;
+        XX("stack_bytes_reserved") << stack_stats.bytes_reserved << std::endl;
+        XX("stack_bytes_mapped") << stack_stats.bytes_mapped << std::endl;
+        XX("stack_bytes_resident") << stack_stats.bytes_resident << std::endl;
+        SSLSocket::Stats ssl_stats = SSLSocket::GetStats();
+        XX("ssl_handshakes") << ssl_stats.handshakes << std::endl;
+        XX("ssl_resumed") << ssl_stats.resumed << std::endl;
+        XX("ssl_ktls_send") << ssl_stats.ktlsSend << std::endl;
+        XX("ssl_ktls_recv") << ssl_stats.ktlsRecv << std::endl;
         ss << "===================================================" << std::endl;
         ss << "<Logger>" << std::endl;
         ss << LoggerMgr::GetInstance()->toYamlString() << std::endl;
@@ -116,6 +127,12 @@ namespace CIM::http
                     hs = std::dynamic_pointer_cast<HttpServer>(*iit);
                 }
                 ss << (*iit)->toString() << std::endl;
+                TcpServer::AcceptStats accept_stats = (*iit)->getAcceptStats();
+                XX("accept_accepted") << accept_stats.accepted << std::endl;
+                XX("accept_rejected") << accept_stats.rejected << std::endl;
+                XX("accept_rejected_ip") << accept_stats.rejectedIp << std::endl;
+                XX("accept_paused") << accept_stats.paused << std::endl;
+                XX("active_connections") << accept_stats.active << std::endl;
             }
             if (hs)
             {
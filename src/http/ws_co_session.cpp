@@ -0,0 +1,159 @@
+#include "ws_co_session.hpp"
+
+#include <string.h>
+
+#include "endian.hpp"
+#include "macro.hpp"
+
+namespace CIM::http {
+static CIM::Logger::ptr g_logger = CIM_LOG_NAME("system");
+
+co::Task<WSFrameMessage::ptr> WSCoRecvMessage(WSSession::ptr session, bool client) {
+    Socket::ptr sock = session->getSocket();
+    int opcode = 0;
+    std::string data;
+    int cur_len = 0;
+    do {
+        // 帧头（2字节）一次读取
+        uint8_t head[2] = {0, 0};
+        if (co_await co::readFixSize(sock, head, sizeof(head)) <= 0) break;
+        uint8_t b1 = head[0], b2 = head[1];
+
+        WSFrameHead ws_head;  // 仅用于日志展示
+        ws_head.fin = (b1 & 0x80) != 0;
+        ws_head.rsv1 = (b1 & 0x40) != 0;
+        ws_head.rsv2 = (b1 & 0x20) != 0;
+        ws_head.rsv3 = (b1 & 0x10) != 0;
+        ws_head.opcode = (b1 & 0x0F);
+        ws_head.mask = (b2 & 0x80) != 0;
+        ws_head.payload = (b2 & 0x7F);
+
+        CIM_LOG_DEBUG(g_logger) << "WSFrameHead " << ws_head.toString();
+
+        if (ws_head.opcode == WSFrameHead::PING) {
+            CIM_LOG_INFO(g_logger) << "PING";
+            if (co_await WSCoPong(session) <= 0) co_return nullptr;
+            continue;
+        } else if (ws_head.opcode == WSFrameHead::PONG) {
+            // 忽略
+            continue;
+        } else if (ws_head.opcode == WSFrameHead::CONTINUE ||
+                   ws_head.opcode == WSFrameHead::TEXT_FRAME ||
+                   ws_head.opcode == WSFrameHead::BIN_FRAME) {
+            if (!client && !ws_head.mask) {
+                CIM_LOG_INFO(g_logger) << "WSFrameHead mask != 1";
+                break;
+            }
+
+            uint64_t length = 0;
+            if (ws_head.payload == 126) {
+                uint16_t len = 0;
+                if (co_await co::readFixSize(sock, &len, sizeof(len)) <= 0) break;
+                length = CIM::byteswap(len);
+            } else if (ws_head.payload == 127) {
+                uint64_t len = 0;
+                if (co_await co::readFixSize(sock, &len, sizeof(len)) <= 0) break;
+                length = CIM::byteswap(len);
+            } else {
+                length = ws_head.payload;
+            }
+
+            if ((cur_len + length) >= g_websocket_message_max_size->getValue()) {
+                CIM_LOG_WARN(g_logger)
+                    << "WSFrameMessage length > " << g_websocket_message_max_size->getValue()
+                    << " (" << (cur_len + length) << ")";
+                break;
+            }
+
+            char mask_key[4] = {0};
+            if (ws_head.mask) {
+                if (co_await co::readFixSize(sock, mask_key, sizeof(mask_key)) <= 0) break;
+            }
+
+            data.resize(cur_len + length);
+            if (length > 0 && co_await co::readFixSize(sock, &data[cur_len], length) <= 0) break;
+            if (ws_head.mask) {
+                for (uint64_t i = 0; i < length; ++i) {
+                    data[cur_len + i] ^= mask_key[i % 4];
+                }
+            }
+            cur_len += length;
+
+            if (!opcode && ws_head.opcode != WSFrameHead::CONTINUE) {
+                opcode = ws_head.opcode;
+            }
+
+            if (ws_head.fin) {
+                CIM_LOG_DEBUG(g_logger) << data;
+                co_return std::make_shared<WSFrameMessage>(opcode, std::move(data));
+            }
+        } else {
+            CIM_LOG_DEBUG(g_logger) << "invalid opcode=" << ws_head.opcode;
+        }
+    } while (true);
+    session->close();
+    co_return nullptr;
+}
+
+co::Task<int32_t> WSCoSendMessage(WSSession::ptr session, WSFrameMessage::ptr msg, bool client,
+                                  bool fin) {
+    Socket::ptr sock = session->getSocket();
+    uint64_t size = msg->getData().size();
+
+    // 帧头：FIN/OPCODE + MASK/PAYLOAD LEN + 扩展长度 + 掩码，合并为一次写入
+    uint8_t head[14];
+    size_t head_len = 0;
+    head[head_len++] = (fin ? 0x80 : 0) | (msg->getOpcode() & 0x0F);
+    uint8_t b2 = client ? 0x80 : 0;  // 客户端发送必须MASK
+    if (size < 126) {
+        head[head_len++] = b2 | (uint8_t)size;
+    } else if (size < 65536) {
+        head[head_len++] = b2 | 126;
+        uint16_t len = CIM::byteswap((uint16_t)size);
+        memcpy(head + head_len, &len, sizeof(len));
+        head_len += sizeof(len);
+    } else {
+        head[head_len++] = b2 | 127;
+        uint64_t len = CIM::byteswap(size);
+        memcpy(head + head_len, &len, sizeof(len));
+        head_len += sizeof(len);
+    }
+
+    do {
+        if (client) {
+            // 生成掩码并写入掩码后数据
+            char mask[4];
+            uint32_t rand_value = rand();
+            memcpy(mask, &rand_value, sizeof(mask));
+            memcpy(head + head_len, mask, sizeof(mask));
+            head_len += sizeof(mask);
+            if (co_await co::writeFixSize(sock, head, head_len) <= 0) break;
+
+            std::string masked = msg->getData();
+            for (size_t i = 0; i < masked.size(); ++i) {
+                masked[i] ^= mask[i % 4];
+            }
+            if (!masked.empty() &&
+                co_await co::writeFixSize(sock, masked.data(), masked.size()) <= 0)
+                break;
+        } else {
+            // 服务端发送不使用掩码
+            if (co_await co::writeFixSize(sock, head, head_len) <= 0) break;
+            if (size > 0 && co_await co::writeFixSize(sock, msg->getData().data(), size) <= 0)
+                break;
+        }
+        co_return (int32_t)(head_len + size);
+    } while (0);
+    session->close();
+    co_return -1;
+}
+
+co::Task<int32_t> WSCoPong(WSSession::ptr session) {
+    uint8_t frame[2] = {0x80 | (uint8_t)WSFrameHead::PONG, 0x00};  // FIN + PONG，无掩码、长度0
+    if (co_await co::writeFixSize(session->getSocket(), frame, sizeof(frame)) <= 0) {
+        session->close();
+        co_return -1;
+    }
+    co_return 2;
+}
+}  // namespace CIM::http
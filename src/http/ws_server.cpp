@@ -37,6 +37,8 @@ void WSServer::handleClient(Socket::ptr client) {
             CIM_LOG_DEBUG(g_logger) << "onConnect return " << rt;
             break;
         }
+        // 心跳与消息投递对延迟敏感：连接建立后该协程按realtime调度，每次收包唤醒都排在普通HTTP请求之前
+        Coroutine::GetThis()->setPriority(Scheduler::REALTIME);
         // 4. 消息主循环，持续接收并分发消息
         while (true) {
             auto msg = session->recvMessage();
@@ -198,38 +198,44 @@ int32_t WSSendMessage(Stream* stream, WSFrameMessage::ptr msg, bool client, bool
         }
         b2 |= (len_indicator & 0x7F);
 
-        if (stream->writeFixSize(&b1, 1) <= 0) break;
-        if (stream->writeFixSize(&b2, 1) <= 0) break;
-
+        // 帧头在栈上拼好，与负载一起交给writev，一帧一次写出
+        char head[14];
+        size_t head_len = 0;
+        head[head_len++] = (char)b1;
+        head[head_len++] = (char)b2;
         if (len_indicator == 126) {
             uint16_t len = (uint16_t)size;
             len = CIM::byteswap(len);
-            if (stream->writeFixSize(&len, sizeof(len)) <= 0) break;
+            memcpy(head + head_len, &len, sizeof(len));
+            head_len += sizeof(len);
         } else if (len_indicator == 127) {
             uint64_t len = CIM::byteswap(size);
-            if (stream->writeFixSize(&len, sizeof(len)) <= 0) break;
+            memcpy(head + head_len, &len, sizeof(len));
+            head_len += sizeof(len);
         }
 
+        std::vector<BufferSlice> slices;
         if (client) {
             // 生成掩码并写入掩码后数据
             char mask[4];
             uint32_t rand_value = rand();
             memcpy(mask, &rand_value, sizeof(mask));
-            if (stream->writeFixSize(mask, sizeof(mask)) <= 0) break;
+            memcpy(head + head_len, mask, sizeof(mask));
+            head_len += sizeof(mask);
 
             std::string masked = msg->getData();
             for (size_t i = 0; i < masked.size(); ++i) {
                 masked[i] ^= mask[i % 4];
             }
-            if (stream->writeFixSize(masked.data(), masked.size()) <= 0) break;
-            return (int32_t)(2 + (len_indicator == 126 ? 2 : (len_indicator == 127 ? 8 : 0)) + 4 +
-                             masked.size());
+            slices.push_back(BufferSlice(head, head_len));
+            slices.push_back(BufferSlice::FromString(std::move(masked)));
         } else {
-            // 服务端发送不使用掩码
-            if (stream->writeFixSize(msg->getData().data(), size) <= 0) break;
-            return (int32_t)(2 + (len_indicator == 126 ? 2 : (len_indicator == 127 ? 8 : 0)) +
-                             size);
+            // 服务端发送不使用掩码，负载由msg持有到发送完成
+            slices.push_back(BufferSlice(head, head_len));
+            slices.push_back(BufferSlice(msg->getData().data(), size, msg));
         }
+        if (stream->writev(slices) <= 0) break;
+        return (int32_t)(head_len + size);
     } while (0);
     stream->close();
     return -1;
@@ -0,0 +1,261 @@
+#include "affinity.hpp"
+#include "macro.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace CIM
+{
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    // set_mempolicy 模式，取值与 <numaif.h> 一致，避免引入libnuma
+    static const int kMpolDefault = 0;
+    static const int kMpolPreferred = 1;
+
+    std::vector<int> ParseCpuList(const std::string &str)
+    {
+        std::vector<int> cpus;
+        std::stringstream ss(str);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            item.erase(std::remove_if(item.begin(), item.end(), ::isspace), item.end());
+            if (item.empty())
+            {
+                continue;
+            }
+            char *end = nullptr;
+            long first = strtol(item.c_str(), &end, 10);
+            long last = first;
+            if (end == item.c_str() || first < 0)
+            {
+                CIM_LOG_WARN(g_logger) << "invalid cpu list item '" << item << "' in '" << str << "'";
+                continue;
+            }
+            if (*end == '-')
+            {
+                const char *begin = end + 1;
+                last = strtol(begin, &end, 10);
+                if (end == begin || last < first)
+                {
+                    CIM_LOG_WARN(g_logger) << "invalid cpu list item '" << item << "' in '" << str << "'";
+                    continue;
+                }
+            }
+            if (*end != '\0')
+            {
+                CIM_LOG_WARN(g_logger) << "invalid cpu list item '" << item << "' in '" << str << "'";
+                continue;
+            }
+            for (long i = first; i <= last && i < CPU_SETSIZE; ++i)
+            {
+                cpus.push_back((int)i);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    std::string CpuListToString(const std::vector<int> &cpus)
+    {
+        std::stringstream ss;
+        for (size_t i = 0; i < cpus.size();)
+        {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            {
+                ++j;
+            }
+            if (i)
+            {
+                ss << ",";
+            }
+            ss << cpus[i];
+            if (j > i)
+            {
+                ss << "-" << cpus[j];
+            }
+            i = j + 1;
+        }
+        return ss.str();
+    }
+
+    std::vector<int> GetNumaNodeCpus(int node)
+    {
+        if (node < 0)
+        {
+            return {};
+        }
+        std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string line;
+        if (!ifs || !std::getline(ifs, line))
+        {
+            return {};
+        }
+        return ParseCpuList(line);
+    }
+
+    int GetCpuNumaNode(int cpu)
+    {
+        if (cpu < 0)
+        {
+            return -1;
+        }
+        // /sys/devices/system/cpu/cpuN/ 下存在名为 nodeM 的链接
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR *dir = opendir(path.c_str());
+        if (!dir)
+        {
+            return -1;
+        }
+        int node = -1;
+        while (struct dirent *ent = readdir(dir))
+        {
+            if (strncmp(ent->d_name, "node", 4) == 0 && isdigit((unsigned char)ent->d_name[4]))
+            {
+                node = atoi(ent->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+        return node;
+    }
+
+    int GetThreadCpu(pid_t tid)
+    {
+        std::ifstream ifs("/proc/self/task/" + std::to_string(tid) + "/stat");
+        std::string line;
+        if (!ifs || !std::getline(ifs, line))
+        {
+            return -1;
+        }
+        // 线程名可能包含空格和括号，从最后一个')'之后开始解析；
+        // 其后第一个字段为第3项(state)，processor 为第39项
+        size_t pos = line.rfind(')');
+        if (pos == std::string::npos)
+        {
+            return -1;
+        }
+        std::stringstream ss(line.substr(pos + 1));
+        std::string field;
+        for (int i = 3; i <= 39; ++i)
+        {
+            if (!(ss >> field))
+            {
+                return -1;
+            }
+        }
+        return atoi(field.c_str());
+    }
+
+    bool SetThreadMemoryNode(int node)
+    {
+        long rt;
+        if (node < 0)
+        {
+            rt = syscall(SYS_set_mempolicy, kMpolDefault, nullptr, 0);
+        }
+        else
+        {
+            const size_t bits = sizeof(unsigned long) * 8;
+            std::vector<unsigned long> mask(node / bits + 1, 0);
+            mask[node / bits] |= 1UL << (node % bits);
+            rt = syscall(SYS_set_mempolicy, kMpolPreferred, mask.data(), mask.size() * bits + 1);
+        }
+        if (rt != 0)
+        {
+            CIM_LOG_WARN(g_logger) << "set_mempolicy node=" << node << " failed errno="
+                                   << errno << " errstr=" << strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    ScopedMemoryNode::ScopedMemoryNode(int node)
+        : m_set(false)
+    {
+        if (node >= 0)
+        {
+            m_set = SetThreadMemoryNode(node);
+        }
+    }
+
+    ScopedMemoryNode::~ScopedMemoryNode()
+    {
+        if (m_set)
+        {
+            SetThreadMemoryNode(-1);
+        }
+    }
+
+    std::string ThreadAffinity::toString() const
+    {
+        std::stringstream ss;
+        ss << "cpus=" << (cpus.empty() ? "all" : CpuListToString(cpus))
+           << " node=" << numa_node
+           << " pin=" << pin;
+        return ss.str();
+    }
+
+    ThreadAffinity ThreadAffinity::Create(const std::string &cpu_set, int numa_node, bool pin)
+    {
+        ThreadAffinity affinity;
+        affinity.numa_node = numa_node;
+        affinity.pin = pin;
+        if (!cpu_set.empty())
+        {
+            affinity.cpus = ParseCpuList(cpu_set);
+        }
+        else if (numa_node >= 0)
+        {
+            affinity.cpus = GetNumaNodeCpus(numa_node);
+            if (affinity.cpus.empty())
+            {
+                CIM_LOG_WARN(g_logger) << "numa node " << numa_node << " has no cpus";
+            }
+        }
+        return affinity;
+    }
+
+    bool ThreadAffinity::apply(size_t index) const
+    {
+        bool ok = true;
+        if (!cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (pin)
+            {
+                CPU_SET(cpus[index % cpus.size()], &set);
+            }
+            else
+            {
+                for (int cpu : cpus)
+                {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            int rt = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (rt != 0)
+            {
+                CIM_LOG_WARN(g_logger) << "pthread_setaffinity_np(" << toString() << ", index="
+                                       << index << ") failed errno=" << rt << " errstr=" << strerror(rt);
+                ok = false;
+            }
+        }
+        if (numa_node >= 0)
+        {
+            ok = SetThreadMemoryNode(numa_node) && ok;
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,206 @@
+#include "context.hpp"
+#include <cstdint>
+#include <cstring>
+
+#ifdef CIM_CONTEXT_ASM
+
+/**
+ * 汇编上下文切换
+ *
+ * cim_context_swap(void **from_sp, void *to_sp)
+ *   将被调用者保存寄存器压入当前栈，把栈顶写入 *from_sp，
+ *   然后切换到 to_sp 并按相反顺序弹出寄存器，最后 ret 到目标上下文的返回地址。
+ *
+ * cim_context_entry
+ *   新上下文的首个返回地址，调用 ContextMake 时放入栈帧的入口函数。
+ */
+extern "C" void cim_context_swap(void **from_sp, void *to_sp);
+extern "C" void cim_context_entry();
+
+#if defined(__x86_64__)
+
+/*
+ * x86_64 System V 栈帧布局(自低地址向高地址)：
+ *   [mxcsr(4) | x87 cw(2) | pad(2)] r12 r13 r14 r15 rbx rbp [返回地址]
+ * 新上下文中 r12 保存入口函数地址。
+ */
+asm(R"(
+    .text
+    .globl cim_context_swap
+    .type cim_context_swap, @function
+    .align 16
+cim_context_swap:
+    pushq %rbp
+    pushq %rbx
+    pushq %r15
+    pushq %r14
+    pushq %r13
+    pushq %r12
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r12
+    popq %r13
+    popq %r14
+    popq %r15
+    popq %rbx
+    popq %rbp
+    ret
+    .size cim_context_swap, .-cim_context_swap
+
+    .globl cim_context_entry
+    .type cim_context_entry, @function
+    .align 16
+cim_context_entry:
+    callq *%r12
+    ud2
+    .size cim_context_entry, .-cim_context_entry
+)");
+
+namespace
+{
+    const size_t kFrameWords = 8; // fpu控制字 + 6个寄存器 + 返回地址
+}
+
+#elif defined(__aarch64__)
+
+/*
+ * aarch64 AAPCS64 栈帧布局(176字节，自低地址向高地址)：
+ *   x19..x28, x29(fp), x30(lr), d8..d15, pad
+ * 新上下文中 x19 保存入口函数地址，x30 为 cim_context_entry。
+ */
+asm(R"(
+    .text
+    .globl cim_context_swap
+    .type cim_context_swap, %function
+    .align 4
+cim_context_swap:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #176
+    ret
+    .size cim_context_swap, .-cim_context_swap
+
+    .globl cim_context_entry
+    .type cim_context_entry, %function
+    .align 4
+cim_context_entry:
+    blr x19
+    brk #0
+    .size cim_context_entry, .-cim_context_entry
+)");
+
+namespace
+{
+    const size_t kFrameWords = 22; // 176字节
+}
+
+#endif
+
+namespace CIM
+{
+    const char *ContextBackendName()
+    {
+        return "asm";
+    }
+
+    bool ContextInit(CoContext *ctx)
+    {
+        // 当前执行流的寄存器在第一次切出时才会被保存
+        ctx->sp = nullptr;
+        return true;
+    }
+
+    bool ContextMake(CoContext *ctx, void *stack, size_t size, void (*fn)())
+    {
+        if (!stack || size < 1024 || !fn)
+        {
+            return false;
+        }
+
+        // 栈顶按16字节对齐，并在帧之上保留两个字，
+        // 使得弹出寄存器并 ret 之后 rsp/sp = top - 16 仍然保持16字节对齐
+        uintptr_t top = ((uintptr_t)stack + size) & ~(uintptr_t)15;
+        uintptr_t *frame = (uintptr_t *)top - kFrameWords - 2;
+        memset(frame, 0, (kFrameWords + 2) * sizeof(uintptr_t));
+
+#if defined(__x86_64__)
+        frame[0] = (uintptr_t)0x1F80 | ((uintptr_t)0x037F << 32); // mxcsr + x87控制字默认值
+        frame[1] = (uintptr_t)fn;                                 // r12
+        frame[7] = (uintptr_t)&cim_context_entry;                 // 返回地址
+#elif defined(__aarch64__)
+        frame[0] = (uintptr_t)fn;                  // x19
+        frame[11] = (uintptr_t)&cim_context_entry; // x30(lr)
+#endif
+        ctx->sp = frame;
+        return true;
+    }
+
+    bool ContextSwap(CoContext *from, CoContext *to)
+    {
+        cim_context_swap(&from->sp, to->sp);
+        return true;
+    }
+}
+
+#else // ucontext 兜底实现
+
+namespace CIM
+{
+    const char *ContextBackendName()
+    {
+        return "ucontext";
+    }
+
+    bool ContextInit(CoContext *ctx)
+    {
+        return getcontext(&ctx->uc) == 0;
+    }
+
+    bool ContextMake(CoContext *ctx, void *stack, size_t size, void (*fn)())
+    {
+        if (getcontext(&ctx->uc))
+        {
+            return false;
+        }
+        ctx->uc.uc_link = nullptr;            // 协程执行完成后返回的上下文
+        ctx->uc.uc_stack.ss_sp = stack;       // 栈空间地址
+        ctx->uc.uc_stack.ss_size = size;      // 栈空间大小
+        makecontext(&ctx->uc, fn, 0);
+        return true;
+    }
+
+    bool ContextSwap(CoContext *from, CoContext *to)
+    {
+        return swapcontext(&from->uc, &to->uc) == 0;
+    }
+}
+
+#endif
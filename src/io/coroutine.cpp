@@ -4,6 +4,9 @@
 #include "scheduler.hpp"
 #include "util.hpp"
 #include <atomic>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace CIM
 {
@@ -21,7 +24,25 @@ namespace CIM
     static auto g_coroutine_stack_size =
         Config::Lookup<uint32_t>("coroutine.stack_size", 1024 * 1024, "coroutine stack size");
 
+    // 定义配置项--每个线程保持常驻的缓存栈数量，超出部分通过madvise归还物理内存
+    static auto g_stack_pool_high_water =
+        Config::Lookup<uint32_t>("coroutine.stack_pool.high_water", 64,
+                                 "per-thread cached stacks kept resident");
+
+    // 定义配置项--每个线程最多缓存的栈数量，超出部分直接munmap
+    static auto g_stack_pool_max_cached =
+        Config::Lookup<uint32_t>("coroutine.stack_pool.max_cached", 1024,
+                                 "per-thread max cached stacks");
+
+    // 定义配置项--每个线程缓存的已结束协程对象数量，用于调度器复用协程
+    static auto g_coroutine_pool_size =
+        Config::Lookup<uint32_t>("coroutine.pool_size", 64,
+                                 "per-thread cached terminated coroutines");
+
     static uint32_t s_coroutine_stack_size = 0;
+    static uint32_t s_stack_pool_high_water = 0;
+    static uint32_t s_stack_pool_max_cached = 0;
+    static uint32_t s_coroutine_pool_size = 0;
 
     struct CoroutineInit
     {
@@ -33,19 +54,40 @@ namespace CIM
                 {
                     s_coroutine_stack_size = new_val;
                 });
+
+            s_stack_pool_high_water = g_stack_pool_high_water->getValue();
+            g_stack_pool_high_water->addListener(
+                [](const uint32_t &ole_val, const uint32_t &new_val)
+                {
+                    s_stack_pool_high_water = new_val;
+                });
+
+            s_stack_pool_max_cached = g_stack_pool_max_cached->getValue();
+            g_stack_pool_max_cached->addListener(
+                [](const uint32_t &ole_val, const uint32_t &new_val)
+                {
+                    s_stack_pool_max_cached = new_val;
+                });
+
+            s_coroutine_pool_size = g_coroutine_pool_size->getValue();
+            g_coroutine_pool_size->addListener(
+                [](const uint32_t &ole_val, const uint32_t &new_val)
+                {
+                    s_coroutine_pool_size = new_val;
+                });
         }
     };
     static CoroutineInit __coroutine_init;
 
-    using StackAllocator = MallocStackAllocator;
+    using StackAllocator = StackPool;
 
     Coroutine::Coroutine()
         : m_state(State::EXEC)
     {
         // 获取上下文，接管当前线程
-        if (getcontext(&m_ctx))
+        if (!ContextInit(&m_ctx))
         {
-            CIM_ASSERT2(false, "getcontext");
+            CIM_ASSERT2(false, "ContextInit");
             return; // 如果有适当的错误处理机制，应该在这里处理
         }
 
@@ -55,11 +97,11 @@ namespace CIM
         CIM_LOG_DEBUG(g_logger) << "Coroutine::Coroutine() id=" << m_id;
     }
 
-    Coroutine::Coroutine(std::function<void()> cb, size_t stack_size, bool use_caller)
+    Coroutine::Coroutine(TaskFunction cb, size_t stack_size, bool use_caller)
         : m_id(++s_coroutine_id),
-          m_cb(cb)
+          m_cb(std::move(cb))
     {
-        CIM_ASSERT(cb);
+        CIM_ASSERT(m_cb);
         ++s_coroutine_count;
 
         // 使用局部变量管理栈空间，确保异常安全性
@@ -73,25 +115,10 @@ namespace CIM
             m_stack_size = stack_size_temp;
             m_stack = stack;
 
-            // 初始化上下文
-            m_ctx.uc_link = nullptr;               // 协程执行完成后返回的上下文
-            m_ctx.uc_stack.ss_sp = m_stack;        // 栈空间地址
-            m_ctx.uc_stack.ss_size = m_stack_size; // 栈空间大小
-
-            // 获取当前线程上下文环境
-            if (getcontext(&m_ctx))
-            {
-                CIM_ASSERT2(false, "getcontext");
-            }
-
-            // 设置协程的入口函数
-            if (use_caller)
+            // 在协程栈上初始化上下文，并设置协程的入口函数
+            if (!ContextMake(&m_ctx, m_stack, m_stack_size, use_caller ? &CallerMainFunc : &MainFunc))
             {
-                makecontext(&m_ctx, &CallerMainFunc, 0);
-            }
-            else
-            {
-                makecontext(&m_ctx, &MainFunc, 0);
+                CIM_ASSERT2(false, "ContextMake");
             }
         }
         catch (...)
@@ -112,15 +139,15 @@ namespace CIM
         CIM_LOG_DEBUG(g_logger) << "Coroutine::~Coroutine" << " id=" << m_id;
         if (m_stack) // 说明为子协程
         {
-            CIM_ASSERT(m_state == State::TERM ||
-                         m_state == State::INIT ||
-                         m_state == State::EXCEPT);
+            CIM_ASSERT(getState() == State::TERM ||
+                         getState() == State::INIT ||
+                         getState() == State::EXCEPT);
             StackAllocator::Dealloc(m_stack, m_stack_size);
         }
         else // 说明为主协程
         {
             CIM_ASSERT(!m_cb);
-            CIM_ASSERT(m_state == State::EXEC);
+            CIM_ASSERT(getState() == State::EXEC);
 
             // 将主协程指针置空
             Coroutine *cur = t_coroutine;
@@ -132,39 +159,34 @@ namespace CIM
         --s_coroutine_count;
     }
 
-    void Coroutine::reset(std::function<void()> cb)
+    void Coroutine::reset(TaskFunction cb)
     {
         CIM_ASSERT(m_stack);
         CIM_ASSERT(m_stack_size > 0);
-        CIM_ASSERT(m_state == State::TERM ||
-                     m_state == State::INIT ||
-                     m_state == State::EXCEPT);
-        m_cb = cb;
-        if (getcontext(&m_ctx)) // 获取当前上下文环境
+        CIM_ASSERT(getState() == State::TERM ||
+                     getState() == State::INIT ||
+                     getState() == State::EXCEPT);
+        m_cb = std::move(cb);
+        if (!ContextMake(&m_ctx, m_stack, m_stack_size, &MainFunc))
         {
-            CIM_ASSERT2(false, "getcontext");
+            CIM_ASSERT2(false, "ContextMake");
         }
-        m_ctx.uc_link = nullptr;
-        m_ctx.uc_stack.ss_sp = m_stack;
-        m_ctx.uc_stack.ss_size = m_stack_size;
-
-        makecontext(&m_ctx, &MainFunc, 0);
-        m_state = State::INIT;
+        m_state.store(State::INIT, std::memory_order_relaxed);
     }
 
     void Coroutine::swapIn()
     {
         // 把当前运行协程设置为该子协程
         SetThis(this);
-        CIM_ASSERT(m_state != State::EXEC &&
-                     m_state != State::TERM &&
-                     m_state != State::EXCEPT);
-        m_state = State::EXEC;
+        CIM_ASSERT(getState() != State::EXEC &&
+                     getState() != State::TERM &&
+                     getState() != State::EXCEPT);
+        m_state.store(State::EXEC, std::memory_order_relaxed);
 
         // 从主协程切换到当前线程（子协程）
-        if (swapcontext(&Scheduler::GetMainCoroutine()->m_ctx, &m_ctx))
+        if (!ContextSwap(&Scheduler::GetMainCoroutine()->m_ctx, &m_ctx))
         {
-            CIM_ASSERT2(false, "swapcontext");
+            CIM_ASSERT2(false, "ContextSwap");
         }
     }
 
@@ -172,31 +194,31 @@ namespace CIM
     {
         // 从当前线程（子协程）切换回主协程
         SetThis(Scheduler::GetMainCoroutine());
-        if (swapcontext(&m_ctx, &Scheduler::GetMainCoroutine()->m_ctx))
+        if (!ContextSwap(&m_ctx, &Scheduler::GetMainCoroutine()->m_ctx))
         {
-            CIM_ASSERT2(false, "swapcontext");
+            CIM_ASSERT2(false, "ContextSwap");
         }
     }
 
     void Coroutine::call()
     {
         SetThis(this);
-        CIM_ASSERT(m_state != State::EXEC &&
-                     m_state != State::TERM &&
-                     m_state != State::EXCEPT);
-        m_state = State::EXEC;
-        if (swapcontext(&t_thread_coroutine->m_ctx, &m_ctx))
+        CIM_ASSERT(getState() != State::EXEC &&
+                     getState() != State::TERM &&
+                     getState() != State::EXCEPT);
+        m_state.store(State::EXEC, std::memory_order_relaxed);
+        if (!ContextSwap(&t_thread_coroutine->m_ctx, &m_ctx))
         {
-            CIM_ASSERT2(false, "swapcontext");
+            CIM_ASSERT2(false, "ContextSwap");
         }
     }
 
     void Coroutine::back()
     {
         SetThis(t_thread_coroutine.get());
-        if (swapcontext(&m_ctx, &t_thread_coroutine->m_ctx))
+        if (!ContextSwap(&m_ctx, &t_thread_coroutine->m_ctx))
         {
-            CIM_ASSERT2(false, "swapcontext");
+            CIM_ASSERT2(false, "ContextSwap");
         }
     }
 
@@ -207,12 +229,12 @@ namespace CIM
 
     Coroutine::State Coroutine::getState() const
     {
-        return m_state;
+        return m_state.load(std::memory_order_acquire);
     }
 
     void Coroutine::setState(State state)
     {
-        m_state = state;
+        m_state.store(state, std::memory_order_release);
     }
 
     void Coroutine::SetThis(Coroutine *val)
@@ -239,19 +261,50 @@ namespace CIM
     void Coroutine::YieldToReady()
     {
         Coroutine::ptr cur = GetThis();
-        CIM_ASSERT(cur->m_state == EXEC);
-        cur->m_state = State::READY;
+        CIM_ASSERT(cur->getState() == EXEC);
+        cur->m_state.store(State::READY, std::memory_order_release);
         cur->swapOut();
     }
 
     void Coroutine::YieldToHold()
     {
         Coroutine::ptr cur = GetThis();
-        CIM_ASSERT(cur->m_state == EXEC);
-        cur->m_state = State::HOLD;
+        CIM_ASSERT(cur->getState() == EXEC);
+        // 保持EXEC直到切换完成：让出前协程可能已登记到IO事件或定时器，
+        // 若提前置为HOLD，其他线程会在上下文保存完成前恢复它；切出后由调度器置为HOLD
         cur->swapOut();
     }
 
+    // 线程本地的已结束协程缓存，线程退出时随之析构并归还栈空间
+    static thread_local std::vector<Coroutine::ptr> t_coroutine_pool;
+
+    Coroutine::ptr Coroutine::Acquire(TaskFunction cb)
+    {
+        if (!t_coroutine_pool.empty())
+        {
+            Coroutine::ptr co = std::move(t_coroutine_pool.back());
+            t_coroutine_pool.pop_back();
+            co->reset(std::move(cb));
+            return co;
+        }
+        return std::make_shared<Coroutine>(std::move(cb));
+    }
+
+    bool Coroutine::Recycle(const Coroutine::ptr &co)
+    {
+        if (!co || co.use_count() != 1 || !co->m_stack ||
+            co->m_stack_size != s_coroutine_stack_size ||
+            (co->getState() != State::TERM && co->getState() != State::EXCEPT) ||
+            t_coroutine_pool.size() >= s_coroutine_pool_size)
+        {
+            return false;
+        }
+        // 异常退出的协程仍持有回调，提前释放其捕获的资源
+        co->m_cb = nullptr;
+        t_coroutine_pool.push_back(co);
+        return true;
+    }
+
     uint64_t Coroutine::TotalCoroutines()
     {
         return s_coroutine_count;
@@ -267,11 +320,11 @@ namespace CIM
         {
             cur->m_cb(); // 执行协程的回调函数
             cur->m_cb = nullptr;
-            cur->m_state = State::TERM;
+            cur->m_state.store(State::TERM, std::memory_order_release);
         }
         catch (std::exception &ex)
         {
-            cur->m_state = State::EXCEPT;
+            cur->m_state.store(State::EXCEPT, std::memory_order_release);
             CIM_LOG_ERROR(g_logger) << "coroutine exception: " << ex.what()
                                       << " coroutine id: " << cur->getId()
                                       << std::endl
@@ -279,7 +332,7 @@ namespace CIM
         }
         catch (...)
         {
-            cur->m_state = State::EXCEPT;
+            cur->m_state.store(State::EXCEPT, std::memory_order_release);
             CIM_LOG_ERROR(g_logger) << "Coroutine exception";
         }
 
@@ -301,11 +354,11 @@ namespace CIM
         {
             cur->m_cb(); // 执行协程的回调函数
             cur->m_cb = nullptr;
-            cur->m_state = State::TERM;
+            cur->m_state.store(State::TERM, std::memory_order_release);
         }
         catch (std::exception &ex)
         {
-            cur->m_state = State::EXCEPT;
+            cur->m_state.store(State::EXCEPT, std::memory_order_release);
             CIM_LOG_ERROR(g_logger) << "coroutine exception: " << ex.what()
                                       << " coroutine id: " << cur->getId()
                                       << std::endl
@@ -313,7 +366,7 @@ namespace CIM
         }
         catch (...)
         {
-            cur->m_state = State::EXCEPT;
+            cur->m_state.store(State::EXCEPT, std::memory_order_release);
             CIM_LOG_ERROR(g_logger) << "Coroutine exception";
         }
 
@@ -339,4 +392,237 @@ namespace CIM
     {
         free(ptr);
     }
+
+    // ==========================StackPool==========================
+
+    static std::atomic<uint64_t> s_stack_live = {0};           // 使用中的栈数量
+    static std::atomic<uint64_t> s_stack_pooled = {0};         // 缓存中的栈数量
+    static std::atomic<uint64_t> s_stack_bytes_reserved = {0}; // 保留的地址空间
+    static std::atomic<uint64_t> s_stack_bytes_mapped = {0};   // 未被madvise回收的可用栈空间
+
+    static size_t GetPageSize()
+    {
+        static size_t s_page_size = sysconf(_SC_PAGESIZE);
+        return s_page_size;
+    }
+
+    /**
+     * @brief 所有已映射栈的可用区域，统计常驻内存时用mincore逐个查询
+     * @details 只在mmap/munmap时更新，缓存复用不经过这里；
+     *          不随静态对象析构，线程退出释放缓存栈时仍可使用
+     */
+    struct StackRegions
+    {
+        Mutex mutex;
+        std::unordered_map<void *, size_t> regions; // 可用区域起始地址 -> 大小
+    };
+
+    static StackRegions &GetStackRegions()
+    {
+        static StackRegions *s_regions = new StackRegions;
+        return *s_regions;
+    }
+
+    /**
+     * @brief 解除栈的映射，ptr为保护页之上的可用区域
+     */
+    static void UnmapStack(void *ptr, size_t usable)
+    {
+        StackRegions &regions = GetStackRegions();
+        {
+            Mutex::Lock lock(regions.mutex);
+            regions.regions.erase(ptr);
+        }
+        munmap((char *)ptr - GetPageSize(), usable + GetPageSize());
+    }
+
+    static size_t AlignToPage(size_t size)
+    {
+        size_t page = GetPageSize();
+        return (size + page - 1) / page * page;
+    }
+
+    // 线程本地栈缓存是否仍然有效(线程退出析构缓存之后置为false)
+    static thread_local bool t_stack_cache_alive = true;
+
+    /**
+     * @brief 线程本地的栈缓存
+     * @details stacks 按归还顺序排列，尾部最热。超出高水位的栈被标记为trimmed，
+     *          其物理页已通过madvise归还给内核。线程退出时释放全部缓存栈。
+     */
+    struct StackCache
+    {
+        struct Entry
+        {
+            void *ptr;    // 可用区域起始地址(保护页之上)
+            size_t size;  // 可用区域大小
+            bool trimmed; // 物理页是否已归还
+        };
+
+        std::vector<Entry> stacks;
+
+        ~StackCache()
+        {
+            t_stack_cache_alive = false;
+            size_t page = GetPageSize();
+            for (auto &i : stacks)
+            {
+                UnmapStack(i.ptr, i.size);
+                --s_stack_pooled;
+                s_stack_bytes_reserved -= i.size + page;
+                if (!i.trimmed)
+                {
+                    s_stack_bytes_mapped -= i.size;
+                }
+            }
+        }
+    };
+
+    static thread_local StackCache t_stack_cache;
+
+    void *StackPool::Alloc(size_t size)
+    {
+        size_t usable = AlignToPage(size);
+        size_t page = GetPageSize();
+
+        // 优先复用当前线程缓存中最近归还的同尺寸栈
+        size_t cached = t_stack_cache_alive ? t_stack_cache.stacks.size() : 0;
+        for (size_t i = cached; i > 0; --i)
+        {
+            auto &stacks = t_stack_cache.stacks;
+            StackCache::Entry &e = stacks[i - 1];
+            if (e.size != usable)
+            {
+                continue;
+            }
+            void *ptr = e.ptr;
+            if (e.trimmed)
+            {
+                s_stack_bytes_mapped += usable;
+            }
+            stacks.erase(stacks.begin() + (i - 1));
+            --s_stack_pooled;
+            ++s_stack_live;
+            return ptr;
+        }
+
+        // 缓存未命中，映射新的栈：[保护页][可用栈空间]，栈向低地址增长，保护页位于最低端
+        size_t total = usable + page;
+        void *base = mmap(nullptr, total, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            CIM_LOG_ERROR(g_logger) << "StackPool mmap(" << total << ") failed errno="
+                                    << errno << " errstr=" << strerror(errno);
+            throw std::bad_alloc();
+        }
+        if (mprotect(base, page, PROT_NONE))
+        {
+            CIM_LOG_ERROR(g_logger) << "StackPool mprotect guard page failed errno="
+                                    << errno << " errstr=" << strerror(errno);
+            munmap(base, total);
+            throw std::bad_alloc();
+        }
+
+        void *ptr = (char *)base + page;
+        {
+            StackRegions &regions = GetStackRegions();
+            Mutex::Lock lock(regions.mutex);
+            regions.regions[ptr] = usable;
+        }
+        ++s_stack_live;
+        s_stack_bytes_reserved += total;
+        s_stack_bytes_mapped += usable;
+        return ptr;
+    }
+
+    void StackPool::Dealloc(void *ptr, size_t size)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        size_t usable = AlignToPage(size);
+        size_t page = GetPageSize();
+
+        // 线程退出阶段(如静态对象析构)缓存已销毁，直接释放；
+        // 缓存已满时刚归还的栈同样直接释放，缓存中较旧的栈已被madvise，保留它们只占地址空间
+        if (!t_stack_cache_alive || t_stack_cache.stacks.size() >= s_stack_pool_max_cached)
+        {
+            UnmapStack(ptr, usable);
+            --s_stack_live;
+            s_stack_bytes_reserved -= usable + page;
+            s_stack_bytes_mapped -= usable;
+            return;
+        }
+
+        auto &stacks = t_stack_cache.stacks;
+        stacks.push_back({ptr, usable, false});
+        --s_stack_live;
+        ++s_stack_pooled;
+
+        // 刚滑出高水位窗口的栈归还物理内存，更早的栈在之前已被处理
+        size_t high_water = s_stack_pool_high_water;
+        if (stacks.size() > high_water)
+        {
+            StackCache::Entry &e = stacks[stacks.size() - high_water - 1];
+            if (!e.trimmed)
+            {
+                madvise(e.ptr, e.size, MADV_DONTNEED);
+                e.trimmed = true;
+                s_stack_bytes_mapped -= e.size;
+            }
+        }
+
+        // 上限被调小后超出的部分从尾部释放，避免从头部删除时整体搬移
+        while (stacks.size() > s_stack_pool_max_cached)
+        {
+            StackCache::Entry e = stacks.back();
+            stacks.pop_back();
+            UnmapStack(e.ptr, e.size);
+            --s_stack_pooled;
+            s_stack_bytes_reserved -= e.size + page;
+            if (!e.trimmed)
+            {
+                s_stack_bytes_mapped -= e.size;
+            }
+        }
+    }
+
+    StackPoolStats StackPool::GetStats()
+    {
+        StackPoolStats stats;
+        stats.live = s_stack_live;
+        stats.pooled = s_stack_pooled;
+        stats.bytes_reserved = s_stack_bytes_reserved;
+        stats.bytes_mapped = s_stack_bytes_mapped;
+
+        // 栈按需缺页，映射了不代表常驻，用mincore统计实际驻留的页
+        size_t page = GetPageSize();
+        std::vector<unsigned char> vec;
+        // 锁内只复制区域列表，扫描期间不阻塞其他线程分配、归还栈；
+        // 扫描时已被解除映射的区域mincore返回ENOMEM，直接跳过
+        std::vector<std::pair<void *, size_t>> snapshot;
+        {
+            StackRegions &regions = GetStackRegions();
+            Mutex::Lock lock(regions.mutex);
+            snapshot.assign(regions.regions.begin(), regions.regions.end());
+        }
+        for (auto &i : snapshot)
+        {
+            vec.resize(i.second / page);
+            if (mincore(i.first, i.second, vec.data()))
+            {
+                continue;
+            }
+            for (unsigned char v : vec)
+            {
+                if (v & 1)
+                {
+                    stats.bytes_resident += page;
+                }
+            }
+        }
+        return stats;
+    }
 }
\ No newline at end of file
@@ -1,17 +1,82 @@
 #include "iomanager.hpp"
 #include "macro.hpp"
 #include "fd_manager.hpp"
+#include "config.hpp"
+#include "uring.hpp"
+#include "time_util.hpp"
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <unistd.h>
-#include <fcntl.h>
+#include <algorithm>
 #include <cerrno>
 
+#ifndef __NR_epoll_pwait2
+#define __NR_epoll_pwait2 441 // 5.11+，各架构统一编号
+#endif
+
 namespace CIM
 {
     static auto g_logger = CIM_LOG_NAME("system");
 
-    IOManager::IOManager(size_t threads, bool use_caller, const std::string &name)
-        : Scheduler(threads, use_caller, name)
+    static ConfigVar<std::string>::ptr g_epoll_mode =
+        Config::Lookup("iomanager.epoll_mode", std::string("persistent"),
+                       "epoll registration: persistent / rearm; persistent relies on hooked close (cancelAll + FdManager::del) to drop registrations");
+
+    static ConfigVar<uint32_t>::ptr g_uring_entries =
+        Config::Lookup("iomanager.uring_entries", (uint32_t)256, "io_uring submission queue entries");
+
+    static ConfigVar<uint32_t>::ptr g_max_events =
+        Config::Lookup("iomanager.max_events", (uint32_t)1024, "upper bound of epoll_wait batch per thread");
+
+    static ConfigVar<bool>::ptr g_epoll_pwait2 =
+        Config::Lookup("iomanager.epoll_pwait2", true, "use epoll_pwait2 nanosecond timeouts when available");
+
+    // 当前线程正在 idle 中处理 epoll 事件与到期定时器所属的IOManager
+    static thread_local IOManager *t_polling = nullptr;
+
+    // idle 分发期间就绪的协程与回调，分发结束后一次批量入队
+    static thread_local std::vector<Coroutine::ptr> t_ready_coroutines;
+    static thread_local std::vector<std::function<void()>> t_ready_cbs;
+
+    // 内核是否支持 epoll_pwait2，首次返回 ENOSYS 后不再尝试
+    static std::atomic<bool> s_has_pwait2 = {true};
+
+    static const int kInitialEvents = 64;                // 事件数组初始大小
+    static const uint64_t kMaxTimeoutNS = 3000000000ull; // 最长等待3秒
+
+    /**
+     * @brief 等待epoll事件，超时为纳秒；不使用epoll_pwait2时向上取整到毫秒，保证不早于定时器到期返回
+     */
+    static int epoll_wait_ns(int epfd, epoll_event *events, int max_events, uint64_t timeout_ns, bool pwait2)
+    {
+        if (pwait2 && s_has_pwait2.load(std::memory_order_relaxed))
+        {
+            struct timespec ts;
+            ts.tv_sec = timeout_ns / 1000000000ull;
+            ts.tv_nsec = timeout_ns % 1000000000ull;
+            int rt = (int)syscall(__NR_epoll_pwait2, epfd, events, max_events, &ts, nullptr, 0);
+            if (rt >= 0 || errno != ENOSYS)
+            {
+                return rt;
+            }
+            s_has_pwait2.store(false, std::memory_order_relaxed);
+            CIM_LOG_INFO(g_logger) << "epoll_pwait2 not supported, fallback to epoll_wait";
+        }
+        return epoll_wait(epfd, events, max_events, (int)((timeout_ns + 999999) / 1000000));
+    }
+
+    static void update_max(std::atomic<uint64_t> &target, uint64_t value)
+    {
+        uint64_t prev = target.load(std::memory_order_relaxed);
+        while (value > prev && !target.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    IOManager::IOManager(size_t threads, bool use_caller, const std::string &name, QueueMode mode,
+                         const ThreadAffinity &affinity, Backend backend)
+        : Scheduler(threads, use_caller, name, mode, affinity)
     {
         int saved_errno;
         // 创建 epoll 实例，用于监听文件描述符事件
@@ -23,34 +88,21 @@ namespace CIM
             throw std::runtime_error("IOManager initialization failed");
         }
 
-        // 创建管道，用于唤醒调度器
-        int pipe_fd[2];
-        int rt = pipe(pipe_fd);
-        if (-1 == rt)
+        // 创建 eventfd，用于唤醒调度器；非阻塞，一次 read 即可清空计数
+        FileDescriptor tickle_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+        if (!tickle_fd.isValid())
         {
             saved_errno = errno;
-            CIM_LOG_ERROR(g_logger) << "pipe failed: " << strerror(saved_errno);
+            CIM_LOG_ERROR(g_logger) << "eventfd failed: " << strerror(saved_errno);
             throw std::runtime_error("IOManager initialization failed");
         }
 
-        FileDescriptor pipe_read_fd(pipe_fd[0]);
-        FileDescriptor pipe_write_fd(pipe_fd[1]);
-
         epoll_event ev = {};
-        ev.events = EPOLLIN | EPOLLET;   // 使用 ET 模式监听读事件
-        ev.data.fd = pipe_read_fd.get(); // 关联管道的读端
-
-        // 将管道的读端设置为非阻塞模式，避免在读取时发生阻塞（若无数据可读或者是无法写入则立即返回）
-        rt = fcntl(pipe_read_fd.get(), F_SETFL, O_NONBLOCK);
-        if (-1 == rt)
-        {
-            saved_errno = errno;
-            CIM_LOG_ERROR(g_logger) << "fcntl failed: " << strerror(saved_errno);
-            throw std::runtime_error("IOManager initialization failed");
-        }
+        ev.events = EPOLLIN | EPOLLET; // 使用 ET 模式监听读事件，每次写入只产生一次就绪
+        ev.data.fd = tickle_fd.get();
 
-        // 将管道的读端添加到 epoll 实例中，以监听其事件
-        rt = epoll_ctl(epfd.get(), EPOLL_CTL_ADD, pipe_read_fd.get(), &ev);
+        // 将 eventfd 添加到 epoll 实例中，以监听其事件
+        int rt = epoll_ctl(epfd.get(), EPOLL_CTL_ADD, tickle_fd.get(), &ev);
         if (-1 == rt)
         {
             saved_errno = errno;
@@ -60,11 +112,40 @@ namespace CIM
 
         // 所有资源初始化成功，释放所有权并保存到成员变量中
         m_epfd = epfd.release();
-        m_tickleFds[0] = pipe_read_fd.release();
-        m_tickleFds[1] = pipe_write_fd.release();
+        m_tickleFd = tickle_fd.release();
+        m_persistentEpoll = g_epoll_mode->getValue() == "persistent";
+        m_pwait2 = g_epoll_pwait2->getValue();
+
+        if (backend == URING)
+        {
+            // hook 提交的操作，以及超时与取消
+            m_uring = IoUring::Create(g_uring_entries->getValue(),
+                                      {IORING_OP_RECV, IORING_OP_RECVMSG, IORING_OP_SEND, IORING_OP_SENDMSG,
+                                       IORING_OP_ACCEPT, IORING_OP_CONNECT, IORING_OP_LINK_TIMEOUT,
+                                       IORING_OP_ASYNC_CANCEL});
+            if (m_uring)
+            {
+                // 完成队列非空时 io_uring 的 fd 可读，与 eventfd 一样加入 epoll
+                ev.events = EPOLLIN | EPOLLET;
+                ev.data.fd = m_uring->getFd();
+                if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_uring->getFd(), &ev))
+                {
+                    saved_errno = errno;
+                    CIM_LOG_ERROR(g_logger) << "epoll_ctl io_uring failed: " << strerror(saved_errno);
+                    m_uring.reset();
+                }
+            }
+            if (!m_uring)
+            {
+                CIM_LOG_WARN(g_logger) << "name=" << name << " io_uring unavailable, fallback to epoll";
+            }
+        }
 
-        // 初始化上下文存储容量，确保可以容纳足够的上下文对象
-        contextResize(64);
+        // fd上下文存放在FdManager的记录中，先于本对象构造，保证析构时仍然有效
+        FdMgr::GetInstance();
+
+        // 每个工作线程（含use_caller的调用线程）一个定时器分片
+        initTimerWheels(m_threadCount + (m_rootThreadId != -1 ? 1 : 0));
 
         // 启动调度器，开始任务调度
         start();
@@ -74,47 +155,49 @@ namespace CIM
     {
         stop();
 
-        // 关闭 epoll 文件描述符和管道文件描述符
+        // fd记录由FdManager保留，清除其中属于本对象的注册，之后的IOManager重新注册
+        FdMgr::GetInstance()->foreach([this](FdCtx *ctx)
+                                      {
+                                          FdContext::MutexType::Lock lock(ctx->mutex);
+                                          if (ctx->owner == this)
+                                          {
+                                              ctx->owner = nullptr;
+                                              ctx->registered = false;
+                                              ctx->ready = NONE;
+                                          } });
+
+        // 关闭 epoll 文件描述符和 eventfd
+        m_uring.reset();
         close(m_epfd);
-        close(m_tickleFds[0]);
-        close(m_tickleFds[1]);
-
-        // 遍历并释放所有的 FdContext 对象
-        for (size_t i = 0; i < m_fdContexts.size(); ++i)
-        {
-            if (m_fdContexts[i])
-            {
-                delete m_fdContexts[i];
-            }
-        }
+        close(m_tickleFd);
     }
 
     bool IOManager::addEvent(int fd, Event event, std::function<void()> cb)
     {
         CIM_ASSERT(fd >= 0)
-        CIM_ASSERT(event == READ || event == WRITE);
-        CIM_ASSERT(cb || Coroutine::GetThis());
-
-        FdContext *fd_ctx = nullptr;
 
         // ====================取出对应 fd 的上下文====================
-        RWMutexType::ReadLock lock(m_mutex);
-        if ((int)m_fdContexts.size() > fd) // 空间够
+        FdContext *fd_ctx = GetFdContext(fd);
+        if (!fd_ctx)
         {
-            fd_ctx = m_fdContexts[fd];
-            lock.unlock();
+            CIM_LOG_ERROR(g_logger) << "addEvent: fd=" << fd << " out of range";
+            return false;
         }
-        else // 空间不足，进行扩容，再取出对应fd上下文
-        {
-            lock.unlock();
+        return addEvent(fd_ctx, event, std::move(cb));
+    }
 
-            RWMutexType::WriteLock lock2(m_mutex);
-            contextResize(fd * 1.5);
-            fd_ctx = m_fdContexts[fd];
-        }
+    bool IOManager::addEvent(FdContext *fd_ctx, Event event, std::function<void()> cb)
+    {
+        CIM_ASSERT(event == READ || event == WRITE);
+        CIM_ASSERT(cb || Coroutine::GetThis());
+        int fd = fd_ctx->fd;
 
         // ====================将事件注册到epoll实例中====================
         FdContext::MutexType::Lock lock2(fd_ctx->mutex);
+        if (!acquire(fd_ctx))
+        {
+            return false;
+        }
         if (fd_ctx->events & event)
         {
             // 如果事件已经存在，则直接返回true，避免重复添加相同的事件类型
@@ -124,22 +207,48 @@ namespace CIM
             return true;
         }
 
-        // 根据已有事件决定是新增还是修改 epoll 监控
-        int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-        epoll_event ev = {};
-        ev.events = fd_ctx->events | event | EPOLLET; // 设置边缘触发模式
-        ev.data.ptr = fd_ctx;
-
-        int saved_errno;
-        // 调用 epoll_ctl 更新事件监听
-        int rt = epoll_ctl(m_epfd, op, fd, &ev);
-        if (rt)
+        if (m_persistentEpoll)
         {
-            saved_errno = errno;
-            // 如果 epoll_ctl 失败，记录错误日志并返回失败
-            CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", " << fd << ", " << ev.events << "): "
-                                    << rt << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
-            return false;
+            // 持久注册：只在首次等待时注册读写两个方向，之后等待者只在用户态登记
+            if (!fd_ctx->registered)
+            {
+                epoll_event ev = {};
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+                ev.data.ptr = fd_ctx;
+                // fd号复用时open()已清除registered，但原打开文件若仍被dup出的fd引用，
+                // 内核中的注册还在，ADD返回EEXIST，改为MOD更新data.ptr
+                m_epollCtls.fetch_add(1, std::memory_order_relaxed);
+                int rt = epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev);
+                if (rt && errno == EEXIST)
+                {
+                    rt = epollCtl(EPOLL_CTL_MOD, fd, ev);
+                }
+                else if (rt)
+                {
+                    int saved_errno = errno;
+                    CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << EPOLL_CTL_ADD << ", " << fd << ", "
+                                            << ev.events << "): " << rt << " (" << saved_errno << ") ("
+                                            << strerror(saved_errno) << ")";
+                }
+                if (rt)
+                {
+                    return false;
+                }
+                fd_ctx->registered = true;
+                fd_ctx->ready = NONE; // 注册时内核会按当前状态报告一次就绪
+            }
+        }
+        else
+        {
+            // 根据已有事件决定是新增还是修改 epoll 监控
+            int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            epoll_event ev = {};
+            ev.events = fd_ctx->events | event | EPOLLET; // 设置边缘触发模式
+            ev.data.ptr = fd_ctx;
+            if (epollCtl(op, fd, ev))
+            {
+                return false;
+            }
         }
 
         // ====================更新上下文信息====================
@@ -171,6 +280,16 @@ namespace CIM
             CIM_ASSERT(event_ctx.coroutine->getState() == Coroutine::EXEC);
         }
 
+        // 登记等待者之前边沿已经到达（ET模式下不会再次报告），直接触发；
+        // 协程在切出完成前不会被其他线程执行，调度器会等待其状态离开EXEC
+        if (fd_ctx->ready & event)
+        {
+            fd_ctx->ready = (Event)(fd_ctx->ready & ~event);
+            m_epollReady.fetch_add(1, std::memory_order_relaxed);
+            fd_ctx->triggerEvent(event);
+            --m_pendingEventCount;
+        }
+
         return true;
     }
 
@@ -179,52 +298,40 @@ namespace CIM
         CIM_ASSERT(fd >= 0)
         CIM_ASSERT(event == READ || event == WRITE);
 
-        FdContext *fd_ctx = nullptr;
-
         // ====================获取文件描述符对应的 FdContext====================
+        FdContext *fd_ctx = GetFdContext(fd);
+        if (!fd_ctx)
         {
-            // 加读锁以保护 m_fdContexts 的并发访问
-            RWMutexType::ReadLock lock(m_mutex);
-            if ((int)m_fdContexts.size() <= fd)
-            {
-                CIM_LOG_ERROR(g_logger) << "delEvent: fd=" << fd
-                                        << " out of range, m_fdContexts.size()=" << m_fdContexts.size();
-                return false; // 文件描述符超出范围，直接返回失败
-            }
-
-            fd_ctx = m_fdContexts[fd];
+            CIM_LOG_ERROR(g_logger) << "delEvent: fd=" << fd << " out of range";
+            return false; // 文件描述符超出范围，直接返回失败
         }
 
         // ====================判断删除的事件是否存在====================
-        // 对 fd_ctx 加锁，确保对其事件的修改是线程安全的
+        // 对 fd_ctx 加锁，确保对其事件的修改是线程安全的；事件属于注册它的IOManager
         FdContext::MutexType::Lock lock2(fd_ctx->mutex);
-        if (!(fd_ctx->events & event))
+        IOManager *iom = fd_ctx->owner;
+        if (!iom || !(fd_ctx->events & event))
         {
             return false; // 如果目标事件不存在，直接返回失败
         }
 
         // ====================从epoll中删除事件监听====================
-        // 计算新的事件集合，并决定 epoll 操作类型
+        // 计算新的事件集合；持久注册模式下注册保持不变，只移除等待者
         Event new_events = (Event)(fd_ctx->events & ~event); // 移除指定事件
-        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL; // 根据剩余事件决定修改还是删除
-        epoll_event ev = {};
-        ev.events = new_events | EPOLLET; // 设置边缘触发模式
-        ev.data.ptr = fd_ctx;
-
-        int saved_errno;
-        // 调用 epoll_ctl 更新事件监听
-        int rt = epoll_ctl(m_epfd, op, fd, &ev);
-        if (rt)
+        if (!iom->m_persistentEpoll)
         {
-            saved_errno = errno;
-            // 如果 epoll_ctl 失败，记录错误日志并返回失败
-            CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", " << fd << ", " << ev.events << "): "
-                                    << rt << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
-            return false;
+            int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL; // 根据剩余事件决定修改还是删除
+            epoll_event ev = {};
+            ev.events = new_events | EPOLLET; // 设置边缘触发模式
+            ev.data.ptr = fd_ctx;
+            if (iom->epollCtl(op, fd, ev))
+            {
+                return false;
+            }
         }
 
         // ====================更新上下文信息====================
-        --m_pendingEventCount;       // 减少待处理事件计数
+        --iom->m_pendingEventCount;  // 减少待处理事件计数
         fd_ctx->events = new_events; // 更新文件描述符上下文中的事件集合
 
         // 重置与目标事件相关的上下文
@@ -236,50 +343,53 @@ namespace CIM
     bool IOManager::cancelEvent(int fd, Event event)
     {
         CIM_ASSERT(fd >= 0)
-        CIM_ASSERT(event == READ || event == WRITE);
 
-        FdContext *fd_ctx = nullptr;
+        FdContext *fd_ctx = GetFdContext(fd);
+        if (!fd_ctx)
         {
-            // 加读锁以保护m_fdContexts容器的并发访问
-            RWMutexType::ReadLock lock(m_mutex);
-            if ((int)m_fdContexts.size() <= fd)
-            {
-                CIM_LOG_ERROR(g_logger) << "cancelEvent: fd=" << fd
-                                        << " out of range, m_fdContexts.size()=" << m_fdContexts.size();
-                return false; // 文件描述符超出范围，直接返回false
-            }
-
-            fd_ctx = m_fdContexts[fd];
+            CIM_LOG_ERROR(g_logger) << "cancelEvent: fd=" << fd << " out of range";
+            return false; // 文件描述符超出范围，直接返回false
         }
+        return cancelEvent(fd_ctx, event);
+    }
+
+    bool IOManager::cancelEvent(FdContext *fd_ctx, Event event)
+    {
+        CIM_ASSERT(event == READ || event == WRITE);
 
-        // 对文件描述符上下文加锁，确保对其事件掩码的安全访问
+        // 对文件描述符上下文加锁，确保对其事件掩码的安全访问；事件属于注册它的IOManager
         FdContext::MutexType::Lock lock2(fd_ctx->mutex);
+        IOManager *iom = fd_ctx->owner;
+        if (!iom)
+        {
+            return false;
+        }
+        if (iom->m_uring && iom->cancelIO(fd_ctx, event))
+        {
+            return true; // 取消进行中的io_uring请求，协程在收到完成后恢复
+        }
         if (!(fd_ctx->events & event))
         {
             return false; // 如果当前文件描述符未监听该事件，直接返回false
         }
 
-        // 计算新的事件集合，并确定epoll操作类型
-        Event new_events = (Event)(fd_ctx->events & ~event);
-        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
-        epoll_event ev = {};
-        ev.events = new_events | EPOLLET;
-        ev.data.ptr = fd_ctx;
-
-        int saved_errno;
-        // 使用epoll_ctl修改或删除事件监听
-        int rt = epoll_ctl(m_epfd, op, fd, &ev);
-        if (rt)
+        // 计算新的事件集合，并确定epoll操作类型；持久注册模式下无需修改注册
+        if (!iom->m_persistentEpoll)
         {
-            saved_errno = errno;
-            CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", " << fd << ", " << ev.events << "): "
-                                    << rt << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
-            return false; // epoll_ctl调用失败时记录错误日志并返回false
+            Event new_events = (Event)(fd_ctx->events & ~event);
+            int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+            epoll_event ev = {};
+            ev.events = new_events | EPOLLET;
+            ev.data.ptr = fd_ctx;
+            if (iom->epollCtl(op, fd_ctx->fd, ev))
+            {
+                return false; // epoll_ctl调用失败时记录错误日志并返回false
+            }
         }
 
         // 触发相关事件的回调函数，并减少待处理事件计数
         fd_ctx->triggerEvent(event);
-        --m_pendingEventCount;
+        --iom->m_pendingEventCount;
 
         return true; // 返回true表示事件已成功取消
     }
@@ -288,40 +398,47 @@ namespace CIM
     {
         CIM_ASSERT(fd >= 0)
 
-        FdContext *fd_ctx = nullptr;
+        // 检查 fd 是否在合法范围内
+        FdContext *fd_ctx = GetFdContext(fd);
+        if (!fd_ctx)
         {
-            RWMutexType::ReadLock lock(m_mutex);
-            // 检查 fd 是否在合法范围内
-            if ((int)m_fdContexts.size() <= fd)
-            {
-                CIM_LOG_ERROR(g_logger) << "cancelAll: fd=" << fd
-                                        << " out of range, m_fdContexts.size()=" << m_fdContexts.size();
-                return false;
-            }
-
-            fd_ctx = m_fdContexts[fd];
+            CIM_LOG_ERROR(g_logger) << "cancelAll: fd=" << fd << " out of range";
+            return false;
         }
 
+        // 事件属于注册它的IOManager，在任意IOManager上关闭fd都能取消
         FdContext::MutexType::Lock lock2(fd_ctx->mutex);
-        // 如果 fd 上未注册任何事件，直接返回 false
-        if (!(fd_ctx->events))
+        IOManager *iom = fd_ctx->owner;
+        if (!iom)
         {
             return false;
         }
+        // 取消进行中的io_uring请求
+        bool cancelled = false;
+        if (iom->m_uring)
+        {
+            cancelled = iom->cancelIO(fd_ctx, READ);
+            cancelled = iom->cancelIO(fd_ctx, WRITE) || cancelled;
+        }
+        // 如果 fd 上未注册任何事件，直接返回
+        if (!(fd_ctx->events) && !fd_ctx->registered)
+        {
+            return cancelled;
+        }
 
         // 从 epoll 实例中删除该文件描述符的事件监听
-        int op = EPOLL_CTL_DEL;
         epoll_event ev = {};
         ev.events = 0;
         ev.data.ptr = fd_ctx;
-
-        int saved_errno;
-        int rt = epoll_ctl(m_epfd, op, fd, &ev);
-        if (rt)
+        int rt = iom->epollCtl(EPOLL_CTL_DEL, fd, ev);
+        if (fd_ctx->registered)
+        {
+            // 持久注册在fd关闭前移除，即使删除失败也不再沿用，避免fd复用后误以为已注册
+            fd_ctx->registered = false;
+            fd_ctx->ready = NONE;
+        }
+        else if (rt)
         {
-            saved_errno = errno;
-            CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", " << fd << ", " << ev.events << "): "
-                                    << rt << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
             return false;
         }
 
@@ -329,14 +446,14 @@ namespace CIM
         if (fd_ctx->events & Event::READ)
         {
             fd_ctx->triggerEvent(READ);
-            --m_pendingEventCount;
+            --iom->m_pendingEventCount;
         }
 
         // 触发 WRITE 事件的回调函数（如果已注册）
         if (fd_ctx->events & Event::WRITE)
         {
             fd_ctx->triggerEvent(WRITE);
-            --m_pendingEventCount;
+            --iom->m_pendingEventCount;
         }
 
         // 确保所有事件都已被正确清理
@@ -349,6 +466,237 @@ namespace CIM
         return dynamic_cast<IOManager *>(Scheduler::GetThis());
     }
 
+    IOManager::Backend IOManager::BackendFromString(const std::string &str)
+    {
+        if (str == "uring" || str == "io_uring")
+        {
+            return URING;
+        }
+        return EPOLL;
+    }
+
+    const char *IOManager::BackendToString(Backend backend)
+    {
+        return backend == URING ? "uring" : "epoll";
+    }
+
+    IOManager::FdContext *IOManager::GetFdContext(int fd)
+    {
+        return FdMgr::GetInstance()->getSlot(fd);
+    }
+
+    bool IOManager::acquire(FdContext *fd_ctx)
+    {
+        IOManager *owner = fd_ctx->owner;
+        if (owner == this)
+        {
+            return true;
+        }
+        if (owner)
+        {
+            if (fd_ctx->events || fd_ctx->read.request || fd_ctx->write.request)
+            {
+                CIM_LOG_ERROR(g_logger) << "fd=" << fd_ctx->fd << " is waited on by IOManager " << owner->getName()
+                                        << ", cannot wait on " << getName();
+                return false;
+            }
+            if (fd_ctx->registered)
+            {
+                // 未经hook关闭的fd已被内核移出epoll，删除失败可以忽略
+                epoll_event ev = {};
+                owner->m_epollCtls.fetch_add(1, std::memory_order_relaxed);
+                epoll_ctl(owner->m_epfd, EPOLL_CTL_DEL, fd_ctx->fd, &ev);
+            }
+        }
+        fd_ctx->owner = this;
+        fd_ctx->registered = false;
+        fd_ctx->ready = NONE;
+        return true;
+    }
+
+    bool IOManager::submitIO(int fd, Event event, IORequest &req)
+    {
+        CIM_ASSERT(fd >= 0)
+        FdContext *fd_ctx = GetFdContext(fd);
+        if (!fd_ctx)
+        {
+            CIM_LOG_ERROR(g_logger) << "submitIO: fd=" << fd << " out of range";
+            return false;
+        }
+        return submitIO(fd_ctx, event, req);
+    }
+
+    bool IOManager::submitIO(FdContext *fd_ctx, Event event, IORequest &req)
+    {
+        CIM_ASSERT(event == READ || event == WRITE);
+        CIM_ASSERT(Coroutine::GetThis());
+        if (!m_uring)
+        {
+            return false;
+        }
+
+        int fd = fd_ctx->fd;
+        FdContext::MutexType::Lock lock(fd_ctx->mutex);
+        // 已经hook关闭的fd不再提交：请求持有文件引用，close之后不会再有人取消它
+        if (static_cast<FdCtx *>(fd_ctx)->isClose() || !acquire(fd_ctx))
+        {
+            return false;
+        }
+        FdContext::EventContext &event_ctx = fd_ctx->getContext(event);
+        if (event_ctx.request || (fd_ctx->events & event))
+        {
+            CIM_LOG_WARN(g_logger) << "submitIO fd=" << fd << " event=" << event << " already waiting";
+            return false;
+        }
+
+        // SQE一旦入队就可能被其他线程提交并完成，入队前先填好恢复协程所需的信息
+        req.result = 0;
+        req.cancelled = false;
+        req.event = event;
+        req.context = fd_ctx;
+        req.scheduler = Scheduler::GetThis();
+        req.coroutine = Coroutine::GetThis();
+        CIM_ASSERT(req.coroutine->getState() == Coroutine::EXEC);
+
+        {
+            Mutex::Lock lock2(m_sqMutex);
+            uint32_t need = req.timeout != ~0ull ? 2 : 1;
+            if (m_uring->space() < need)
+            {
+                // 提交队列已满，先提交一批再取空位
+                m_uring->submit();
+                m_uringEnters.fetch_add(1, std::memory_order_relaxed);
+                if (m_uring->space() < need)
+                {
+                    req.coroutine.reset();
+                    return false;
+                }
+            }
+            event_ctx.request = &req;
+            ++m_pendingEventCount;
+
+            io_uring_sqe *sqe = m_uring->getSqe();
+            sqe->opcode = req.opcode;
+            sqe->fd = fd;
+            sqe->addr = req.addr;
+            sqe->len = req.len;
+            sqe->off = req.off;
+            sqe->msg_flags = req.op_flags; // 与accept_flags等共用同一字段
+            sqe->user_data = (uint64_t)&req;
+            if (req.timeout != ~0ull)
+            {
+                // 链接的超时到期时内核以 -ECANCELED 完成请求，超时本身的CQE忽略
+                sqe->flags |= IOSQE_IO_LINK;
+                req.ts[0] = req.timeout / 1000;
+                req.ts[1] = req.timeout % 1000 * 1000000;
+                io_uring_sqe *timeout_sqe = m_uring->getSqe();
+                timeout_sqe->opcode = IORING_OP_LINK_TIMEOUT;
+                timeout_sqe->fd = -1;
+                timeout_sqe->addr = (uint64_t)req.ts;
+                timeout_sqe->len = 1;
+                timeout_sqe->user_data = 0;
+            }
+            m_uringSqes.fetch_add(need, std::memory_order_relaxed);
+
+            // 有空闲线程时立即提交：当前线程让出后可能接着执行耗时任务，空闲线程则阻塞在
+            // epoll_wait 中，若等到某个线程进入idle才提交，请求可能长时间没有发给内核。
+            // 所有线程都在忙时留到下一次进入idle批量提交，那时才有线程能处理完成事件
+            if (hasIdleThreads())
+            {
+                int rt = m_uring->submit();
+                m_uringEnters.fetch_add(1, std::memory_order_relaxed);
+                if (rt < 0)
+                {
+                    CIM_LOG_ERROR(g_logger) << "io_uring_enter submit fd=" << fd << " failed: " << strerror(-rt);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool IOManager::cancelIO(FdContext *fd_ctx, Event event)
+    {
+        IORequest *req = fd_ctx->getContext(event).request;
+        if (!req)
+        {
+            return false;
+        }
+        if (req->cancelled)
+        {
+            return true;
+        }
+        req->cancelled = true;
+
+        // 立即提交：请求完成前槽位不会清空，协程也不会复用同一地址发起新请求，按user_data取消不会误伤
+        Mutex::Lock lock(m_sqMutex);
+        if (m_uring->space() < 1)
+        {
+            m_uring->submit();
+            m_uringEnters.fetch_add(1, std::memory_order_relaxed);
+        }
+        io_uring_sqe *sqe = m_uring->getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)req;
+        sqe->user_data = 0;
+        m_uringSqes.fetch_add(1, std::memory_order_relaxed);
+        int rt = m_uring->submit();
+        m_uringEnters.fetch_add(1, std::memory_order_relaxed);
+        if (rt < 0)
+        {
+            CIM_LOG_ERROR(g_logger) << "io_uring_enter cancel fd=" << fd_ctx->fd << " failed: " << strerror(-rt);
+        }
+        return true;
+    }
+
+    void IOManager::flushIO()
+    {
+        Mutex::Lock lock(m_sqMutex);
+        if (m_uring->pending() == 0)
+        {
+            return;
+        }
+        int rt = m_uring->submit();
+        m_uringEnters.fetch_add(1, std::memory_order_relaxed);
+        if (rt < 0)
+        {
+            CIM_LOG_ERROR(g_logger) << "io_uring_enter submit failed: " << strerror(-rt);
+        }
+    }
+
+    void IOManager::reapIO()
+    {
+        Mutex::Lock lock(m_cqMutex);
+        size_t count = m_uring->reap([this](const io_uring_cqe &cqe)
+                                     {
+                                         if (!cqe.user_data)
+                                         {
+                                             return; // 超时与取消请求自身的完成
+                                         }
+                                         IORequest *req = (IORequest *)cqe.user_data;
+                                         {
+                                             FdContext::MutexType::Lock lock2(req->context->mutex);
+                                             FdContext::EventContext &event_ctx = req->context->getContext(req->event);
+                                             if (event_ctx.request == req)
+                                             {
+                                                 event_ctx.request = nullptr;
+                                             }
+                                         }
+                                         req->result = cqe.res;
+                                         --m_pendingEventCount;
+                                         // 调度后协程可能立即恢复并释放req，之后不能再访问；
+                                         // 在本调度器的idle中收取时随本轮其他就绪任务一起入队
+                                         if (t_polling && t_polling == req->scheduler)
+                                         {
+                                             t_ready_coroutines.push_back(std::move(req->coroutine));
+                                         }
+                                         else
+                                         {
+                                             req->scheduler->schedule(&req->coroutine);
+                                         } });
+        m_uringCqes.fetch_add(count, std::memory_order_relaxed);
+    }
+
     void IOManager::tickle()
     {
         //  检查是否有空闲线程，若无则直接返回
@@ -356,16 +704,126 @@ namespace CIM
         {
             return;
         }
-        // 通过管道写入一个字节 "T" 以触发调度器
-        int rt = write(m_tickleFds[1], "T", 1);
-        CIM_ASSERT(rt == 1)
+        m_tickleCalls.fetch_add(1, std::memory_order_relaxed);
+        // 事件循环中调度的任务由当前线程返回run后自行执行，若积压多个任务，
+        // 取任务时会再接力唤醒其他线程，这里无需唤醒
+        if (t_polling == this)
+        {
+            m_tickleCoalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // 上一次唤醒还未被空闲线程消费，被唤醒的线程会看到本次新增的任务，无需再次写入
+        if (m_tickled.exchange(true))
+        {
+            m_tickleCoalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint64_t one = 1;
+        int rt = write(m_tickleFd, &one, sizeof(one));
+        CIM_ASSERT(rt == sizeof(one));
+        m_tickleWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    IOManager::TickleStats IOManager::getTickleStats() const
+    {
+        TickleStats stats;
+        stats.calls = m_tickleCalls.load(std::memory_order_relaxed);
+        stats.coalesced = m_tickleCoalesced.load(std::memory_order_relaxed);
+        stats.writes = m_tickleWrites.load(std::memory_order_relaxed);
+        stats.reads = m_tickleReads.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    IOManager::EpollStats IOManager::getEpollStats() const
+    {
+        EpollStats stats;
+        stats.ctls = m_epollCtls.load(std::memory_order_relaxed);
+        stats.ready = m_epollReady.load(std::memory_order_relaxed);
+        stats.waits = m_epollWaits.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    bool IOManager::isPreciseWait() const
+    {
+        return m_pwait2 && s_has_pwait2.load(std::memory_order_relaxed);
+    }
+
+    IOManager::LoopStats IOManager::getLoopStats() const
+    {
+        LoopStats stats;
+        stats.wakeups = m_loopWakeups.load(std::memory_order_relaxed);
+        stats.events = m_loopEvents.load(std::memory_order_relaxed);
+        stats.maxEvents = m_loopMaxEvents.load(std::memory_order_relaxed);
+        stats.timers = m_loopTimers.load(std::memory_order_relaxed);
+        stats.grows = m_loopGrows.load(std::memory_order_relaxed);
+        stats.loopUs = m_loopUs.load(std::memory_order_relaxed);
+        stats.maxLoopUs = m_loopMaxUs.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    IOManager::UringStats IOManager::getUringStats() const
+    {
+        UringStats stats;
+        stats.enters = m_uringEnters.load(std::memory_order_relaxed);
+        stats.sqes = m_uringSqes.load(std::memory_order_relaxed);
+        stats.cqes = m_uringCqes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::ostream &IOManager::dump(std::ostream &os)
+    {
+        Scheduler::dump(os);
+        TickleStats stats = getTickleStats();
+        EpollStats epoll_stats = getEpollStats();
+        os << std::endl
+           << "    tickle: calls=" << stats.calls
+           << " coalesced=" << stats.coalesced
+           << " writes=" << stats.writes
+           << " reads=" << stats.reads
+           << std::endl
+           << "    epoll: mode=" << (m_persistentEpoll ? "persistent" : "rearm")
+           << " ctls=" << epoll_stats.ctls
+           << " ready=" << epoll_stats.ready
+           << " waits=" << epoll_stats.waits;
+        LoopStats loop_stats = getLoopStats();
+        os << std::endl
+           << "    loop: wakeups=" << loop_stats.wakeups
+           << " events=" << loop_stats.events
+           << " max_events=" << loop_stats.maxEvents
+           << " timers=" << loop_stats.timers
+           << " grows=" << loop_stats.grows
+           << " avg_us=" << (loop_stats.wakeups ? loop_stats.loopUs / loop_stats.wakeups : 0)
+           << " max_us=" << loop_stats.maxLoopUs
+           << " pwait2=" << isPreciseWait();
+        if (m_uring)
+        {
+            UringStats uring_stats = getUringStats();
+            os << std::endl
+               << "    io_uring: enters=" << uring_stats.enters
+               << " sqes=" << uring_stats.sqes
+               << " cqes=" << uring_stats.cqes;
+        }
+        return os;
+    }
+
+    int IOManager::epollCtl(int op, int fd, epoll_event &ev)
+    {
+        m_epollCtls.fetch_add(1, std::memory_order_relaxed);
+        int rt = epoll_ctl(m_epfd, op, fd, &ev);
+        if (rt)
+        {
+            int saved_errno = errno;
+            CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", " << fd << ", " << ev.events << "): "
+                                    << rt << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
+        }
+        return rt;
     }
 
     bool IOManager::stopping(uint64_t &timeout)
     {
-        timeout = getNextTimer();
-        // ~0ull表示没有定时器或者无限超时
-        return timeout == ~0ull && m_pendingEventCount == 0 && Scheduler::stopping();
+        timeout = getNextTimerNS();
+        // 时间轮下其他线程分片的到期时间只是提示值，定时器取消后不会立即更新，以定时器总数为准
+        return !hasTimer() && m_pendingEventCount == 0 && Scheduler::stopping();
     }
 
     bool IOManager::stopping()
@@ -379,10 +837,13 @@ namespace CIM
         // ==========初始化阶段==========
         CIM_LOG_DEBUG(g_logger) << "idle";
 
-        // 分配 epoll_event 数组并使用智能指针管理内存，用于存储 epoll 等待到的事件
-        epoll_event *events = new epoll_event[64]();
-        std::shared_ptr<epoll_event> shared_event(events, [](epoll_event *ptr)
-                                                  { delete[] ptr; });
+        // 存储 epoll 等待到的事件，一次等待返回满数组说明还有积压，翻倍扩容直到上限
+        std::vector<epoll_event> events(kInitialEvents);
+        // 到期定时器回调，跨轮复用避免每轮分配
+        std::vector<std::function<void()>> &cbs = t_ready_cbs;
+
+        // 绑定本线程的定时器分片，协程内添加的超时定时器由本线程处理
+        bindTimerWheel();
 
         // 主空闲循环，持续运行直到满足停止条件
         while (true)
@@ -393,54 +854,62 @@ namespace CIM
             if (stopping(next_timeout))
             {
                 CIM_LOG_INFO(g_logger) << "name=" << getName() << " idle stopping exit";
+                // tickle已合并，停止时接力唤醒下一个仍在epoll_wait中的线程
+                tickle();
                 break;
             }
 
             // ==========epoll_wait 等待事件==========
+            // 本轮调度中协程填写的SQE在这里一次提交
+            if (m_uring)
+            {
+                flushIO();
+            }
             int rt = 0;
+            // 没有定时器或超过最长等待时间时按最长时间等待
+            next_timeout = next_timeout > kMaxTimeoutNS ? kMaxTimeoutNS : next_timeout;
             do
             {
-                static const int MAX_TIMEOUT = 3000; // 设置最大超时时间为3秒
-                if (next_timeout != ~0ull)           // 如果有定时器
-                {
-                    // 限制超时时间不超过 MAX_TIMEOUT 毫秒
-                    next_timeout = (int)next_timeout > MAX_TIMEOUT ? MAX_TIMEOUT : next_timeout;
-                }
-                else
-                {
-                    next_timeout = MAX_TIMEOUT;
-                }
-                // 等待 epoll 事件，超时时间为 next_timeout 毫秒，确保定时任务能够及时执行
-                rt = epoll_wait(m_epfd, events, 64, (int)next_timeout);
+                // 等待 epoll 事件，超时时间为 next_timeout 纳秒，确保定时任务能够及时执行
+                rt = epoll_wait_ns(m_epfd, events.data(), (int)events.size(), next_timeout, m_pwait2);
+                m_epollWaits.fetch_add(1, std::memory_order_relaxed);
             } while (rt < 0 && errno == EINTR);
 
-            // ==========处理到期定时器==========
-            std::vector<std::function<void()>> cbs;
-            listExpiredCb(cbs);
-            if (!cbs.empty())
-            {
-                // 将到期的定时器回调加入调度队列
-                schedule(cbs.begin(), cbs.end());
-                cbs.clear();
-            }
+            uint64_t wake_us = TimeUtil::NowToUS();
+            t_polling = this;
 
             // ==========处理 epoll 事件==========
+            // 先分发IO再收集定时器，同一轮中数据已到达的请求不会被它的超时定时器取消
             for (int i = 0; i < rt; ++i)
             {
                 epoll_event &event = events[i];
 
-                // 如果事件来自用于唤醒调度器的管道，清空管道中的数据
-                if (event.data.fd == m_tickleFds[0])
+                // io_uring 有完成的请求
+                if (m_uring && event.data.fd == m_uring->getFd())
+                {
+                    reapIO();
+                    continue;
+                }
+
+                // 如果事件来自用于唤醒调度器的 eventfd，清空计数并允许下一次唤醒写入
+                if (event.data.fd == m_tickleFd)
                 {
-                    uint8_t dummy;
-                    while (read(m_tickleFds[0], &dummy, 1) == 1)
-                        ;
+                    uint64_t dummy;
+                    if (read(m_tickleFd, &dummy, sizeof(dummy)) == sizeof(dummy))
+                    {
+                        m_tickleReads.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    m_tickled = false;
                     continue;
                 }
 
                 // 获取与文件描述符关联的上下文对象
                 FdContext *fd_ctx = (FdContext *)event.data.ptr;
                 FdContext::MutexType::Lock lock(fd_ctx->mutex);
+                if (fd_ctx->owner != this)
+                {
+                    continue; // 取出事件前注册已迁移到其他IOManager
+                }
 
                 /*如果发生错误或挂起，启用读和写的监控，
                 保证即使在错误或挂起的情况下，
@@ -448,7 +917,7 @@ namespace CIM
                 */
                 if (event.events & (EPOLLERR | EPOLLHUP))
                 {
-                    event.events |= (EPOLLIN | EPOLLOUT) & fd_ctx->events;
+                    event.events |= (EPOLLIN | EPOLLOUT) & (m_persistentEpoll ? (READ | WRITE) : fd_ctx->events);
                 }
 
                 // 确定实际发生的事件类型（读/写）
@@ -462,26 +931,34 @@ namespace CIM
                     real_events |= WRITE;
                 }
 
-                // 如果没有设置相关事件则跳过触发事件
-                if ((fd_ctx->events & real_events) == NONE)
+                if (m_persistentEpoll)
                 {
-                    continue;
+                    // 没有等待者的事件记为就绪，留给下一次addEvent，注册保持不变
+                    fd_ctx->ready = (Event)(fd_ctx->ready | (real_events & ~fd_ctx->events));
+                    real_events &= fd_ctx->events;
+                    if (real_events == NONE)
+                    {
+                        continue;
+                    }
                 }
-
-                // 更新 epoll 监听事件：如果有剩余事件则修改(MOD)，否则删除(DEL)
-                int left_events = (fd_ctx->events & ~real_events);
-                int op = left_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
-                event.events = left_events | EPOLLET;
-
-                // 更新 epoll 对该文件描述符的监听设置
-                int rt2 = epoll_ctl(m_epfd, op, fd_ctx->fd, &event);
-                if (rt2)
+                else
                 {
-                    int saved_errno = errno;
-                    CIM_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op << ", "
-                                            << fd_ctx->fd << ", " << event.events << "): "
-                                            << rt2 << " (" << saved_errno << ") (" << strerror(saved_errno) << ")";
-                    continue;
+                    // 如果没有设置相关事件则跳过触发事件
+                    if ((fd_ctx->events & real_events) == NONE)
+                    {
+                        continue;
+                    }
+
+                    // 更新 epoll 监听事件：如果有剩余事件则修改(MOD)，否则删除(DEL)
+                    int left_events = (fd_ctx->events & ~real_events);
+                    int op = left_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+                    event.events = left_events | EPOLLET;
+
+                    // 更新 epoll 对该文件描述符的监听设置
+                    if (epollCtl(op, fd_ctx->fd, event))
+                    {
+                        continue;
+                    }
                 }
 
                 // 如果适用，则触发读事件回调
@@ -499,6 +976,32 @@ namespace CIM
                 }
             }
 
+            // ==========处理到期定时器==========
+            size_t io_cbs = cbs.size();
+            listExpiredCb(cbs);
+            size_t timers = cbs.size() - io_cbs;
+
+            // 就绪的协程、回调与到期定时器回调一次加锁入队
+            scheduleBatch(t_ready_coroutines, cbs);
+            t_polling = nullptr;
+
+            // ==========统计与扩容==========
+            uint64_t cost_us = TimeUtil::NowToUS() - wake_us;
+            if (rt >= 0)
+            {
+                m_loopWakeups.fetch_add(1, std::memory_order_relaxed);
+                m_loopEvents.fetch_add(rt, std::memory_order_relaxed);
+                update_max(m_loopMaxEvents, rt);
+            }
+            m_loopTimers.fetch_add(timers, std::memory_order_relaxed);
+            m_loopUs.fetch_add(cost_us, std::memory_order_relaxed);
+            update_max(m_loopMaxUs, cost_us);
+            if (rt == (int)events.size() && events.size() < g_max_events->getValue())
+            {
+                events.resize(std::min<size_t>(events.size() * 2, g_max_events->getValue()));
+                m_loopGrows.fetch_add(1, std::memory_order_relaxed);
+            }
+
             // ==========协程切换==========
             // 将控制权交回协程调度器，当前协程让出执行权
             Coroutine::ptr cur = Coroutine::GetThis();
@@ -506,6 +1009,8 @@ namespace CIM
             cur.reset(); // 引用计数减一
             raw_ptr->swapOut();
         }
+
+        unbindTimerWheel();
     }
 
     void IOManager::onTimerInsertedAtFront()
@@ -513,21 +1018,6 @@ namespace CIM
         tickle();
     }
 
-    void IOManager::contextResize(size_t size)
-    {
-        m_fdContexts.resize(size);
-
-        // 遍历数组，为未初始化的元素分配和设置文件描述符上下文
-        for (size_t i = 0; i < m_fdContexts.size(); ++i)
-        {
-            if (!m_fdContexts[i]) // 如果当前索引的元素为空
-            {
-                m_fdContexts[i] = new FdContext;
-                m_fdContexts[i]->fd = i; // 设置文件描述符
-            }
-        }
-    }
-
     IOManager::FdContext::EventContext &IOManager::FdContext::getContext(Event event)
     {
         switch (event)
@@ -562,16 +1052,28 @@ namespace CIM
         // 获取与事件关联的上下文
         EventContext &event_ctx = getContext(event);
 
-        // 根据上下文内容调度回调函数或协程
-        if (event_ctx.cb)
+        // 根据上下文内容调度回调函数或协程；
+        // 在本调度器的idle中分发时先收集起来，本轮结束后一次批量入队
+        if (t_polling && t_polling == event_ctx.scheduler)
+        {
+            if (event_ctx.cb)
+            {
+                t_ready_cbs.push_back(std::move(event_ctx.cb));
+            }
+            else
+            {
+                t_ready_coroutines.push_back(std::move(event_ctx.coroutine));
+            }
+        }
+        else if (event_ctx.cb)
         {
-            // 如果存在回调函数，则调度该回调
-            event_ctx.scheduler->schedule(event_ctx.cb);
+            // 如果存在回调函数，则调度该回调（移交所有权，避免拷贝回调）
+            event_ctx.scheduler->schedule(&event_ctx.cb);
         }
         else
         {
             // 如果不存在回调函数，则调度协程
-            event_ctx.scheduler->schedule(event_ctx.coroutine);
+            event_ctx.scheduler->schedule(&event_ctx.coroutine);
         }
 
         // 触发完成后必须清理上下文，避免后续 addEvent 命中断言
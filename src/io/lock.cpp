@@ -16,6 +16,10 @@ namespace CIM
     {
         pthread_mutex_lock(&m_mutex);
     }
+    bool Mutex::trylock()
+    {
+        return pthread_mutex_trylock(&m_mutex) == 0;
+    }
     void Mutex::unlock()
     {
         pthread_mutex_unlock(&m_mutex);
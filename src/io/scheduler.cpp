@@ -1,6 +1,8 @@
 #include "scheduler.hpp"
+#include "config.hpp"
 #include "macro.hpp"
 #include "hook.hpp"
+#include "time_util.hpp"
 
 namespace CIM
 {
@@ -10,11 +12,119 @@ namespace CIM
     static thread_local Scheduler *t_scheduler = nullptr;
     // 当前线程的协程对象
     static thread_local Coroutine *t_coroutine = nullptr;
+    // 工作窃取模式下当前线程的任务队列（仅当 t_scheduler 为其所属调度器时有效）
+    static thread_local void *t_worker_queue = nullptr;
+    // 工作窃取模式下选择窃取目标用的随机数状态
+    static thread_local uint32_t t_steal_seed = 0;
 
-    Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name)
-        : m_name(name)
+    // 每个线程最多缓存的空闲任务节点数量
+    static const size_t kMaxCachedTaskNodes = 1024;
+
+    // 定义配置项--各优先级(realtime / normal / background)在一轮调度中最多连续取出的任务数
+    static ConfigVar<std::vector<uint32_t>>::ptr g_priority_weights =
+        Config::Lookup<std::vector<uint32_t>>("scheduler.priority_weights", {8, 4, 1},
+                                              "scheduler realtime/normal/background dispatch weights");
+
+    static std::atomic<uint32_t> s_priority_weights[Scheduler::kPriorityCount];
+
+    /**
+     * @brief 更新各优先级权重，缺失或为0的项按1处理
+     */
+    static void SetPriorityWeights(const std::vector<uint32_t> &weights)
+    {
+        for (int i = 0; i < Scheduler::kPriorityCount; ++i)
+        {
+            uint32_t w = i < (int)weights.size() ? weights[i] : 1;
+            s_priority_weights[i] = w ? w : 1;
+        }
+    }
+
+    struct SchedulerInit
+    {
+        SchedulerInit()
+        {
+            SetPriorityWeights(g_priority_weights->getValue());
+            g_priority_weights->addListener(
+                [](const std::vector<uint32_t> &old_val, const std::vector<uint32_t> &new_val)
+                {
+                    SetPriorityWeights(new_val);
+                });
+        }
+    };
+    static SchedulerInit __scheduler_init;
+
+    // 当前线程在本轮调度中各优先级剩余的额度
+    static thread_local uint32_t t_dispatch_credits[Scheduler::kPriorityCount] = {0};
+
+    /**
+     * @brief 计算本次取任务时各优先级的尝试顺序
+     * @details 仍有额度的优先级按优先级从高到低排在前面，额度用完的排在后面，
+     *          这样高优先级用完额度后低优先级可以得到执行，而空闲时任何优先级都不会被跳过
+     */
+    static void DispatchOrder(int order[Scheduler::kPriorityCount])
+    {
+        int n = 0;
+        for (int i = 0; i < Scheduler::kPriorityCount; ++i)
+        {
+            if (t_dispatch_credits[i] > 0)
+            {
+                order[n++] = i;
+            }
+        }
+        for (int i = 0; i < Scheduler::kPriorityCount; ++i)
+        {
+            if (t_dispatch_credits[i] == 0)
+            {
+                order[n++] = i;
+            }
+        }
+    }
+
+    /**
+     * @brief 从某个优先级取到任务后扣减额度，额度已用完说明其他有额度的优先级均为空，开始新的一轮
+     */
+    static void ConsumeCredit(int priority)
+    {
+        if (t_dispatch_credits[priority] == 0)
+        {
+            for (int i = 0; i < Scheduler::kPriorityCount; ++i)
+            {
+                t_dispatch_credits[i] = s_priority_weights[i];
+            }
+        }
+        --t_dispatch_credits[priority];
+    }
+
+    /**
+     * @brief xorshift32 伪随机数，用于随机选择窃取目标
+     */
+    static uint32_t NextStealRandom()
+    {
+        uint32_t x = t_steal_seed;
+        if (x == 0)
+        {
+            x = (uint32_t)GetThreadId() * 2654435761u + 1;
+        }
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        t_steal_seed = x;
+        return x;
+    }
+
+    Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, QueueMode mode,
+                         const ThreadAffinity &affinity)
+        : m_name(name),
+          m_queueMode(mode),
+          m_affinity(affinity)
     {
         CIM_ASSERT(threads > 0);
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            m_queuedCount[i] = 0;
+            m_expiredDropped[i] = 0;
+            m_expiredDemoted[i] = 0;
+        }
 
         // 如果使用调用线程，则将当前线程作为调度线程之一
         if (use_caller)
@@ -37,6 +147,17 @@ namespace CIM
             m_rootThreadId = -1;
         }
         m_threadCount = threads;
+
+        if (m_queueMode == WORK_STEALING)
+        {
+            // 调用线程(若参与调度)与所有工作线程各占一个队列
+            size_t total = m_threadCount + (use_caller ? 1 : 0);
+            m_workerQueues.resize(total);
+            for (size_t i = 0; i < total; ++i)
+            {
+                m_workerQueues[i] = new WorkerQueue;
+            }
+        }
     }
 
     Scheduler::~Scheduler()
@@ -46,6 +167,17 @@ namespace CIM
         {
             t_scheduler = nullptr;
         }
+
+        for (auto wq : m_workerQueues)
+        {
+            Task *task = nullptr;
+            while (wq->local.steal(task))
+            {
+                delete task;
+            }
+            delete wq;
+        }
+        m_workerQueues.clear();
     }
 
     const std::string &Scheduler::getName() const
@@ -53,6 +185,422 @@ namespace CIM
         return m_name;
     }
 
+    const char *Scheduler::QueueModeToString(QueueMode mode)
+    {
+        switch (mode)
+        {
+        case WORK_STEALING:
+            return "work_steal";
+        case GLOBAL:
+        default:
+            return "global";
+        }
+    }
+
+    Scheduler::QueueMode Scheduler::QueueModeFromString(const std::string &str)
+    {
+        if (str == "work_steal" || str == "work_stealing")
+        {
+            return WORK_STEALING;
+        }
+        return GLOBAL;
+    }
+
+    const char *Scheduler::PriorityToString(Priority priority)
+    {
+        switch (priority)
+        {
+        case REALTIME:
+            return "realtime";
+        case BACKGROUND:
+            return "background";
+        case NORMAL:
+        default:
+            return "normal";
+        }
+    }
+
+    Scheduler::Priority Scheduler::PriorityFromString(const std::string &str)
+    {
+        if (str == "realtime")
+        {
+            return REALTIME;
+        }
+        if (str == "background")
+        {
+            return BACKGROUND;
+        }
+        return NORMAL;
+    }
+
+    Scheduler::PriorityStats Scheduler::getPriorityStats(Priority priority) const
+    {
+        PriorityStats stats;
+        const LatencyHistogram &hist = m_delayHist[priority];
+        stats.count = hist.count();
+        stats.p50 = hist.percentile(0.5);
+        stats.p99 = hist.percentile(0.99);
+        stats.max = hist.max();
+        stats.dropped = m_expiredDropped[priority];
+        stats.demoted = m_expiredDemoted[priority];
+        return stats;
+    }
+
+    size_t Scheduler::getQueuedTaskCount() const
+    {
+        size_t count = m_stealingTaskCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            count += m_queuedCount[i].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    Scheduler::WorkerQueue *Scheduler::findWorkerQueue(pid_t tid)
+    {
+        for (auto wq : m_workerQueues)
+        {
+            if (wq->threadId == tid)
+            {
+                return wq;
+            }
+        }
+        return nullptr;
+    }
+
+    std::list<Scheduler::Task> &Scheduler::FreeTaskNodes()
+    {
+        static thread_local std::list<Task> s_nodes;
+        return s_nodes;
+    }
+
+    bool Scheduler::taskQueueEmptyNolock() const
+    {
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            if (!m_taskQueues[i].empty())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Scheduler::pushTaskNolock(Task &&task)
+    {
+        task.enqueueUs = TimeUtil::NowToUS();
+        int priority = task.priority;
+        std::list<Task> &queue = m_taskQueues[priority];
+        std::list<Task> &nodes = FreeTaskNodes();
+        if (nodes.empty())
+        {
+            queue.push_back(std::move(task));
+        }
+        else
+        {
+            nodes.front() = std::move(task);
+            queue.splice(queue.end(), nodes, nodes.begin());
+        }
+        ++m_queuedCount[priority];
+    }
+
+    void Scheduler::takeTaskNolock(std::list<Task> &queue, std::list<Task>::iterator it, Task &task)
+    {
+        --m_queuedCount[&queue - m_taskQueues];
+        task = std::move(*it);
+        std::list<Task> &nodes = FreeTaskNodes();
+        if (nodes.size() < kMaxCachedTaskNodes)
+        {
+            it->reset();
+            nodes.splice(nodes.begin(), queue, it);
+        }
+        else
+        {
+            queue.erase(it);
+        }
+    }
+
+    bool Scheduler::takePriorityNolock(int priority, uint64_t now, Task &task, bool &tickle_me,
+                                       std::list<Task> &expired)
+    {
+        std::list<Task> &queue = m_taskQueues[priority];
+        auto it = queue.begin();
+        while (it != queue.end())
+        {
+            // 当前任务指定了执行线程，且该线程不是当前线程，则跳过该任务，并标记为需要通知其他线程
+            if (it->threadId != -1 && it->threadId != GetThreadId())
+            {
+                ++it;
+                tickle_me = true;
+                continue;
+            }
+
+            CIM_ASSERT(it->coroutine || it->cb);
+
+            // 如果it中保存的是协程，并且正在执行中，则跳过
+            if (it->coroutine && it->coroutine->getState() == Coroutine::State::EXEC)
+            {
+                ++it;
+                continue;
+            }
+
+            // 任务已过期：回调任务可直接丢弃，否则降级到background队列尾部
+            if (it->deadlineUs && it->deadlineUs < now)
+            {
+                auto next = std::next(it);
+                if (it->dropExpired && !it->coroutine)
+                {
+                    ++m_expiredDropped[priority];
+                    --m_queuedCount[priority];
+                    expired.splice(expired.end(), queue, it);
+                    it = next;
+                    continue;
+                }
+                if (priority != BACKGROUND)
+                {
+                    ++m_expiredDemoted[priority];
+                    it->deadlineUs = 0;
+                    --m_queuedCount[priority];
+                    ++m_queuedCount[BACKGROUND];
+                    m_taskQueues[BACKGROUND].splice(m_taskQueues[BACKGROUND].end(), queue, it);
+                    it = next;
+                    continue;
+                }
+            }
+
+            takeTaskNolock(queue, it, task);
+            return true;
+        }
+        return false;
+    }
+
+    bool Scheduler::selectTaskNolock(uint64_t now, Task &task, bool &tickle_me, std::list<Task> &expired)
+    {
+        int order[kPriorityCount];
+        DispatchOrder(order);
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            if (takePriorityNolock(order[i], now, task, tickle_me, expired))
+            {
+                ConsumeCredit(order[i]);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Scheduler::ReleaseExpired(std::list<Task> &expired)
+    {
+        if (expired.empty())
+        {
+            return;
+        }
+        for (auto &task : expired)
+        {
+            task.reset();
+        }
+        std::list<Task> &nodes = FreeTaskNodes();
+        if (nodes.size() < kMaxCachedTaskNodes)
+        {
+            nodes.splice(nodes.begin(), expired);
+        }
+        expired.clear();
+    }
+
+    std::vector<std::unique_ptr<Scheduler::Task>> &Scheduler::FreeTasks()
+    {
+        static thread_local std::vector<std::unique_ptr<Task>> s_tasks;
+        return s_tasks;
+    }
+
+    Scheduler::Task *Scheduler::NewTask(Task &&task)
+    {
+        std::vector<std::unique_ptr<Task>> &tasks = FreeTasks();
+        if (tasks.empty())
+        {
+            return new Task(std::move(task));
+        }
+        Task *t = tasks.back().release();
+        tasks.pop_back();
+        *t = std::move(task);
+        return t;
+    }
+
+    void Scheduler::ReleaseTask(Task *t, Task &task)
+    {
+        task = std::move(*t);
+        std::vector<std::unique_ptr<Task>> &tasks = FreeTasks();
+        if (tasks.size() < kMaxCachedTaskNodes)
+        {
+            t->reset();
+            tasks.emplace_back(t);
+        }
+        else
+        {
+            delete t;
+        }
+    }
+
+    bool Scheduler::scheduleStealing(Task &&task)
+    {
+        if (!task.coroutine && !task.cb)
+        {
+            return false;
+        }
+
+        // 指定线程的任务进入目标线程的收件箱
+        if (task.threadId != -1)
+        {
+            WorkerQueue *wq = findWorkerQueue(task.threadId);
+            if (wq)
+            {
+                task.enqueueUs = TimeUtil::NowToUS();
+                MutexType::Lock lock(wq->mutex);
+                wq->pinned.push_back(std::move(task));
+                ++wq->pinnedCount;
+                ++m_stealingTaskCount;
+                return true;
+            }
+        }
+        // 当前线程是本调度器的工作线程，无期限的normal任务直接压入本地队列；
+        // 其他优先级和带期限的任务进入共享队列，参与按权重轮转与过期检查
+        else if (t_scheduler == this && t_worker_queue && task.priority == NORMAL && !task.deadlineUs)
+        {
+            WorkerQueue *wq = static_cast<WorkerQueue *>(t_worker_queue);
+            task.enqueueUs = TimeUtil::NowToUS();
+            ++m_stealingTaskCount;
+            wq->local.push(NewTask(std::move(task)));
+            // 仅在本地队列由空变为非空时唤醒空闲线程，被唤醒的线程会持续窃取直到队列耗尽，
+            // 避免每次入队都触发一次 tickle 系统调用
+            return wq->local.size() == 1 && hasIdleThreads();
+        }
+
+        // 外部线程或目标线程尚未就绪，进入共享注入队列
+        MutexType::Lock lock(m_mutex);
+        bool need_tickle = taskQueueEmptyNolock();
+        pushTaskNolock(std::move(task));
+        return need_tickle;
+    }
+
+    void Scheduler::scheduleTask(Task &&task, const TaskAttr &attr)
+    {
+        if (!task.coroutine && !task.cb)
+        {
+            return;
+        }
+        task.priority = (attr.priority >= 0 && attr.priority < kPriorityCount) ? attr.priority : NORMAL;
+        task.dropExpired = attr.dropExpired;
+        if (attr.deadline)
+        {
+            task.deadlineUs = TimeUtil::NowToUS() + attr.deadline * 1000;
+        }
+
+        bool need_tickle = false;
+        if (m_queueMode == WORK_STEALING)
+        {
+            need_tickle = scheduleStealing(std::move(task));
+        }
+        else
+        {
+            MutexType::Lock lock(m_mutex);
+            need_tickle = taskQueueEmptyNolock();
+            pushTaskNolock(std::move(task));
+        }
+        if (need_tickle)
+        {
+            tickle();
+        }
+    }
+
+    bool Scheduler::takeTaskStealing(Task &task, bool &tickle_me, uint64_t now)
+    {
+        WorkerQueue *self = static_cast<WorkerQueue *>(t_worker_queue);
+        Task *t = nullptr;
+
+        // 1. 指定给本线程的任务
+        if (self && self->pinnedCount > 0)
+        {
+            MutexType::Lock lock(self->mutex);
+            if (!self->pinned.empty())
+            {
+                task = std::move(self->pinned.front());
+                self->pinned.pop_front();
+                --self->pinnedCount;
+                --m_stealingTaskCount;
+                return true;
+            }
+        }
+
+        // 2. 按权重轮转：本地队列（LIFO）视为normal，优先于共享队列中的normal任务；
+        //    共享注入队列语义与全局模式相同，为空时无锁跳过
+        int order[kPriorityCount];
+        DispatchOrder(order);
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            int priority = order[i];
+            if (priority == NORMAL && self && self->local.pop(t))
+            {
+                --m_stealingTaskCount;
+                ReleaseTask(t, task);
+                ConsumeCredit(priority);
+                // IOManager::idle批量放入本地队列时没有唤醒其他线程，本地还有积压就接力唤醒，让它们来窃取
+                if (self->local.size() > 0 && hasIdleThreads())
+                {
+                    tickle_me = true;
+                }
+                return true;
+            }
+            if (m_queuedCount[priority] == 0)
+            {
+                continue;
+            }
+            std::list<Task> expired;
+            bool found = false;
+            {
+                MutexType::Lock lock(m_mutex);
+                found = takePriorityNolock(priority, now, task, tickle_me, expired);
+            }
+            ReleaseExpired(expired);
+            if (found)
+            {
+                ConsumeCredit(priority);
+                return true;
+            }
+        }
+
+        // 4. 从随机选择的其他线程队列顶部窃取
+        size_t n = m_workerQueues.size();
+        if (n > 1)
+        {
+            size_t start = NextStealRandom() % n;
+            for (size_t i = 0; i < n; ++i)
+            {
+                WorkerQueue *victim = m_workerQueues[(start + i) % n];
+                if (victim == self)
+                {
+                    continue;
+                }
+                if (victim->local.steal(t))
+                {
+                    --m_stealingTaskCount;
+                    ReleaseTask(t, task);
+                    // 被窃取的队列仍有积压时接力唤醒下一个空闲线程
+                    if (victim->local.size() > 0 && hasIdleThreads())
+                    {
+                        tickle_me = true;
+                    }
+                    return true;
+                }
+                // 其他线程的收件箱还有任务，需要唤醒它们
+                if (victim->pinnedCount > 0)
+                {
+                    tickle_me = true;
+                }
+            }
+        }
+        return false;
+    }
+
     Scheduler *Scheduler::GetThis()
     {
         return t_scheduler;
@@ -67,6 +615,45 @@ namespace CIM
         return m_idleThreadCount > 0;
     }
 
+    void Scheduler::scheduleBatch(std::vector<Coroutine::ptr> &coroutines, std::vector<std::function<void()>> &cbs)
+    {
+        if (coroutines.empty() && cbs.empty())
+        {
+            return;
+        }
+        bool need_tickle = false;
+        if (m_queueMode == WORK_STEALING)
+        {
+            // 工作线程上压入本地队列，本身无需加锁
+            for (auto &co : coroutines)
+            {
+                need_tickle = scheduleStealing(Task(&co, -1)) || need_tickle;
+            }
+            for (auto &cb : cbs)
+            {
+                need_tickle = scheduleStealing(Task(&cb, -1)) || need_tickle;
+            }
+        }
+        else
+        {
+            MutexType::Lock lock(m_mutex);
+            for (auto &co : coroutines)
+            {
+                need_tickle = scheduleNolock(&co, -1) || need_tickle;
+            }
+            for (auto &cb : cbs)
+            {
+                need_tickle = scheduleNolock(&cb, -1) || need_tickle;
+            }
+        }
+        coroutines.clear();
+        cbs.clear();
+        if (need_tickle)
+        {
+            tickle();
+        }
+    }
+
     Coroutine *Scheduler::GetMainCoroutine()
     {
         return t_coroutine;
@@ -126,7 +713,7 @@ namespace CIM
 
         m_isRunning = false;
 
-        // 确保在线程安全的前提下唤醒所有工作线程
+        // 唤醒工作线程；IOManager 的 tickle 会被合并，由退出的线程接力唤醒其余线程
         {
             MutexType::Lock lock(m_mutex);
             for (size_t i = 0; i < m_threadCount; ++i)
@@ -185,7 +772,8 @@ namespace CIM
     bool Scheduler::stopping()
     {
         MutexType::Lock lock(m_mutex);
-        return m_autoStop && m_taskQueue.empty() && !m_isRunning && m_activeThreadCount == 0;
+        return m_autoStop && taskQueueEmptyNolock() && m_stealingTaskCount == 0 &&
+               !m_isRunning && m_activeThreadCount == 0;
     }
 
     void Scheduler::idle()
@@ -207,6 +795,11 @@ namespace CIM
         // 创建工作线程的主协程
         if (GetThreadId() != m_rootThreadId)
         {
+            // 先设置亲和性与内存策略，之后本线程分配的协程栈等内存均落在目标节点
+            if (!m_affinity.empty())
+            {
+                m_affinity.apply(m_nextAffinityIndex++);
+            }
             t_coroutine = Coroutine::GetThis().get();
         }
         else
@@ -214,6 +807,17 @@ namespace CIM
             t_coroutine = m_rootCoroutine.get();
         }
 
+        // 工作窃取模式下为当前线程绑定一个本地队列
+        t_worker_queue = nullptr;
+        if (m_queueMode == WORK_STEALING)
+        {
+            size_t index = m_nextWorkerIndex++;
+            CIM_ASSERT(index < m_workerQueues.size());
+            WorkerQueue *wq = m_workerQueues[index];
+            wq->threadId = GetThreadId();
+            t_worker_queue = wq;
+        }
+
         // 创建空闲协程，当没有任务可执行时运行
         Coroutine::ptr idle_coroutine(new Coroutine(std::bind(&Scheduler::idle, this)));
         // 用于执行回调函数的协程
@@ -221,6 +825,8 @@ namespace CIM
 
         // 存储从协程队列中取出的协程或回调任务
         Task task;
+        // 取任务时被丢弃的过期任务，释放锁后销毁
+        std::list<Task> expired;
 
         while (true)
         {
@@ -228,38 +834,47 @@ namespace CIM
             task.reset();           // 清除上一次循环中保存的任务，确保当前循环处理的是新任务
             bool tickle_me = false; // 是否需要通知其他线程
             bool is_active = false; // 线程是否处于活动状态
+            uint64_t now = TimeUtil::NowToUS();
+            if (m_queueMode == WORK_STEALING)
             {
-                // 加锁访问协程队列
-                MutexType::Lock lock(m_mutex);
-                auto it = m_taskQueue.begin();
-                while (it != m_taskQueue.end())
+                if (takeTaskStealing(task, tickle_me, now))
                 {
-
-                    // 当前任务指定了执行线程，且该线程不是当前线程，则跳过该任务，并标记为需要通知其他线程
-                    if (it->threadId != -1 && it->threadId != GetThreadId())
+                    // 协程仍在其他线程上执行（尚未完成切出），放回注入队列稍后再取
+                    if (task.coroutine && task.coroutine->getState() == Coroutine::State::EXEC)
                     {
-                        ++it;
-                        tickle_me = true;
-                        continue;
+                        MutexType::Lock lock(m_mutex);
+                        pushTaskNolock(std::move(task));
+                        task.reset();
                     }
-
-                    CIM_ASSERT(it->coroutine || it->cb);
-
-                    // 如果it中保存的是协程，并且正在执行中，则跳过
-                    if (it->coroutine && it->coroutine->getState() == Coroutine::State::EXEC)
-                    {
-                        ++it;
-                        continue;
-                    }
-
-                    // 取出协程任务
-                    task = *it;
-                    m_taskQueue.erase(it);
+                    // 无论是否放回都计为活跃，放回时会在空闲处理阶段直接进入下一轮循环
                     ++m_activeThreadCount;
                     is_active = true;
-                    break;
                 }
             }
+            else
+            {
+                {
+                    // 加锁访问协程队列，按优先级权重取出协程任务
+                    MutexType::Lock lock(m_mutex);
+                    if (selectTaskNolock(now, task, tickle_me, expired))
+                    {
+                        ++m_activeThreadCount;
+                        is_active = true;
+                        // 队列中还有任务时接力唤醒一个空闲线程，而不是入队时一次唤醒所有线程
+                        if (!taskQueueEmptyNolock() && hasIdleThreads())
+                        {
+                            tickle_me = true;
+                        }
+                    }
+                }
+                ReleaseExpired(expired);
+            }
+
+            // 统计从入队到被取出的调度延迟
+            if ((task.coroutine || task.cb) && task.enqueueUs)
+            {
+                m_delayHist[task.priority].record(now > task.enqueueUs ? now - task.enqueueUs : 0);
+            }
 
             // ==========跨线程通知阶段==========
             // 如果有其他线程需要被唤醒，则触发tickle
@@ -273,6 +888,8 @@ namespace CIM
                 task.coroutine->getState() != Coroutine::State::TERM &&
                 task.coroutine->getState() != Coroutine::State::EXCEPT)
             {
+                // 记录任务优先级，协程之后因IO或定时器重新入队时沿用
+                task.coroutine->setPriority(task.priority);
                 // 进入目标协程
                 task.coroutine->swapIn();
                 // 离开目标协程
@@ -280,7 +897,7 @@ namespace CIM
                 // 如果协程状态为READY，说明协程主动让出了执行权，但仍需要继续执行，重新加入调度队列
                 if (task.coroutine->getState() == Coroutine::State::READY)
                 {
-                    schedule(task.coroutine);
+                    schedule(task.coroutine, TaskAttr((Priority)task.coroutine->getPriority()));
                 }
                 // 如果协程未结束且无异常，设置为HOLD状态
                 else if (task.coroutine->getState() != Coroutine::State::TERM &&
@@ -288,19 +905,25 @@ namespace CIM
                 {
                     task.coroutine->setState(Coroutine::State::HOLD);
                 }
-                // 如果协程是终止状态（TERM）或异常状态（EXCEPT），结束该协程的任务
+                // 如果协程是终止状态（TERM）或异常状态（EXCEPT），结束该协程的任务，
+                // 调度器持有唯一引用时放回协程池供后续回调任务复用
+                else
+                {
+                    Coroutine::Recycle(task.coroutine);
+                }
             }
             else if (task.cb) // 回调函数类型任务
             {
-                // 回调协程复用
+                // 回调协程复用，没有可复用的协程时从协程池获取
                 if (cb_coroutine)
                 {
-                    cb_coroutine->reset(task.cb);
+                    cb_coroutine->reset(std::move(task.cb));
                 }
                 else
                 {
-                    cb_coroutine.reset(new Coroutine(task.cb));
+                    cb_coroutine = Coroutine::Acquire(std::move(task.cb));
                 }
+                cb_coroutine->setPriority(task.priority);
                 // 进入回调函数
                 cb_coroutine->swapIn();
                 // 离开回调函数
@@ -309,7 +932,7 @@ namespace CIM
                 // 如果协程状态为READY，重新加入调度队列
                 if (cb_coroutine->getState() == Coroutine::State::READY)
                 {
-                    schedule(cb_coroutine);
+                    schedule(cb_coroutine, TaskAttr((Priority)cb_coroutine->getPriority()));
                     cb_coroutine.reset();
                 }
                 else if (cb_coroutine->getState() == Coroutine::State::TERM ||
@@ -375,11 +998,16 @@ namespace CIM
     std::ostream &Scheduler::dump(std::ostream &os)
     {
         os << "[Scheduler name=" << m_name
+           << " queue=" << QueueModeToString(m_queueMode)
            << " size=" << m_threadCount
            << " active_count=" << m_activeThreadCount
            << " idle_count=" << m_idleThreadCount
-           << " Running=" << m_isRunning
-           << " ]" << std::endl
+           << " Running=" << m_isRunning;
+        if (!m_affinity.empty())
+        {
+            os << " affinity=(" << m_affinity.toString() << ")";
+        }
+        os << " ]" << std::endl
            << "    ";
         for (size_t i = 0; i < m_threadIds.size(); ++i)
         {
@@ -387,7 +1015,22 @@ namespace CIM
             {
                 os << ", ";
             }
-            os << m_threadIds[i];
+            // 线程ID及其当前所在的CPU和NUMA节点
+            int cpu = GetThreadCpu(m_threadIds[i]);
+            os << m_threadIds[i] << "[cpu=" << cpu << " node=" << GetCpuNumaNode(cpu) << "]";
+        }
+        // 各优先级的调度延迟(微秒)与过期任务数
+        for (int i = 0; i < kPriorityCount; ++i)
+        {
+            PriorityStats stats = getPriorityStats((Priority)i);
+            os << std::endl
+               << "    " << PriorityToString((Priority)i)
+               << ": count=" << stats.count
+               << " p50=" << stats.p50 << "us"
+               << " p99=" << stats.p99 << "us"
+               << " max=" << stats.max << "us"
+               << " dropped=" << stats.dropped
+               << " demoted=" << stats.demoted;
         }
         return os;
     }
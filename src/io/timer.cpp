@@ -1,14 +1,429 @@
 #include "timer.hpp"
 #include "time_util.hpp"
 #include "macro.hpp"
+#include "config.hpp"
+#include <algorithm>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
 
 namespace CIM
 {
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    static ConfigVar<std::string>::ptr g_timer_type =
+        Config::Lookup("timer.type", std::string("wheel"), "timer implementation: wheel / set");
+
+    /**
+     * @brief 单调时钟(毫秒)，不受系统时间修改影响
+     */
+    static uint64_t MonotonicMS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+    }
+
+    /// 其他线程的分片到期超过该时间仍未被拥有者处理时，空闲线程代为处理(毫秒)
+    static const uint64_t kStealGraceMS = 10;
+
+    /// 当前线程绑定的定时器管理器及其分片
+    static thread_local TimerManager *t_timer_manager = nullptr;
+    static thread_local TimerWheel *t_timer_wheel = nullptr;
+
+    /**
+     * @brief 分层时间轮（单个分片）
+     *
+     * 第0层256个槽，每槽1ms；第1~4层各64个槽，每槽覆盖下一层一整圈，
+     * 总跨度2^32ms（约49天），更远的定时器先挂在最高层，级联时重新放置。
+     * 槽内为侵入式双向链表，插入和删除都是O(1)；每层用位图记录非空槽，
+     * 推进时整段跳过空槽。第0层走完一圈时把上一层对应槽的定时器级联下来。
+     *
+     * 除 nextExpire 外所有成员都需持有 mutex 访问。
+     */
+    class TimerWheel : public Noncopyable
+    {
+    public:
+        static const int kRootBits = 8;
+        static const int kRootSize = 1 << kRootBits;
+        static const int kLevelBits = 6;
+        static const int kLevelSize = 1 << kLevelBits;
+        static const int kLevels = 4;
+        static const uint64_t kMaxDelay = (1ull << (kRootBits + kLevels * kLevelBits)) - 1;
+
+        TimerWheel(TimerManager *manager, uint64_t now)
+            : m_manager(manager),
+              m_current(now)
+        {
+            memset(m_root, 0, sizeof(m_root));
+            memset(m_rootBits, 0, sizeof(m_rootBits));
+            memset(m_levels, 0, sizeof(m_levels));
+            memset(m_levelBits, 0, sizeof(m_levelBits));
+        }
+
+        ~TimerWheel()
+        {
+            // 打断定时器对自身的引用，外部仍持有的Timer::ptr不再指向有效分片
+            std::vector<Timer::ptr> refs;
+            for (int i = 0; i < kRootSize; ++i)
+            {
+                drain(m_root[i], refs);
+            }
+            for (int l = 0; l < kLevels; ++l)
+            {
+                for (int i = 0; i < kLevelSize; ++i)
+                {
+                    drain(m_levels[l][i], refs);
+                }
+            }
+        }
+
+        /**
+         * @brief 锁住定时器当前所在的分片
+         *
+         * 定时器可能正在分片间迁移(m_wheel为nullptr)或在加锁期间被迁走，循环直到锁住的就是它所在的分片。
+         */
+        static TimerWheel *Lock(Timer *timer)
+        {
+            while (true)
+            {
+                TimerWheel *wheel = timer->m_wheel.load(std::memory_order_acquire);
+                if (!wheel)
+                {
+                    sched_yield();
+                    continue;
+                }
+                wheel->mutex.lock();
+                if (timer->m_wheel.load(std::memory_order_acquire) == wheel)
+                {
+                    return wheel;
+                }
+                wheel->mutex.unlock();
+            }
+        }
+
+        /**
+         * @brief 挂上定时器，调用方须已设置 m_wheelRef
+         * @return 是否成为本分片最早到期且尚未通知过的定时器
+         */
+        bool add(Timer *timer)
+        {
+            link(timer);
+            ++m_count;
+            m_manager->m_wheelCount.fetch_add(1, std::memory_order_relaxed);
+            if (timer->m_next < nextExpire.load(std::memory_order_relaxed))
+            {
+                nextExpire.store(timer->m_next, std::memory_order_relaxed);
+                if (!tickled)
+                {
+                    tickled = true;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 摘下定时器，m_wheelRef 由调用方处理
+         */
+        void remove(Timer *timer)
+        {
+            unlink(timer);
+            --m_count;
+            m_manager->m_wheelCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 最早到期时间的下界，无定时器返回~0ull
+         *
+         * 第0层当前圈内的精确到期时间，或下一次级联的时间点。
+         */
+        uint64_t next() const
+        {
+            if (m_count == 0)
+            {
+                return ~0ull;
+            }
+            int idx = m_current & (kRootSize - 1);
+            // 停在圈首说明本次级联尚未执行，上层待级联的槽非空时必须立即处理
+            if (idx == 0 && cascadePending())
+            {
+                return m_current;
+            }
+            int slot = findRoot(idx);
+            if (slot >= 0)
+            {
+                return m_current + (slot - idx);
+            }
+            return m_current + (kRootSize - idx);
+        }
+
+        /**
+         * @brief 推进到now，收集到期回调；周期定时器重新挂回本分片
+         */
+        void expire(uint64_t now, std::vector<std::function<void()>> &cbs)
+        {
+            while (m_current <= now)
+            {
+                if (m_count == 0)
+                {
+                    m_current = now + 1;
+                    break;
+                }
+                int idx = m_current & (kRootSize - 1);
+                if (idx == 0)
+                {
+                    cascade();
+                }
+                int slot = findRoot(idx);
+                if (slot < 0)
+                {
+                    // 本圈剩余的槽都为空，直接跳到下一次级联
+                    uint64_t boundary = m_current + (kRootSize - idx);
+                    m_current = boundary <= now ? boundary : now + 1;
+                    continue;
+                }
+                uint64_t when = m_current + (slot - idx);
+                if (when > now)
+                {
+                    m_current = now + 1;
+                    break;
+                }
+                m_current = when;
+                fire(slot, now, cbs);
+                ++m_current;
+            }
+            nextExpire.store(next(), std::memory_order_relaxed);
+        }
+
+        size_t size() const { return m_count; }
+
+    public:
+        /// 操作计数，受 mutex 保护
+        TimerManager::TimerStats stats;
+        /// 分片锁
+        Mutex mutex;
+        /// 最早到期时间的下界，供其他线程无锁判断是否需要代为处理
+        std::atomic<uint64_t> nextExpire{~0ull};
+        /// 是否已通知过新的最早定时器，getNextTimer时清除
+        bool tickled = false;
+
+    private:
+        void link(Timer *timer)
+        {
+            uint64_t expires = timer->m_next < m_current ? m_current : timer->m_next;
+            uint64_t delta = expires - m_current;
+            if (delta > kMaxDelay)
+            {
+                delta = kMaxDelay;
+                expires = m_current + delta;
+            }
+            Timer **head;
+            if (delta < (uint64_t)kRootSize)
+            {
+                int slot = expires & (kRootSize - 1);
+                timer->m_wheelLevel = 0;
+                timer->m_wheelSlot = slot;
+                head = &m_root[slot];
+                m_rootBits[slot >> 6] |= 1ull << (slot & 63);
+            }
+            else
+            {
+                int level = 0;
+                int shift = kRootBits;
+                while (level < kLevels - 1 && delta >= (1ull << (shift + kLevelBits)))
+                {
+                    ++level;
+                    shift += kLevelBits;
+                }
+                int slot = (expires >> shift) & (kLevelSize - 1);
+                timer->m_wheelLevel = level + 1;
+                timer->m_wheelSlot = slot;
+                head = &m_levels[level][slot];
+                m_levelBits[level] |= 1ull << slot;
+            }
+            timer->m_wheelPrev = nullptr;
+            timer->m_wheelNext = *head;
+            if (*head)
+            {
+                (*head)->m_wheelPrev = timer;
+            }
+            *head = timer;
+        }
+
+        void unlink(Timer *timer)
+        {
+            int slot = timer->m_wheelSlot;
+            Timer **head = timer->m_wheelLevel == 0 ? &m_root[slot]
+                                                    : &m_levels[timer->m_wheelLevel - 1][slot];
+            if (timer->m_wheelPrev)
+            {
+                timer->m_wheelPrev->m_wheelNext = timer->m_wheelNext;
+            }
+            else
+            {
+                *head = timer->m_wheelNext;
+            }
+            if (timer->m_wheelNext)
+            {
+                timer->m_wheelNext->m_wheelPrev = timer->m_wheelPrev;
+            }
+            if (!*head)
+            {
+                if (timer->m_wheelLevel == 0)
+                {
+                    m_rootBits[slot >> 6] &= ~(1ull << (slot & 63));
+                }
+                else
+                {
+                    m_levelBits[timer->m_wheelLevel - 1] &= ~(1ull << slot);
+                }
+            }
+            timer->m_wheelLevel = -1;
+            timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+        }
+
+        /**
+         * @brief 查找第0层从idx开始（含）到本圈末尾的第一个非空槽
+         */
+        int findRoot(int idx) const
+        {
+            for (int w = idx >> 6; w < kRootSize / 64; ++w)
+            {
+                uint64_t bits = m_rootBits[w];
+                if (w == (idx >> 6))
+                {
+                    bits &= ~0ull << (idx & 63);
+                }
+                if (bits)
+                {
+                    return w * 64 + __builtin_ctzll(bits);
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * @brief 在当前圈首执行级联时是否有定时器需要重新放置
+         */
+        bool cascadePending() const
+        {
+            int shift = kRootBits;
+            for (int l = 0; l < kLevels; ++l, shift += kLevelBits)
+            {
+                int slot = (m_current >> shift) & (kLevelSize - 1);
+                if (m_levelBits[l] & (1ull << slot))
+                {
+                    return true;
+                }
+                if (slot != 0)
+                {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 第0层转完一圈，把上层对应槽的定时器重新放置；某层下标未回绕到0时停止
+         */
+        void cascade()
+        {
+            int shift = kRootBits;
+            for (int l = 0; l < kLevels; ++l, shift += kLevelBits)
+            {
+                int slot = (m_current >> shift) & (kLevelSize - 1);
+                Timer *timer = m_levels[l][slot];
+                m_levels[l][slot] = nullptr;
+                m_levelBits[l] &= ~(1ull << slot);
+                while (timer)
+                {
+                    Timer *next = timer->m_wheelNext;
+                    link(timer);
+                    timer = next;
+                }
+                if (slot != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief 触发第0层一个槽内的全部定时器
+         */
+        void fire(int slot, uint64_t now, std::vector<std::function<void()>> &cbs)
+        {
+            Timer *timer = m_root[slot];
+            m_root[slot] = nullptr;
+            m_rootBits[slot >> 6] &= ~(1ull << (slot & 63));
+            while (timer)
+            {
+                Timer *next = timer->m_wheelNext;
+                timer->m_wheelLevel = -1;
+                timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+                ++stats.expired;
+                if (timer->m_recurring)
+                {
+                    cbs.push_back(timer->m_cb);
+                    timer->m_next = now + timer->m_ms;
+                    link(timer);
+                }
+                else
+                {
+                    cbs.push_back(std::move(timer->m_cb));
+                    timer->m_cb = nullptr;
+                    --m_count;
+                    m_manager->m_wheelCount.fetch_sub(1, std::memory_order_relaxed);
+                    // 回调已移出，此处释放自引用不会在锁内执行用户代码
+                    timer->m_wheelRef.reset();
+                }
+                timer = next;
+            }
+        }
+
+        void drain(Timer *&head, std::vector<Timer::ptr> &refs)
+        {
+            Timer *timer = head;
+            head = nullptr;
+            while (timer)
+            {
+                Timer *next = timer->m_wheelNext;
+                timer->m_wheelLevel = -1;
+                timer->m_wheelPrev = timer->m_wheelNext = nullptr;
+                refs.push_back(std::move(timer->m_wheelRef));
+                timer = next;
+            }
+        }
+
+    private:
+        TimerManager *m_manager;
+        /// 下一个待处理的时刻(毫秒)
+        uint64_t m_current;
+        /// 定时器数量
+        size_t m_count = 0;
+        Timer *m_root[kRootSize];
+        uint64_t m_rootBits[kRootSize / 64];
+        Timer *m_levels[kLevels][kLevelSize];
+        uint64_t m_levelBits[kLevels];
+    };
+
+    /**
+     * @brief 用于make_shared的派生类，使Timer对象与控制块一次分配
+     */
+    struct SharedTimer : public Timer
+    {
+        SharedTimer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager)
+            : Timer(ms, std::move(cb), recurring, manager)
+        {
+        }
+    };
+
     Timer::Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager)
         : m_recurring(recurring),
           m_ms(ms),
-          m_next(TimeUtil::NowToMS() + m_ms),
-          m_cb(cb),
+          m_next(manager->currentMS() + m_ms),
+          m_cb(std::move(cb)),
           m_manager(manager)
     {
     }
@@ -20,6 +435,24 @@ namespace CIM
 
     bool Timer::cancel()
     {
+        if (m_manager->m_useWheel)
+        {
+            // 回调和自引用在解锁后析构，避免其析构函数在分片锁内再次操作定时器
+            std::function<void()> cb;
+            Timer::ptr ref;
+            TimerWheel *wheel = TimerWheel::Lock(this);
+            bool linked = m_cb && m_wheelLevel >= 0;
+            cb.swap(m_cb);
+            if (linked)
+            {
+                wheel->remove(this);
+                ++wheel->stats.cancelled;
+                ref.swap(m_wheelRef);
+            }
+            wheel->mutex.unlock();
+            return linked;
+        }
+
         TimerManager::RWMutexType::WriteLock lock(m_manager->m_mutex);
         if (m_cb)
         {
@@ -30,6 +463,7 @@ namespace CIM
             if (it != m_manager->m_timers.end())
             {
                 m_manager->m_timers.erase(it);
+                ++m_manager->m_stats.cancelled;
                 return true;
             }
         }
@@ -38,6 +472,20 @@ namespace CIM
 
     bool Timer::refresh()
     {
+        if (m_manager->m_useWheel)
+        {
+            TimerWheel *wheel = TimerWheel::Lock(this);
+            if (!m_cb || m_wheelLevel < 0)
+            {
+                wheel->mutex.unlock();
+                return false;
+            }
+            wheel->remove(this);
+            m_next = m_manager->currentMS() + m_ms;
+            m_manager->relinkTimer(this, wheel);
+            return true;
+        }
+
         TimerManager::RWMutexType::WriteLock lock(m_manager->m_mutex);
         if (m_cb)
         {
@@ -60,6 +508,21 @@ namespace CIM
         {
             return true;
         }
+        if (m_manager->m_useWheel)
+        {
+            TimerWheel *wheel = TimerWheel::Lock(this);
+            if (!m_cb || m_wheelLevel < 0)
+            {
+                wheel->mutex.unlock();
+                return false;
+            }
+            wheel->remove(this);
+            uint64_t start = from_now ? m_manager->currentMS() : m_next - m_ms;
+            m_ms = ms;
+            m_next = start + ms;
+            m_manager->relinkTimer(this, wheel);
+            return true;
+        }
         TimerManager::RWMutexType::WriteLock lock(m_manager->m_mutex);
         // 检查定时器回调函数是否存在
         if (!m_cb)
@@ -125,13 +588,125 @@ namespace CIM
     TimerManager::TimerManager()
     {
         m_previouseTime = TimeUtil::NowToMS();
+        const std::string &type = g_timer_type->getValue();
+        m_useWheel = type != "set";
+        if (m_useWheel)
+        {
+            m_wheels.push_back(new TimerWheel(this, MonotonicMS()));
+        }
+        if (type != "set" && type != "wheel")
+        {
+            CIM_LOG_WARN(g_logger) << "unknown timer.type=" << type << ", use wheel";
+        }
+    }
+
+    TimerManager::~TimerManager()
+    {
+        for (auto wheel : m_wheels)
+        {
+            delete wheel;
+        }
+    }
+
+    uint64_t TimerManager::currentMS() const
+    {
+        // 时间轮按整毫秒推进，起点向上取整，保证定时器不会提前(不足1ms)触发
+        return m_useWheel ? MonotonicMS() + 1 : TimeUtil::NowToMS();
+    }
+
+    TimerWheel *TimerManager::selectWheel() const
+    {
+        if (t_timer_manager == this)
+        {
+            return t_timer_wheel;
+        }
+        return m_wheels[0];
+    }
+
+    void TimerManager::initTimerWheels(size_t count)
+    {
+        if (!m_useWheel)
+        {
+            return;
+        }
+        uint64_t now = MonotonicMS();
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_wheels.push_back(new TimerWheel(this, now));
+        }
+    }
+
+    void TimerManager::bindTimerWheel()
+    {
+        if (!m_useWheel)
+        {
+            return;
+        }
+        size_t idx = m_nextWheel.fetch_add(1);
+        if (idx < m_wheels.size())
+        {
+            t_timer_manager = this;
+            t_timer_wheel = m_wheels[idx];
+        }
+    }
+
+    void TimerManager::unbindTimerWheel()
+    {
+        if (t_timer_manager == this)
+        {
+            t_timer_manager = nullptr;
+            t_timer_wheel = nullptr;
+        }
+    }
+
+    void TimerManager::relinkTimer(Timer *timer, TimerWheel *locked)
+    {
+        TimerWheel *target = selectWheel();
+        bool front = false;
+        if (target == locked)
+        {
+            front = target->add(timer);
+            locked->mutex.unlock();
+        }
+        else
+        {
+            // 迁移期间置空，并发的cancel/refresh在Lock中等待迁移完成
+            timer->m_wheel.store(nullptr, std::memory_order_release);
+            locked->mutex.unlock();
+            Mutex::Lock lock(target->mutex);
+            timer->m_wheel.store(target, std::memory_order_release);
+            front = target->add(timer);
+        }
+        // 本线程分片上的定时器由本线程在下一轮idle中计算超时，只有共享分片需要唤醒
+        if (front && target == m_wheels[0])
+        {
+            onTimerInsertedAtFront();
+        }
     }
 
     Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool recurring)
     {
         //CIM_ASSERT(ms && cb);
-        Timer::ptr timer(new Timer(ms, cb, recurring, this));
+        Timer::ptr timer = std::make_shared<SharedTimer>(ms, std::move(cb), recurring, this);
+        if (m_useWheel)
+        {
+            TimerWheel *wheel = selectWheel();
+            bool front = false;
+            {
+                Mutex::Lock lock(wheel->mutex);
+                timer->m_wheel.store(wheel, std::memory_order_relaxed);
+                timer->m_wheelRef = timer;
+                ++wheel->stats.added;
+                front = wheel->add(timer.get());
+            }
+            if (front && wheel == m_wheels[0])
+            {
+                onTimerInsertedAtFront();
+            }
+            return timer;
+        }
         RWMutex::WriteLock lock(m_mutex);
+        ++m_stats.added;
         addTimer(timer, lock);
         return timer;
     }
@@ -152,8 +727,38 @@ namespace CIM
         return addTimer(ms, std::bind(&OnTimer, weak_cond, cb), recurring);
     }
 
-    uint64_t TimerManager::getNextTimer()
+    uint64_t TimerManager::nextExpire()
     {
+        if (m_useWheel)
+        {
+            uint64_t next = ~0ull;
+            TimerWheel *shared = m_wheels[0];
+            TimerWheel *own = selectWheel();
+            {
+                Mutex::Lock lock(shared->mutex);
+                shared->tickled = false;
+                next = shared->next();
+            }
+            if (own != shared)
+            {
+                Mutex::Lock lock(own->mutex);
+                next = std::min(next, own->next());
+            }
+            // 其他线程的分片只在拥有者忙碌、超过宽限时间仍未处理时才代为处理
+            for (size_t i = 1; i < m_wheels.size(); ++i)
+            {
+                if (m_wheels[i] != own)
+                {
+                    uint64_t expire = m_wheels[i]->nextExpire.load(std::memory_order_relaxed);
+                    if (expire != ~0ull)
+                    {
+                        next = std::min(next, expire + kStealGraceMS);
+                    }
+                }
+            }
+            return next;
+        }
+
         RWMutex::ReadLock lock(m_mutex);
         m_tickled = false;
         if (m_timers.empty())
@@ -161,22 +766,66 @@ namespace CIM
             return ~0ull;
         }
         // 获取最早执行的定时器
-        const Timer::ptr &next = *m_timers.begin();
-        uint64_t now = TimeUtil::NowToMS();
+        return (*m_timers.begin())->m_next;
+    }
 
-        if (now >= next->m_next)
+    uint64_t TimerManager::getNextTimer()
+    {
+        uint64_t next = nextExpire();
+        if (next == ~0ull)
         {
-            // 立即处理
-            return 0;
+            return ~0ull;
         }
-        else
+        uint64_t now = m_useWheel ? MonotonicMS() : TimeUtil::NowToMS();
+        // 已到期则立即处理
+        return now >= next ? 0 : next - now;
+    }
+
+    uint64_t TimerManager::getNextTimerNS()
+    {
+        uint64_t next = nextExpire();
+        if (next == ~0ull)
         {
-            return next->m_next - now;
+            return ~0ull;
         }
+        // 与到期判断使用同一时钟：当前毫秒数达到next即到期，即纳秒时间达到next整毫秒
+        struct timespec ts;
+        clock_gettime(m_useWheel ? CLOCK_MONOTONIC : CLOCK_REALTIME, &ts);
+        uint64_t now = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        uint64_t deadline = next * 1000000ull;
+        return now >= deadline ? 0 : deadline - now;
     }
 
     void TimerManager::listExpiredCb(std::vector<std::function<void()>> &cbs)
     {
+        if (m_useWheel)
+        {
+            uint64_t now = MonotonicMS();
+            TimerWheel *own = selectWheel();
+            if (own->nextExpire.load(std::memory_order_relaxed) <= now)
+            {
+                Mutex::Lock lock(own->mutex);
+                own->expire(now, cbs);
+            }
+            // 共享分片和超过宽限时间的其他分片，trylock失败说明已有线程在处理
+            for (size_t i = 0; i < m_wheels.size(); ++i)
+            {
+                TimerWheel *wheel = m_wheels[i];
+                if (wheel == own)
+                {
+                    continue;
+                }
+                uint64_t grace = i == 0 ? 0 : kStealGraceMS;
+                uint64_t expire = wheel->nextExpire.load(std::memory_order_relaxed);
+                if (expire != ~0ull && expire + grace <= now && wheel->mutex.trylock())
+                {
+                    wheel->expire(now, cbs);
+                    wheel->mutex.unlock();
+                }
+            }
+            return;
+        }
+
         uint64_t now_ms = TimeUtil::NowToMS();
         std::vector<Timer::ptr> expired;
 
@@ -218,27 +867,51 @@ namespace CIM
         m_timers.erase(m_timers.begin(), it);
         
         cbs.reserve(expired.size());
+        m_stats.expired += expired.size();
 
         // 处理所有已到期的定时器
         for (auto &timer : expired)
         {
-            cbs.push_back(timer->m_cb);
             if (timer->m_recurring)
             {
                 // 对于重复执行的定时器，设置下次执行时间并重新插入队列
+                cbs.push_back(timer->m_cb);
                 timer->m_next = now_ms + timer->m_ms;
                 m_timers.insert(timer);
             }
             else
             {
-                // 对于一次性定时器，清空回调函数
+                // 对于一次性定时器，直接移走回调函数
+                cbs.push_back(std::move(timer->m_cb));
                 timer->m_cb = nullptr;
             }
         }
     }
 
+    TimerManager::TimerStats TimerManager::getTimerStats()
+    {
+        if (!m_useWheel)
+        {
+            RWMutex::ReadLock lock(m_mutex);
+            return m_stats;
+        }
+        TimerStats total;
+        for (auto wheel : m_wheels)
+        {
+            Mutex::Lock lock(wheel->mutex);
+            total.added += wheel->stats.added;
+            total.cancelled += wheel->stats.cancelled;
+            total.expired += wheel->stats.expired;
+        }
+        return total;
+    }
+
     bool TimerManager::hasTimer()
     {
+        if (m_useWheel)
+        {
+            return m_wheelCount.load(std::memory_order_relaxed) > 0;
+        }
         RWMutex::ReadLock lock(m_mutex);
         return !m_timers.empty();
     }
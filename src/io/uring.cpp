@@ -0,0 +1,160 @@
+#include "uring.hpp"
+#include "macro.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace CIM
+{
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    static int sys_io_uring_setup(uint32_t entries, io_uring_params *p)
+    {
+        return (int)syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    static int sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+    {
+        return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+    }
+
+    static int sys_io_uring_register(int fd, uint32_t opcode, void *arg, uint32_t nr_args)
+    {
+        return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+    }
+
+    IoUring::ptr IoUring::Create(uint32_t entries, const std::vector<uint8_t> &opcodes)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = sys_io_uring_setup(entries, &params);
+        if (fd < 0)
+        {
+            int saved_errno = errno;
+            CIM_LOG_WARN(g_logger) << "io_uring_setup(" << entries << ") failed: " << strerror(saved_errno);
+            return nullptr;
+        }
+
+        ptr ring(new IoUring);
+        ring->m_fd = fd;
+        // 需要单次映射同时包含提交与完成队列(5.4+)，以及完成队列溢出时不丢弃CQE(5.5+)
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP))
+        {
+            CIM_LOG_WARN(g_logger) << "io_uring features not supported: " << params.features;
+            return nullptr;
+        }
+
+        // 探测所需操作码(5.6+)
+        size_t probe_size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<char> probe_buf(probe_size, 0);
+        io_uring_probe *probe = (io_uring_probe *)probe_buf.data();
+        if (sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+        {
+            int saved_errno = errno;
+            CIM_LOG_WARN(g_logger) << "io_uring probe failed: " << strerror(saved_errno);
+            return nullptr;
+        }
+        for (uint8_t op : opcodes)
+        {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            {
+                CIM_LOG_WARN(g_logger) << "io_uring opcode " << (int)op << " not supported";
+                return nullptr;
+            }
+        }
+
+        size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ring->m_ringSize = sq_size > cq_size ? sq_size : cq_size;
+        void *addr = mmap(nullptr, ring->m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_SQ_RING);
+        if (addr == MAP_FAILED)
+        {
+            int saved_errno = errno;
+            CIM_LOG_WARN(g_logger) << "io_uring mmap ring failed: " << strerror(saved_errno);
+            return nullptr;
+        }
+        ring->m_ring = addr;
+
+        ring->m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        addr = mmap(nullptr, ring->m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                    IORING_OFF_SQES);
+        if (addr == MAP_FAILED)
+        {
+            int saved_errno = errno;
+            CIM_LOG_WARN(g_logger) << "io_uring mmap sqes failed: " << strerror(saved_errno);
+            return nullptr;
+        }
+        ring->m_sqes = (io_uring_sqe *)addr;
+
+        char *base = (char *)ring->m_ring;
+        ring->m_sqHead = (uint32_t *)(base + params.sq_off.head);
+        ring->m_sqTail = (uint32_t *)(base + params.sq_off.tail);
+        ring->m_sqArray = (uint32_t *)(base + params.sq_off.array);
+        ring->m_sqMask = *(uint32_t *)(base + params.sq_off.ring_mask);
+        ring->m_sqEntries = params.sq_entries;
+        ring->m_sqeTail = *ring->m_sqTail;
+        ring->m_submitted = ring->m_sqeTail;
+        ring->m_cqHead = (uint32_t *)(base + params.cq_off.head);
+        ring->m_cqTail = (uint32_t *)(base + params.cq_off.tail);
+        ring->m_cqMask = *(uint32_t *)(base + params.cq_off.ring_mask);
+        ring->m_cqes = (io_uring_cqe *)(base + params.cq_off.cqes);
+        return ring;
+    }
+
+    IoUring::~IoUring()
+    {
+        if (m_sqes)
+        {
+            munmap(m_sqes, m_sqesSize);
+        }
+        if (m_ring)
+        {
+            munmap(m_ring, m_ringSize);
+        }
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    uint32_t IoUring::space() const
+    {
+        uint32_t head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        return m_sqEntries - (m_sqeTail - head);
+    }
+
+    io_uring_sqe *IoUring::getSqe()
+    {
+        CIM_ASSERT(space() > 0);
+        uint32_t index = m_sqeTail & m_sqMask;
+        io_uring_sqe *sqe = &m_sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        m_sqArray[index] = index;
+        ++m_sqeTail;
+        return sqe;
+    }
+
+    int IoUring::submit()
+    {
+        uint32_t to_submit = pending();
+        if (to_submit == 0)
+        {
+            return 0;
+        }
+        __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+        int rt;
+        do
+        {
+            rt = sys_io_uring_enter(m_fd, to_submit, 0, 0);
+        } while (rt < 0 && errno == EINTR);
+        if (rt < 0)
+        {
+            return -errno;
+        }
+        m_submitted += rt;
+        return rt;
+    }
+}
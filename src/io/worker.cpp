@@ -80,17 +80,30 @@ namespace CIM
             std::string name = i.first;
             int32_t thread_num = GetParamValue(i.second, "thread_num", 1);
             int32_t worker_num = GetParamValue(i.second, "worker_num", 1);
+            // 任务队列模式：global(默认) / work_steal
+            Scheduler::QueueMode mode = Scheduler::QueueModeFromString(
+                GetParamValue<std::string>(i.second, "queue", "global"));
+            // 线程放置：cpu_set 为CPU列表，numa_node 为内存节点，pin 为每线程固定单个CPU
+            std::string pin = GetParamValue<std::string>(i.second, "pin", "false");
+            ThreadAffinity affinity = ThreadAffinity::Create(
+                GetParamValue<std::string>(i.second, "cpu_set", ""),
+                GetParamValue(i.second, "numa_node", -1),
+                pin == "true" || pin == "1" || pin == "yes");
+            // IO后端：epoll(默认) / uring，内核不支持io_uring时回退为epoll
+            IOManager::Backend backend = IOManager::BackendFromString(
+                GetParamValue<std::string>(i.second, "backend", "epoll"));
 
             for (int32_t x = 0; x < worker_num; ++x)
             {
                 Scheduler::ptr s;
                 if (!x)
                 {
-                    s = std::make_shared<IOManager>(thread_num, false, name);
+                    s = std::make_shared<IOManager>(thread_num, false, name, mode, affinity, backend);
                 }
                 else
                 {
-                    s = std::make_shared<IOManager>(thread_num, false, name + "-" + std::to_string(x));
+                    s = std::make_shared<IOManager>(thread_num, false, name + "-" + std::to_string(x), mode,
+                                                    affinity, backend);
                 }
                 add(s);
             }
@@ -1,5 +1,7 @@
 #include "address.hpp"
+#include "dns.hpp"
 #include "endian.hpp"
+#include "iomanager.hpp"
 #include "macro.hpp"
 #include <sstream>
 #include <cstring>
@@ -46,6 +48,32 @@ namespace CIM
         return result;
     }
 
+    /**
+     * @brief 解析端口：数字直接转换，服务名查/etc/services
+     */
+    static bool ParseService(const char *service, int type, uint16_t &port)
+    {
+        char *end = nullptr;
+        unsigned long v = strtoul(service, &end, 10);
+        if (*service && !*end)
+        {
+            if (v > 65535)
+            {
+                return false;
+            }
+            port = (uint16_t)v;
+            return true;
+        }
+        servent ent, *rt = nullptr;
+        char buf[1024];
+        if (getservbyname_r(service, type == SOCK_DGRAM ? "udp" : "tcp", &ent, buf, sizeof(buf), &rt) || !rt)
+        {
+            return false;
+        }
+        port = ntohs((uint16_t)rt->s_port);
+        return true;
+    }
+
     Address::ptr Address::Create(const sockaddr *addr, socklen_t addrlen)
     {
         CIM_ASSERT(addr && addrlen > 0);
@@ -88,7 +116,7 @@ namespace CIM
         const char *service = nullptr;
 
         // 处理IPv6地址的方括号格式，如"[2001:db8::1]:8080"
-        if (!host.empty() && host[0] != '[')
+        if (!host.empty() && host[0] == '[')
         {
             const char *endipv6 = (const char *)memchr(host.c_str() + 1, ']', host.size() - 1);
             if (endipv6)
@@ -125,6 +153,32 @@ namespace CIM
             node = host;
         }
 
+        // IP字面量以外的主机名交给DnsResolver：在协程中等待DNS应答时只挂起当前协程，不阻塞IO线程
+        in6_addr literal;
+        if ((family == AF_INET || family == AF_INET6 || family == AF_UNSPEC) && node.find('%') == std::string::npos &&
+            inet_pton(AF_INET, node.c_str(), &literal) != 1 && inet_pton(AF_INET6, node.c_str(), &literal) != 1)
+        {
+            uint16_t port = 0;
+            if (service && !ParseService(service, type, port))
+            {
+                CIM_LOG_ERROR(g_logger) << "Address::Lookup(" << host << ") invalid service";
+                return false;
+            }
+            std::vector<IPAddress::ptr> addrs;
+            if (!DnsMgr::GetInstance()->resolve(node, family, addrs))
+            {
+                CIM_LOG_ERROR(g_logger) << "Address::Lookup(" << host << ", "
+                                          << family << ", " << type << ") resolve fail";
+                return false;
+            }
+            for (auto &i : addrs)
+            {
+                i->setPort(port);
+                result.push_back(i);
+            }
+            return true;
+        }
+
         // 调用系统函数getaddrinfo进行地址解析
         int error = getaddrinfo(node.c_str(), service, &hints, &results);
         if (error)
@@ -159,6 +213,29 @@ namespace CIM
         return nullptr;
     }
 
+    void Address::LookupAsync(const std::string &host,
+                              std::function<void(bool, const std::vector<Address::ptr> &)> cb,
+                              int family, int type, int protocol, IOManager *iom)
+    {
+        if (!iom)
+        {
+            iom = IOManager::GetThis();
+        }
+        if (!iom)
+        {
+            // 不在调度器中：同步解析后回调
+            std::vector<Address::ptr> result;
+            bool ok = Lookup(result, host, family, type, protocol);
+            cb(ok, result);
+            return;
+        }
+        iom->schedule([host, cb, family, type, protocol]()
+                      {
+                          std::vector<Address::ptr> result;
+                          bool ok = Lookup(result, host, family, type, protocol);
+                          cb(ok, result); });
+    }
+
     std::shared_ptr<IPAddress> Address::LookupAnyIpAddress(const std::string &host, int family, int type, int protocol)
     {
         CIM_ASSERT(!host.empty());
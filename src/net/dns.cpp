@@ -0,0 +1,794 @@
+#include "dns.hpp"
+#include "config.hpp"
+#include "coroutine.hpp"
+#include "logger.hpp"
+#include "macro.hpp"
+#include "scheduler.hpp"
+#include "semaphore.hpp"
+#include "socket.hpp"
+#include <algorithm>
+#include <fstream>
+#include <netdb.h>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+#include <time.h>
+
+namespace CIM
+{
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    static auto g_dns_resolv_conf =
+        Config::Lookup("dns.resolv_conf", std::string("/etc/resolv.conf"), "dns resolv.conf path");
+
+    static auto g_dns_hosts_file =
+        Config::Lookup("dns.hosts_file", std::string("/etc/hosts"), "dns hosts file path");
+
+    static auto g_dns_timeout =
+        Config::Lookup("dns.timeout", (uint32_t)2000, "dns query timeout per server(ms)");
+
+    static auto g_dns_attempts =
+        Config::Lookup("dns.attempts", (uint32_t)2, "dns query rounds over all servers");
+
+    // NXDOMAIN/无记录且应答中没有SOA时的否定缓存时间；退回getaddrinfo时结果也按它缓存
+    static auto g_dns_negative_ttl =
+        Config::Lookup("dns.negative_ttl", (uint32_t)30, "dns negative cache ttl(s) without SOA");
+
+    static auto g_dns_max_ttl =
+        Config::Lookup("dns.max_ttl", (uint32_t)3600, "dns cache ttl upper bound(s)");
+
+    static auto g_dns_cache_size =
+        Config::Lookup("dns.cache_size", (uint32_t)10000, "dns cache max entries");
+
+    /// hosts文件修改检查的最小间隔(毫秒)
+    static const uint64_t kHostsCheckInterval = 1000;
+
+    static const uint16_t kTypeA = 1;
+    static const uint16_t kTypeSOA = 6;
+    static const uint16_t kTypeAAAA = 28;
+    static const uint16_t kClassIN = 1;
+
+    /**
+     * @brief 单调时钟(毫秒)，不受系统时间修改影响
+     */
+    static uint64_t MonotonicMS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+    }
+
+    /**
+     * @brief 解析IP字面量，不是IP时返回nullptr
+     */
+    static IPAddress::ptr ParseLiteral(const std::string &name)
+    {
+        sockaddr_in addr4;
+        memset(&addr4, 0, sizeof(addr4));
+        if (inet_pton(AF_INET, name.c_str(), &addr4.sin_addr) == 1)
+        {
+            addr4.sin_family = AF_INET;
+            return std::make_shared<IPv4Address>(addr4);
+        }
+        sockaddr_in6 addr6;
+        memset(&addr6, 0, sizeof(addr6));
+        if (inet_pton(AF_INET6, name.c_str(), &addr6.sin6_addr) == 1)
+        {
+            addr6.sin6_family = AF_INET6;
+            return std::make_shared<IPv6Address>(addr6);
+        }
+        return nullptr;
+    }
+
+    static bool FamilyMatch(int family, const IPAddress::ptr &addr)
+    {
+        return family == AF_UNSPEC || addr->getFamily() == family;
+    }
+
+    /**
+     * @brief 复制地址追加到to：缓存和hosts中的地址对象是共享的，调用者会修改端口
+     */
+    static void AppendCopies(const std::vector<IPAddress::ptr> &from, int family, std::vector<IPAddress::ptr> &to)
+    {
+        for (auto &i : from)
+        {
+            if (FamilyMatch(family, i))
+            {
+                to.push_back(std::dynamic_pointer_cast<IPAddress>(Address::Create(i->getAddr(), i->getAddrLen())));
+            }
+        }
+    }
+
+    /**
+     * @brief 小写并去掉末尾的'.'
+     */
+    static std::string NormalizeName(const std::string &name)
+    {
+        std::string rt = name;
+        std::transform(rt.begin(), rt.end(), rt.begin(), ::tolower);
+        while (!rt.empty() && rt.back() == '.')
+        {
+            rt.pop_back();
+        }
+        return rt;
+    }
+
+    static uint16_t ReadU16(const uint8_t *p)
+    {
+        return (uint16_t)(p[0] << 8 | p[1]);
+    }
+
+    static uint32_t ReadU32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+
+    /**
+     * @brief 构造查询报文：RD=1，一个问题
+     * @return 名字中有超过63字节的标签或总长超过255时返回false
+     */
+    static bool BuildQuery(const std::string &name, uint16_t type, uint16_t id, std::string &packet)
+    {
+        uint8_t header[12] = {0};
+        header[0] = id >> 8;
+        header[1] = id & 0xFF;
+        header[2] = 0x01; // RD
+        header[5] = 1;    // QDCOUNT
+        packet.assign((const char *)header, sizeof(header));
+
+        size_t begin = 0;
+        while (begin < name.size())
+        {
+            size_t end = name.find('.', begin);
+            if (end == std::string::npos)
+            {
+                end = name.size();
+            }
+            size_t len = end - begin;
+            if (len == 0 || len > 63)
+            {
+                return false;
+            }
+            packet.push_back((char)len);
+            packet.append(name, begin, len);
+            begin = end + 1;
+        }
+        packet.push_back(0);
+        if (packet.size() - sizeof(header) > 255)
+        {
+            return false;
+        }
+        packet.push_back(type >> 8);
+        packet.push_back(type & 0xFF);
+        packet.push_back(0);
+        packet.push_back(kClassIN);
+        return true;
+    }
+
+    /**
+     * @brief 跳过报文中的名字(支持压缩指针)
+     * @return 名字之后的偏移，越界返回0
+     */
+    static size_t SkipName(const uint8_t *p, size_t n, size_t off)
+    {
+        while (off < n)
+        {
+            uint8_t len = p[off];
+            if (len == 0)
+            {
+                return off + 1;
+            }
+            if ((len & 0xC0) == 0xC0)
+            {
+                return off + 2 <= n ? off + 2 : 0;
+            }
+            off += len + 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief 解析应答
+     * @param[out] ttl 肯定应答为记录TTL的最小值，否定应答为SOA的最小TTL
+     * @return 1有记录，0名字不存在或无该类型记录，-1服务器错误或报文损坏，-2不是本次查询的应答
+     */
+    static int ParseResponse(const uint8_t *p, size_t n, uint16_t id, uint16_t type,
+                             std::vector<IPAddress::ptr> &result, uint32_t &ttl)
+    {
+        if (n < 12)
+        {
+            return -1;
+        }
+        if (ReadU16(p) != id || !(p[2] & 0x80))
+        {
+            return -2;
+        }
+        uint8_t rcode = p[3] & 0x0F;
+        if (rcode != 0 && rcode != 3)
+        {
+            // SERVFAIL/REFUSED等，换下一个服务器
+            return -1;
+        }
+        uint16_t qdcount = ReadU16(p + 4);
+        uint16_t ancount = ReadU16(p + 6);
+        uint16_t nscount = ReadU16(p + 8);
+
+        size_t off = 12;
+        for (uint16_t i = 0; i < qdcount; ++i)
+        {
+            off = SkipName(p, n, off);
+            if (!off || off + 4 > n)
+            {
+                return -1;
+            }
+            off += 4;
+        }
+
+        uint32_t min_ttl = UINT32_MAX;
+        uint32_t negative_ttl = UINT32_MAX;
+        size_t found = 0;
+        for (uint32_t i = 0; i < (uint32_t)ancount + nscount; ++i)
+        {
+            off = SkipName(p, n, off);
+            if (!off || off + 10 > n)
+            {
+                return -1;
+            }
+            uint16_t rtype = ReadU16(p + off);
+            uint16_t rclass = ReadU16(p + off + 2);
+            uint32_t rttl = ReadU32(p + off + 4);
+            uint16_t rdlen = ReadU16(p + off + 8);
+            off += 10;
+            if (off + rdlen > n)
+            {
+                return -1;
+            }
+            const uint8_t *rdata = p + off;
+            if (i < ancount && rcode == 0 && rclass == kClassIN && rtype == type)
+            {
+                // 应答中CNAME链末端的记录与问题名字不同，直接按类型收集
+                if (type == kTypeA && rdlen == 4)
+                {
+                    sockaddr_in addr;
+                    memset(&addr, 0, sizeof(addr));
+                    addr.sin_family = AF_INET;
+                    memcpy(&addr.sin_addr, rdata, 4);
+                    result.push_back(std::make_shared<IPv4Address>(addr));
+                    min_ttl = std::min(min_ttl, rttl);
+                    ++found;
+                }
+                else if (type == kTypeAAAA && rdlen == 16)
+                {
+                    sockaddr_in6 addr;
+                    memset(&addr, 0, sizeof(addr));
+                    addr.sin6_family = AF_INET6;
+                    memcpy(&addr.sin6_addr, rdata, 16);
+                    result.push_back(std::make_shared<IPv6Address>(addr));
+                    min_ttl = std::min(min_ttl, rttl);
+                    ++found;
+                }
+            }
+            else if (i >= ancount && rtype == kTypeSOA)
+            {
+                // RFC 2308：否定缓存时间取SOA记录TTL与MINIMUM字段的较小值
+                size_t soa = SkipName(p, off + rdlen, off);
+                soa = soa ? SkipName(p, off + rdlen, soa) : 0;
+                if (soa && soa + 20 <= off + rdlen)
+                {
+                    negative_ttl = std::min(rttl, ReadU32(p + soa + 16));
+                }
+            }
+            off += rdlen;
+        }
+
+        if (found)
+        {
+            ttl = min_ttl;
+            return 1;
+        }
+        ttl = negative_ttl != UINT32_MAX ? negative_ttl : g_dns_negative_ttl->getValue();
+        return 0;
+    }
+
+    /**
+     * @brief 查询ID，每线程独立的随机序列
+     */
+    static uint16_t NextQueryId()
+    {
+        static thread_local std::mt19937 s_rng(std::random_device{}());
+        return (uint16_t)s_rng();
+    }
+
+    struct DnsResolver::Pending
+    {
+        Mutex mutex;
+        bool done = false;
+        bool ok = false;
+        std::vector<IPAddress::ptr> result;
+        std::vector<std::pair<Scheduler *, Coroutine::ptr>> coroutines; /// 等待的协程
+        std::vector<Semaphore *> threads;                               /// 不在调度器中的等待线程
+    };
+
+    DnsResolver::DnsResolver()
+    {
+        loadResolvConf(g_dns_resolv_conf->getValue());
+        loadHosts(g_dns_hosts_file->getValue());
+    }
+
+    bool DnsResolver::loadResolvConf(const std::string &path)
+    {
+        std::ifstream ifs(path);
+        if (!ifs)
+        {
+            CIM_LOG_WARN(g_logger) << "DnsResolver open " << path << " fail, fall back to getaddrinfo";
+            return false;
+        }
+        std::vector<IPAddress::ptr> servers;
+        std::vector<std::string> search;
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            std::stringstream ss(line);
+            std::string key;
+            ss >> key;
+            if (key == "nameserver")
+            {
+                std::string ip;
+                ss >> ip;
+                IPAddress::ptr addr = ParseLiteral(ip);
+                if (addr)
+                {
+                    addr->setPort(53);
+                    servers.push_back(addr);
+                }
+            }
+            else if (key == "search" || key == "domain")
+            {
+                // 后出现的search/domain覆盖之前的
+                search.clear();
+                std::string domain;
+                while (ss >> domain)
+                {
+                    search.push_back(NormalizeName(domain));
+                }
+            }
+        }
+        RWMutex::WriteLock lock(m_mutex);
+        m_servers.swap(servers);
+        m_search.swap(search);
+        return true;
+    }
+
+    bool DnsResolver::loadHosts(const std::string &path)
+    {
+        std::unordered_map<std::string, std::vector<IPAddress::ptr>> hosts;
+        struct stat st;
+        time_t mtime = stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+        std::ifstream ifs(path);
+        if (ifs)
+        {
+            std::string line;
+            while (std::getline(ifs, line))
+            {
+                size_t pos = line.find('#');
+                if (pos != std::string::npos)
+                {
+                    line.resize(pos);
+                }
+                std::stringstream ss(line);
+                std::string ip;
+                ss >> ip;
+                IPAddress::ptr addr = ParseLiteral(ip);
+                if (!addr)
+                {
+                    continue;
+                }
+                std::string name;
+                while (ss >> name)
+                {
+                    hosts[NormalizeName(name)].push_back(addr);
+                }
+            }
+        }
+        RWMutex::WriteLock lock(m_mutex);
+        m_hostsPath = path;
+        m_hostsMtime = mtime;
+        m_hostsChecked = MonotonicMS();
+        m_hosts.swap(hosts);
+        return (bool)ifs;
+    }
+
+    void DnsResolver::setServers(const std::vector<IPAddress::ptr> &servers)
+    {
+        std::vector<IPAddress::ptr> v;
+        for (auto &i : servers)
+        {
+            IPAddress::ptr addr = std::dynamic_pointer_cast<IPAddress>(Address::Create(i->getAddr(), i->getAddrLen()));
+            if (!addr->getPort())
+            {
+                addr->setPort(53);
+            }
+            v.push_back(addr);
+        }
+        RWMutex::WriteLock lock(m_mutex);
+        m_servers.swap(v);
+    }
+
+    std::vector<IPAddress::ptr> DnsResolver::getServers()
+    {
+        RWMutex::ReadLock lock(m_mutex);
+        return m_servers;
+    }
+
+    bool DnsResolver::lookupHosts(const std::string &name, int family, std::vector<IPAddress::ptr> &result)
+    {
+        uint64_t now = MonotonicMS();
+        std::string path;
+        time_t mtime = 0;
+        {
+            RWMutex::ReadLock lock(m_mutex);
+            if (now - m_hostsChecked >= kHostsCheckInterval)
+            {
+                path = m_hostsPath;
+                mtime = m_hostsMtime;
+            }
+        }
+        if (!path.empty())
+        {
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0 && st.st_mtime != mtime)
+            {
+                loadHosts(path);
+            }
+            else
+            {
+                RWMutex::WriteLock lock(m_mutex);
+                m_hostsChecked = now;
+            }
+        }
+
+        RWMutex::ReadLock lock(m_mutex);
+        auto it = m_hosts.find(name);
+        if (it == m_hosts.end())
+        {
+            return false;
+        }
+        size_t size = result.size();
+        AppendCopies(it->second, family, result);
+        return result.size() > size;
+    }
+
+    bool DnsResolver::resolve(const std::string &name, int family, std::vector<IPAddress::ptr> &result)
+    {
+        IPAddress::ptr literal = ParseLiteral(name);
+        if (literal)
+        {
+            if (!FamilyMatch(family, literal))
+            {
+                return false;
+            }
+            result.push_back(literal);
+            return true;
+        }
+
+        std::string lname = NormalizeName(name);
+        if (lname.empty())
+        {
+            return false;
+        }
+        if (lookupHosts(lname, family, result))
+        {
+            ++m_hostsHits;
+            return true;
+        }
+
+        std::string key = std::to_string(family) + ":" + lname;
+        uint64_t now = MonotonicMS();
+        {
+            RWMutex::ReadLock lock(m_cacheMutex);
+            auto it = m_cache.find(key);
+            if (it != m_cache.end() && it->second.expire > now)
+            {
+                if (it->second.addrs.empty())
+                {
+                    ++m_negativeHits;
+                    ++m_failures;
+                    return false;
+                }
+                AppendCopies(it->second.addrs, AF_UNSPEC, result);
+                ++m_hits;
+                return true;
+            }
+        }
+
+        // 同名查询进行中则等待它的结果，否则由本调用发起查询
+        std::shared_ptr<Pending> pending;
+        bool leader = false;
+        {
+            Mutex::Lock lock(m_pendingMutex);
+            auto it = m_pending.find(key);
+            if (it != m_pending.end())
+            {
+                pending = it->second;
+            }
+            else
+            {
+                pending = std::make_shared<Pending>();
+                m_pending[key] = pending;
+                leader = true;
+            }
+        }
+
+        if (!leader)
+        {
+            ++m_coalesced;
+            Mutex::Lock lock(pending->mutex);
+            if (!pending->done)
+            {
+                if (Scheduler::GetThis())
+                {
+                    pending->coroutines.push_back(std::make_pair(Scheduler::GetThis(), Coroutine::GetThis()));
+                    lock.unlock();
+                    Coroutine::YieldToHold();
+                }
+                else
+                {
+                    Semaphore sem;
+                    pending->threads.push_back(&sem);
+                    lock.unlock();
+                    sem.wait();
+                }
+                lock.lock();
+            }
+            AppendCopies(pending->result, AF_UNSPEC, result);
+            if (!pending->ok)
+            {
+                ++m_failures;
+            }
+            return pending->ok;
+        }
+
+        std::vector<IPAddress::ptr> addrs;
+        uint32_t ttl = 0;
+        int rt = resolveUncached(lname, family, addrs, ttl);
+        if (rt >= 0 && ttl)
+        {
+            CacheEntry entry;
+            entry.addrs = addrs;
+            entry.expire = MonotonicMS() + std::min(ttl, g_dns_max_ttl->getValue()) * 1000ull;
+            RWMutex::WriteLock lock(m_cacheMutex);
+            if (m_cache.size() >= g_dns_cache_size->getValue())
+            {
+                // 先清理过期项，仍然满时随机淘汰一项
+                for (auto it = m_cache.begin(); it != m_cache.end();)
+                {
+                    if (it->second.expire <= now)
+                    {
+                        it = m_cache.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+                if (m_cache.size() >= g_dns_cache_size->getValue() && !m_cache.empty())
+                {
+                    m_cache.erase(m_cache.begin());
+                }
+            }
+            m_cache[key] = entry;
+        }
+        if (rt < 0)
+        {
+            CIM_LOG_ERROR(g_logger) << "DnsResolver resolve " << name << " family=" << family << " fail";
+        }
+
+        {
+            Mutex::Lock lock(m_pendingMutex);
+            m_pending.erase(key);
+        }
+        Mutex::Lock lock(pending->mutex);
+        pending->done = true;
+        pending->ok = rt > 0;
+        pending->result = addrs;
+        for (auto &i : pending->coroutines)
+        {
+            i.first->schedule(i.second);
+        }
+        for (auto &i : pending->threads)
+        {
+            i->notify();
+        }
+        lock.unlock();
+
+        if (rt <= 0)
+        {
+            ++m_failures;
+            return false;
+        }
+        AppendCopies(addrs, AF_UNSPEC, result);
+        return true;
+    }
+
+    int DnsResolver::resolveUncached(const std::string &name, int family, std::vector<IPAddress::ptr> &result, uint32_t &ttl)
+    {
+        std::vector<std::string> names;
+        {
+            RWMutex::ReadLock lock(m_mutex);
+            if (m_servers.empty())
+            {
+                lock.unlock();
+                // 没有nameserver(如只配置了nss插件)，退回阻塞的getaddrinfo
+                addrinfo hints, *results;
+                memset(&hints, 0, sizeof(hints));
+                hints.ai_family = family;
+                hints.ai_socktype = SOCK_STREAM;
+                int error = getaddrinfo(name.c_str(), nullptr, &hints, &results);
+                ttl = g_dns_negative_ttl->getValue();
+                if (error)
+                {
+                    return error == EAI_NONAME ? 0 : -1;
+                }
+                for (addrinfo *next = results; next; next = next->ai_next)
+                {
+                    IPAddress::ptr addr = std::dynamic_pointer_cast<IPAddress>(
+                        Address::Create(next->ai_addr, (socklen_t)next->ai_addrlen));
+                    if (addr)
+                    {
+                        result.push_back(addr);
+                    }
+                }
+                freeaddrinfo(results);
+                return result.empty() ? 0 : 1;
+            }
+            // 不含'.'的短名字先按search域补全，最后再查名字本身
+            if (name.find('.') == std::string::npos)
+            {
+                for (auto &i : m_search)
+                {
+                    names.push_back(name + "." + i);
+                }
+            }
+        }
+        names.push_back(name);
+
+        bool error = false;
+        for (auto &n : names)
+        {
+            uint32_t min_ttl = UINT32_MAX;
+            int found = 0;
+            for (uint16_t type : {kTypeA, kTypeAAAA})
+            {
+                if ((type == kTypeA && family == AF_INET6) || (type == kTypeAAAA && family == AF_INET))
+                {
+                    continue;
+                }
+                uint32_t t = 0;
+                int rt = query(n, type, result, t);
+                if (rt < 0)
+                {
+                    error = true;
+                    continue;
+                }
+                // 否定应答的TTL也参与取最小值：AF_UNSPEC时A有记录、AAAA无记录，结果按两者较短的时间缓存
+                min_ttl = std::min(min_ttl, t);
+                found |= rt;
+            }
+            if (found)
+            {
+                ttl = min_ttl;
+                return 1;
+            }
+            if (min_ttl != UINT32_MAX)
+            {
+                ttl = min_ttl;
+            }
+        }
+        return error ? -1 : 0;
+    }
+
+    int DnsResolver::query(const std::string &name, uint16_t type, std::vector<IPAddress::ptr> &result, uint32_t &ttl)
+    {
+        std::vector<IPAddress::ptr> servers = getServers();
+        std::string packet;
+        uint16_t id = NextQueryId();
+        if (!BuildQuery(name, type, id, packet))
+        {
+            ttl = g_dns_negative_ttl->getValue();
+            return 0;
+        }
+
+        uint32_t timeout = g_dns_timeout->getValue();
+        uint32_t attempts = std::max(g_dns_attempts->getValue(), (uint32_t)1);
+        uint8_t buf[1500];
+        for (uint32_t a = 0; a < attempts; ++a)
+        {
+            for (auto &server : servers)
+            {
+                // 每次查询一个新的UDP socket，源端口由内核随机分配；
+                // 在协程中socket经过hook，recv超时等待挂起的是当前协程
+                Socket::ptr sock = Socket::CreateUDP(server);
+                if (!sock->connect(server))
+                {
+                    continue;
+                }
+                ++m_queries;
+                if (sock->send(packet.data(), packet.size()) != (int)packet.size())
+                {
+                    continue;
+                }
+                uint64_t deadline = MonotonicMS() + timeout;
+                while (true)
+                {
+                    uint64_t now = MonotonicMS();
+                    if (now >= deadline)
+                    {
+                        ++m_timeouts;
+                        break;
+                    }
+                    sock->setRecvTimeout(deadline - now);
+                    int n = sock->recv(buf, sizeof(buf));
+                    if (n < 0)
+                    {
+                        if (errno == ETIMEDOUT || errno == EAGAIN)
+                        {
+                            ++m_timeouts;
+                        }
+                        break;
+                    }
+                    int rt = ParseResponse(buf, n, id, type, result, ttl);
+                    if (rt == -2)
+                    {
+                        // 不是本次查询的应答(迟到的旧应答或伪造报文)，继续等待
+                        continue;
+                    }
+                    if (rt >= 0)
+                    {
+                        return rt;
+                    }
+                    break;
+                }
+            }
+        }
+        return -1;
+    }
+
+    std::string DnsResolver::resolveToString(const std::string &name, int family)
+    {
+        std::vector<IPAddress::ptr> result;
+        if (!resolve(name, family, result))
+        {
+            return name;
+        }
+        char buf[INET6_ADDRSTRLEN] = {0};
+        const sockaddr *addr = result[0]->getAddr();
+        if (addr->sa_family == AF_INET)
+        {
+            inet_ntop(AF_INET, &((const sockaddr_in *)addr)->sin_addr, buf, sizeof(buf));
+        }
+        else
+        {
+            inet_ntop(AF_INET6, &((const sockaddr_in6 *)addr)->sin6_addr, buf, sizeof(buf));
+        }
+        return buf;
+    }
+
+    void DnsResolver::clearCache()
+    {
+        RWMutex::WriteLock lock(m_cacheMutex);
+        m_cache.clear();
+    }
+
+    DnsResolver::Stats DnsResolver::getStats() const
+    {
+        Stats stats;
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+        stats.negativeHits = m_negativeHits.load(std::memory_order_relaxed);
+        stats.hostsHits = m_hostsHits.load(std::memory_order_relaxed);
+        stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+        stats.queries = m_queries.load(std::memory_order_relaxed);
+        stats.timeouts = m_timeouts.load(std::memory_order_relaxed);
+        stats.failures = m_failures.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
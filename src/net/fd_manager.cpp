@@ -3,6 +3,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/socket.h>
+#include <stdlib.h>
+#include <new>
 
 namespace CIM
 {
@@ -11,12 +13,30 @@ namespace CIM
           m_isSocket(false),
           m_sysNonBlock(false),
           m_userNonBlock(false),
-          m_isClosed(false),
-          m_fd(fd),
           m_recvTimeout(-1),
-          m_sendTimeout(-1)
+          m_sendTimeout(-1),
+          m_idleTimeout(-1)
     {
+        this->fd = fd;
+    }
+
+    void FdCtx::open()
+    {
+        m_isInit = false;
+        m_idleTimeout = -1;
+        m_idleDeadline.store(0, std::memory_order_relaxed);
+        m_idleIom.store(nullptr, std::memory_order_relaxed);
+        m_idleWatched.store(false, std::memory_order_relaxed);
         init();
+        // fd号被复用：旧fd关闭时可能没有经过cancelAll(未hook或不在IOManager线程上)，
+        // 内核已把它移出epoll，这里的注册状态不能沿用，否则addEvent会跳过EPOLL_CTL_ADD
+        events = IOManager::NONE;
+        ready = IOManager::NONE;
+        registered = false;
+        owner = nullptr;
+        m_generation.fetch_add(1, std::memory_order_relaxed);
+        // 其他线程看到未关闭时，上面的初始化已经完成
+        m_isClosed.store(false, std::memory_order_release);
     }
 
     /**
@@ -45,7 +65,7 @@ namespace CIM
 
         // 使用fstat检查文件描述符状态
         struct stat fd_stat;
-        if (-1 == fstat(m_fd, &fd_stat))
+        if (-1 == fstat(fd, &fd_stat))
         {
             m_isInit = false;
             m_isSocket = false;
@@ -59,10 +79,10 @@ namespace CIM
         // 检查文件描述符是否为非阻塞模式，如果不是，则设置为非阻塞模式
         if (m_isSocket)
         {
-            int flags = fcntl_f(m_fd, F_GETFL, 0);
+            int flags = fcntl_f(fd, F_GETFL, 0);
             if (!(flags & O_NONBLOCK))
             {
-                fcntl_f(m_fd, F_SETFL, flags | O_NONBLOCK); // 设置非阻塞模式
+                fcntl_f(fd, F_SETFL, flags | O_NONBLOCK); // 设置非阻塞模式
             }
             m_sysNonBlock = true;
         }
@@ -72,7 +92,6 @@ namespace CIM
         }
 
         m_userNonBlock = false;
-        m_isClosed = false;
         return m_isInit;
     }
 
@@ -88,7 +107,12 @@ namespace CIM
 
     bool FdCtx::isClose() const
     {
-        return m_isClosed;
+        return m_isClosed.load(std::memory_order_acquire);
+    }
+
+    uint32_t FdCtx::getGeneration() const
+    {
+        return m_generation.load(std::memory_order_relaxed);
     }
 
     bool FdCtx::close()
@@ -141,52 +165,187 @@ namespace CIM
         return -1;
     }
 
-    FdManager::FdManager()
+    /// 截止时间的特殊值，表示等待已被巡检器判定超时
+    static const uint64_t kIdleTimedOut = 1;
+
+    void FdCtx::setIdleTimeout(uint64_t v)
+    {
+        m_idleTimeout = v;
+    }
+
+    uint64_t FdCtx::getIdleTimeout() const
     {
-        m_fdCtxs.resize(64);
+        return m_idleTimeout;
     }
 
-    FdCtx::ptr FdManager::get(int fd, bool auto_create)
+    void FdCtx::beginIdleWait(IOManager *iom, uint64_t deadline)
     {
-        if (fd < 0)
+        m_idleIom.store(iom, std::memory_order_relaxed);
+        m_idleDeadline.store(deadline < 2 ? 2 : deadline, std::memory_order_release);
+    }
+
+    bool FdCtx::endIdleWait()
+    {
+        return m_idleDeadline.exchange(0) == kIdleTimedOut;
+    }
+
+    bool FdCtx::checkIdleDeadline(uint64_t now)
+    {
+        uint64_t deadline = m_idleDeadline.load(std::memory_order_acquire);
+        if (deadline <= kIdleTimedOut || now < deadline)
         {
-            return nullptr;
+            return false;
+        }
+        // 与endIdleWait竞争：只有仍处于本次等待时才标记超时
+        if (!m_idleDeadline.compare_exchange_strong(deadline, kIdleTimedOut))
+        {
+            return false;
+        }
+        IOManager *iom = m_idleIom.load(std::memory_order_relaxed);
+        if (iom)
+        {
+            iom->cancelEvent(this, IOManager::READ);
         }
+        return true;
+    }
+
+    bool FdCtx::isIdleWaiting() const
+    {
+        return m_idleDeadline.load() > kIdleTimedOut;
+    }
 
-        RWMutexType::WriteLock lock(m_mutex);
-        if (fd >= (int)m_fdCtxs.size())
+    bool FdCtx::exchangeIdleWatched(bool v)
+    {
+        return m_idleWatched.exchange(v);
+    }
+
+    FdManager::FdManager()
+    {
+        for (int i = 0; i < kMaxChunks; ++i)
         {
-            if (!auto_create)
-            {
-                return nullptr;
-            }
-            m_fdCtxs.resize(fd * 1.5 + 1); // 防止 fd 是0或1
+            m_chunks[i].store(nullptr, std::memory_order_relaxed);
         }
-        else
+    }
+
+    FdManager::~FdManager()
+    {
+        for (int i = 0; i < kMaxChunks; ++i)
         {
-            if (m_fdCtxs[fd])
+            FdCtx *ctxs = m_chunks[i].load(std::memory_order_relaxed);
+            if (!ctxs)
             {
-                return m_fdCtxs[fd];
+                continue;
             }
-            if (!auto_create)
+            for (int j = 0; j < kChunkSize; ++j)
             {
-                return nullptr;
+                ctxs[j].~FdCtx();
             }
+            free(ctxs);
         }
+    }
 
-        FdCtx::ptr ctx = std::make_shared<FdCtx>(fd);
-        m_fdCtxs[fd] = ctx;
+    FdCtx *FdManager::chunk(int index, bool create)
+    {
+        FdCtx *ctxs = m_chunks[index].load(std::memory_order_acquire);
+        if (ctxs || !create)
+        {
+            return ctxs;
+        }
+
+        // 按缓存行对齐分配整块记录，多个线程同时分配时只有一个发布成功
+        void *mem = nullptr;
+        if (posix_memalign(&mem, alignof(FdCtx), sizeof(FdCtx) * kChunkSize))
+        {
+            throw std::bad_alloc();
+        }
+        FdCtx *created = (FdCtx *)mem;
+        for (int j = 0; j < kChunkSize; ++j)
+        {
+            new (&created[j]) FdCtx(index * kChunkSize + j);
+        }
+        if (m_chunks[index].compare_exchange_strong(ctxs, created, std::memory_order_acq_rel))
+        {
+            return created;
+        }
+        for (int j = 0; j < kChunkSize; ++j)
+        {
+            created[j].~FdCtx();
+        }
+        free(created);
+        return ctxs;
+    }
+
+    FdCtx *FdManager::getSlot(int fd)
+    {
+        if (fd < 0 || fd >= kMaxChunks * kChunkSize)
+        {
+            return nullptr;
+        }
+        FdCtx *ctxs = chunk(fd >> kChunkBits, true);
+        return &ctxs[fd & (kChunkSize - 1)];
+    }
+
+    FdCtx *FdManager::get(int fd, bool auto_create)
+    {
+        if (fd < 0 || fd >= kMaxChunks * kChunkSize)
+        {
+            return nullptr;
+        }
+
+        FdCtx *ctxs = chunk(fd >> kChunkBits, auto_create);
+        if (!ctxs)
+        {
+            return nullptr;
+        }
+        FdCtx *ctx = &ctxs[fd & (kChunkSize - 1)];
+        if (!ctx->isClose())
+        {
+            return ctx;
+        }
+        if (!auto_create)
+        {
+            return nullptr;
+        }
+
+        // 记录复用同一把锁，与IOManager的事件操作及del互斥
+        FdCtx::MutexType::Lock lock(ctx->mutex);
+        if (ctx->isClose())
+        {
+            ctx->open();
+        }
         return ctx;
     }
-    
+
     void FdManager::del(int fd)
     {
-        RWMutexType::WriteLock lock(m_mutex);
-        if (fd < 0 || fd >= (int)m_fdCtxs.size())
+        if (fd < 0 || fd >= kMaxChunks * kChunkSize)
         {
             return;
         }
-        m_fdCtxs[fd].reset();
+        FdCtx *ctxs = chunk(fd >> kChunkBits, false);
+        if (!ctxs)
+        {
+            return;
+        }
+        FdCtx *ctx = &ctxs[fd & (kChunkSize - 1)];
+        FdCtx::MutexType::Lock lock(ctx->mutex);
+        ctx->m_isClosed.store(true, std::memory_order_release);
+    }
+
+    void FdManager::foreach(const std::function<void(FdCtx *)> &cb)
+    {
+        for (int i = 0; i < kMaxChunks; ++i)
+        {
+            FdCtx *ctxs = m_chunks[i].load(std::memory_order_acquire);
+            if (!ctxs)
+            {
+                continue;
+            }
+            for (int j = 0; j < kChunkSize; ++j)
+            {
+                cb(&ctxs[j]);
+            }
+        }
     }
 
     FileDescriptor::FileDescriptor(int fd)
@@ -7,9 +7,12 @@
 #include "config.hpp"
 
 #include <dlfcn.h>
+#include <linux/io_uring.h>
 #include <sys/socket.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <time.h>
 
 namespace CIM
 {
@@ -19,6 +22,10 @@ namespace CIM
     static auto g_tcp_connect_timeout =
         Config::Lookup("tcp.connect.timeout", 5000, "tcp connect timeout");
 
+    // 空闲超时巡检间隔
+    static auto g_idle_sweep_interval =
+        Config::Lookup("tcp.idle_sweep_interval", 500, "idle timeout sweep interval(ms)");
+
     // hook 是否启用
     static thread_local bool t_hook_enable = false;
 
@@ -40,6 +47,7 @@ namespace CIM
     XX(send)         \
     XX(sendto)       \
     XX(sendmsg)      \
+    XX(sendfile)     \
     XX(close)        \
     XX(fcntl)        \
     XX(ioctl)        \
@@ -68,6 +76,7 @@ namespace CIM
     }
 
     static uint64_t s_connect_timeout = 0;
+    static uint64_t s_idle_sweep_interval = 500;
     // 静态初始化器，确保程序启动时就完成hook初始化
     struct HookIniter
     {
@@ -83,6 +92,15 @@ namespace CIM
                                              << old_value << " to " << new_value;
                     s_connect_timeout = new_value;
                 });
+
+            s_idle_sweep_interval = g_idle_sweep_interval->getValue();
+            g_idle_sweep_interval->addListener(
+                [](const int &old_value, const int &new_value)
+                {
+                    CIM_LOG_INFO(g_logger) << "idle sweep interval changed from "
+                                             << old_value << " to " << new_value;
+                    s_idle_sweep_interval = new_value;
+                });
         }
     };
 
@@ -113,6 +131,119 @@ namespace CIM
         int cancelled = 0;
     };
 
+    /**
+     * @brief 设置errno
+     *
+     * errno 经由 __const__ 属性的 __errno_location() 访问，编译器可以在同一函数内复用其返回的线程局部地址；
+     * 协程让出后可能在其他线程恢复，恢复后必须通过不内联的函数重新取地址，否则会写到原线程的errno上。
+     */
+    static void __attribute__((noinline)) set_errno(int e)
+    {
+        errno = e;
+    }
+
+    /**
+     * @brief 粗粒度单调时钟(毫秒)，空闲超时只需巡检间隔级别的精度
+     */
+    static uint64_t CoarseNowMS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+    }
+
+    /**
+     * @brief 空闲超时巡检器（每线程一个）
+     *
+     * 截止时间模式的连接第一次阻塞读时登记到所在线程的巡检器，之后的读等待只更新FdCtx中的截止时间。
+     * 巡检器在有登记连接时保持一个间隔为 tcp.idle_sweep_interval 的一次性定时器，
+     * 到期时取消已过截止时间的等待，并移出不再等待的连接（下次阻塞时重新登记）。
+     * 每个连接的定时器操作从每次读一对 add/cancel 降为零，每线程每个间隔一次 add。
+     */
+    class IdleSweeper : public std::enable_shared_from_this<IdleSweeper>
+    {
+    public:
+        typedef std::shared_ptr<IdleSweeper> ptr;
+
+        explicit IdleSweeper(IOManager *iom)
+            : m_iom(iom)
+        {
+        }
+
+        /**
+         * @brief 确保正在等待的连接已登记到某个巡检器
+         */
+        static void Watch(IOManager *iom, FdCtx *ctx)
+        {
+            if (ctx->exchangeIdleWatched(true))
+            {
+                return;
+            }
+            static thread_local IdleSweeper::ptr t_sweeper;
+            if (!t_sweeper || t_sweeper->m_iom != iom)
+            {
+                t_sweeper = std::make_shared<IdleSweeper>(iom);
+            }
+            t_sweeper->add(ctx);
+        }
+
+    private:
+        void add(FdCtx *ctx)
+        {
+            Mutex::Lock lock(m_mutex);
+            m_fds.push_back(std::make_pair(ctx, ctx->getGeneration()));
+            armNolock();
+        }
+
+        void armNolock()
+        {
+            if (m_armed || m_fds.empty())
+            {
+                return;
+            }
+            m_armed = true;
+            IdleSweeper::ptr self = shared_from_this();
+            m_iom->addTimer(s_idle_sweep_interval, [self]()
+                            { self->sweep(); });
+        }
+
+        void sweep()
+        {
+            uint64_t now = CoarseNowMS();
+            Mutex::Lock lock(m_mutex);
+            m_armed = false;
+            size_t keep = 0;
+            for (size_t i = 0; i < m_fds.size(); ++i)
+            {
+                // fd已关闭或已被复用，登记随之失效
+                FdCtx *ctx = m_fds[i].first;
+                if (ctx->isClose() || ctx->getGeneration() != m_fds[i].second)
+                {
+                    continue;
+                }
+                if (!ctx->isIdleWaiting())
+                {
+                    // 先清除登记标记再复查：与Watch中"先写截止时间再检查标记"配对，保证等待中的连接总被某个巡检器持有
+                    ctx->exchangeIdleWatched(false);
+                    if (!ctx->isIdleWaiting() || ctx->exchangeIdleWatched(true))
+                    {
+                        continue;
+                    }
+                }
+                ctx->checkIdleDeadline(now);
+                m_fds[keep++] = m_fds[i];
+            }
+            m_fds.resize(keep);
+            armNolock();
+        }
+
+    private:
+        IOManager *m_iom;                      ///< 巡检定时器所在的IOManager
+        Mutex m_mutex;                         ///< 保护以下成员，巡检回调可能在其他线程执行
+        std::vector<std::pair<FdCtx *, uint32_t>> m_fds; ///< 登记的连接及登记时的代数
+        bool m_armed = false;                  ///< 巡检定时器是否已添加
+    };
+
     /**
      * @brief 执行带有协程支持的IO操作
      * @tparam OriginFun 原始函数类型
@@ -143,7 +274,7 @@ namespace CIM
         }
 
         // ==========获取文件描述符上下文==========
-        FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+        FdCtx *ctx = FdMgr::GetInstance()->get(fd);
         if (!ctx)
         {
             return fun(fd, std::forward<Args>(args)...);
@@ -162,8 +293,13 @@ namespace CIM
             return fun(fd, std::forward<Args>(args)...);
         }
 
-        // 获取超时设置
+        // 获取超时设置；读操作启用了空闲超时时改用截止时间模式，不再逐次创建定时器
         uint64_t timeout = ctx->getTimeout(timeout_so);
+        uint64_t idle_timeout = timeout_so == SO_RCVTIMEO ? ctx->getIdleTimeout() : (uint64_t)-1;
+        if (idle_timeout != (uint64_t)-1)
+        {
+            timeout = -1;
+        }
         std::shared_ptr<timer_info> tinfo(new timer_info);
 
     // 重试标签，用于IO操作被中断或需要重试的情况
@@ -186,7 +322,7 @@ namespace CIM
             if (timeout != (uint64_t)-1) // 判断是否设置了超时时间
             {
                 // 设置一个条件定时器来实现超时控制
-                timer = iom->addConditionTimer(timeout, [winfo, fd, iom, event]()
+                timer = iom->addConditionTimer(timeout, [winfo, ctx, iom, event]()
                                                { 
                                                 auto t = winfo.lock();
                                                 // 如果转换失败或者cancelled已被设置，直接返回
@@ -197,11 +333,11 @@ namespace CIM
                                                 // 记录超时标准
                                                 t->cancelled = ETIMEDOUT;
                                                 // 通知 IOManager 取消对指定文件描述符上特定事件的监听
-                                                iom->cancelEvent(fd,(IOManager::Event)event); }, winfo);
+                                                iom->cancelEvent(ctx,(IOManager::Event)event); }, winfo);
             }
 
             // 添加IO事件监听
-            bool rt = iom->addEvent(fd, (IOManager::Event)event);
+            bool rt = iom->addEvent(ctx, (IOManager::Event)event);
             if (!rt)
             {
                 // 添加事件失败，记录日志并返回错误
@@ -213,9 +349,22 @@ namespace CIM
                 return -1;
             }
 
+            if (idle_timeout != (uint64_t)-1)
+            {
+                // 事件已注册后再写截止时间，巡检器取消事件时一定能唤醒本协程
+                ctx->beginIdleWait(iom, CoarseNowMS() + idle_timeout);
+                IdleSweeper::Watch(iom, ctx);
+            }
+
             // 成功添加事件，让出当前协程控制权
             Coroutine::YieldToHold();
 
+            if (idle_timeout != (uint64_t)-1 && ctx->endIdleWait())
+            {
+                set_errno(ETIMEDOUT);
+                return -1;
+            }
+
             // 协程重新被调度时，首先取消定时器（因为不再需要超时控制）
             if (timer)
             {
@@ -225,7 +374,13 @@ namespace CIM
             // 如果定时器触发（超时），设置错误码并返回
             if (tinfo->cancelled)
             {
-                errno = tinfo->cancelled;
+                set_errno(tinfo->cancelled);
+                return -1;
+            }
+            // 等待期间fd被hook关闭(close先标记关闭再取消事件)，不能再注册到已关闭的fd上
+            if (ctx->isClose())
+            {
+                set_errno(EBADF);
                 return -1;
             }
             // 重新尝试IO操作
@@ -234,6 +389,133 @@ namespace CIM
         return n;
     }
 
+    /**
+     * @brief 判断fd上的阻塞IO能否交给io_uring
+     * @param[in] fd 文件描述符
+     * @param[out] ctx fd上下文
+     * @return IOManager* 可以时返回当前线程的IOManager，否则返回nullptr
+     */
+    static IOManager *uring_manager(int fd, FdCtx *&ctx)
+    {
+        if (!is_hook_enable())
+        {
+            return nullptr;
+        }
+        IOManager *iom = IOManager::GetThis();
+        if (!iom || !iom->isUring())
+        {
+            return nullptr;
+        }
+        ctx = FdMgr::GetInstance()->get(fd);
+        if (!ctx || ctx->isClose() || !ctx->isSocket() || ctx->getUserNonBlock())
+        {
+            return nullptr;
+        }
+        return iom;
+    }
+
+    /**
+     * @brief 提交io_uring请求并挂起当前协程，直到完成、超时或fd关闭
+     * @param[out] n 与系统调用相同的返回值，失败时已设置errno
+     * @return bool 无法提交（提交队列已满等）时返回false，调用者改走epoll
+     *
+     * 超时由内核的LINK_TIMEOUT处理，不再创建定时器；截止时间模式与do_io相同，由巡检器取消请求。
+     * 被cancelEvent/cancelAll取消时与do_io一样重新发起，fd已关闭则返回EBADF。
+     */
+    static bool wait_uring(int fd, FdCtx *ctx, IOManager *iom, uint32_t event, int timeout_so,
+                           IOManager::IORequest &req, ssize_t &n)
+    {
+        uint32_t generation = ctx->getGeneration();
+        uint64_t idle_timeout = timeout_so == SO_RCVTIMEO ? ctx->getIdleTimeout() : (uint64_t)-1;
+        req.timeout = idle_timeout != (uint64_t)-1 ? (uint64_t)-1 : ctx->getTimeout(timeout_so);
+        while (true)
+        {
+            if (!iom->submitIO(ctx, (IOManager::Event)event, req))
+            {
+                return false;
+            }
+            if (idle_timeout != (uint64_t)-1)
+            {
+                ctx->beginIdleWait(iom, CoarseNowMS() + idle_timeout);
+                IdleSweeper::Watch(iom, ctx);
+            }
+
+            Coroutine::YieldToHold();
+
+            bool idle_expired = idle_timeout != (uint64_t)-1 && ctx->endIdleWait();
+            // 数据已经读入缓冲区时即使同时超时也返回数据
+            if (req.result >= 0)
+            {
+                n = req.result;
+                return true;
+            }
+            n = -1;
+            if (idle_expired)
+            {
+                set_errno(ETIMEDOUT);
+                return true;
+            }
+            if (req.result == -ECANCELED)
+            {
+                if (!req.cancelled)
+                {
+                    set_errno(ETIMEDOUT); // 链接的超时到期
+                    return true;
+                }
+                if (ctx->isClose() || ctx->getGeneration() != generation)
+                {
+                    set_errno(EBADF);
+                    return true;
+                }
+                continue;
+            }
+            if (req.result == -EINTR || req.result == -EAGAIN)
+            {
+                continue;
+            }
+            set_errno(-req.result);
+            return true;
+        }
+    }
+
+    /**
+     * @brief io_uring后端下的IO：读类操作直接提交请求，写类操作先尝试系统调用，阻塞时再提交
+     * @param[in] req 填好opcode/addr/len等字段的请求
+     * @param[in] direct 是否跳过首次系统调用直接提交
+     *
+     * 写操作通常能立即完成，直接调用只需一次系统调用且没有额外的调度延迟；
+     * 读操作在长连接上多数会阻塞，直接提交省去一次返回EAGAIN的调用。
+     * 非io_uring后端或无法提交时回退到do_io。
+     */
+    template <typename OriginFun, typename... Args>
+    static ssize_t do_io_uring(int fd, IOManager::IORequest &req, bool direct, OriginFun fun,
+                               const char *hook_fun_name, uint32_t event, int timeout_so, Args &&...args)
+    {
+        FdCtx *ctx = nullptr;
+        IOManager *iom = uring_manager(fd, ctx);
+        if (iom)
+        {
+            ssize_t n;
+            if (!direct)
+            {
+                n = fun(fd, args...);
+                while (n == -1 && errno == EINTR)
+                {
+                    n = fun(fd, args...);
+                }
+                if (n != -1 || errno != EAGAIN)
+                {
+                    return n;
+                }
+            }
+            if (wait_uring(fd, ctx, iom, event, timeout_so, req, n))
+            {
+                return n;
+            }
+        }
+        return do_io(fd, fun, hook_fun_name, event, timeout_so, std::forward<Args>(args)...);
+    }
+
     extern "C"
     {
         // 定义函数指针
@@ -392,7 +674,7 @@ namespace CIM
             }
 
             // 获取文件描述符上下文
-            FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+            FdCtx *ctx = FdMgr::GetInstance()->get(fd);
             if (!ctx || ctx->isClose())
             {
                 errno = EBADF;
@@ -411,6 +693,27 @@ namespace CIM
                 return connect_f(fd, addr, addrlen);
             }
 
+            // io_uring后端直接提交连接请求，超时交给内核
+            IOManager *uring_iom = IOManager::GetThis();
+            if (uring_iom && uring_iom->isUring())
+            {
+                IOManager::IORequest req;
+                req.opcode = IORING_OP_CONNECT;
+                req.addr = (uint64_t)addr;
+                req.off = addrlen;
+                req.timeout = timeout_ms;
+                if (uring_iom->submitIO(ctx, IOManager::WRITE, req))
+                {
+                    Coroutine::YieldToHold();
+                    if (req.result == 0)
+                    {
+                        return 0;
+                    }
+                    set_errno(req.result == -ECANCELED && !req.cancelled ? ETIMEDOUT : -req.result);
+                    return -1;
+                }
+            }
+
             // 尝试连接
             int n = connect_f(fd, addr, addrlen);
             if (n == 0)
@@ -433,7 +736,7 @@ namespace CIM
             // 如果设置了超时时间，则添加超时定时器，如果在规定时间内未完成连接，则设置错误表示，以返回连接错误
             if (timeout_ms != (uint64_t)-1)
             {
-                timer = iom->addConditionTimer(timeout_ms, [winfo, fd, iom]()
+                timer = iom->addConditionTimer(timeout_ms, [winfo, ctx, iom]()
                                                {
                                                 auto t = winfo.lock();
                                                 if(!t || t->cancelled) {
@@ -442,11 +745,11 @@ namespace CIM
                                                 // 设置错误标识
                                                 t->cancelled = ETIMEDOUT;
                                                 // 取消监听事件
-                                                iom->cancelEvent(fd, IOManager::WRITE); }, winfo);
+                                                iom->cancelEvent(ctx, IOManager::WRITE); }, winfo);
             }
 
             // 添加写事件监听（连接完成时socket可写）
-            bool rt = iom->addEvent(fd, IOManager::WRITE);
+            bool rt = iom->addEvent(ctx, IOManager::WRITE);
             if (!rt)
             {
                 // 事件添加失败，取消定时器并记录日志
@@ -470,7 +773,7 @@ namespace CIM
                 // 检查是否因超时取消
                 if (tinfo->cancelled)
                 {
-                    errno = tinfo->cancelled;
+                    set_errno(tinfo->cancelled);
                     return -1;
                 }
             }
@@ -490,7 +793,7 @@ namespace CIM
             }
             else
             {
-                errno = error;
+                set_errno(error);
                 return -1;
             }
         }
@@ -524,7 +827,11 @@ namespace CIM
          */
         int accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
         {
-            int fd = do_io(sockfd, accept_f, "accept", IOManager::READ, SO_RCVTIMEO, addr, addrlen);
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_ACCEPT;
+            req.addr = (uint64_t)addr;
+            req.off = (uint64_t)addrlen;
+            int fd = do_io_uring(sockfd, req, true, accept_f, "accept", IOManager::READ, SO_RCVTIMEO, addr, addrlen);
             if (fd >= 0)
             {
                 FdMgr::GetInstance()->get(fd, true);
@@ -544,7 +851,11 @@ namespace CIM
          */
         ssize_t read(int fd, void *buf, size_t count)
         {
-            return do_io(fd, read_f, "read", IOManager::READ, SO_RCVTIMEO, buf, count);
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_RECV; // 非阻塞socket上的IORING_OP_READ会直接返回EAGAIN，socket统一用RECV
+            req.addr = (uint64_t)buf;
+            req.len = count;
+            return do_io_uring(fd, req, true, read_f, "read", IOManager::READ, SO_RCVTIMEO, buf, count);
         }
 
         /**
@@ -575,7 +886,16 @@ namespace CIM
          */
         ssize_t recv(int sockfd, void *buf, size_t len, int flags)
         {
-            return do_io(sockfd, recv_f, "recv", IOManager::READ, SO_RCVTIMEO, buf, len, flags);
+            if (flags & MSG_DONTWAIT)
+            {
+                return do_io(sockfd, recv_f, "recv", IOManager::READ, SO_RCVTIMEO, buf, len, flags);
+            }
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_RECV;
+            req.addr = (uint64_t)buf;
+            req.len = len;
+            req.op_flags = flags;
+            return do_io_uring(sockfd, req, true, recv_f, "recv", IOManager::READ, SO_RCVTIMEO, buf, len, flags);
         }
 
         /**
@@ -609,7 +929,15 @@ namespace CIM
          */
         ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags)
         {
-            return do_io(sockfd, recvmsg_f, "recvmsg", IOManager::READ, SO_RCVTIMEO, msg, flags);
+            if (flags & MSG_DONTWAIT)
+            {
+                return do_io(sockfd, recvmsg_f, "recvmsg", IOManager::READ, SO_RCVTIMEO, msg, flags);
+            }
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_RECVMSG;
+            req.addr = (uint64_t)msg;
+            req.op_flags = flags;
+            return do_io_uring(sockfd, req, true, recvmsg_f, "recvmsg", IOManager::READ, SO_RCVTIMEO, msg, flags);
         }
 
         /**
@@ -639,7 +967,13 @@ namespace CIM
          */
         ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
         {
-            return do_io(fd, writev_f, "writev", IOManager::WRITE, SO_SNDTIMEO, iov, iovcnt);
+            struct msghdr msg = {};
+            msg.msg_iov = (iovec *)iov;
+            msg.msg_iovlen = iovcnt;
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_SENDMSG; // 同READ，非阻塞socket上的WRITEV不会等待
+            req.addr = (uint64_t)&msg;
+            return do_io_uring(fd, req, false, writev_f, "writev", IOManager::WRITE, SO_SNDTIMEO, iov, iovcnt);
         }
 
         /**
@@ -655,7 +989,16 @@ namespace CIM
          */
         ssize_t send(int sockfd, const void *buf, size_t len, int flags)
         {
-            return do_io(sockfd, send_f, "send", IOManager::WRITE, SO_SNDTIMEO, buf, len, flags);
+            if (flags & MSG_DONTWAIT)
+            {
+                return do_io(sockfd, send_f, "send", IOManager::WRITE, SO_SNDTIMEO, buf, len, flags);
+            }
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_SEND;
+            req.addr = (uint64_t)buf;
+            req.len = len;
+            req.op_flags = flags;
+            return do_io_uring(sockfd, req, false, send_f, "send", IOManager::WRITE, SO_SNDTIMEO, buf, len, flags);
         }
 
         /**
@@ -689,7 +1032,31 @@ namespace CIM
          */
         ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags)
         {
-            return do_io(sockfd, sendmsg_f, "sendmsg", IOManager::WRITE, SO_SNDTIMEO, msg, flags);
+            if (flags & MSG_DONTWAIT)
+            {
+                return do_io(sockfd, sendmsg_f, "sendmsg", IOManager::WRITE, SO_SNDTIMEO, msg, flags);
+            }
+            IOManager::IORequest req;
+            req.opcode = IORING_OP_SENDMSG;
+            req.addr = (uint64_t)msg;
+            req.op_flags = flags;
+            return do_io_uring(sockfd, req, false, sendmsg_f, "sendmsg", IOManager::WRITE, SO_SNDTIMEO, msg, flags);
+        }
+
+        /**
+         * @brief 重写的sendfile函数，支持协程调度
+         * @param[in] out_fd 目标socket
+         * @param[in] in_fd 源文件
+         * @param[in,out] offset 源文件偏移，发送后前移
+         * @param[in] count 最多发送的字节数
+         * @return 成功返回实际发送的字节数，失败返回-1并设置errno
+         *
+         * @details io_uring没有对应的操作码，使用do_io在out_fd不可写时让出协程。
+         *          kTLS socket上内核加密后发送，文件内容不经过用户态。
+         */
+        ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+        {
+            return do_io(out_fd, sendfile_f, "sendfile", IOManager::WRITE, SO_SNDTIMEO, in_fd, offset, count);
         }
 
         /**
@@ -708,17 +1075,17 @@ namespace CIM
                 return close_f(fd);
             }
 
-            FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+            FdCtx *ctx = FdMgr::GetInstance()->get(fd);
             if (ctx)
             {
+                // 先标记关闭再取消：被取消唤醒的协程看到fd已关闭后返回EBADF，不会重新提交请求
+                FdMgr::GetInstance()->del(fd);
                 auto iom = IOManager::GetThis();
                 if (iom)
                 {
                     // 取消该文件描述符上所有IO事件监听
                     iom->cancelAll(fd);
                 }
-                // 从管理器中删除该文件描述符的上下文
-                FdMgr::GetInstance()->del(fd);
             }
             // 调用原始的close函数关闭文件描述符
             return close_f(fd);
@@ -751,7 +1118,7 @@ namespace CIM
             {
                 int arg = va_arg(args, int);
                 va_end(args);
-                FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+                FdCtx *ctx = FdMgr::GetInstance()->get(fd);
                 if (!ctx || !ctx->isSocket() || ctx->isClose())
                 {
                     return fcntl_f(fd, cmd, arg);
@@ -773,7 +1140,7 @@ namespace CIM
             {
                 va_end(args);
                 int arg = fcntl_f(fd, cmd);
-                FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+                FdCtx *ctx = FdMgr::GetInstance()->get(fd);
                 if (!ctx || !ctx->isSocket() || ctx->isClose())
                 {
                     return arg;
@@ -867,7 +1234,7 @@ namespace CIM
             if (FIONBIO == request)
             {
                 bool user_nonblock = !!(*(int *)arg);
-                FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+                FdCtx *ctx = FdMgr::GetInstance()->get(fd);
                 if (!ctx || !ctx->isSocket() || ctx->isClose())
                 {
                     return ioctl_f(fd, request, arg);
@@ -876,56 +1243,56 @@ namespace CIM
             }
             return ioctl_f(fd, request, arg);
         }
-    }
-
-    /**
-     * @brief 重写的getsockopt函数
-     * @param[in] sockfd socket文件描述符
-     * @param[in] level 选项定义层次
-     * @param[in] optname 需要查询的选项名
-     * @param[out] optval 用于存放选项值的缓冲区
-     * @param[in,out] optlen optval缓冲区长度，返回时为实际数据长度
-     * @return 成功返回0，失败返回-1并设置errno
-     *
-     * @details 该函数目前直接转发给系统原始函数，未做特殊处理。
-     */
-    int getsockopt(int sockfd, int level, int optname, void *optval, socklen_t *optlen)
-    {
-        return getsockopt_f(sockfd, level, optname, optval, optlen);
-    }
 
-    /**
-     * @brief 重写的setsockopt函数
-     * @param[in] sockfd socket文件描述符
-     * @param[in] level 选项定义层次
-     * @param[in] optname 需要设置的选项名
-     * @param[in] optval 包含选项值的缓冲区
-     * @param[in] optlen optval缓冲区长度
-     * @return 成功返回0，失败返回-1并设置errno
-     *
-     * @details 该函数在原始setsockopt基础上增加了对超时选项的处理。
-     *          当设置SO_RCVTIMEO或SO_SNDTIMEO选项时，会同时更新FdCtx中的超时设置。
-     */
-    int setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen)
-    {
-        if (!is_hook_enable())
+        /**
+         * @brief 重写的getsockopt函数
+         * @param[in] sockfd socket文件描述符
+         * @param[in] level 选项定义层次
+         * @param[in] optname 需要查询的选项名
+         * @param[out] optval 用于存放选项值的缓冲区
+         * @param[in,out] optlen optval缓冲区长度，返回时为实际数据长度
+         * @return 成功返回0，失败返回-1并设置errno
+         *
+         * @details 该函数目前直接转发给系统原始函数，未做特殊处理。
+         */
+        int getsockopt(int sockfd, int level, int optname, void *optval, socklen_t *optlen)
         {
-            return setsockopt_f(sockfd, level, optname, optval, optlen);
+            return getsockopt_f(sockfd, level, optname, optval, optlen);
         }
 
-        if (level == SOL_SOCKET)
+        /**
+         * @brief 重写的setsockopt函数
+         * @param[in] sockfd socket文件描述符
+         * @param[in] level 选项定义层次
+         * @param[in] optname 需要设置的选项名
+         * @param[in] optval 包含选项值的缓冲区
+         * @param[in] optlen optval缓冲区长度
+         * @return 成功返回0，失败返回-1并设置errno
+         *
+         * @details 该函数在原始setsockopt基础上增加了对超时选项的处理。
+         *          当设置SO_RCVTIMEO或SO_SNDTIMEO选项时，会同时更新FdCtx中的超时设置。
+         */
+        int setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen)
         {
-            if (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO)
+            if (!is_hook_enable())
             {
-                FdCtx::ptr ctx = FdMgr::GetInstance()->get(sockfd);
-                if (ctx)
+                return setsockopt_f(sockfd, level, optname, optval, optlen);
+            }
+
+            if (level == SOL_SOCKET)
+            {
+                if (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO)
                 {
-                    // 将传入的timeval结构体转换为毫秒数，并设置到上下文中的超时时间
-                    const timeval *tv = (const timeval *)optval;
-                    ctx->setTimeout(optname, tv->tv_sec * 1000 + tv->tv_usec / 1000);
+                    FdCtx *ctx = FdMgr::GetInstance()->get(sockfd);
+                    if (ctx)
+                    {
+                        // 将传入的timeval结构体转换为毫秒数，并设置到上下文中的超时时间
+                        const timeval *tv = (const timeval *)optval;
+                        ctx->setTimeout(optname, tv->tv_sec * 1000 + tv->tv_usec / 1000);
+                    }
                 }
             }
+            return setsockopt_f(sockfd, level, optname, optval, optlen);
         }
-        return setsockopt_f(sockfd, level, optname, optval, optlen);
     }
 }
\ No newline at end of file
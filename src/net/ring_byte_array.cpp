@@ -0,0 +1,576 @@
+#include "ring_byte_array.hpp"
+#include "endian.hpp"
+#include "macro.hpp"
+#include <iomanip>
+
+namespace CIM
+{
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    /**
+     * @brief 向上取整为2的幂，环形寻址只需要一次按位与
+     */
+    static size_t RoundUpPow2(size_t v)
+    {
+        size_t n = 1;
+        while (n < v)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static uint32_t EncodeZigzag32(int32_t v)
+    {
+        if (v < 0)
+        {
+            return ((uint32_t)(-v)) * 2 - 1;
+        }
+        else
+        {
+            return (uint32_t)(v) * 2;
+        }
+    }
+
+    static uint64_t EncodeZigzag64(int64_t v)
+    {
+        if (v < 0)
+        {
+            return ((uint64_t)(-v)) * 2 - 1;
+        }
+        else
+        {
+            return (uint64_t)(v) * 2;
+        }
+    }
+
+    static int32_t DecodeZigzag32(uint32_t v)
+    {
+        return (v >> 1) ^ -(v & 1);
+    }
+
+    static int64_t DecodeZigzag64(uint64_t v)
+    {
+        return (v >> 1) ^ -(v & 1);
+    }
+
+    RingByteArray::Buffer::Buffer(size_t s)
+        : ptr(new char[s]),
+          size(s)
+    {
+    }
+
+    RingByteArray::Buffer::~Buffer()
+    {
+        delete[] ptr;
+    }
+
+    RingByteArray::RingByteArray(size_t base_size)
+        : m_buffer(std::make_shared<Buffer>(RoundUpPow2(base_size))),
+          m_begin(0),
+          m_position(0),
+          m_data_size(0),
+          m_endian(CIM_BIG_ENDIAN)
+    {
+    }
+
+    void RingByteArray::writeFint8(int8_t value)
+    {
+        write(&value, sizeof(value));
+    }
+
+    void RingByteArray::writeFuint8(uint8_t value)
+    {
+        write(&value, sizeof(value));
+    }
+
+#define XX(value)                   \
+    if (CIM_BYTE_ORDER != m_endian) \
+    {                               \
+        value = byteswap(value);    \
+    }                               \
+    write(&value, sizeof(value));
+    void RingByteArray::writeFint16(int16_t value) { XX(value); }
+    void RingByteArray::writeFuint16(uint16_t value) { XX(value); }
+    void RingByteArray::writeFint32(int32_t value) { XX(value); }
+    void RingByteArray::writeFuint32(uint32_t value) { XX(value); }
+    void RingByteArray::writeFint64(int64_t value) { XX(value); }
+    void RingByteArray::writeFuint64(uint64_t value) { XX(value); }
+#undef XX
+
+    void RingByteArray::writeInt32(int32_t value)
+    {
+        writeUint32(EncodeZigzag32(value));
+    }
+
+    void RingByteArray::writeUint32(uint32_t value)
+    {
+        uint8_t tmp[5];
+        uint8_t i = 0;
+        while (value >= 0x80)
+        {
+            tmp[i++] = (value & 0x7F) | 0x80;
+            value >>= 7;
+        }
+        tmp[i++] = value;
+        write(tmp, i);
+    }
+
+    void RingByteArray::writeInt64(int64_t value)
+    {
+        writeUint64(EncodeZigzag64(value));
+    }
+
+    void RingByteArray::writeUint64(uint64_t value)
+    {
+        uint8_t tmp[10];
+        uint8_t i = 0;
+        while (value >= 0x80)
+        {
+            tmp[i++] = (value & 0x7F) | 0x80;
+            value >>= 7;
+        }
+        tmp[i++] = value;
+        write(tmp, i);
+    }
+
+    void RingByteArray::writeFloat(float value)
+    {
+        uint32_t v;
+        memcpy(&v, &value, sizeof(value));
+        writeFuint32(v);
+    }
+
+    void RingByteArray::writeDouble(double value)
+    {
+        uint64_t v;
+        memcpy(&v, &value, sizeof(value));
+        writeFuint64(v);
+    }
+
+    void RingByteArray::writeStringF16(const std::string &value)
+    {
+        writeFuint16(value.size());
+        write(value.c_str(), value.size());
+    }
+
+    void RingByteArray::writeStringF32(const std::string &value)
+    {
+        writeFuint32(value.size());
+        write(value.c_str(), value.size());
+    }
+
+    void RingByteArray::writeStringF64(const std::string &value)
+    {
+        writeFuint64(value.size());
+        write(value.c_str(), value.size());
+    }
+
+    void RingByteArray::writeStringVint(const std::string &value)
+    {
+        writeUint64(value.size());
+        write(value.c_str(), value.size());
+    }
+
+    void RingByteArray::writeStringWithoutLength(const std::string &value)
+    {
+        write(value.c_str(), value.size());
+    }
+
+    int8_t RingByteArray::readFint8()
+    {
+        return (int8_t)readFuint8();
+    }
+
+    /**
+     * @brief 读取单个字节
+     * @details 变长整数逐字节解码，这里直接按下标取值，不走通用的read
+     */
+    uint8_t RingByteArray::readFuint8()
+    {
+        if (m_position >= m_data_size)
+        {
+            throw std::out_of_range("not enough len");
+        }
+        uint8_t v = m_buffer->ptr[index(m_position)];
+        ++m_position;
+        return v;
+    }
+
+#define XX(type)                    \
+    type v;                         \
+    read(&v, sizeof(v));            \
+    if (CIM_BYTE_ORDER != m_endian) \
+    {                               \
+        return byteswap(v);         \
+    }                               \
+    return v;
+    int16_t RingByteArray::readFint16() { XX(int16_t); }
+    uint16_t RingByteArray::readFuint16() { XX(uint16_t); }
+    int32_t RingByteArray::readFint32() { XX(int32_t); }
+    uint32_t RingByteArray::readFuint32() { XX(uint32_t); }
+    int64_t RingByteArray::readFint64() { XX(int64_t); }
+    uint64_t RingByteArray::readFuint64() { XX(uint64_t); }
+#undef XX
+
+    int32_t RingByteArray::readInt32()
+    {
+        return DecodeZigzag32(readUint32());
+    }
+
+    uint32_t RingByteArray::readUint32()
+    {
+        uint32_t result = 0;
+        for (int i = 0; i < 32; i += 7)
+        {
+            uint8_t b = readFuint8();
+            if (b < 0x80)
+            {
+                result |= ((uint32_t)b) << i;
+                break;
+            }
+            else
+            {
+                result |= ((uint32_t)(b & 0x7f)) << i;
+            }
+        }
+        return result;
+    }
+
+    int64_t RingByteArray::readInt64()
+    {
+        return DecodeZigzag64(readUint64());
+    }
+
+    uint64_t RingByteArray::readUint64()
+    {
+        uint64_t result = 0;
+        for (int i = 0; i < 64; i += 7)
+        {
+            uint8_t b = readFuint8();
+            if (b < 0x80)
+            {
+                result |= ((uint64_t)b) << i;
+                break;
+            }
+            else
+            {
+                result |= ((uint64_t)(b & 0x7f)) << i;
+            }
+        }
+        return result;
+    }
+
+    float RingByteArray::readFloat()
+    {
+        uint32_t v = readFuint32();
+        float value;
+        memcpy(&value, &v, sizeof(v));
+        return value;
+    }
+
+    double RingByteArray::readDouble()
+    {
+        uint64_t v = readFuint64();
+        double value;
+        memcpy(&value, &v, sizeof(v));
+        return value;
+    }
+
+#define XX(len_fun)                  \
+    uint64_t len = len_fun();        \
+    std::string buffer;              \
+    buffer.resize(len);              \
+    read(&buffer[0], len);           \
+    return buffer;
+    std::string RingByteArray::readString16() { XX(readFuint16); }
+    std::string RingByteArray::readString32() { XX(readFuint32); }
+    std::string RingByteArray::readString64() { XX(readFuint64); }
+    std::string RingByteArray::readStringVint() { XX(readUint64); }
+#undef XX
+
+    void RingByteArray::clear()
+    {
+        m_begin = m_position = m_data_size = 0;
+    }
+
+    void RingByteArray::write(const void *buf, size_t size)
+    {
+        if (!buf || size == 0)
+        {
+            return;
+        }
+        prepareWrite(size);
+
+        // 环形寻址，最多拆成尾部和头部两段
+        size_t pos = index(m_position);
+        size_t first = std::min(size, m_buffer->size - pos);
+        memcpy(m_buffer->ptr + pos, buf, first);
+        if (size > first)
+        {
+            memcpy(m_buffer->ptr, (const char *)buf + first, size - first);
+        }
+
+        m_position += size;
+        if (m_position > m_data_size)
+        {
+            m_data_size = m_position;
+        }
+    }
+
+    void RingByteArray::read(void *buf, size_t size)
+    {
+        if (!buf || size == 0)
+        {
+            return;
+        }
+        if (size > getReadSize())
+        {
+            throw std::out_of_range("not enough len");
+        }
+        copyOut(buf, size, m_position);
+        m_position += size;
+    }
+
+    void RingByteArray::read(void *buf, size_t size, size_t position) const
+    {
+        if (!buf || size == 0)
+        {
+            return;
+        }
+        if (position > m_data_size || size > (m_data_size - position))
+        {
+            throw std::out_of_range("not enough len");
+        }
+        copyOut(buf, size, position);
+    }
+
+    void RingByteArray::setPosition(size_t v)
+    {
+        if (v > m_buffer->size)
+        {
+            throw std::out_of_range("RingByteArray::setPosition out of range");
+        }
+        m_position = v;
+        if (m_position > m_data_size)
+        {
+            m_data_size = m_position;
+        }
+    }
+
+    bool RingByteArray::writeToFile(const std::string &path) const
+    {
+        std::ofstream ofs;
+        ofs.open(path, std::ios::trunc | std::ios::binary);
+        if (!ofs)
+        {
+            CIM_LOG_ERROR(g_logger) << "RingByteArray::writeToFile path=" << path
+                                    << " error=" << errno << " errstr=" << strerror(errno);
+            return false;
+        }
+
+        std::vector<iovec> iovs;
+        getReadBuffers(iovs);
+        for (auto &i : iovs)
+        {
+            ofs.write((const char *)i.iov_base, i.iov_len);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 从文件读取内容到字节数组
+     * @details 直接读入getWriteBuffers返回的内存，不经过中间缓冲区；内容追加到当前位置
+     */
+    bool RingByteArray::readFromFile(const std::string &path)
+    {
+        std::ifstream ifs;
+        ifs.open(path, std::ios::in | std::ios::binary);
+        if (!ifs)
+        {
+            CIM_LOG_ERROR(g_logger) << "RingByteArray::readFromFile path=" << path
+                                    << " error=" << errno << " errstr=" << strerror(errno);
+            return false;
+        }
+
+        std::vector<iovec> iovs;
+        while (ifs)
+        {
+            iovs.clear();
+            // 剩余容量用完后按4K申请，由prepareWrite按倍数扩容
+            getWriteBuffers(iovs, std::max<size_t>(4096, m_buffer->size - m_position));
+            size_t got = 0;
+            for (auto &i : iovs)
+            {
+                ifs.read((char *)i.iov_base, i.iov_len);
+                got += ifs.gcount();
+                if ((size_t)ifs.gcount() < i.iov_len)
+                {
+                    break;
+                }
+            }
+            setPosition(m_position + got);
+        }
+        return true;
+    }
+
+    size_t RingByteArray::getCapacity() const
+    {
+        return m_buffer->size;
+    }
+
+    bool RingByteArray::isLittleEndian() const
+    {
+        return m_endian == CIM_LITTLE_ENDIAN;
+    }
+
+    void RingByteArray::setIsLittleEndian(bool val)
+    {
+        m_endian = val ? CIM_LITTLE_ENDIAN : CIM_BIG_ENDIAN;
+    }
+
+    std::string RingByteArray::toString() const
+    {
+        std::string str;
+        str.resize(getReadSize());
+        if (str.empty())
+        {
+            return str;
+        }
+        copyOut(&str[0], str.size(), m_position);
+        return str;
+    }
+
+    std::string RingByteArray::toHexString() const
+    {
+        std::string str = toString();
+        std::stringstream ss;
+
+        for (size_t i = 0; i < str.size(); i++)
+        {
+            if (i > 0 && i % 32 == 0)
+            {
+                ss << std::endl;
+            }
+            ss << std::setw(2) << std::setfill('0') << std::hex << (int)(uint8_t)str[i] << " ";
+        }
+
+        return ss.str();
+    }
+
+    uint64_t RingByteArray::getReadBuffers(std::vector<iovec> &buffer, uint64_t len) const
+    {
+        len = std::min<uint64_t>(len, getReadSize());
+        appendBuffers(buffer, len, m_position);
+        return len;
+    }
+
+    uint64_t RingByteArray::getReadBuffers(std::vector<iovec> &buffer, uint64_t len, uint64_t position) const
+    {
+        if (position > m_data_size)
+        {
+            return 0;
+        }
+        len = std::min<uint64_t>(len, m_data_size - position);
+        appendBuffers(buffer, len, position);
+        return len;
+    }
+
+    uint64_t RingByteArray::getWriteBuffers(std::vector<iovec> &buffer, uint64_t len)
+    {
+        if (len == 0)
+        {
+            return 0;
+        }
+        prepareWrite(len);
+        appendBuffers(buffer, len, m_position);
+        return len;
+    }
+
+    void RingByteArray::reserve(size_t size)
+    {
+        if (m_position + size > m_buffer->size)
+        {
+            relocate(RoundUpPow2(m_position + size));
+        }
+    }
+
+    RingByteArray::ptr RingByteArray::slice(size_t position, size_t len) const
+    {
+        if (position > m_data_size || len > m_data_size - position)
+        {
+            throw std::out_of_range("RingByteArray::slice out of range");
+        }
+        // 拷贝构造只复制shared_ptr，底层内存共享
+        ptr rt(new RingByteArray(*this));
+        rt->m_begin = index(position);
+        rt->m_position = 0;
+        rt->m_data_size = len;
+        return rt;
+    }
+
+    void RingByteArray::consume()
+    {
+        m_begin = index(m_position);
+        m_data_size -= m_position;
+        m_position = 0;
+    }
+
+    void RingByteArray::prepareWrite(size_t size)
+    {
+        size_t need = m_position + size;
+        if (need > m_buffer->size)
+        {
+            // 按倍数扩容，避免逐字节写入时反复搬移
+            relocate(RoundUpPow2(std::max(need, m_buffer->size * 2)));
+        }
+        else if (m_buffer.use_count() > 1)
+        {
+            // 底层内存被切片共享，写时复制，保证切片内容不变
+            relocate(m_buffer->size);
+        }
+    }
+
+    void RingByteArray::relocate(size_t capacity)
+    {
+        std::shared_ptr<Buffer> buf = std::make_shared<Buffer>(capacity);
+        copyOut(buf->ptr, m_data_size, 0);
+        m_buffer.swap(buf);
+        m_begin = 0;
+    }
+
+    void RingByteArray::copyOut(void *buf, size_t size, size_t position) const
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        size_t pos = index(position);
+        size_t first = std::min(size, m_buffer->size - pos);
+        memcpy(buf, m_buffer->ptr + pos, first);
+        if (size > first)
+        {
+            memcpy((char *)buf + first, m_buffer->ptr, size - first);
+        }
+    }
+
+    void RingByteArray::appendBuffers(std::vector<iovec> &buffer, size_t size, size_t position) const
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        size_t pos = index(position);
+        size_t first = std::min(size, m_buffer->size - pos);
+        iovec iov;
+        iov.iov_base = m_buffer->ptr + pos;
+        iov.iov_len = first;
+        buffer.push_back(iov);
+        if (size > first)
+        {
+            iov.iov_base = m_buffer->ptr;
+            iov.iov_len = size - first;
+            buffer.push_back(iov);
+        }
+    }
+}
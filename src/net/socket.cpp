@@ -3,12 +3,27 @@
 #include "fd_manager.hpp"
 #include "macro.hpp"
 #include "hook.hpp"
+#include "config.hpp"
+#include <atomic>
 #include <limits.h>
+#include <sys/sendfile.h>
+#include <unordered_map>
 
 namespace CIM
 {
     static auto g_logger = CIM_LOG_NAME("system");
 
+    static auto g_ssl_ktls =
+        Config::Lookup("ssl.ktls", true, "hand record encryption to the kernel (kTLS) after the handshake when available");
+    static auto g_ssl_session_cache_size =
+        Config::Lookup("ssl.session_cache_size", (uint32_t)20480, "TLS sessions cached for resumption, server and client side; 0 disables");
+    static auto g_ssl_session_timeout =
+        Config::Lookup("ssl.session_timeout", (uint32_t)300, "TLS session lifetime in seconds");
+    static auto g_ssl_session_tickets =
+        Config::Lookup("ssl.session_tickets", true, "issue stateless session tickets");
+    static auto g_ssl_write_coalesce =
+        Config::Lookup("ssl.write_coalesce", (uint32_t)16384, "iovec pieces smaller than this are merged into one TLS record; 0 writes each piece separately");
+
     Socket::ptr Socket::CreateTCP(CIM::Address::ptr address)
     {
         Socket::ptr sock(new Socket(address->getFamily(), TCP, 0));
@@ -79,7 +94,7 @@ namespace CIM
 
     int64_t Socket::getSendTimeout()
     {
-        FdCtx::ptr ctx = FdMgr::GetInstance()->get(m_sock);
+        FdCtx *ctx = FdMgr::GetInstance()->get(m_sock);
         if (ctx)
         {
             return ctx->getTimeout(SO_SNDTIMEO);
@@ -95,7 +110,7 @@ namespace CIM
 
     int64_t Socket::getRecvTimeout()
     {
-        FdCtx::ptr ctx = FdMgr::GetInstance()->get(m_sock);
+        FdCtx *ctx = FdMgr::GetInstance()->get(m_sock);
         if (ctx)
         {
             return ctx->getTimeout(SO_RCVTIMEO);
@@ -109,6 +124,25 @@ namespace CIM
         setOption(SOL_SOCKET, SO_RCVTIMEO, tv);
     }
 
+    int64_t Socket::getIdleTimeout()
+    {
+        FdCtx *ctx = FdMgr::GetInstance()->get(m_sock);
+        if (ctx)
+        {
+            return ctx->getIdleTimeout();
+        }
+        return -1;
+    }
+
+    void Socket::setIdleTimeout(int64_t v)
+    {
+        FdCtx *ctx = FdMgr::GetInstance()->get(m_sock);
+        if (ctx)
+        {
+            ctx->setIdleTimeout(v);
+        }
+    }
+
     bool Socket::getOption(int level, int option, void *result, socklen_t *len)
     {
         int rt = getsockopt(m_sock, level, option, result, (socklen_t *)len);
@@ -156,6 +190,45 @@ namespace CIM
         return nullptr;
     }
 
+    int Socket::tryAccept(sockaddr *addr, socklen_t *addrlen)
+    {
+        // accept4 未经过hook，监听socket在系统层面已是非阻塞，没有连接时直接返回EAGAIN
+        int fd = ::accept4(m_sock, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0)
+        {
+            FdMgr::GetInstance()->get(fd, true);
+        }
+        return fd;
+    }
+
+    Socket::ptr Socket::adopt(int fd)
+    {
+        Socket::ptr sock(new Socket(m_family, m_type, m_protocol));
+        if (sock->init(fd))
+        {
+            return sock;
+        }
+        if (!sock->isValid())
+        {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+
+    bool Socket::setReusePort()
+    {
+        if (!isValid())
+        {
+            newSock();
+            if (CIM_UNLIKELY(!isValid()))
+            {
+                return false;
+            }
+        }
+        int val = 1;
+        return setOption(SOL_SOCKET, SO_REUSEPORT, val);
+    }
+
     bool Socket::bind(const Address::ptr addr)
     {
         if (!isValid())
@@ -279,7 +352,7 @@ namespace CIM
     bool Socket::init(int sock)
     {
         // 在fd管理器中注册该套接字，方便统一管理
-        FdCtx::ptr ctx = FdMgr::GetInstance()->get(sock);
+        FdCtx *ctx = FdMgr::GetInstance()->get(sock);
         if (ctx && ctx->isSocket() && !ctx->isClose())
         {
             // 初始化成员变量
@@ -436,6 +509,29 @@ namespace CIM
         return -1;
     }
 
+    int64_t Socket::sendFile(int fd, off_t offset, size_t length)
+    {
+        if (!isConnected())
+        {
+            return -1;
+        }
+        size_t left = length;
+        while (left > 0)
+        {
+            ssize_t n = ::sendfile(m_sock, fd, &offset, left);
+            if (n < 0)
+            {
+                return -1;
+            }
+            if (n == 0)
+            {
+                break; // 文件已结束
+            }
+            left -= n;
+        }
+        return length - left;
+    }
+
     int Socket::sendTo(const void *buffer, size_t length, const Address::ptr to, int flags)
     {
         if (isConnected())
@@ -624,6 +720,24 @@ namespace CIM
 
         static _SSLInit s_init;
 
+        std::atomic<uint64_t> s_handshakes{0};
+        std::atomic<uint64_t> s_resumed{0};
+        std::atomic<uint64_t> s_ktls_send{0};
+        std::atomic<uint64_t> s_ktls_recv{0};
+
+        /// 客户端会话缓存：服务端地址 -> 最近一次收到的会话
+        struct ClientSessionCache
+        {
+            Mutex mutex;
+            std::unordered_map<std::string, std::shared_ptr<SSL_SESSION>> sessions;
+        };
+
+        ClientSessionCache &GetClientSessions()
+        {
+            static ClientSessionCache s_cache;
+            return s_cache;
+        }
+
     }
 
     SSLSocket::SSLSocket(int family, int type, int protocol)
@@ -649,6 +763,22 @@ namespace CIM
         return nullptr;
     }
 
+    Socket::ptr SSLSocket::adopt(int fd)
+    {
+        SSLSocket::ptr sock(new SSLSocket(m_family, m_type, m_protocol));
+        sock->m_ctx = m_ctx;
+        if (sock->init(fd))
+        {
+            return sock;
+        }
+        // 握手失败时fd已由sock持有，随sock析构关闭
+        if (!sock->isValid())
+        {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+
     bool SSLSocket::bind(const Address::ptr addr)
     {
         return Socket::bind(addr);
@@ -659,10 +789,47 @@ namespace CIM
         bool v = Socket::connect(addr, timeout_ms);
         if (v)
         {
-            m_ctx.reset(SSL_CTX_new(SSLv23_client_method()), SSL_CTX_free);
+            // 客户端共用一个上下文，不再每次连接创建；新会话经回调存入客户端会话缓存
+            static std::shared_ptr<SSL_CTX> s_client_ctx = []()
+            {
+                std::shared_ptr<SSL_CTX> ctx(SSL_CTX_new(TLS_client_method()), SSL_CTX_free);
+                SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+                SSL_CTX_sess_set_new_cb(ctx.get(), &SSLSocket::OnNewSession);
+                return ctx;
+            }();
+            if (!m_ctx)
+            {
+                m_ctx = s_client_ctx;
+            }
             m_ssl.reset(SSL_new(m_ctx.get()), SSL_free);
+            SSL_set_app_data(m_ssl.get(), this);
+            if (g_ssl_ktls->getValue())
+            {
+                SSL_set_options(m_ssl.get(), SSL_OP_ENABLE_KTLS);
+            }
             SSL_set_fd(m_ssl.get(), m_sock);
+            if (g_ssl_session_cache_size->getValue() && m_remoteAddress)
+            {
+                std::shared_ptr<SSL_SESSION> session;
+                {
+                    ClientSessionCache &cache = GetClientSessions();
+                    Mutex::Lock lock(cache.mutex);
+                    auto it = cache.sessions.find(m_remoteAddress->toString());
+                    if (it != cache.sessions.end())
+                    {
+                        session = it->second;
+                    }
+                }
+                if (session)
+                {
+                    SSL_set_session(m_ssl.get(), session.get());
+                }
+            }
             v = (SSL_connect(m_ssl.get()) == 1);
+            if (v)
+            {
+                onHandshake();
+            }
         }
         return v;
     }
@@ -674,16 +841,27 @@ namespace CIM
 
     bool SSLSocket::close()
     {
+        if (m_ssl && SSL_is_init_finished(m_ssl.get()))
+        {
+            // 与之前一样不发送close_notify，只把连接标记为正常关闭，
+            // 否则OpenSSL释放SSL时会把会话移出服务端缓存
+            SSL_set_quiet_shutdown(m_ssl.get(), 1);
+            SSL_shutdown(m_ssl.get());
+        }
         return Socket::close();
     }
 
     int SSLSocket::send(const void *buffer, size_t length, int flags)
     {
-        if (m_ssl)
+        if (!m_ssl)
         {
-            return SSL_write(m_ssl.get(), buffer, length);
+            return -1;
         }
-        return -1;
+        if (m_ktlsSend)
+        {
+            return Socket::send(buffer, length, flags);
+        }
+        return SSL_write(m_ssl.get(), buffer, length);
     }
 
     int SSLSocket::send(const iovec *buffers, size_t length, int flags)
@@ -692,23 +870,109 @@ namespace CIM
         {
             return -1;
         }
+        if (m_ktlsSend)
+        {
+            // 内核按记录切分加密，一次sendmsg即可
+            return Socket::send(buffers, length, flags);
+        }
+
+        // 未开启部分写时SSL_write要么写完要么失败；小片段拼到一条记录里再写，
+        // 达到ssl.write_coalesce的片段直接写，不拷贝
+        size_t limit = g_ssl_write_coalesce->getValue();
+        std::string pending;
         int total = 0;
+        auto flush = [&]() -> int
+        {
+            if (pending.empty())
+            {
+                return 1;
+            }
+            int rt = SSL_write(m_ssl.get(), pending.data(), pending.size());
+            if (rt > 0)
+            {
+                total += rt;
+                pending.clear();
+            }
+            return rt;
+        };
         for (size_t i = 0; i < length; ++i)
         {
-            int tmp = SSL_write(m_ssl.get(), buffers[i].iov_base, buffers[i].iov_len);
-            if (tmp <= 0)
+            const char *data = (const char *)buffers[i].iov_base;
+            size_t len = buffers[i].iov_len;
+            if (len == 0)
             {
-                return tmp;
+                continue;
             }
-            total += tmp;
-            if (tmp != (int)buffers[i].iov_len)
+            if (len < limit)
             {
-                break;
+                if (pending.size() + len > limit)
+                {
+                    int rt = flush();
+                    if (rt <= 0)
+                    {
+                        return total ? total : rt;
+                    }
+                }
+                if (pending.empty())
+                {
+                    pending.reserve(limit);
+                }
+                pending.append(data, len);
+                continue;
+            }
+            int rt = flush();
+            if (rt <= 0)
+            {
+                return total ? total : rt;
             }
+            rt = SSL_write(m_ssl.get(), data, len);
+            if (rt <= 0)
+            {
+                return total ? total : rt;
+            }
+            total += rt;
+        }
+        int rt = flush();
+        if (rt <= 0)
+        {
+            return total ? total : rt;
         }
         return total;
     }
 
+    int64_t SSLSocket::sendFile(int fd, off_t offset, size_t length)
+    {
+        if (!m_ssl)
+        {
+            return -1;
+        }
+        if (m_ktlsSend)
+        {
+            return Socket::sendFile(fd, offset, length);
+        }
+        std::vector<char> buf(std::min(length, (size_t)64 * 1024));
+        size_t left = length;
+        while (left > 0)
+        {
+            ssize_t n = ::pread(fd, &buf[0], std::min(left, buf.size()), offset);
+            if (n < 0)
+            {
+                return -1;
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            if (SSL_write(m_ssl.get(), &buf[0], n) <= 0)
+            {
+                return -1;
+            }
+            offset += n;
+            left -= n;
+        }
+        return length - left;
+    }
+
     int SSLSocket::sendTo(const void *buffer, size_t length, const Address::ptr to, int flags)
     {
         CIM_ASSERT(false);
@@ -723,11 +987,20 @@ namespace CIM
 
     int SSLSocket::recv(void *buffer, size_t length, int flags)
     {
-        if (m_ssl)
+        if (!m_ssl)
         {
-            return SSL_read(m_ssl.get(), buffer, length);
+            return -1;
         }
-        return -1;
+        if (m_ktlsRecv && !SSL_has_pending(m_ssl.get()))
+        {
+            int rt = Socket::recv(buffer, length, flags);
+            // 告警、KeyUpdate、NewSessionTicket等非应用数据记录内核以EIO拒绝，交给OpenSSL处理
+            if (rt >= 0 || errno != EIO)
+            {
+                return rt;
+            }
+        }
+        return SSL_read(m_ssl.get(), buffer, length);
     }
 
     int SSLSocket::recv(iovec *buffers, size_t length, int flags)
@@ -736,6 +1009,14 @@ namespace CIM
         {
             return -1;
         }
+        if (m_ktlsRecv && !SSL_has_pending(m_ssl.get()))
+        {
+            int rt = Socket::recv(buffers, length, flags);
+            if (rt >= 0 || errno != EIO)
+            {
+                return rt;
+            }
+        }
         int total = 0;
         for (size_t i = 0; i < length; ++i)
         {
@@ -771,12 +1052,75 @@ namespace CIM
         if (v)
         {
             m_ssl.reset(SSL_new(m_ctx.get()), SSL_free);
+            if (g_ssl_ktls->getValue())
+            {
+                SSL_set_options(m_ssl.get(), SSL_OP_ENABLE_KTLS);
+            }
             SSL_set_fd(m_ssl.get(), m_sock);
             v = (SSL_accept(m_ssl.get()) == 1);
+            if (v)
+            {
+                onHandshake();
+            }
         }
         return v;
     }
 
+    void SSLSocket::onHandshake()
+    {
+        // OpenSSL在握手完成时尝试为两个方向安装kTLS，内核或密码套件不支持时保持用户态加解密
+        m_ktlsSend = BIO_get_ktls_send(SSL_get_wbio(m_ssl.get())) > 0;
+        m_ktlsRecv = BIO_get_ktls_recv(SSL_get_rbio(m_ssl.get())) > 0;
+        s_handshakes.fetch_add(1, std::memory_order_relaxed);
+        if (SSL_session_reused(m_ssl.get()))
+        {
+            s_resumed.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_ktlsSend)
+        {
+            s_ktls_send.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_ktlsRecv)
+        {
+            s_ktls_recv.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    int SSLSocket::OnNewSession(SSL *ssl, SSL_SESSION *session)
+    {
+        SSLSocket *sock = (SSLSocket *)SSL_get_app_data(ssl);
+        uint32_t limit = g_ssl_session_cache_size->getValue();
+        if (!sock || !sock->m_remoteAddress || !limit)
+        {
+            return 0;
+        }
+        std::string key = sock->m_remoteAddress->toString();
+        ClientSessionCache &cache = GetClientSessions();
+        Mutex::Lock lock(cache.mutex);
+        if (cache.sessions.size() >= limit && !cache.sessions.count(key))
+        {
+            cache.sessions.erase(cache.sessions.begin());
+        }
+        // 返回1表示接管session的引用
+        cache.sessions[key].reset(session, SSL_SESSION_free);
+        return 1;
+    }
+
+    bool SSLSocket::isSessionReused() const
+    {
+        return m_ssl && SSL_session_reused(m_ssl.get());
+    }
+
+    SSLSocket::Stats SSLSocket::GetStats()
+    {
+        Stats stats;
+        stats.handshakes = s_handshakes.load(std::memory_order_relaxed);
+        stats.resumed = s_resumed.load(std::memory_order_relaxed);
+        stats.ktlsSend = s_ktls_send.load(std::memory_order_relaxed);
+        stats.ktlsRecv = s_ktls_recv.load(std::memory_order_relaxed);
+        return stats;
+    }
+
     bool SSLSocket::loadCertificates(const std::string &cert_file, const std::string &key_file)
     {
         m_ctx.reset(SSL_CTX_new(SSLv23_server_method()), SSL_CTX_free);
@@ -798,6 +1142,30 @@ namespace CIM
                                       << cert_file << " key_file=" << key_file;
             return false;
         }
+
+        // 会话复用：TLS1.2按会话ID查服务端缓存，ticket由客户端保存、服务端无状态解密；
+        // TLS1.3关闭ticket时改为有状态ticket，仍依赖服务端缓存
+        uint32_t cache_size = g_ssl_session_cache_size->getValue();
+        if (cache_size)
+        {
+            static const unsigned char s_sid_ctx[] = "CIM";
+            SSL_CTX_set_session_cache_mode(m_ctx.get(), SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(m_ctx.get(), cache_size);
+            SSL_CTX_set_session_id_context(m_ctx.get(), s_sid_ctx, sizeof(s_sid_ctx) - 1);
+        }
+        else
+        {
+            SSL_CTX_set_session_cache_mode(m_ctx.get(), SSL_SESS_CACHE_OFF);
+        }
+        SSL_CTX_set_timeout(m_ctx.get(), g_ssl_session_timeout->getValue());
+        if (!g_ssl_session_tickets->getValue())
+        {
+            SSL_CTX_set_options(m_ctx.get(), SSL_OP_NO_TICKET);
+            if (!cache_size)
+            {
+                SSL_CTX_set_num_tickets(m_ctx.get(), 0);
+            }
+        }
         return true;
     }
 
@@ -68,4 +68,23 @@ namespace CIM
         }
         return length;
     }
+
+    int Stream::writev(const std::vector<BufferSlice> &slices, bool more)
+    {
+        int total = 0;
+        for (auto &i : slices)
+        {
+            if (!i.size)
+            {
+                continue;
+            }
+            int rt = writeFixSize(i.data, i.size);
+            if (rt <= 0)
+            {
+                return rt;
+            }
+            total += rt;
+        }
+        return total;
+    }
 }
\ No newline at end of file
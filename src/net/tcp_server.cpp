@@ -1,6 +1,9 @@
 #include "tcp_server.hpp"
 #include "config.hpp"
 #include "macro.hpp"
+#include "util.hpp"
+#include "fd_manager.hpp"
+#include <linux/filter.h>
 
 namespace CIM
 {
@@ -11,6 +14,28 @@ namespace CIM
         CIM::Config::Lookup("tcp_server.read_timeout", (uint64_t)(60 * 1000 * 2),
                               "tcp server read timeout");
 
+    // io_worker 积压时接收循环的休眠间隔
+    static auto g_tcp_server_accept_pause_interval =
+        CIM::Config::Lookup("tcp_server.accept_pause_interval", (uint32_t)10,
+                              "tcp server accept pause interval(ms) when io_worker is backlogged");
+
+    /**
+     * @brief 已放行连接的名额持有者
+     * @details handleClient拿到的Socket::ptr与它共享引用计数，
+     * 连接的最后一个引用释放时归还名额；handleClient返回后仍被持有的连接（如rock会话）继续占用名额
+     */
+    struct TcpServer::ConnectionRef
+    {
+        Socket::ptr sock;
+        TcpServer::ptr server;
+        std::string ip;
+
+        ~ConnectionRef()
+        {
+            server->releaseConnection(ip);
+        }
+    };
+
     TcpServer::TcpServer(CIM::IOManager *worker,
                          CIM::IOManager *io_worker,
                          CIM::IOManager *accept_worker)
@@ -48,36 +73,74 @@ namespace CIM
     bool TcpServer::bind(const std::vector<Address::ptr> &addrs, std::vector<Address::ptr> &fails, bool ssl)
     {
         m_ssl = ssl;
+        std::vector<pid_t> threads;
+        if (m_reusePort && m_ioWorker)
+        {
+            threads = m_ioWorker->getThreadIds();
+        }
         for (auto &addr : addrs)
         {
-            // 根据是否启用ssl加密创建 Socket
-            Socket::ptr sock = ssl ? SSLSocket::CreateTCP(addr) : Socket::CreateTCP(addr);
+            // reuseport模式下每个io线程一个监听socket；Unix域地址bind时会删除已有的路径，不能共享
+            bool reuse = !threads.empty() && !std::dynamic_pointer_cast<UnixAddress>(addr);
+            size_t count = reuse ? threads.size() : 1;
+            std::vector<Socket::ptr> group;
+            for (size_t i = 0; i < count; ++i)
+            {
+                // 根据是否启用ssl加密创建 Socket
+                Socket::ptr sock = ssl ? SSLSocket::CreateTCP(addr) : Socket::CreateTCP(addr);
 
-            // 绑定地址
-            if (!sock->bind(addr))
+                // SO_REUSEPORT 必须在 bind 之前设置
+                if (reuse && !sock->setReusePort())
+                {
+                    CIM_LOG_ERROR(g_logger) << "SO_REUSEPORT fail errno="
+                                              << errno << " errstr=" << strerror(errno)
+                                              << " addr=[" << addr->toString() << "]";
+                    break;
+                }
+
+                // 绑定地址
+                if (!sock->bind(addr))
+                {
+                    CIM_LOG_ERROR(g_logger) << "bind fail errno="
+                                              << errno << " errstr=" << strerror(errno)
+                                              << " addr=[" << addr->toString() << "]";
+                    break;
+                }
+
+                // 开启监听
+                if (!sock->listen())
+                {
+                    CIM_LOG_ERROR(g_logger) << "listen fail errno="
+                                              << errno << " errstr=" << strerror(errno)
+                                              << " addr=[" << addr->toString() << "]";
+                    break;
+                }
+                group.push_back(sock);
+            }
+            if (group.size() != count)
             {
-                CIM_LOG_ERROR(g_logger) << "bind fail errno="
-                                          << errno << " errstr=" << strerror(errno)
-                                          << " addr=[" << addr->toString() << "]";
                 fails.push_back(addr);
                 continue;
             }
 
-            // 开启监听
-            if (!sock->listen())
+            for (size_t i = 0; i < count; ++i)
             {
-                CIM_LOG_ERROR(g_logger) << "listen fail errno="
-                                          << errno << " errstr=" << strerror(errno)
-                                          << " addr=[" << addr->toString() << "]";
-                fails.push_back(addr);
-                continue;
+                m_socks.push_back(group[i]);
+                if (m_reusePort)
+                {
+                    m_reuseSocks.push_back(reuse);
+                }
+            }
+            if (reuse)
+            {
+                steerReusePort(group);
             }
-            m_socks.push_back(sock);
         }
 
         if (!fails.empty())
         {
             m_socks.clear();
+            m_reuseSocks.clear();
             return false;
         }
 
@@ -99,32 +162,243 @@ namespace CIM
         }
         m_isRun = true;
 
-        for (auto &sock : m_socks)
+        for (size_t i = 0; i < m_socks.size(); ++i)
         {
-            m_acceptWorker->schedule(std::bind(&TcpServer::startAccept,
-                                               shared_from_this(), sock));
+            if (!m_reuseSocks.empty() && m_reuseSocks[i])
+            {
+                // reuseport：每个监听socket一个排空循环，直接运行在io_worker上
+                m_ioWorker->schedule(std::bind(&TcpServer::startAccept,
+                                               shared_from_this(), m_socks[i]));
+            }
+            else
+            {
+                m_acceptWorker->schedule(std::bind(&TcpServer::startAccept,
+                                                   shared_from_this(), m_socks[i]));
+            }
         }
         return true;
     }
 
+    void TcpServer::initClient(Socket::ptr client)
+    {
+        // 设置读超时时间；截止时间模式下读等待不再逐次创建定时器
+        if (m_idleDeadline)
+        {
+            client->setIdleTimeout(m_recvTimeout);
+        }
+        else
+        {
+            client->setRecvTimeout(m_recvTimeout);
+        }
+    }
+
     void TcpServer::startAccept(Socket::ptr sock)
     {
+        // 监听socket可能创建于未启用hook的线程，登记到FdManager使其在系统层面非阻塞，否则accept4会阻塞整个线程
+        FdMgr::GetInstance()->get(sock->getSocket(), true);
+        IOManager *iom = IOManager::GetThis();
         while (m_isRun)
         {
-            // 接受新连接
-            Socket::ptr client_fd = sock->accept();
-            if (client_fd)
+            // io_worker积压时暂停接收，新连接留在内核的监听队列中，由backlog向客户端施加背压
+            if (m_acceptPauseQueue && m_ioWorker->getQueuedTaskCount() > m_acceptPauseQueue)
             {
-                // 设置读超时时间
-                client_fd->setRecvTimeout(m_recvTimeout);
-                m_ioWorker->schedule(std::bind(&TcpServer::handleClient,
-                                               shared_from_this(), client_fd));
+                m_acceptPaused.fetch_add(1, std::memory_order_relaxed);
+                usleep(g_tcp_server_accept_pause_interval->getValue() * 1000);
+                continue;
             }
-            else
+
+            uint32_t n = 0;
+            int fd = -1;
+            while (n < m_acceptBatch)
             {
-                CIM_LOG_ERROR(g_logger) << "accept errno=" << errno
+                sockaddr_storage addr;
+                socklen_t len = sizeof(addr);
+                fd = sock->tryAccept((sockaddr *)&addr, &len);
+                if (fd < 0)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED)
+                    {
+                        continue;
+                    }
+                    break;
+                }
+                ++n;
+
+                // 只在开启单IP上限时提取来源地址，按原始字节做键
+                std::string ip;
+                if (m_maxConnectionsPerIp)
+                {
+                    if (addr.ss_family == AF_INET)
+                    {
+                        ip.assign((const char *)&((sockaddr_in *)&addr)->sin_addr, sizeof(in_addr));
+                    }
+                    else if (addr.ss_family == AF_INET6)
+                    {
+                        ip.assign((const char *)&((sockaddr_in6 *)&addr)->sin6_addr, sizeof(in6_addr));
+                    }
+                }
+                if (!admitConnection(ip))
+                {
+                    // 超过上限：RST关闭，不进入握手与业务处理
+                    linger lg = {1, 0};
+                    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                    FdMgr::GetInstance()->del(fd);
+                    ::close(fd);
+                    continue;
+                }
+                // 握手和读超时设置放到连接自己的协程里，不阻塞排空；
+                // 工作窃取模式下从工作线程调度的任务进入本线程的本地队列
+                m_ioWorker->schedule(std::bind(&TcpServer::handleAccepted,
+                                               shared_from_this(), sock, fd, ip));
+            }
+
+            if (fd >= 0)
+            {
+                // 本批已满，让出线程后继续排空
+                Coroutine::YieldToReady();
+                continue;
+            }
+            if (errno != EAGAIN)
+            {
+                if (errno == EBADF || errno == EINVAL)
+                {
+                    // 监听socket已关闭
+                    break;
+                }
+                // EMFILE/ENFILE 等：稍后重试，避免空转
+                CIM_LOG_ERROR(g_logger) << "accept4 errno=" << errno
                                           << " errstr=" << strerror(errno);
+                usleep(10 * 1000);
+                continue;
             }
+
+            // 监听队列已排空，等待下一批连接
+            if (!iom->addEvent(sock->getSocket(), IOManager::READ))
+            {
+                CIM_LOG_ERROR(g_logger) << "accept addEvent fail sock=" << sock->getSocket();
+                break;
+            }
+            Coroutine::YieldToHold();
+        }
+    }
+
+    void TcpServer::handleAccepted(Socket::ptr sock, int fd, const std::string &ip)
+    {
+        Socket::ptr client = sock->adopt(fd);
+        if (!client)
+        {
+            CIM_LOG_ERROR(g_logger) << "adopt fd=" << fd << " fail";
+            releaseConnection(ip);
+            return;
+        }
+        std::shared_ptr<ConnectionRef> ref(new ConnectionRef);
+        ref->sock = client;
+        ref->server = shared_from_this();
+        ref->ip = ip;
+        // 与ref共享引用计数的别名指针：连接的所有副本释放后才归还名额
+        Socket::ptr tracked(ref, client.get());
+        initClient(tracked);
+        handleClient(tracked);
+    }
+
+    bool TcpServer::admitConnection(const std::string &ip)
+    {
+        int64_t active = m_activeConnections.fetch_add(1, std::memory_order_relaxed);
+        if (m_maxConnections && active >= (int64_t)m_maxConnections)
+        {
+            m_activeConnections.fetch_sub(1, std::memory_order_relaxed);
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!ip.empty())
+        {
+            Mutex::Lock lock(m_ipMutex);
+            uint32_t &count = m_ipConnections[ip];
+            if (count >= m_maxConnectionsPerIp)
+            {
+                lock.unlock();
+                m_activeConnections.fetch_sub(1, std::memory_order_relaxed);
+                m_rejectedIp.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            ++count;
+        }
+        m_accepted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void TcpServer::releaseConnection(const std::string &ip)
+    {
+        if (!ip.empty())
+        {
+            Mutex::Lock lock(m_ipMutex);
+            auto it = m_ipConnections.find(ip);
+            if (it != m_ipConnections.end() && --it->second == 0)
+            {
+                m_ipConnections.erase(it);
+            }
+        }
+        m_activeConnections.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void TcpServer::steerReusePort(const std::vector<Socket::ptr> &socks)
+    {
+        if (m_steering == "none" || socks.size() < 2)
+        {
+            return;
+        }
+        if (m_steering != "cpu" && m_steering != "cbpf")
+        {
+            CIM_LOG_WARN(g_logger) << "unknown reuseport_steering=" << m_steering;
+            return;
+        }
+        // 线程可以迁移时最近运行的CPU没有意义，分发退回内核哈希
+        if (!m_ioWorker->getAffinity().pin)
+        {
+            CIM_LOG_WARN(g_logger) << "reuseport_steering=" << m_steering
+                                   << " needs pinned io_worker threads, fall back to hash";
+            return;
+        }
+        const std::vector<pid_t> &threads = m_ioWorker->getThreadIds();
+        std::vector<int> cpus;
+        for (size_t i = 0; i < socks.size(); ++i)
+        {
+            cpus.push_back(GetThreadCpu(threads[i]));
+        }
+
+        if (m_steering == "cpu")
+        {
+            for (size_t i = 0; i < socks.size(); ++i)
+            {
+                if (cpus[i] < 0 || !socks[i]->setOption(SOL_SOCKET, SO_INCOMING_CPU, cpus[i]))
+                {
+                    CIM_LOG_WARN(g_logger) << "SO_INCOMING_CPU fail cpu=" << cpus[i]
+                                           << " sock=" << socks[i]->getSocket();
+                }
+            }
+            return;
+        }
+
+        // 收包CPU等于第i个线程的CPU时选第i个监听socket，其余按CPU取模；
+        // 组内下标即listen的顺序，返回值越界时内核退回哈希
+        std::vector<sock_filter> code;
+        code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)));
+        for (size_t i = 0; i < socks.size(); ++i)
+        {
+            if (cpus[i] >= 0)
+            {
+                code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)cpus[i], 0, 1));
+                code.push_back(BPF_STMT(BPF_RET | BPF_K, (uint32_t)i));
+            }
+        }
+        code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)socks.size()));
+        code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+        sock_fprog prog;
+        prog.len = code.size();
+        prog.filter = &code[0];
+        if (!socks[0]->setOption(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, prog))
+        {
+            CIM_LOG_WARN(g_logger) << "SO_ATTACH_REUSEPORT_CBPF fail sock=" << socks[0]->getSocket();
         }
     }
 
@@ -143,7 +417,8 @@ namespace CIM
             sock->cancelAll();
             sock->close();
         }
-        m_socks.clear(); });
+        m_socks.clear();
+        m_reuseSocks.clear(); });
     }
 
     uint64_t TcpServer::getRecvTimeout() const
@@ -151,6 +426,54 @@ namespace CIM
         return m_recvTimeout;
     }
 
+    bool TcpServer::isIdleDeadline() const
+    {
+        return m_idleDeadline;
+    }
+
+    void TcpServer::setIdleDeadline(bool v)
+    {
+        m_idleDeadline = v;
+    }
+
+    void TcpServer::setReusePort(bool v, const std::string &steering)
+    {
+        m_reusePort = v;
+        m_steering = steering;
+    }
+
+    bool TcpServer::isReusePort() const
+    {
+        return m_reusePort;
+    }
+
+    void TcpServer::setConnectionLimits(uint32_t max, uint32_t per_ip)
+    {
+        m_maxConnections = max;
+        m_maxConnectionsPerIp = per_ip;
+    }
+
+    void TcpServer::setAcceptBatch(uint32_t v)
+    {
+        m_acceptBatch = v ? v : 1;
+    }
+
+    void TcpServer::setAcceptPauseQueue(uint32_t v)
+    {
+        m_acceptPauseQueue = v;
+    }
+
+    TcpServer::AcceptStats TcpServer::getAcceptStats() const
+    {
+        AcceptStats stats;
+        stats.accepted = m_accepted.load(std::memory_order_relaxed);
+        stats.rejected = m_rejected.load(std::memory_order_relaxed);
+        stats.rejectedIp = m_rejectedIp.load(std::memory_order_relaxed);
+        stats.paused = m_acceptPaused.load(std::memory_order_relaxed);
+        stats.active = m_activeConnections.load(std::memory_order_relaxed);
+        return stats;
+    }
+
     std::string TcpServer::getName() const
     {
         return m_name;
@@ -183,15 +506,23 @@ namespace CIM
 
     bool TcpServer::loadCertificates(const std::string &cert_file, const std::string &key_file)
     {
+        // 所有监听socket共用一个SSL上下文，reuseport下不同线程接收的连接也能复用彼此的会话
+        std::shared_ptr<SSL_CTX> ctx;
         for (auto &i : m_socks)
         {
             auto ssl_socket = std::dynamic_pointer_cast<SSLSocket>(i);
             if (ssl_socket)
             {
+                if (ctx)
+                {
+                    ssl_socket->setContext(ctx);
+                    continue;
+                }
                 if (!ssl_socket->loadCertificates(cert_file, key_file))
                 {
                     return false;
                 }
+                ctx = ssl_socket->getContext();
             }
         }
         return true;
@@ -204,7 +535,13 @@ namespace CIM
            << " name=" << m_name << " ssl=" << m_ssl
            << " worker=" << (m_worker ? m_worker->getName() : "")
            << " accept=" << (m_acceptWorker ? m_acceptWorker->getName() : "")
-           << " recv_timeout=" << m_recvTimeout << "]" << std::endl;
+           << " recv_timeout=" << m_recvTimeout
+           << " timeout_mode=" << (m_idleDeadline ? "deadline" : "timer")
+           << " reuseport=" << (m_reusePort ? m_steering : "off")
+           << " max_connections=" << m_maxConnections
+           << " max_connections_per_ip=" << m_maxConnectionsPerIp
+           << " accept_batch=" << m_acceptBatch
+           << " accept_pause_queue=" << m_acceptPauseQueue << "]" << std::endl;
         std::string pfx = prefix.empty() ? "    " : prefix;
         for (auto &i : m_socks)
         {
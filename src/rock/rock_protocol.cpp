@@ -316,15 +316,20 @@ namespace CIM
             header.length = ba->getDataSize();
         }
         header.length = ntoh(header.length);
-        if (stream->writeFixSize(&header, sizeof(header)) <= 0)
+
+        // 报文头与ByteArray的各个内存块一次写出，内存块由ba持有到发送完成
+        std::vector<iovec> iovs;
+        ba->getReadBuffers(iovs, ba->getReadSize());
+        std::vector<BufferSlice> slices;
+        slices.push_back(BufferSlice(&header, sizeof(header)));
+        for (auto &i : iovs)
         {
-            CIM_LOG_ERROR(g_logger) << "RockMessageDecoder serializeTo write header fail";
-            return -3;
+            slices.push_back(BufferSlice(i.iov_base, i.iov_len, ba));
         }
-        if (stream->writeFixSize(ba, ba->getReadSize()) <= 0)
+        if (stream->writev(slices) <= 0)
         {
-            CIM_LOG_ERROR(g_logger) << "RockMessageDecoder serializeTo write body fail";
-            return -4;
+            CIM_LOG_ERROR(g_logger) << "RockMessageDecoder serializeTo write fail";
+            return -3;
         }
         return sizeof(header) + ba->getDataSize();
     }
@@ -1,8 +1,47 @@
 #include "socket_stream.hpp"
+#include "config.hpp"
+#include "hook.hpp"
+#include "time_util.hpp"
 #include "util.hpp"
+#include <limits.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
 
 namespace CIM
 {
+    static auto g_logger = CIM_LOG_NAME("system");
+
+    // 达到该长度的writev使用MSG_ZEROCOPY，0表示关闭；页引用和完成通知的开销只在大块数据上划算
+    static auto g_zerocopy_threshold =
+        Config::Lookup("socket_stream.zerocopy_threshold", (uint64_t)(64 * 1024),
+                       "socket stream MSG_ZEROCOPY threshold(bytes), 0 disables");
+
+    // 每个连接未确认完成的零拷贝字节数上限，超过后按普通发送处理，避免长期占住片段内存和optmem
+    static auto g_zerocopy_max_pending =
+        Config::Lookup("socket_stream.zerocopy_max_pending", (uint64_t)(16 * 1024 * 1024),
+                       "socket stream max pending MSG_ZEROCOPY bytes per connection");
+
+    // 关闭或析构时等待零拷贝完成通知的上限，超时后未完成的片段交给定时器延后释放
+    static auto g_zerocopy_close_wait =
+        Config::Lookup("socket_stream.zerocopy_close_wait", (uint64_t)100,
+                       "socket stream max wait(ms) for MSG_ZEROCOPY completions on close");
+
+    // 超时仍未完成的零拷贝片段再保留的时长，期间内核通常已发完或连接已重置
+    static const uint64_t kZeroCopyLingerMS = 30000;
+
     SocketStream::SocketStream(Socket::ptr sock, bool owner)
         : m_socket(sock),
           m_owner(owner)
@@ -11,6 +50,7 @@ namespace CIM
 
     SocketStream::~SocketStream()
     {
+        releaseZeroCopy();
         if (m_owner && m_socket)
         {
             m_socket->close();
@@ -75,8 +115,234 @@ namespace CIM
         return rt;
     }
 
+    int SocketStream::writev(const std::vector<BufferSlice> &slices, bool more)
+    {
+        if (!isConnected())
+        {
+            return -1;
+        }
+
+        std::vector<iovec> iovs;
+        iovs.reserve(slices.size());
+        size_t total = 0;
+        size_t unowned = 0;
+        for (auto &i : slices)
+        {
+            if (!i.size)
+            {
+                continue;
+            }
+            iovec iov;
+            iov.iov_base = (void *)i.data;
+            iov.iov_len = i.size;
+            iovs.push_back(iov);
+            total += i.size;
+            if (!i.owner)
+            {
+                unowned += i.size;
+            }
+        }
+        // 先回收已完成的零拷贝发送，空的writev也可用于回收
+        if (!m_zeroCopyPending.empty())
+        {
+            reapZeroCopy();
+        }
+        if (iovs.empty())
+        {
+            return 0;
+        }
+
+        // 是否零拷贝：只有普通TCP连接开启SO_ZEROCOPY后才有完成通知
+        bool zerocopy = false;
+        uint64_t threshold = g_zerocopy_threshold->getValue();
+        if (threshold && total - unowned >= threshold && m_zeroCopy >= 0 &&
+            m_zeroCopyBytes + total <= g_zerocopy_max_pending->getValue())
+        {
+            if (m_zeroCopy == 0)
+            {
+                int family = m_socket->getFamily();
+                bool tcp = (family == AF_INET || family == AF_INET6) && m_socket->getType() == SOCK_STREAM &&
+                           !std::dynamic_pointer_cast<SSLSocket>(m_socket);
+                m_zeroCopy = tcp && m_socket->setOption(SOL_SOCKET, SO_ZEROCOPY, 1) ? 1 : -1;
+            }
+            zerocopy = m_zeroCopy > 0;
+        }
+
+        ZeroCopyPending pending;
+        if (zerocopy)
+        {
+            // 没有owner的片段(通常是报文头)很小，拷贝一份交给pending持有
+            std::shared_ptr<std::string> holder;
+            if (unowned)
+            {
+                holder = std::make_shared<std::string>();
+                holder->reserve(unowned);
+            }
+            size_t n = 0;
+            for (auto &i : slices)
+            {
+                if (!i.size)
+                {
+                    continue;
+                }
+                if (i.owner)
+                {
+                    pending.owners.push_back(i.owner);
+                }
+                else
+                {
+                    iovs[n].iov_base = &(*holder)[holder->size()];
+                    holder->append((const char *)i.data, i.size);
+                }
+                ++n;
+            }
+            if (holder)
+            {
+                pending.owners.push_back(holder);
+            }
+        }
+
+        int flags = more ? MSG_MORE : 0;
+        size_t idx = 0;
+        size_t sent = 0;
+        int rt = 0;
+        bool issued = false;
+        while (idx < iovs.size())
+        {
+            size_t count = std::min(iovs.size() - idx, (size_t)IOV_MAX);
+            rt = m_socket->send(&iovs[idx], count, zerocopy ? flags | MSG_ZEROCOPY : flags);
+            if (rt < 0 && zerocopy && errno == ENOBUFS)
+            {
+                // optmem不足以记录更多零拷贝发送，剩余部分按普通发送处理
+                zerocopy = false;
+                continue;
+            }
+            if (rt <= 0)
+            {
+                break;
+            }
+            if (zerocopy)
+            {
+                ++m_zeroCopyId;
+                issued = true;
+            }
+            sent += rt;
+            size_t left = rt;
+            while (idx < iovs.size() && left >= iovs[idx].iov_len)
+            {
+                left -= iovs[idx].iov_len;
+                ++idx;
+            }
+            if (left)
+            {
+                iovs[idx].iov_base = (char *)iovs[idx].iov_base + left;
+                iovs[idx].iov_len -= left;
+            }
+        }
+
+        if (issued)
+        {
+            // 出错时已零拷贝发出的部分同样要等完成通知才能释放
+            pending.id = m_zeroCopyId - 1;
+            pending.bytes = sent;
+            m_zeroCopyBytes += sent;
+            m_zeroCopyPending.push_back(std::move(pending));
+        }
+        return idx < iovs.size() ? rt : (int)sent;
+    }
+
+    void SocketStream::reapZeroCopy()
+    {
+        char control[128];
+        while (!m_zeroCopyPending.empty())
+        {
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            // 直接调用原始函数：错误队列为空时立即返回，不能挂起协程等待可读
+            int rt = recvmsg_f(m_socket->getSocket(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+            if (rt < 0)
+            {
+                break;
+            }
+            for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+            {
+                if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                      (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                {
+                    continue;
+                }
+                sock_extended_err *err = (sock_extended_err *)CMSG_DATA(cm);
+                if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                {
+                    continue;
+                }
+                // [ee_info, ee_data] 为已完成的发送序号区间，TCP按序完成
+                uint32_t hi = err->ee_data;
+                while (!m_zeroCopyPending.empty() && (int32_t)(m_zeroCopyPending.front().id - hi) <= 0)
+                {
+                    m_zeroCopyBytes -= m_zeroCopyPending.front().bytes;
+                    m_zeroCopyPending.pop_front();
+                }
+                if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                {
+                    // 内核退化为拷贝，继续零拷贝只会多出页引用与通知的开销
+                    m_zeroCopy = -1;
+                }
+            }
+        }
+    }
+
+    size_t SocketStream::getZeroCopyPending() const
+    {
+        return m_zeroCopyBytes;
+    }
+
+    void SocketStream::releaseZeroCopy()
+    {
+        if (m_zeroCopyPending.empty())
+        {
+            return;
+        }
+        // 内核确认完成前网卡仍可能读取这些页面，提前释放会让复用内存的数据被发出去
+        uint64_t wait = g_zerocopy_close_wait->getValue();
+        uint64_t start = TimeUtil::NowToMS();
+        while (m_socket && m_socket->isValid())
+        {
+            reapZeroCopy();
+            if (m_zeroCopyPending.empty() || TimeUtil::NowToMS() - start >= wait)
+            {
+                break;
+            }
+            // hook的usleep在协程中挂起而不阻塞线程
+            usleep(1000);
+        }
+        if (m_zeroCopyPending.empty())
+        {
+            return;
+        }
+
+        std::shared_ptr<std::deque<ZeroCopyPending>> pending =
+            std::make_shared<std::deque<ZeroCopyPending>>(std::move(m_zeroCopyPending));
+        m_zeroCopyPending.clear();
+        m_zeroCopyBytes = 0;
+        IOManager *iom = IOManager::GetThis();
+        if (iom)
+        {
+            // 片段由定时器持有，生命周期不再依赖本对象
+            iom->addTimer(kZeroCopyLingerMS, [pending]() {});
+        }
+        else
+        {
+            CIM_LOG_WARN(g_logger) << "SocketStream release " << pending->size()
+                                   << " unfinished zerocopy sends without IOManager";
+        }
+    }
+
     void SocketStream::close()
     {
+        releaseZeroCopy();
         if (m_socket)
         {
             m_socket->close();
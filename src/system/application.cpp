@@ -379,6 +379,9 @@ namespace CIM
                 server->setName(i.name);
             }
 
+            // reuseport模式需要在bind时为每个io线程打开监听socket
+            server->setReusePort(i.reuseport, i.reuseport_steering);
+
             // 绑定服务器地址
             std::vector<Address::ptr> fails;
             if (!server->bind(address, fails, i.ssl))
@@ -401,6 +404,15 @@ namespace CIM
                 }
             }
 
+            // 读超时及其模式
+            server->setRecvTimeout(i.timeout);
+            server->setIdleDeadline(i.timeout_mode == "deadline");
+
+            // 批量接收与连接数上限
+            server->setConnectionLimits(i.max_connections, i.max_connections_per_ip);
+            server->setAcceptBatch(i.accept_batch);
+            server->setAcceptPauseQueue(i.accept_pause_queue);
+
             // 设置服务器配置并添加到服务器列表
             server->setConf(i);
             m_servers[i.type].push_back(server);
@@ -0,0 +1,295 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "tcp_server.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * TcpServer 批量接收与连接数上限
+ *
+ * 1. max_connections：超过上限的连接被RST关闭，关闭已有连接后名额归还
+ * 2. max_connections_per_ip：按来源IP计数，不同来源互不影响
+ * 3. accept_pause_queue：io_worker积压时暂停接收，积压消除后连接照常处理
+ * 4. accept_batch：一批连接数小于排队连接数时分多批排空
+ *
+ * 客户端在主线程用阻塞socket，服务端运行在独立的IOManager线程上
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+class HoldServer : public CIM::TcpServer
+{
+public:
+    HoldServer(CIM::IOManager *io, CIM::IOManager *accept)
+        : CIM::TcpServer(io, io, accept)
+    {
+    }
+
+protected:
+    // 回显1字节后持有连接，直到客户端关闭
+    void handleClient(CIM::Socket::ptr client) override
+    {
+        char c;
+        if (client->recv(&c, 1) != 1 || client->send(&c, 1) != 1)
+        {
+            return;
+        }
+        while (client->recv(&c, 1) > 0)
+        {
+        }
+    }
+};
+
+static uint16_t g_port = 0;
+
+static std::shared_ptr<HoldServer> make_server(CIM::IOManager *io, CIM::IOManager *accept)
+{
+    std::shared_ptr<HoldServer> server(new HoldServer(io, accept));
+    server->setRecvTimeout(10 * 1000);
+    std::vector<CIM::Address::ptr> addrs;
+    std::vector<CIM::Address::ptr> fails;
+    addrs.push_back(CIM::Address::LookupAny("127.0.0.1:0"));
+    CIM_ASSERT(server->bind(addrs, fails));
+    // 监听socket在主线程创建，未经过hook，需登记到FdManager
+    CIM::FdMgr::GetInstance()->get(server->getSocks()[0]->getSocket(), true);
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    ::getsockname(server->getSocks()[0]->getSocket(), (sockaddr *)&addr, &len);
+    g_port = ntohs(addr.sin_port);
+    return server;
+}
+
+/// 连接并完成一次回显；被拒绝的连接返回-1
+static int connect_echo(const char *src = "127.0.0.1")
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    inet_pton(AF_INET, src, &addr.sin_addr);
+    CIM_ASSERT(::bind(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    CIM_ASSERT(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    timeval tv = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char c = 'x';
+    if (::send(fd, &c, 1, MSG_NOSIGNAL) != 1 || ::recv(fd, &c, 1, 0) != 1)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void close_all(std::vector<int> &fds)
+{
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+    fds.clear();
+}
+
+static void wait_active(std::shared_ptr<HoldServer> server, int64_t active)
+{
+    auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (server->getAcceptStats().active != active && Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CIM_ASSERT2(server->getAcceptStats().active == active,
+                "active=" + std::to_string(server->getAcceptStats().active));
+}
+
+static void test_max_connections()
+{
+    CIM::IOManager io(2, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    server->setConnectionLimits(5, 0);
+    CIM_ASSERT(server->start());
+
+    std::vector<int> fds;
+    int refused = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        int fd = connect_echo();
+        if (fd >= 0)
+        {
+            fds.push_back(fd);
+        }
+        else
+        {
+            ++refused;
+        }
+    }
+    CIM::TcpServer::AcceptStats stats = server->getAcceptStats();
+    CIM_ASSERT2(fds.size() == 5 && refused == 3, "ok=" + std::to_string(fds.size()));
+    CIM_ASSERT(stats.accepted == 5 && stats.rejected == 3 && stats.rejectedIp == 0);
+    CIM_ASSERT(stats.active == 5);
+
+    // 关闭已有连接后名额归还
+    close_all(fds);
+    wait_active(server, 0);
+    int fd = connect_echo();
+    CIM_ASSERT(fd >= 0);
+    ::close(fd);
+    wait_active(server, 0);
+    CIM_ASSERT(server->getAcceptStats().accepted == 6);
+
+    std::cout << "max_connections: accepted=" << server->getAcceptStats().accepted
+              << " rejected=" << server->getAcceptStats().rejected << std::endl;
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+static void test_per_ip()
+{
+    CIM::IOManager io(2, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    server->setConnectionLimits(0, 2);
+    CIM_ASSERT(server->start());
+
+    std::vector<int> fds;
+    for (int i = 0; i < 2; ++i)
+    {
+        int fd = connect_echo("127.0.0.1");
+        CIM_ASSERT(fd >= 0);
+        fds.push_back(fd);
+    }
+    CIM_ASSERT(connect_echo("127.0.0.1") < 0);
+    // 另一个来源IP不受影响
+    for (int i = 0; i < 2; ++i)
+    {
+        int fd = connect_echo("127.0.0.2");
+        CIM_ASSERT(fd >= 0);
+        fds.push_back(fd);
+    }
+    CIM_ASSERT(connect_echo("127.0.0.2") < 0);
+
+    CIM::TcpServer::AcceptStats stats = server->getAcceptStats();
+    CIM_ASSERT(stats.accepted == 4 && stats.rejectedIp == 2 && stats.rejected == 0);
+    CIM_ASSERT(stats.active == 4);
+
+    // 归还一个名额后同一来源可以再连接
+    ::close(fds[0]);
+    fds.erase(fds.begin());
+    wait_active(server, 3);
+    int fd = connect_echo("127.0.0.1");
+    CIM_ASSERT(fd >= 0);
+    fds.push_back(fd);
+
+    close_all(fds);
+    wait_active(server, 0);
+    std::cout << "max_connections_per_ip: accepted=" << server->getAcceptStats().accepted
+              << " rejected_ip=" << server->getAcceptStats().rejectedIp << std::endl;
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+static void test_pause()
+{
+    CIM::IOManager io(1, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    server->setAcceptPauseQueue(4);
+    CIM_ASSERT(server->start());
+
+    // 占住io_worker唯一的线程，并在它的队列里堆积任务
+    std::atomic<bool> release{false};
+    io.schedule([&release]()
+                {
+                    while (!release)
+                    {
+                        std::this_thread::yield();
+                    }
+                });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int i = 0; i < 8; ++i)
+    {
+        io.schedule([]() {});
+    }
+    CIM_ASSERT(io.getQueuedTaskCount() > 4);
+
+    std::thread releaser([&release]()
+                         {
+                             std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                             release = true;
+                         });
+    auto start = Clock::now();
+    int fd = connect_echo();
+    int64_t cost = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    releaser.join();
+    CIM_ASSERT(fd >= 0);
+    CIM_ASSERT2(cost >= 150, "cost=" + std::to_string(cost));
+    CIM::TcpServer::AcceptStats stats = server->getAcceptStats();
+    CIM_ASSERT(stats.paused > 0 && stats.accepted == 1);
+    ::close(fd);
+    wait_active(server, 0);
+
+    std::cout << "accept_pause_queue: paused=" << stats.paused << " echo_ms=" << cost << std::endl;
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+static void test_batch()
+{
+    CIM::IOManager io(2, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    server->setAcceptBatch(4);
+    server->setConnectionLimits(100, 0);
+
+    // 启动前先排队，第一次可读时监听队列中已有全部连接
+    const int n = 30;
+    std::vector<int> fds;
+    for (int i = 0; i < n; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(g_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        CIM_ASSERT(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+        char c = 'x';
+        CIM_ASSERT(::send(fd, &c, 1, 0) == 1);
+        fds.push_back(fd);
+    }
+    CIM_ASSERT(server->start());
+    for (int fd : fds)
+    {
+        timeval tv = {5, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        char c;
+        CIM_ASSERT(::recv(fd, &c, 1, 0) == 1);
+    }
+    CIM_ASSERT(server->getAcceptStats().accepted == (uint64_t)n);
+    close_all(fds);
+    wait_active(server, 0);
+
+    std::cout << "accept_batch: connections=" << n << " batch=4" << std::endl;
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::FATAL);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_max_connections();
+    test_per_ip();
+    test_pause();
+    test_batch();
+    return 0;
+}
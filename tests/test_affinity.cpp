@@ -0,0 +1,57 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "affinity.hpp"
+#include <atomic>
+#include <iostream>
+#include <sched.h>
+
+/**
+ * 工作线程放置
+ *
+ * 1. CPU列表解析与格式化
+ * 2. pin 模式下每个工作线程只允许运行在一个CPU上，且内存策略为指定节点
+ * 3. dump 输出放置策略与每个线程当前所在的CPU/节点
+ */
+
+static void test_cpu_list()
+{
+    auto cpus = CIM::ParseCpuList("8, 0-3,2,10-11,bad,5-4");
+    CIM_ASSERT(CIM::CpuListToString(cpus) == "0-3,8,10-11");
+    CIM_ASSERT(CIM::ParseCpuList("").empty());
+    std::cout << "cpu list ok" << std::endl;
+}
+
+static void test_pin()
+{
+    int cpu = sched_getcpu();
+    int node = CIM::GetCpuNumaNode(cpu);
+    auto affinity = CIM::ThreadAffinity::Create(std::to_string(cpu), node, true);
+    std::cout << "affinity: " << affinity.toString() << std::endl;
+
+    std::atomic<int> checked{0};
+    {
+        CIM::IOManager iom(2, false, "pinned", CIM::Scheduler::GLOBAL, affinity);
+        for (int i = 0; i < 8; ++i)
+        {
+            iom.schedule([&checked, cpu]()
+                         {
+                             cpu_set_t set;
+                             CPU_ZERO(&set);
+                             CIM_ASSERT(sched_getaffinity(0, sizeof(set), &set) == 0);
+                             CIM_ASSERT(CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set));
+                             CIM_ASSERT(sched_getcpu() == cpu);
+                             ++checked; });
+        }
+        iom.dump(std::cout) << std::endl;
+    }
+    CIM_ASSERT(checked == 8);
+    std::cout << "pin ok" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    test_cpu_list();
+    test_pin();
+    return 0;
+}
@@ -0,0 +1,252 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "co_io.hpp"
+#include "ws_co_session.hpp"
+#include "address.hpp"
+#include "hook.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <iomanip>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 空闲WebSocket连接的内存占用：有栈 WSSession::recvMessage vs 无栈 WSCoRecvMessage
+ *
+ * 建立 N 条本地连接，服务端每条连接都阻塞在接收消息上，
+ * 统计进程 VmRSS / VmSize 的增量除以 N；随后每个客户端发送一帧并校验回显，
+ * 确认两种实现都能正常收发。每种模式在独立的子进程中运行，避免相互影响。
+ */
+
+static const int N = 4000;
+
+static std::atomic<int> g_accepted{0};
+static std::atomic<int> g_received{0};
+
+/**
+ * @brief 读取 /proc/self/status 中的某一项(kB)
+ */
+static long read_status_kb(const char *key)
+{
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (!fp)
+    {
+        return -1;
+    }
+    char line[256];
+    long value = -1;
+    size_t klen = strlen(key);
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, key, klen) == 0 && line[klen] == ':')
+        {
+            value = atol(line + klen + 1);
+            break;
+        }
+    }
+    fclose(fp);
+    return value;
+}
+
+static CIM::co::Task<> co_serve(CIM::http::WSSession::ptr session)
+{
+    while (true)
+    {
+        auto msg = co_await CIM::http::WSCoRecvMessage(session);
+        if (!msg)
+        {
+            break;
+        }
+        ++g_received;
+        co_await CIM::http::WSCoSendMessage(session, msg);
+    }
+}
+
+static void stackful_serve(CIM::http::WSSession::ptr session)
+{
+    while (auto msg = session->recvMessage())
+    {
+        ++g_received;
+        session->sendMessage(msg);
+    }
+}
+
+/**
+ * @brief 发送一帧带掩码的文本消息并读取服务端回显
+ */
+static bool client_echo(int fd, const std::string &payload)
+{
+    std::string frame;
+    frame.push_back((char)0x81);
+    frame.push_back((char)(0x80 | payload.size()));
+    const char mask[4] = {0x11, 0x22, 0x33, 0x44};
+    frame.append(mask, 4);
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+        frame.push_back(payload[i] ^ mask[i % 4]);
+    }
+    if (::send(fd, frame.data(), frame.size(), 0) != (ssize_t)frame.size())
+    {
+        return false;
+    }
+
+    std::string rsp(2 + payload.size(), '\0');
+    size_t got = 0;
+    while (got < rsp.size())
+    {
+        ssize_t n = ::recv(fd, &rsp[got], rsp.size() - got, 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += n;
+    }
+    return (uint8_t)rsp[0] == 0x81 && rsp.compare(2, payload.size(), payload) == 0;
+}
+
+static void run(bool stackless)
+{
+    CIM::IOManager iom(1, false, "co");
+
+    auto addr = CIM::IPv4Address::Create("127.0.0.1", 0);
+    auto listener = CIM::Socket::CreateTCPSocket();
+    CIM_ASSERT(listener->bind(addr));
+    CIM_ASSERT(listener->listen(4096));
+    uint16_t port = std::static_pointer_cast<CIM::IPv4Address>(listener->getLocalAddress())->getPort();
+
+    iom.schedule([listener, stackless]()
+                 {
+                     for (int i = 0; i < N; ++i)
+                     {
+                         auto client = listener->accept();
+                         if (!client)
+                         {
+                             break;
+                         }
+                         auto session = std::make_shared<CIM::http::WSSession>(client);
+                         if (stackless)
+                         {
+                             CIM::co::spawn(co_serve(session));
+                         }
+                         else
+                         {
+                             CIM::Scheduler::GetThis()->schedule(std::bind(&stackful_serve, session));
+                         }
+                         ++g_accepted;
+                     } });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    long rss0 = read_status_kb("VmRSS");
+    long vsz0 = read_status_kb("VmSize");
+
+    std::vector<int> clients;
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < N; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(fd, (sockaddr *)&sa, sizeof(sa)))
+        {
+            perror("connect");
+            ::close(fd);
+            break;
+        }
+        clients.push_back(fd);
+    }
+    while (g_accepted < (int)clients.size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // 等待所有会话进入接收等待
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    long rss1 = read_status_kb("VmRSS");
+    long vsz1 = read_status_kb("VmSize");
+
+    int ok = 0;
+    for (int fd : clients)
+    {
+        ok += client_echo(fd, "hello co_await");
+    }
+    for (int fd : clients)
+    {
+        ::close(fd);
+    }
+
+    std::cout << std::setw(10) << (stackless ? "stackless" : "stackful")
+              << " connections=" << clients.size()
+              << " rss/conn=" << std::fixed << std::setprecision(2) << (rss1 - rss0) * 1024.0 / clients.size() << "B"
+              << " vsz/conn=" << (vsz1 - vsz0) * 1024.0 / clients.size() << "B"
+              << " echo_ok=" << ok << std::endl;
+    CIM_ASSERT(ok == (int)clients.size());
+}
+
+/**
+ * @brief sleep / whenReadable 超时与就绪
+ */
+static CIM::co::Task<> co_primitives(int rfd, int wfd, std::atomic<bool> *done)
+{
+    auto start = std::chrono::steady_clock::now();
+    co_await CIM::co::sleep(50);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CIM_ASSERT(elapsed >= std::chrono::milliseconds(50));
+
+    int rt = co_await CIM::co::whenReadable(rfd, 50);
+    CIM_ASSERT(rt == ETIMEDOUT);
+
+    write_f(wfd, "x", 1);
+    rt = co_await CIM::co::whenReadable(rfd, 1000);
+    CIM_ASSERT(rt == 0);
+    *done = true;
+}
+
+static void test_primitives()
+{
+    int fds[2];
+    CIM_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+    std::atomic<bool> done{false};
+    {
+        CIM::IOManager iom(1, false, "primitives");
+        CIM::co::spawn(co_primitives(fds[0], fds[1], &done), &iom);
+    }
+    CIM_ASSERT(done);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "primitives ok" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_primitives();
+    for (bool stackless : {false, true})
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            run(stackless);
+            return 0;
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::cerr << (stackless ? "stackless" : "stackful") << " run failed" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
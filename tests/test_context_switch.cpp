@@ -0,0 +1,113 @@
+#include "macro.hpp"
+#include "coroutine.hpp"
+#include "context.hpp"
+#include <ucontext.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/**
+ * 协程上下文切换微基准
+ *
+ * 1. ucontext: 直接使用 swapcontext 在两个上下文间来回切换
+ * 2. CoContext: 使用当前编译选择的后端(ContextBackendName)来回切换
+ * 3. Coroutine: 通过 Coroutine::call/back 来回切换(包含状态维护等开销)
+ *
+ * 每次"往返"包含两次切换，结果以每秒切换次数给出。
+ */
+
+static const long ROUNDS = 2000000;
+static const size_t STACK_SIZE = 128 * 1024;
+
+static ucontext_t s_uc_main;
+static ucontext_t s_uc_co;
+
+static void uc_entry()
+{
+    while (true)
+    {
+        swapcontext(&s_uc_co, &s_uc_main);
+    }
+}
+
+static CIM::CoContext s_ctx_main;
+static CIM::CoContext s_ctx_co;
+
+static void ctx_entry()
+{
+    while (true)
+    {
+        CIM::ContextSwap(&s_ctx_co, &s_ctx_main);
+    }
+}
+
+static CIM::Coroutine *s_coroutine = nullptr;
+
+static void coroutine_entry()
+{
+    while (true)
+    {
+        s_coroutine->setState(CIM::Coroutine::HOLD);
+        s_coroutine->back();
+    }
+}
+
+static void report(const std::string &name, std::chrono::steady_clock::duration d)
+{
+    double sec = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / 1e9;
+    double switches = ROUNDS * 2.0;
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(16) << std::right << std::fixed << std::setprecision(0) << switches / sec << " switches/s"
+              << std::setw(10) << std::setprecision(1) << sec * 1e9 / switches << " ns/switch" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::INFO);
+    std::cout << "backend = " << CIM::ContextBackendName() << ", rounds = " << ROUNDS << std::endl;
+
+    {
+        void *stack = CIM::StackPool::Alloc(STACK_SIZE);
+        getcontext(&s_uc_co);
+        s_uc_co.uc_link = nullptr;
+        s_uc_co.uc_stack.ss_sp = stack;
+        s_uc_co.uc_stack.ss_size = STACK_SIZE;
+        makecontext(&s_uc_co, &uc_entry, 0);
+
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < ROUNDS; ++i)
+        {
+            swapcontext(&s_uc_main, &s_uc_co);
+        }
+        report("ucontext", std::chrono::steady_clock::now() - start);
+    }
+
+    {
+        void *stack = CIM::StackPool::Alloc(STACK_SIZE);
+        CIM::ContextInit(&s_ctx_main);
+        CIM::ContextMake(&s_ctx_co, stack, STACK_SIZE, &ctx_entry);
+
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < ROUNDS; ++i)
+        {
+            CIM::ContextSwap(&s_ctx_main, &s_ctx_co);
+        }
+        report(std::string("CoContext(") + CIM::ContextBackendName() + ")",
+               std::chrono::steady_clock::now() - start);
+    }
+
+    {
+        CIM::Coroutine::GetThis();
+        CIM::Coroutine::ptr co(new CIM::Coroutine(&coroutine_entry, STACK_SIZE, true));
+        s_coroutine = co.get();
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < ROUNDS; ++i)
+        {
+            co->call();
+        }
+        report("Coroutine::call/back", std::chrono::steady_clock::now() - start);
+        // 协程为无限循环，不会自然结束，进程退出时不再析构
+        new CIM::Coroutine::ptr(co);
+    }
+    return 0;
+}
@@ -0,0 +1,440 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "dns.hpp"
+#include "address.hpp"
+#include "config.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * DnsResolver，对本地桩DNS服务器测试
+ *
+ * 1. A/AAAA查询、Address::Lookup/LookupAsync经过全局解析器并带上端口
+ * 2. 肯定缓存按TTL过期，否定缓存按SOA的最小TTL过期
+ * 3. 并发解析同一名字只发出一次查询
+ * 4. 协程等待应答时线程继续运行其他协程
+ * 5. 服务器无应答时超时后切换到下一个服务器
+ * 6. hosts文件优先，不区分大小写
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief 桩DNS服务器：独立线程上的阻塞UDP socket，逐个应答
+ */
+class StubDns
+{
+public:
+    struct Record
+    {
+        std::string ip;    /// 为空表示NXDOMAIN
+        uint32_t ttl = 60;
+        int delay_ms = 0;  /// 应答前的延迟
+    };
+
+    StubDns()
+    {
+        m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        CIM_ASSERT(::bind(m_fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+        socklen_t len = sizeof(addr);
+        ::getsockname(m_fd, (sockaddr *)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        timeval tv = {0, 50 * 1000};
+        ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        m_thread = std::thread(&StubDns::run, this);
+    }
+
+    ~StubDns()
+    {
+        m_stop = true;
+        m_thread.join();
+        ::close(m_fd);
+    }
+
+    void add(const std::string &name, const std::string &ip, uint32_t ttl = 60, int delay_ms = 0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Record r;
+        r.ip = ip;
+        r.ttl = ttl;
+        r.delay_ms = delay_ms;
+        m_records[name] = r;
+    }
+
+    int count(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_counts[name];
+    }
+
+    CIM::IPAddress::ptr address() const
+    {
+        auto addr = CIM::IPAddress::Create("127.0.0.1", m_port);
+        return addr;
+    }
+
+private:
+    void run()
+    {
+        uint8_t buf[512];
+        while (!m_stop)
+        {
+            sockaddr_in from;
+            socklen_t len = sizeof(from);
+            int n = ::recvfrom(m_fd, buf, sizeof(buf), 0, (sockaddr *)&from, &len);
+            if (n < 12)
+            {
+                continue;
+            }
+            // 问题中的名字与类型
+            std::string name;
+            size_t off = 12;
+            while (off < (size_t)n && buf[off])
+            {
+                if (!name.empty())
+                {
+                    name += ".";
+                }
+                name.append((const char *)buf + off + 1, buf[off]);
+                off += buf[off] + 1;
+            }
+            ++off;
+            uint16_t qtype = buf[off] << 8 | buf[off + 1];
+            size_t qend = off + 4;
+
+            Record r;
+            bool known = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_counts[name];
+                auto it = m_records.find(name);
+                if (it != m_records.end())
+                {
+                    r = it->second;
+                    known = !r.ip.empty();
+                }
+            }
+            if (r.delay_ms)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(r.delay_ms));
+            }
+
+            std::string rsp((const char *)buf, qend);
+            rsp[2] = (char)0x81; // QR RD
+            rsp[3] = (char)(known ? 0x80 : 0x83); // RA, NXDOMAIN
+            rsp[6] = rsp[7] = rsp[8] = rsp[9] = rsp[10] = rsp[11] = 0;
+
+            in6_addr ip6;
+            in_addr ip4;
+            bool v6 = known && inet_pton(AF_INET6, r.ip.c_str(), &ip6) == 1;
+            bool v4 = known && inet_pton(AF_INET, r.ip.c_str(), &ip4) == 1;
+            if ((qtype == 1 && v4) || (qtype == 28 && v6))
+            {
+                rsp[7] = 1;
+                const char rr[] = {(char)0xC0, 0x0C, 0, (char)qtype, 0, 1};
+                rsp.append(rr, sizeof(rr));
+                uint32_t ttl = htonl(r.ttl);
+                rsp.append((const char *)&ttl, 4);
+                uint16_t rdlen = htons(v4 ? 4 : 16);
+                rsp.append((const char *)&rdlen, 2);
+                rsp.append(v4 ? (const char *)&ip4 : (const char *)&ip6, v4 ? 4 : 16);
+            }
+            else
+            {
+                // NXDOMAIN或无该类型记录：附SOA，TTL 5秒、MINIMUM 2秒
+                rsp[9] = 1;
+                const char rr[] = {(char)0xC0, 0x0C, 0, 6, 0, 1, 0, 0, 0, 5, 0, 28,
+                                   2, 'n', 's', 0, 2, 'h', 'm', 0,
+                                   0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 2};
+                rsp.append(rr, sizeof(rr));
+            }
+            ::sendto(m_fd, rsp.data(), rsp.size(), 0, (sockaddr *)&from, len);
+        }
+    }
+
+private:
+    int m_fd;
+    uint16_t m_port;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::mutex m_mutex;
+    std::map<std::string, Record> m_records;
+    std::map<std::string, int> m_counts;
+};
+
+/// 在IOManager的协程中运行f并等待完成
+template <class F>
+static void run_in(CIM::IOManager &iom, F f)
+{
+    std::atomic<bool> done{false};
+    iom.schedule([&]()
+                 {
+                     f();
+                     done = true; });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static std::string ip_of(const CIM::IPAddress::ptr &addr)
+{
+    char buf[INET6_ADDRSTRLEN] = {0};
+    const sockaddr *sa = addr->getAddr();
+    if (sa->sa_family == AF_INET)
+    {
+        inet_ntop(AF_INET, &((const sockaddr_in *)sa)->sin_addr, buf, sizeof(buf));
+    }
+    else
+    {
+        inet_ntop(AF_INET6, &((const sockaddr_in6 *)sa)->sin6_addr, buf, sizeof(buf));
+    }
+    return buf;
+}
+
+static void test_resolve_and_cache(StubDns &stub, CIM::IOManager &iom)
+{
+    CIM::DnsResolver resolver;
+    resolver.setServers({stub.address()});
+    stub.add("a.test", "10.0.0.1", 60);
+    stub.add("a.test.v6", "fd00::1", 60);
+    stub.add("short.test", "10.0.0.2", 1);
+
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(resolver.resolve("a.test", AF_INET, r) && r.size() == 1);
+               CIM_ASSERT(ip_of(r[0]) == "10.0.0.1");
+               r.clear();
+               CIM_ASSERT(resolver.resolve("A.TEST.", AF_INET, r) && ip_of(r[0]) == "10.0.0.1");
+               r.clear();
+               CIM_ASSERT(resolver.resolve("a.test.v6", AF_INET6, r) && ip_of(r[0]) == "fd00::1");
+               r.clear();
+               CIM_ASSERT(resolver.resolve("a.test.v6", AF_UNSPEC, r) && r.size() == 1);
+               r.clear();
+               CIM_ASSERT(resolver.resolve("short.test", AF_INET, r));
+           });
+    CIM_ASSERT(stub.count("a.test") == 1);
+    CIM::DnsResolver::Stats stats = resolver.getStats();
+    CIM_ASSERT(stats.hits == 1);
+
+    // TTL=1秒的记录过期后重新查询
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(resolver.resolve("short.test", AF_INET, r));
+               CIM_ASSERT(resolver.resolve("a.test", AF_INET, r));
+           });
+    CIM_ASSERT(stub.count("short.test") == 2);
+    CIM_ASSERT(stub.count("a.test") == 1);
+    std::cout << "resolve/cache: hits=" << resolver.getStats().hits
+              << " queries=" << resolver.getStats().queries << std::endl;
+}
+
+static void test_negative(StubDns &stub, CIM::IOManager &iom)
+{
+    CIM::DnsResolver resolver;
+    resolver.setServers({stub.address()});
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(!resolver.resolve("nx.test", AF_INET, r));
+               CIM_ASSERT(!resolver.resolve("nx.test", AF_INET, r));
+           });
+    CIM_ASSERT(stub.count("nx.test") == 1);
+    CIM_ASSERT(resolver.getStats().negativeHits == 1);
+
+    // 否定缓存时间为SOA的MINIMUM(2秒)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(!resolver.resolve("nx.test", AF_INET, r));
+           });
+    CIM_ASSERT(stub.count("nx.test") == 2);
+    std::cout << "negative: negative_hits=" << resolver.getStats().negativeHits << std::endl;
+}
+
+static void test_coalesce(StubDns &stub, CIM::IOManager &iom)
+{
+    CIM::DnsResolver resolver;
+    resolver.setServers({stub.address()});
+    stub.add("slow.test", "10.0.0.3", 60, 200);
+
+    const int n = 50;
+    std::atomic<int> ok{0};
+    std::atomic<int> finished{0};
+    for (int i = 0; i < n; ++i)
+    {
+        iom.schedule([&]()
+                     {
+                         std::vector<CIM::IPAddress::ptr> r;
+                         if (resolver.resolve("slow.test", AF_INET, r) && r.size() == 1 && ip_of(r[0]) == "10.0.0.3")
+                         {
+                             ++ok;
+                         }
+                         ++finished; });
+    }
+    // 普通线程同时解析，走信号量等待
+    std::thread t([&]()
+                  {
+                      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                      std::vector<CIM::IPAddress::ptr> r;
+                      if (resolver.resolve("slow.test", AF_INET, r))
+                      {
+                          ++ok;
+                      }
+                      ++finished; });
+    while (finished < n + 1)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    t.join();
+    CIM_ASSERT2(ok == n + 1, "ok=" + std::to_string(ok));
+    CIM_ASSERT2(stub.count("slow.test") == 1, "queries=" + std::to_string(stub.count("slow.test")));
+    std::cout << "coalesce: callers=" << n + 1 << " queries=" << stub.count("slow.test")
+              << " coalesced=" << resolver.getStats().coalesced << std::endl;
+}
+
+static void test_nonblocking(StubDns &stub)
+{
+    CIM::IOManager iom(1, false, "dns1");
+    CIM::DnsResolver resolver;
+    resolver.setServers({stub.address()});
+    stub.add("slow2.test", "10.0.0.4", 60, 300);
+
+    std::atomic<int> ticks{0};
+    std::atomic<bool> done{false};
+    iom.schedule([&]()
+                 {
+                     std::vector<CIM::IPAddress::ptr> r;
+                     CIM_ASSERT(resolver.resolve("slow2.test", AF_INET, r));
+                     done = true; });
+    iom.schedule([&]()
+                 {
+                     while (!done)
+                     {
+                         ++ticks;
+                         usleep(10 * 1000);
+                     } });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 唯一的线程在等待应答期间继续运行计时协程
+    CIM_ASSERT2(ticks >= 15, "ticks=" + std::to_string(ticks));
+    std::cout << "nonblocking: ticks during 300ms lookup=" << ticks << std::endl;
+}
+
+static void test_failover(StubDns &stub, CIM::IOManager &iom)
+{
+    // 绑定但从不应答的服务器
+    int dead = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CIM_ASSERT(::bind(dead, (sockaddr *)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    ::getsockname(dead, (sockaddr *)&addr, &len);
+
+    CIM::Config::Lookup<uint32_t>("dns.timeout")->setValue(200);
+    CIM::DnsResolver resolver;
+    resolver.setServers({CIM::IPAddress::Create("127.0.0.1", ntohs(addr.sin_port)), stub.address()});
+    stub.add("b.test", "10.0.0.5", 60);
+    auto start = Clock::now();
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(resolver.resolve("b.test", AF_INET, r) && ip_of(r[0]) == "10.0.0.5");
+           });
+    int64_t cost = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    CIM_ASSERT(resolver.getStats().timeouts == 1);
+    CIM_ASSERT2(cost >= 180 && cost < 1000, "cost=" + std::to_string(cost));
+    CIM::Config::Lookup<uint32_t>("dns.timeout")->setValue(2000);
+    ::close(dead);
+    std::cout << "failover: cost=" << cost << "ms timeouts=" << resolver.getStats().timeouts << std::endl;
+}
+
+static void test_hosts(StubDns &stub, CIM::IOManager &iom)
+{
+    const char *path = "/tmp/test_dns_hosts";
+    {
+        std::ofstream ofs(path);
+        ofs << "# comment\n10.9.9.9   MyHost.Local  alias # trailing\nfd00::9 myhost.local\n";
+    }
+    CIM::DnsResolver resolver;
+    resolver.setServers({stub.address()});
+    resolver.loadHosts(path);
+    run_in(iom, [&]()
+           {
+               std::vector<CIM::IPAddress::ptr> r;
+               CIM_ASSERT(resolver.resolve("myhost.local", AF_INET, r) && r.size() == 1 && ip_of(r[0]) == "10.9.9.9");
+               r.clear();
+               CIM_ASSERT(resolver.resolve("ALIAS", AF_INET, r) && ip_of(r[0]) == "10.9.9.9");
+               r.clear();
+               CIM_ASSERT(resolver.resolve("myhost.local", AF_UNSPEC, r) && r.size() == 2);
+           });
+    CIM_ASSERT(stub.count("myhost.local") == 0);
+    CIM_ASSERT(resolver.getStats().hostsHits == 3);
+    unlink(path);
+    std::cout << "hosts: hits=" << resolver.getStats().hostsHits << std::endl;
+}
+
+static void test_address_lookup(StubDns &stub, CIM::IOManager &iom)
+{
+    CIM::DnsMgr::GetInstance()->setServers({stub.address()});
+    stub.add("api.test", "10.0.0.6", 60);
+    run_in(iom, [&]()
+           {
+               auto addr = CIM::Address::LookupAnyIpAddress("api.test:8080");
+               CIM_ASSERT(addr && addr->toString() == "10.0.0.6:8080");
+               auto literal = CIM::Address::LookupAny("127.0.0.1:80");
+               CIM_ASSERT(literal && literal->toString() == "127.0.0.1:80");
+               auto v6 = CIM::Address::LookupAny("[::1]:81", AF_INET6);
+               CIM_ASSERT(v6 && v6->toString() == "[::1]:81");
+           });
+
+    std::atomic<bool> done{false};
+    CIM::Address::LookupAsync("api.test:443", [&](bool ok, const std::vector<CIM::Address::ptr> &result)
+                              {
+                                  CIM_ASSERT(ok && result.size() == 1 && result[0]->toString() == "10.0.0.6:443");
+                                  done = true; },
+                              AF_INET, 0, 0, &iom);
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CIM_ASSERT(stub.count("api.test") == 1);
+    std::cout << "address: lookup through DnsMgr ok" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::FATAL);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    StubDns stub;
+    CIM::IOManager iom(2, false, "dns");
+    test_resolve_and_cache(stub, iom);
+    test_negative(stub, iom);
+    test_coalesce(stub, iom);
+    test_nonblocking(stub);
+    test_failover(stub, iom);
+    test_hosts(stub, iom);
+    test_address_lookup(stub, iom);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "config.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * IOManager 事件循环
+ *
+ * 1. 定时器精度：空闲的 IOManager 上连续添加 1~20ms 的一次性定时器，统计实际触发比预期晚多少，
+ *    比较 epoll_pwait2(纳秒超时) 与 epoll_wait(毫秒超时)
+ * 2. 批量分发：N 个协程各阻塞在一个 socketpair 上读，工作线程忙碌时外部线程写入全部，
+ *    唤醒返回满数组后事件数组扩容，统计每次唤醒的事件数与分发耗时
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const int kTimers = 100; // 定时器精度测试的定时器数
+static const int N = 4000;      // 批量分发测试的fd对数
+
+static void test_timer_accuracy(bool pwait2)
+{
+    CIM::Config::Lookup<bool>("iomanager.epoll_pwait2")->setValue(pwait2);
+    CIM::IOManager iom(1, false, pwait2 ? "pwait2" : "wait");
+    CIM_ASSERT(pwait2 || !iom.isPreciseWait());
+
+    std::vector<int64_t> late_us;
+    for (int i = 0; i < kTimers; ++i)
+    {
+        std::atomic<bool> fired{false};
+        int64_t delay_ms = i % 20 + 1;
+        Clock::time_point start = Clock::now();
+        std::atomic<int64_t> cost_us{0};
+        iom.addTimer(delay_ms, [&]()
+                     {
+                         cost_us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+                         fired = true; });
+        while (!fired)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        CIM_ASSERT2(cost_us >= delay_ms * 1000 - 1000, "early cost=" + std::to_string(cost_us));
+        late_us.push_back(cost_us - delay_ms * 1000);
+    }
+    std::sort(late_us.begin(), late_us.end());
+    int64_t sum = 0;
+    for (int64_t v : late_us)
+    {
+        sum += v;
+    }
+    std::cout << std::setw(6) << (iom.isPreciseWait() ? "pwait2" : "wait")
+              << " timer late: avg=" << sum / kTimers << "us p50=" << late_us[kTimers / 2]
+              << "us p99=" << late_us[kTimers * 99 / 100] << "us" << std::endl;
+    CIM::Config::Lookup<bool>("iomanager.epoll_pwait2")->setValue(true);
+}
+
+static void test_batch()
+{
+    std::vector<int> fds(N * 2);
+    for (int i = 0; i < N; ++i)
+    {
+        CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, &fds[i * 2]) == 0);
+        // socketpair 未经过hook，需登记到FdManager
+        CIM::FdMgr::GetInstance()->get(fds[i * 2 + 1], true);
+    }
+
+    std::atomic<int> done{0};
+    {
+        CIM::IOManager iom(1, false, "batch");
+        for (int i = 0; i < N; ++i)
+        {
+            int fd = fds[i * 2 + 1];
+            iom.schedule([fd, &done]()
+                         {
+                             char c;
+                             CIM_ASSERT(read(fd, &c, 1) == 1);
+                             ++done; });
+        }
+        // 等待全部协程挂起在读事件上
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        CIM::IOManager::LoopStats before = iom.getLoopStats();
+        for (int round = 0; round < 2; ++round)
+        {
+            if (round == 1)
+            {
+                // 第二轮重新挂起全部读者
+                for (int i = 0; i < N; ++i)
+                {
+                    int fd = fds[i * 2 + 1];
+                    iom.schedule([fd, &done]()
+                                 {
+                                     char c;
+                                     CIM_ASSERT(read(fd, &c, 1) == 1);
+                                     ++done; });
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+            // 写入期间占住唯一的工作线程，使全部事件在同一次等待中就绪
+            std::atomic<bool> gate{false};
+            std::atomic<bool> blocked{false};
+            iom.schedule([&]()
+                         {
+                             blocked = true;
+                             while (!gate)
+                             {
+                             } });
+            while (!blocked)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (int i = 0; i < N; ++i)
+            {
+                CIM_ASSERT(::write(fds[i * 2], "x", 1) == 1);
+            }
+            gate = true;
+            auto deadline = Clock::now() + std::chrono::seconds(10);
+            while (done < N * (round + 1) && Clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            CIM_ASSERT2(done == N * (round + 1), "done=" + std::to_string(done));
+        }
+        CIM::IOManager::LoopStats after = iom.getLoopStats();
+        uint64_t wakeups = after.wakeups - before.wakeups;
+        uint64_t events = after.events - before.events;
+        std::cout << "batch: fds=" << N << " x2 wakeups=" << wakeups
+                  << " events/wakeup=" << std::fixed << std::setprecision(1) << (double)events / wakeups
+                  << " max_events=" << after.maxEvents << " grows=" << after.grows
+                  << " avg_loop_us=" << (after.wakeups ? after.loopUs / after.wakeups : 0)
+                  << " max_loop_us=" << after.maxLoopUs << std::endl;
+        // 初始64，翻倍直到上限1024
+        CIM_ASSERT2(after.grows == 4, "grows=" + std::to_string(after.grows));
+        CIM_ASSERT2(after.maxEvents == 1024, "max_events=" + std::to_string(after.maxEvents));
+    }
+
+    for (int fd : fds)
+    {
+        // 主线程未启用hook，close不会清理FdCtx
+        CIM::FdMgr::GetInstance()->del(fd);
+        ::close(fd);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_timer_accuracy(false);
+    test_timer_accuracy(true);
+    test_batch();
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "config.hpp"
+#include "hook.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * epoll 注册模式：rearm vs persistent
+ *
+ * 回环 TCP 上的 echo 服务（与 examples/echo_server 相同的"读一次-处理"循环，这里把数据写回），
+ * M 个客户端协程各做 kRounds 次请求-应答，统计 epoll_ctl 调用次数与吞吐。
+ * 每种模式连续跑两轮，第二轮的连接复用第一轮关闭的 fd 号，
+ * 同时验证 close(hook 调用 cancelAll) 正确移除了持久注册。
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const int M = 50;        // 连接数
+static const int kRounds = 400; // 每个连接的请求数
+
+static void echo(int fd)
+{
+    char buf[256];
+    while (true)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        send(fd, buf, n, 0);
+    }
+    close(fd);
+}
+
+static void round_trip(CIM::IOManager &iom, uint16_t port, std::atomic<int> &done)
+{
+    for (int i = 0; i < M; ++i)
+    {
+        iom.schedule([port, &done]()
+                     {
+                         int fd = socket(AF_INET, SOCK_STREAM, 0);
+                         sockaddr_in addr = {};
+                         addr.sin_family = AF_INET;
+                         addr.sin_port = htons(port);
+                         addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                         CIM_ASSERT(connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+                         char buf[64] = "ping";
+                         for (int r = 0; r < kRounds; ++r)
+                         {
+                             CIM_ASSERT(send(fd, buf, 16, 0) == 16);
+                             CIM_ASSERT(recv(fd, buf, sizeof(buf), 0) == 16);
+                         }
+                         close(fd);
+                         ++done; });
+    }
+}
+
+static void run(const std::string &mode)
+{
+    CIM::Config::Lookup<std::string>("iomanager.epoll_mode")->setValue(mode);
+    CIM::IOManager iom(2, false, "echo-" + mode);
+    CIM_ASSERT(iom.isPersistentEpoll() == (mode == "persistent"));
+
+    std::atomic<int> port{0};
+    std::atomic<bool> stop{false};
+    iom.schedule([&]()
+                 {
+                     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+                     sockaddr_in addr = {};
+                     addr.sin_family = AF_INET;
+                     addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                     CIM_ASSERT(bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+                     CIM_ASSERT(listen(listen_fd, 128) == 0);
+                     socklen_t len = sizeof(addr);
+                     getsockname(listen_fd, (sockaddr *)&addr, &len);
+                     port = ntohs(addr.sin_port);
+                     while (!stop)
+                     {
+                         int client = accept(listen_fd, nullptr, nullptr);
+                         if (client < 0 || stop)
+                         {
+                             close(client);
+                             break;
+                         }
+                         CIM::IOManager::GetThis()->schedule(std::bind(&echo, client));
+                     }
+                     close(listen_fd); });
+    while (port == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::atomic<int> done{0};
+    round_trip(iom, port, done);
+    while (done < M)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 第二轮：fd 号复用，只统计这一轮
+    done = 0;
+    CIM::IOManager::EpollStats before = iom.getEpollStats();
+    auto start = Clock::now();
+    round_trip(iom, port, done);
+    while (done < M)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    CIM::IOManager::EpollStats after = iom.getEpollStats();
+
+    // 主线程未启用hook，用一次阻塞connect让accept循环退出
+    stop = true;
+    int wake = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CIM_ASSERT(::connect(wake, (sockaddr *)&addr, sizeof(addr)) == 0);
+
+    double requests = (double)M * kRounds;
+    uint64_t ctls = after.ctls - before.ctls;
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(10) << mode
+              << " requests=" << (uint64_t)requests
+              << " epoll_ctl=" << ctls
+              << " epoll_ctl/request=" << ctls / requests
+              << std::setprecision(0)
+              << " epoll_ctl/s=" << ctls / seconds
+              << " ready=" << after.ready - before.ready
+              << " qps=" << requests / seconds << std::endl;
+    ::close(wake);
+    if (mode == "persistent")
+    {
+        // 每个连接两端各注册一次、关闭时各移除一次
+        CIM_ASSERT2(ctls <= 4 * M + 4, "epoll_ctl=" + std::to_string(ctls));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    run("rearm");
+    run("persistent");
+    return 0;
+}
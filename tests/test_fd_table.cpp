@@ -0,0 +1,199 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "config.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * fd 记录表：分段两级数组，FdCtx 与 IOManager::FdContext 合并为一条记录
+ *
+ * 1. 正确性：fd 关闭后记录标记为已关闭、复用时代数递增；同一 fd 先后在两个 IOManager 上等待，
+ *    注册随之迁移；IOManager 析构后新的 IOManager 重新注册同一 fd
+ * 2. 性能：多个线程并发查找（每次 hook 的系统调用一次），同时另一个线程不断打开更大的 fd
+ *    使表增长，统计查找吞吐
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static void wait_for(std::atomic<int> &counter, int value)
+{
+    auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (counter < value && Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CIM_ASSERT2(counter >= value, "counter=" + std::to_string(counter) + " expect=" + std::to_string(value));
+}
+
+static void test_generation()
+{
+    int fds[2];
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    CIM::FdManager *mgr = CIM::FdMgr::GetInstance();
+    CIM_ASSERT(mgr->get(fds[0]) == nullptr);
+
+    CIM::FdCtx *ctx = mgr->get(fds[0], true);
+    CIM_ASSERT(ctx && !ctx->isClose() && ctx->isSocket());
+    CIM_ASSERT(mgr->get(fds[0]) == ctx);
+    CIM_ASSERT(mgr->getSlot(fds[0]) == ctx);
+    uint32_t generation = ctx->getGeneration();
+    ctx->setTimeout(SO_RCVTIMEO, 100);
+    // 模拟旧fd常驻注册在epoll中时被直接关闭
+    ctx->registered = true;
+    ctx->events = CIM::IOManager::READ;
+
+    // 删除后持有旧指针的一方看到已关闭，复用时原地重新初始化
+    mgr->del(fds[0]);
+    CIM_ASSERT(ctx->isClose());
+    CIM_ASSERT(mgr->get(fds[0]) == nullptr);
+    CIM::FdCtx *reopened = mgr->get(fds[0], true);
+    CIM_ASSERT(reopened == ctx && !ctx->isClose());
+    CIM_ASSERT(ctx->getGeneration() == generation + 1);
+    CIM_ASSERT(ctx->getTimeout(SO_RCVTIMEO) == (uint64_t)-1);
+    // 复用的fd号需要重新EPOLL_CTL_ADD
+    CIM_ASSERT(!ctx->registered && ctx->events == CIM::IOManager::NONE && ctx->owner == nullptr);
+
+    // 超出上限
+    CIM_ASSERT(mgr->get(CIM::FdManager::kMaxChunks * CIM::FdManager::kChunkSize, true) == nullptr);
+
+    mgr->del(fds[0]);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "generation ok" << std::endl;
+}
+
+static void test_migrate(const std::string &mode)
+{
+    CIM::Config::Lookup<std::string>("iomanager.epoll_mode")->setValue(mode);
+    int fds[2];
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    // socketpair 未经过hook，需登记到FdManager
+    CIM::FdMgr::GetInstance()->get(fds[1], true);
+
+    std::atomic<int> done{0};
+    auto reader = [&]()
+    {
+        char c;
+        CIM_ASSERT(read(fds[1], &c, 1) == 1);
+        ++done;
+    };
+    for (int round = 0; round < 2; ++round)
+    {
+        // 第二轮：第一轮的两个IOManager都已析构，新的IOManager必须重新注册
+        CIM::IOManager a(1, false, "a-" + mode);
+        CIM::IOManager b(1, false, "b-" + mode);
+        for (int i = 0; i < 3; ++i)
+        {
+            CIM::IOManager &iom = i % 2 ? b : a;
+            int expect = done + 1;
+            iom.schedule(reader);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            CIM_ASSERT(::write(fds[0], "x", 1) == 1);
+            wait_for(done, expect);
+        }
+    }
+
+    // 在另一个IOManager上等待时，原owner仍有等待者，注册不能迁移
+    {
+        CIM::IOManager a(1, false, "a-" + mode);
+        CIM::IOManager b(1, false, "b-" + mode);
+        int expect = done + 1;
+        a.schedule(reader);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::atomic<int> added{0};
+        b.schedule([&]()
+                   {
+                       CIM_ASSERT(!CIM::IOManager::GetThis()->addEvent(fds[1], CIM::IOManager::READ, []() {}));
+                       ++added; });
+        wait_for(added, 1);
+        CIM_ASSERT(::write(fds[0], "x", 1) == 1);
+        wait_for(done, expect);
+    }
+
+    CIM::FdMgr::GetInstance()->del(fds[1]);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << std::setw(10) << mode << " migrate ok" << std::endl;
+}
+
+static void bench(int threads)
+{
+    const int kFds = 64;
+    const int kOps = 5000000;
+    std::vector<int> fds;
+    for (int i = 0; i < kFds; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        CIM::FdMgr::GetInstance()->get(fd, true);
+        fds.push_back(fd);
+    }
+
+    // 另一个线程打开越来越大的fd，原实现每次扩容都要持有写锁
+    std::atomic<bool> stop{false};
+    std::atomic<int> grown{0};
+    std::thread grower([&]()
+                       {
+                           int fd = 1000;
+                           while (!stop && fd < 200000)
+                           {
+                               CIM::FdMgr::GetInstance()->get(fd, true);
+                               CIM::FdMgr::GetInstance()->del(fd);
+                               fd = fd * 3 / 2;
+                               ++grown;
+                               std::this_thread::sleep_for(std::chrono::microseconds(100));
+                           } });
+
+    std::atomic<uint64_t> hits{0};
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+                             {
+                                 uint64_t local = 0;
+                                 for (int i = 0; i < kOps; ++i)
+                                 {
+                                     CIM::FdCtx *ctx = CIM::FdMgr::GetInstance()->get(fds[(i + t) % kFds]);
+                                     local += ctx && ctx->isSocket();
+                                 }
+                                 hits += local; });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stop = true;
+    grower.join();
+    CIM_ASSERT(hits == (uint64_t)threads * kOps);
+
+    for (int fd : fds)
+    {
+        CIM::FdMgr::GetInstance()->del(fd);
+        ::close(fd);
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "threads=" << threads << " get=" << threads * (double)kOps / seconds / 1e6
+              << "M/s (concurrent growth steps=" << grown << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::FATAL);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_generation();
+    test_migrate("persistent");
+    test_migrate("rearm");
+    CIM::Config::Lookup<std::string>("iomanager.epoll_mode")->setValue("persistent");
+    bench(argc > 1 ? atoi(argv[1]) : 8);
+    return 0;
+}
@@ -0,0 +1,406 @@
+#include "macro.hpp"
+#include "config.hpp"
+#include "iomanager.hpp"
+#include "http_server.hpp"
+#include "fd_manager.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * HttpSession 请求体流式读取与分块传输编码
+ *
+ * 1. 分块请求体整体读入HttpRequest，后面紧跟的流水线请求正常处理
+ * 2. 选择按流读取的servlet边读边处理Content-Length和分块请求体，请求对象中不保存请求体
+ * 3. servlet没读完的请求体被丢弃，连接继续可用
+ * 4. 超过http.request.max_body_size的请求体(定长和分块)回复413后关闭连接
+ * 5. Expect: 100-continue 在读取请求体前回复100 Continue
+ * 6. 每次创建新实例的servlet每个请求只创建一次，判断读取方式和处理使用同一个实例
+ * 7. 基准：上传32MB，整体读入 与 按流读取 的吞吐
+ */
+
+static uint16_t g_port = 0;
+
+static auto g_max_body_size = CIM::Config::Lookup("http.request.max_body_size", (uint64_t)(64 * 1024 * 1024), "");
+
+/**
+ * @brief 按流读取请求体，响应体为 字节数:校验和:请求对象中的请求体大小
+ */
+static int32_t stream_upload(CIM::http::HttpRequest::ptr req, CIM::http::HttpResponse::ptr rsp,
+                             CIM::http::HttpSession::ptr session)
+{
+    CIM::Stream::ptr body = session->getBodyStream();
+    char buf[64 * 1024];
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    int rt = 0;
+    while ((rt = body->read(buf, sizeof(buf))) > 0)
+    {
+        for (int i = 0; i < rt; ++i)
+        {
+            sum += (unsigned char)buf[i];
+        }
+        total += rt;
+    }
+    if (rt < 0)
+    {
+        rsp->setStatus(CIM::http::HttpStatus::BAD_REQUEST);
+    }
+    rsp->setBody(std::to_string(total) + ":" + std::to_string(sum) + ":" + std::to_string(req->getBody().size()));
+    return 0;
+}
+
+/**
+ * @brief 每个请求新建实例的servlet，记录创建次数，按流读取请求体
+ */
+class CountingServlet : public CIM::http::Servlet
+{
+public:
+    static std::atomic<int> s_created;
+
+    CountingServlet()
+        : Servlet("CountingServlet")
+    {
+        ++s_created;
+        setStreamBody(true);
+    }
+
+    int32_t handle(CIM::http::HttpRequest::ptr req, CIM::http::HttpResponse::ptr rsp,
+                   CIM::http::HttpSession::ptr session) override
+    {
+        return stream_upload(req, rsp, session);
+    }
+};
+
+std::atomic<int> CountingServlet::s_created{0};
+
+static CIM::http::HttpServer::ptr make_server(CIM::IOManager *io, CIM::IOManager *accept)
+{
+    CIM::http::HttpServer::ptr server(new CIM::http::HttpServer(true, io, io, accept));
+    server->setRecvTimeout(10 * 1000);
+    std::vector<CIM::Address::ptr> addrs;
+    std::vector<CIM::Address::ptr> fails;
+    addrs.push_back(CIM::Address::LookupAny("127.0.0.1:0"));
+    CIM_ASSERT(server->bind(addrs, fails));
+    // 监听socket在主线程创建，未经过hook，需登记到FdManager
+    CIM::FdMgr::GetInstance()->get(server->getSocks()[0]->getSocket(), true);
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    ::getsockname(server->getSocks()[0]->getSocket(), (sockaddr *)&addr, &len);
+    g_port = ntohs(addr.sin_port);
+
+    auto sd = server->getServletDispatch();
+    // 整体读入：响应体为 路径:请求体
+    sd->addGlobServlet("/p/*", [](CIM::http::HttpRequest::ptr req,
+                                  CIM::http::HttpResponse::ptr rsp,
+                                  CIM::http::HttpSession::ptr session)
+                       {
+                           rsp->setBody(req->getPath() + ":" + req->getBody());
+                           return 0; });
+    // 整体读入：响应体为 字节数:校验和，用于基准
+    sd->addServlet("/sum", [](CIM::http::HttpRequest::ptr req,
+                              CIM::http::HttpResponse::ptr rsp,
+                              CIM::http::HttpSession::ptr session)
+                   {
+                       const std::string &body = req->getBody();
+                       uint64_t sum = 0;
+                       for (char c : body)
+                       {
+                           sum += (unsigned char)c;
+                       }
+                       rsp->setBody(std::to_string(body.size()) + ":" + std::to_string(sum) + ":" + std::to_string(body.size()));
+                       return 0; });
+
+    CIM::http::Servlet::ptr upload(new CIM::http::FunctionServlet(stream_upload));
+    upload->setStreamBody(true);
+    sd->addServlet("/upload", upload);
+
+    // 按流读取但不读请求体
+    CIM::http::Servlet::ptr ignore(new CIM::http::FunctionServlet([](CIM::http::HttpRequest::ptr req,
+                                                                     CIM::http::HttpResponse::ptr rsp,
+                                                                     CIM::http::HttpSession::ptr session)
+                                                                  {
+                                                                      rsp->setBody("ignored");
+                                                                      return 0; }));
+    ignore->setStreamBody(true);
+    sd->addServlet("/ignore", ignore);
+
+    sd->addServletCreator<CountingServlet>("/counted");
+    return server;
+}
+
+static int connect_server()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    CIM_ASSERT(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    timeval tv = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static std::string make_request(const std::string &path, const std::string &body = "")
+{
+    std::string req = "POST " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+    if (!body.empty())
+    {
+        req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    return req + "\r\n" + body;
+}
+
+/// 把body按每块chunk字节编码成分块请求
+static std::string make_chunked_request(const std::string &path, const std::string &body, size_t chunk)
+{
+    std::string req = "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n";
+    char size[32];
+    for (size_t i = 0; i < body.size(); i += chunk)
+    {
+        size_t n = std::min(chunk, body.size() - i);
+        snprintf(size, sizeof(size), "%zx;ext=1\r\n", n);
+        req += size;
+        req.append(body, i, n);
+        req += "\r\n";
+    }
+    return req + "0\r\nX-Trailer: t\r\n\r\n";
+}
+
+static void send_all(int fd, const std::string &data)
+{
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        ssize_t rt = ::send(fd, data.c_str() + pos, data.size() - pos, MSG_NOSIGNAL);
+        CIM_ASSERT2(rt > 0, "send rt=" + std::to_string(rt));
+        pos += rt;
+    }
+}
+
+/// 按Content-Length从连接中依次读出n个响应体
+static std::vector<std::string> recv_bodies(int fd, size_t n)
+{
+    std::vector<std::string> bodies;
+    std::string buf;
+    char tmp[16 * 1024];
+    while (bodies.size() < n)
+    {
+        size_t head_end = buf.find("\r\n\r\n");
+        if (head_end != std::string::npos)
+        {
+            size_t pos = buf.find("content-length: ");
+            if (pos == std::string::npos || pos > head_end)
+            {
+                pos = buf.find("Content-Length: ");
+            }
+            CIM_ASSERT(pos != std::string::npos && pos < head_end);
+            size_t len = strtoul(buf.c_str() + pos + 16, nullptr, 10);
+            if (buf.size() >= head_end + 4 + len)
+            {
+                bodies.push_back(buf.substr(head_end + 4, len));
+                buf.erase(0, head_end + 4 + len);
+                continue;
+            }
+        }
+        ssize_t rt = ::recv(fd, tmp, sizeof(tmp), 0);
+        CIM_ASSERT2(rt > 0, "recv rt=" + std::to_string(rt));
+        buf.append(tmp, rt);
+    }
+    CIM_ASSERT(buf.empty());
+    return bodies;
+}
+
+/// 对端关闭连接前读完所有数据，返回是否收到了关闭
+static bool wait_closed(int fd, std::string *data = nullptr)
+{
+    char tmp[4096];
+    ssize_t rt;
+    while ((rt = ::recv(fd, tmp, sizeof(tmp), 0)) > 0)
+    {
+        if (data)
+        {
+            data->append(tmp, rt);
+        }
+    }
+    return rt == 0;
+}
+
+/// 超限的请求体应收到413且响应要求关闭连接
+static bool is_too_large(const std::string &rsp)
+{
+    return rsp.compare(0, 12, "HTTP/1.1 413") == 0 && rsp.find("connection: close\r\n") != std::string::npos;
+}
+
+static std::string make_body(size_t size)
+{
+    std::string body(size, 0);
+    for (size_t i = 0; i < size; ++i)
+    {
+        body[i] = (char)(i * 7 + 3);
+    }
+    return body;
+}
+
+static std::string expect_sum(const std::string &body, size_t kept)
+{
+    uint64_t sum = 0;
+    for (char c : body)
+    {
+        sum += (unsigned char)c;
+    }
+    return std::to_string(body.size()) + ":" + std::to_string(sum) + ":" + std::to_string(kept);
+}
+
+static void test_chunked_buffered()
+{
+    int fd = connect_server();
+    send_all(fd, make_chunked_request("/p/a", "hello world", 4) + make_request("/p/b", "22"));
+    std::vector<std::string> bodies = recv_bodies(fd, 2);
+    CIM_ASSERT(bodies[0] == "/p/a:hello world");
+    CIM_ASSERT(bodies[1] == "/p/b:22");
+
+    // 空的分块请求体
+    send_all(fd, make_chunked_request("/p/c", "", 1));
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == "/p/c:");
+    ::close(fd);
+    std::cout << "chunked buffered ok" << std::endl;
+}
+
+static void test_stream()
+{
+    int fd = connect_server();
+    std::string body = make_body(3 * 1024 * 1024 + 17);
+    send_all(fd, make_request("/upload", body));
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == expect_sum(body, 0));
+
+    send_all(fd, make_chunked_request("/upload", body, 100000) + make_request("/p/next", "n"));
+    std::vector<std::string> bodies = recv_bodies(fd, 2);
+    CIM_ASSERT(bodies[0] == expect_sum(body, 0));
+    CIM_ASSERT(bodies[1] == "/p/next:n");
+
+    // 不读请求体的servlet，请求体被丢弃
+    send_all(fd, make_request("/ignore", body) + make_chunked_request("/ignore", "abc", 1) + make_request("/p/after", "x"));
+    bodies = recv_bodies(fd, 3);
+    CIM_ASSERT(bodies[0] == "ignored" && bodies[1] == "ignored");
+    CIM_ASSERT(bodies[2] == "/p/after:x");
+    ::close(fd);
+    std::cout << "stream body ok" << std::endl;
+}
+
+static void test_servlet_once()
+{
+    int fd = connect_server();
+    std::string body = make_body(100000);
+    int before = CountingServlet::s_created;
+    send_all(fd, make_request("/counted", body) + make_chunked_request("/counted", body, 3000));
+    std::vector<std::string> bodies = recv_bodies(fd, 2);
+    // 由同一个实例判断按流读取，请求对象中不保存请求体
+    CIM_ASSERT(bodies[0] == expect_sum(body, 0) && bodies[1] == expect_sum(body, 0));
+    CIM_ASSERT(CountingServlet::s_created - before == 2);
+    ::close(fd);
+    std::cout << "servlet created once per request ok" << std::endl;
+}
+
+static void test_max_body_size()
+{
+    // 客户端只发到服务端判定超限为止，服务端关闭时没有未读数据，对端收到413后是FIN
+    g_max_body_size->setValue(1024);
+    std::string head = "POST /p/a HTTP/1.1\r\nHost: localhost\r\nContent-Length: 2048\r\n\r\n";
+
+    std::string rsp;
+    int fd = connect_server();
+    send_all(fd, head);
+    CIM_ASSERT(wait_closed(fd, &rsp));
+    CIM_ASSERT2(is_too_large(rsp), rsp);
+    ::close(fd);
+
+    // 分块：前两块共1024字节，第三块超限
+    std::string chunk(512, 'c');
+    std::string chunked = "POST /p/a HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n"
+                          "200\r\n" + chunk + "\r\n200\r\n" + chunk + "\r\n200\r\n";
+    rsp.clear();
+    fd = connect_server();
+    send_all(fd, chunked);
+    CIM_ASSERT(wait_closed(fd, &rsp));
+    CIM_ASSERT2(is_too_large(rsp), rsp);
+    ::close(fd);
+
+    // 按流读取时超限返回错误，servlet仍可以响应
+    fd = connect_server();
+    std::string upload = chunked;
+    upload.replace(5, 4, "/upload");
+    send_all(fd, upload);
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == expect_sum(chunk + chunk, 0));
+    CIM_ASSERT(wait_closed(fd));
+    ::close(fd);
+
+    // 格式错误的分块
+    fd = connect_server();
+    send_all(fd, "POST /p/a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n");
+    CIM_ASSERT(wait_closed(fd));
+    ::close(fd);
+
+    g_max_body_size->setValue(64 * 1024 * 1024);
+    std::cout << "max body size ok" << std::endl;
+}
+
+static void test_expect_continue()
+{
+    int fd = connect_server();
+    send_all(fd, "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\nExpect: 100-continue\r\n\r\n");
+    char tmp[256];
+    ssize_t rt = ::recv(fd, tmp, sizeof(tmp), 0);
+    CIM_ASSERT(rt > 0 && std::string(tmp, rt) == "HTTP/1.1 100 Continue\r\n\r\n");
+    send_all(fd, "abcde");
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == expect_sum("abcde", 0));
+
+    // 不读请求体时不回复100 Continue，响应后关闭连接
+    send_all(fd, "POST /ignore HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\nExpect: 100-continue\r\n\r\n");
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == "ignored");
+    CIM_ASSERT(wait_closed(fd));
+    ::close(fd);
+    std::cout << "expect continue ok" << std::endl;
+}
+
+static void bench_upload(const std::string &path, size_t size)
+{
+    std::string body = make_body(size);
+    std::string req = make_request(path, body);
+    int fd = connect_server();
+    auto start = std::chrono::steady_clock::now();
+    send_all(fd, req);
+    std::string rsp = recv_bodies(fd, 1)[0];
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ::close(fd);
+    // 整体读入时请求对象持有完整的请求体，按流读取时为0
+    std::cout << path << " size=" << size << " response=" << rsp
+              << " MB/s=" << (uint64_t)(size / sec / 1024 / 1024) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM::IOManager io(2, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    CIM_ASSERT(server->start());
+
+    test_chunked_buffered();
+    test_stream();
+    test_servlet_once();
+    test_max_body_size();
+    test_expect_continue();
+    bench_upload("/sum", 32 * 1024 * 1024);
+    bench_upload("/upload", 32 * 1024 * 1024);
+
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
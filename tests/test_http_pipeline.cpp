@@ -0,0 +1,180 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "http_server.hpp"
+#include "fd_manager.hpp"
+#include <arpa/inet.h>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * HttpSession 读缓冲复用与HTTP/1.1流水线
+ *
+ * 1. 一次send中的多个请求（含请求体）全部按顺序得到响应，不丢弃读缓冲中剩余的数据
+ * 2. 请求体跨越两次send时，后半部分和紧跟的下一个请求都能正确处理
+ * 3. 流水线吞吐：同一连接上一次发出depth个请求，统计每秒请求数
+ *
+ * 客户端在主线程用阻塞socket，服务端运行在独立的IOManager线程上
+ */
+
+static uint16_t g_port = 0;
+
+static CIM::http::HttpServer::ptr make_server(CIM::IOManager *io, CIM::IOManager *accept)
+{
+    CIM::http::HttpServer::ptr server(new CIM::http::HttpServer(true, io, io, accept));
+    server->setRecvTimeout(10 * 1000);
+    std::vector<CIM::Address::ptr> addrs;
+    std::vector<CIM::Address::ptr> fails;
+    addrs.push_back(CIM::Address::LookupAny("127.0.0.1:0"));
+    CIM_ASSERT(server->bind(addrs, fails));
+    // 监听socket在主线程创建，未经过hook，需登记到FdManager
+    CIM::FdMgr::GetInstance()->get(server->getSocks()[0]->getSocket(), true);
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    ::getsockname(server->getSocks()[0]->getSocket(), (sockaddr *)&addr, &len);
+    g_port = ntohs(addr.sin_port);
+
+    // 响应体为 路径:请求体，便于核对顺序
+    server->getServletDispatch()->addGlobServlet("/p/*", [](CIM::http::HttpRequest::ptr req,
+                                                            CIM::http::HttpResponse::ptr rsp,
+                                                            CIM::http::HttpSession::ptr session)
+                                                 {
+                                                     rsp->setBody(req->getPath() + ":" + req->getBody());
+                                                     return 0; });
+    return server;
+}
+
+static int connect_server()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    CIM_ASSERT(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    timeval tv = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static std::string make_request(const std::string &path, const std::string &body = "")
+{
+    std::string req = "POST " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+    if (!body.empty())
+    {
+        req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    return req + "\r\n" + body;
+}
+
+static void send_all(int fd, const std::string &data)
+{
+    CIM_ASSERT(::send(fd, data.c_str(), data.size(), MSG_NOSIGNAL) == (ssize_t)data.size());
+}
+
+/// 按Content-Length从连接中依次读出n个响应体
+static std::vector<std::string> recv_bodies(int fd, size_t n)
+{
+    std::vector<std::string> bodies;
+    std::string buf;
+    char tmp[16 * 1024];
+    while (bodies.size() < n)
+    {
+        size_t head_end = buf.find("\r\n\r\n");
+        if (head_end != std::string::npos)
+        {
+            size_t pos = buf.find("content-length: ");
+            if (pos == std::string::npos || pos > head_end)
+            {
+                pos = buf.find("Content-Length: ");
+            }
+            CIM_ASSERT(pos != std::string::npos && pos < head_end);
+            size_t len = strtoul(buf.c_str() + pos + 16, nullptr, 10);
+            if (buf.size() >= head_end + 4 + len)
+            {
+                bodies.push_back(buf.substr(head_end + 4, len));
+                buf.erase(0, head_end + 4 + len);
+                continue;
+            }
+        }
+        ssize_t rt = ::recv(fd, tmp, sizeof(tmp), 0);
+        CIM_ASSERT2(rt > 0, "recv rt=" + std::to_string(rt));
+        buf.append(tmp, rt);
+    }
+    CIM_ASSERT(buf.empty());
+    return bodies;
+}
+
+static void test_pipeline_order()
+{
+    int fd = connect_server();
+    send_all(fd, make_request("/p/a", "111") + make_request("/p/b") + make_request("/p/c", "33333"));
+    std::vector<std::string> bodies = recv_bodies(fd, 3);
+    CIM_ASSERT(bodies[0] == "/p/a:111");
+    CIM_ASSERT(bodies[1] == "/p/b:");
+    CIM_ASSERT(bodies[2] == "/p/c:33333");
+
+    // 连接保持可用
+    send_all(fd, make_request("/p/d"));
+    CIM_ASSERT(recv_bodies(fd, 1)[0] == "/p/d:");
+    ::close(fd);
+    std::cout << "pipeline order ok" << std::endl;
+}
+
+static void test_split_body()
+{
+    int fd = connect_server();
+    std::string body(10000, 'x');
+    std::string data = make_request("/p/big", body) + make_request("/p/next", "n");
+    // 第一次只发到请求体中间，剩余请求体和下一个请求一起发
+    size_t cut = data.size() - body.size() / 2 - make_request("/p/next", "n").size();
+    send_all(fd, data.substr(0, cut));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    send_all(fd, data.substr(cut));
+    std::vector<std::string> bodies = recv_bodies(fd, 2);
+    CIM_ASSERT(bodies[0] == "/p/big:" + body);
+    CIM_ASSERT(bodies[1] == "/p/next:n");
+    ::close(fd);
+    std::cout << "split body ok" << std::endl;
+}
+
+static void bench_pipeline(size_t depth, size_t rounds)
+{
+    int fd = connect_server();
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i)
+    {
+        batch += make_request("/p/bench");
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        send_all(fd, batch);
+        recv_bodies(fd, depth);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ::close(fd);
+    std::cout << "pipeline depth=" << depth << " requests=" << depth * rounds
+              << " req/s=" << (uint64_t)(depth * rounds / sec) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM::IOManager io(2, false, "io");
+    CIM::IOManager accept(1, false, "accept");
+    auto server = make_server(&io, &accept);
+    CIM_ASSERT(server->start());
+
+    test_pipeline_order();
+    test_split_body();
+    bench_pipeline(1, 20000);
+    bench_pipeline(16, 2000);
+
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
\ No newline at end of file
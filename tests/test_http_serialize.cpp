@@ -0,0 +1,121 @@
+#include "macro.hpp"
+#include "http.hpp"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+/**
+ * HttpResponse 头部序列化
+ *
+ * 1. serializeHead与dumpHead输出一致（含WebSocket、Cookie、自定义原因短语）
+ * 2. extra插在结尾空行之前
+ * 3. Date头每秒格式化一次，同一秒内返回同一个缓存
+ * 4. 基准：约200字节JSON响应，stringstream+拷贝 与 复用缓冲直接写入 的ns/response
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static CIM::http::HttpResponse::ptr make_json_response()
+{
+    CIM::http::HttpResponse::ptr rsp(new CIM::http::HttpResponse(0x11, false));
+    rsp->setHeader("Content-Type", "application/json;charset=utf-8");
+    std::string body = "{\"code\":200,\"message\":\"success\",\"data\":{\"uid\":10086,"
+                       "\"nickname\":\"traveler\",\"avatar\":\"https://cdn.example.com/a/10086.png\","
+                       "\"gender\":1,\"motto\":\"hello\",\"email\":\"user@example.com\",\"mobile\":\"13800000000\"}}";
+    rsp->setBody(body);
+    return rsp;
+}
+
+static std::string dump_head(CIM::http::HttpResponse::ptr rsp)
+{
+    std::stringstream ss;
+    rsp->dumpHead(ss);
+    return ss.str();
+}
+
+static void test_same_output()
+{
+    auto rsp = make_json_response();
+    std::string out;
+    rsp->serializeHead(out);
+    CIM_ASSERT(out == dump_head(rsp));
+
+    CIM::http::HttpResponse::ptr close_rsp(new CIM::http::HttpResponse(0x10, true));
+    close_rsp->setStatus(CIM::http::HttpStatus::NOT_FOUND);
+    close_rsp->setReason("Gone Fishing");
+    close_rsp->setCookie("sid", "abc", 0, "/");
+    out.clear();
+    close_rsp->serializeHead(out);
+    CIM_ASSERT(out == dump_head(close_rsp));
+
+    CIM::http::HttpResponse::ptr ws(new CIM::http::HttpResponse);
+    ws->setWebsocket(true);
+    ws->setStatus(CIM::http::HttpStatus::SWITCHING_PROTOCOLS);
+    ws->setHeader("Connection", "Upgrade");
+    ws->setHeader("Upgrade", "websocket");
+    out.clear();
+    ws->serializeHead(out);
+    CIM_ASSERT(out == dump_head(ws));
+
+    // extra在结尾空行之前，追加写入不影响已有内容
+    std::string extra = "Server: cim\r\n";
+    std::string prefix = "prefix";
+    out = prefix;
+    rsp->serializeHead(out, extra.data(), extra.size());
+    std::string expect = dump_head(rsp);
+    expect.insert(expect.size() - 2, extra);
+    CIM_ASSERT(out == prefix + expect);
+    std::cout << "serializeHead output ok" << std::endl;
+}
+
+static void test_date_header()
+{
+    const std::string &a = CIM::http::GetHttpDateHeader();
+    CIM_ASSERT(a.compare(0, 6, "Date: ") == 0);
+    CIM_ASSERT(a.size() == 37 && a.compare(a.size() - 6, 6, " GMT\r\n") == 0);
+    const std::string &b = CIM::http::GetHttpDateHeader();
+    CIM_ASSERT(&a == &b);
+    std::cout << a;
+}
+
+static void bench(int n)
+{
+    auto rsp = make_json_response();
+    size_t sum = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < n; ++i)
+    {
+        // 原发送路径：stringstream格式化后拷贝成string
+        std::stringstream ss;
+        rsp->dumpHead(ss);
+        std::string head = ss.str();
+        sum += head.size();
+    }
+    double ss_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    std::string buf;
+    const std::string &date = CIM::http::GetHttpDateHeader();
+    start = Clock::now();
+    for (int i = 0; i < n; ++i)
+    {
+        buf.clear();
+        rsp->serializeHead(buf, date.data(), date.size());
+        sum += buf.size();
+    }
+    double direct_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    std::cout << "body=" << rsp->getBody().size() << "B n=" << n
+              << " stringstream=" << ss_ns << "ns/response"
+              << " serializeHead=" << direct_ns << "ns/response"
+              << " (" << sum << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    test_same_output();
+    test_date_header();
+    bench(1000000);
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
\ No newline at end of file
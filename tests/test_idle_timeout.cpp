@@ -0,0 +1,183 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 空闲连接超时：按次定时器(SO_RCVTIMEO) vs 截止时间模式(FdCtx::setIdleTimeout)
+ *
+ * 1. 截止时间模式下静默连接在 [timeout, timeout + 巡检间隔] 内以 ETIMEDOUT 返回，
+ *    持续有数据的连接不会被误判超时
+ * 2. M 个会话做请求-应答，统计每个请求的定时器操作数(添加+取消)
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const int M = 100;          // 会话数
+static const int kRounds = 200;    // 每个会话的请求数
+static const uint64_t kTimeout = 2000;
+
+static void set_timeout(int fd, bool deadline, uint64_t ms)
+{
+    // socketpair 未经过hook，需登记到FdManager，读端才会以协程等待的方式工作
+    CIM::FdCtx *ctx = CIM::FdMgr::GetInstance()->get(fd, true);
+    if (deadline)
+    {
+        ctx->setIdleTimeout(ms);
+    }
+    else
+    {
+        ctx->setTimeout(SO_RCVTIMEO, ms);
+    }
+}
+
+static void test_expire()
+{
+    CIM::IOManager iom(2, false, "idle");
+    int silent[2];
+    int chatty[2];
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, silent) == 0);
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, chatty) == 0);
+    set_timeout(silent[1], true, 300);
+    set_timeout(chatty[1], true, 300);
+
+    std::atomic<int64_t> silent_cost{-1};
+    std::atomic<int> silent_errno{0};
+    std::atomic<int> chatty_reads{0};
+    std::atomic<int> chatty_errno{0};
+    std::atomic<bool> chatty_done{false};
+    auto start = Clock::now();
+    iom.schedule([&]()
+                 {
+                     char buf[16];
+                     ssize_t n = recv(silent[1], buf, sizeof(buf), 0);
+                     silent_errno = n < 0 ? errno : 0;
+                     silent_cost = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count(); });
+    iom.schedule([&]()
+                 {
+                     char buf[16];
+                     while (true)
+                     {
+                         ssize_t n = recv(chatty[1], buf, sizeof(buf), 0);
+                         if (n <= 0)
+                         {
+                             chatty_errno = n < 0 ? errno : 0;
+                             break;
+                         }
+                         ++chatty_reads;
+                     }
+                     chatty_done = true; });
+
+    // 每100ms写一次，总时长远超过超时时间，但每次等待都不超过超时时间
+    for (int i = 0; i < 12; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CIM_ASSERT(::send(chatty[0], "x", 1, 0) == 1);
+    }
+    ::shutdown(chatty[0], SHUT_WR);
+
+    // 两个协程都退出后才能关闭fd，否则阻塞中的读事件永远不会触发
+    while (silent_cost < 0 || !chatty_done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CIM_ASSERT2(silent_errno == ETIMEDOUT, "errno=" + std::to_string(silent_errno));
+    CIM_ASSERT2(silent_cost >= 290 && silent_cost < 300 + 500 + 200, "cost=" + std::to_string(silent_cost));
+    CIM_ASSERT(chatty_errno == 0 && chatty_reads == 12);
+    std::cout << "deadline expire ok: silent timed out after " << silent_cost << "ms, chatty reads=" << chatty_reads << std::endl;
+    for (int fd : {silent[0], silent[1], chatty[0], chatty[1]})
+    {
+        // 主线程未启用hook，close不会清理FdCtx，避免fd复用时沿用超时设置
+        CIM::FdMgr::GetInstance()->del(fd);
+        ::close(fd);
+    }
+}
+
+static void bench(bool deadline)
+{
+    std::atomic<int> done{0};
+    double seconds = 0;
+    CIM::TimerManager::TimerStats before, after;
+    {
+        CIM::IOManager iom(2, false, deadline ? "deadline" : "timer");
+        std::vector<int> clients;
+        for (int i = 0; i < M; ++i)
+        {
+            int sv[2];
+            CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+            set_timeout(sv[1], deadline, kTimeout);
+            CIM::FdMgr::GetInstance()->get(sv[0], true);
+            clients.push_back(sv[0]);
+            // 服务端：读请求，回应答
+            iom.schedule([sv]()
+                         {
+                             char buf[64];
+                             while (true)
+                             {
+                                 ssize_t n = recv(sv[1], buf, sizeof(buf), 0);
+                                 if (n <= 0)
+                                 {
+                                     break;
+                                 }
+                                 send(sv[1], buf, n, 0);
+                             }
+                             close(sv[1]); });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        before = iom.getTimerStats();
+        auto start = Clock::now();
+        // 客户端：逐个请求-应答，读等待同样走对应的超时模式
+        for (int i = 0; i < M; ++i)
+        {
+            int fd = clients[i];
+            set_timeout(fd, deadline, kTimeout);
+            iom.schedule([fd, &done]()
+                         {
+                             char buf[64] = "ping";
+                             for (int r = 0; r < kRounds; ++r)
+                             {
+                                 send(fd, buf, 8, 0);
+                                 if (recv(fd, buf, sizeof(buf), 0) <= 0)
+                                 {
+                                     break;
+                                 }
+                             }
+                             close(fd);
+                             ++done; });
+        }
+        while (done < M)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        after = iom.getTimerStats();
+    }
+    double requests = (double)M * kRounds;
+    double ops = (after.added - before.added) + (after.cancelled - before.cancelled);
+    std::cout << std::fixed << std::setprecision(3)
+              << (deadline ? "deadline" : "timer   ")
+              << " requests=" << (uint64_t)requests
+              << " timer_ops/request=" << ops / requests
+              << " (added=" << after.added - before.added
+              << " cancelled=" << after.cancelled - before.cancelled << ")"
+              << std::setprecision(0) << " qps=" << requests / seconds << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_expire();
+    bench(false);
+    bench(true);
+    return 0;
+}
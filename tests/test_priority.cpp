@@ -0,0 +1,248 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * 调度器优先级与期限
+ *
+ * 1. 权重轮转：单线程积压 background / normal / realtime 任务，realtime 最先执行完，
+ *    background 也能在第一轮得到执行
+ * 2. 期限：过期的回调任务被丢弃，或降级到 background 后仍然执行
+ * 3. 工作窃取模式下同样生效
+ * 4. 积压大量慢任务时，realtime 任务的调度延迟 p99：全部 normal(FIFO) vs realtime
+ * 5. realtime 协程挂起后被 schedule(coroutine) 恢复(IO事件、定时器的唤醒方式)时仍按 realtime 调度
+ */
+
+static void busy_wait_us(int us)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+/**
+ * @brief 在调度器的唯一工作线程上放一个阻塞任务，返回后积压的任务会在gate打开后依次执行
+ */
+static void block_worker(CIM::Scheduler &sc, std::atomic<bool> &gate)
+{
+    std::atomic<bool> entered{false};
+    sc.schedule([&gate, &entered]()
+                {
+                    // 工作线程上sleep会被hook为协程让出，这里必须真正占住线程
+                    entered = true;
+                    while (!gate)
+                    {
+                        std::this_thread::yield();
+                    } });
+    while (!entered)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void test_weighted(CIM::Scheduler::QueueMode mode)
+{
+    std::vector<int> order;
+    CIM::Mutex mutex;
+    std::atomic<bool> gate{false};
+    {
+        CIM::IOManager iom(1, false, "weighted", mode);
+        block_worker(iom, gate);
+        auto push = [&](CIM::Scheduler::Priority p, int n)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                iom.schedule([&order, &mutex, p]()
+                             {
+                                 CIM::Mutex::Lock lock(mutex);
+                                 order.push_back(p); },
+                             p);
+            }
+        };
+        push(CIM::Scheduler::BACKGROUND, 50);
+        push(CIM::Scheduler::NORMAL, 50);
+        push(CIM::Scheduler::REALTIME, 20);
+        gate = true;
+    }
+    CIM_ASSERT(order.size() == 120);
+
+    size_t last_realtime = 0;
+    size_t first_background = order.size();
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (order[i] == CIM::Scheduler::REALTIME)
+        {
+            last_realtime = i;
+        }
+        if (order[i] == CIM::Scheduler::BACKGROUND && first_background == order.size())
+        {
+            first_background = i;
+        }
+    }
+    // 8:4:1 权重下 20 个 realtime 任务在前3轮(每轮最多13个)内全部完成
+    CIM_ASSERT2(last_realtime < 39, "last_realtime=" + std::to_string(last_realtime));
+    // background 在第一轮内就能得到执行
+    CIM_ASSERT2(first_background < 13, "first_background=" + std::to_string(first_background));
+    std::cout << CIM::Scheduler::QueueModeToString(mode) << " weighted ok: last_realtime=" << last_realtime
+              << " first_background=" << first_background << std::endl;
+}
+
+static void test_deadline()
+{
+    std::atomic<int> dropped_ran{0};
+    std::atomic<int> demoted_ran{0};
+    std::atomic<bool> gate{false};
+    CIM::Scheduler::PriorityStats stats;
+    {
+        CIM::IOManager iom(1, false, "deadline");
+        block_worker(iom, gate);
+        for (int i = 0; i < 10; ++i)
+        {
+            iom.schedule([&dropped_ran]()
+                         { ++dropped_ran; },
+                         CIM::Scheduler::TaskAttr(CIM::Scheduler::REALTIME, 1, true));
+            iom.schedule([&demoted_ran]()
+                         { ++demoted_ran; },
+                         CIM::Scheduler::TaskAttr(CIM::Scheduler::NORMAL, 1, false));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate = true;
+        while (demoted_ran < 10)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stats = iom.getPriorityStats(CIM::Scheduler::REALTIME);
+        CIM_ASSERT(stats.dropped == 10);
+        stats = iom.getPriorityStats(CIM::Scheduler::NORMAL);
+        CIM_ASSERT(stats.demoted == 10);
+    }
+    CIM_ASSERT(dropped_ran == 0);
+    CIM_ASSERT(demoted_ran == 10);
+    std::cout << "deadline ok" << std::endl;
+}
+
+static void test_resume_priority(CIM::Scheduler::QueueMode mode)
+{
+    const int kSlow = 300;
+    const int kRounds = 5;
+    CIM::Coroutine::ptr waiting;
+    CIM::Mutex mutex;
+    std::atomic<int> resumed{0};
+    std::atomic<int> resumed_priority{-1};
+    std::atomic<uint64_t> woken_us{0};
+    uint64_t worst_us = 0;
+    {
+        CIM::IOManager iom(1, false, "resume", mode);
+        iom.schedule([&]()
+                     {
+                         for (int i = 0; i < kRounds; ++i)
+                         {
+                             {
+                                 CIM::Mutex::Lock lock(mutex);
+                                 waiting = CIM::Coroutine::GetThis();
+                             }
+                             // 与IO事件、定时器等待相同：挂起后由其他线程以 schedule(coroutine) 重新入队
+                             CIM::Coroutine::YieldToHold();
+                             woken_us = CIM::TimeUtil::NowToUS();
+                             ++resumed;
+                         }
+                         resumed_priority = CIM::Coroutine::GetThis()->getPriority(); },
+                     CIM::Scheduler::REALTIME);
+        for (int i = 0; i < kRounds; ++i)
+        {
+            CIM::Coroutine::ptr co;
+            while (!co || co->getState() != CIM::Coroutine::HOLD)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                CIM::Mutex::Lock lock(mutex);
+                co = waiting;
+            }
+            {
+                CIM::Mutex::Lock lock(mutex);
+                waiting.reset();
+            }
+            for (int j = 0; j < kSlow; ++j)
+            {
+                iom.schedule([]()
+                             { busy_wait_us(1000); });
+            }
+            uint64_t start = CIM::TimeUtil::NowToUS();
+            iom.schedule(co);
+            co.reset();
+            while (resumed <= i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            worst_us = std::max<uint64_t>(worst_us, woken_us - start);
+        }
+    }
+    CIM_ASSERT(resumed_priority == CIM::Scheduler::REALTIME);
+    // 恢复后若降为normal，每次都要排在积压的慢任务(约300ms)之后
+    CIM_ASSERT2(worst_us < 100000, "worst_us=" + std::to_string(worst_us));
+    std::cout << CIM::Scheduler::QueueModeToString(mode) << " resume priority ok: worst wake delay "
+              << worst_us << "us" << std::endl;
+}
+
+/**
+ * @brief 单线程上持续积压1ms的慢任务，同时每2ms投递一个realtime任务，返回realtime任务的调度延迟统计
+ * @param[in] prioritized false时realtime任务也以normal优先级投递(等价于原FIFO行为)
+ */
+static CIM::Scheduler::PriorityStats run_latency(bool prioritized)
+{
+    const int kSlow = 300;
+    const int kPings = 50;
+    CIM::Scheduler::Priority ping_priority = prioritized ? CIM::Scheduler::REALTIME : CIM::Scheduler::NORMAL;
+    CIM::Scheduler::PriorityStats stats;
+    {
+        CIM::IOManager iom(1, false, "latency");
+        for (int i = 0; i < kSlow; ++i)
+        {
+            iom.schedule([]()
+                         { busy_wait_us(1000); },
+                         prioritized ? CIM::Scheduler::BACKGROUND : CIM::Scheduler::NORMAL);
+        }
+        for (int i = 0; i < kPings; ++i)
+        {
+            iom.schedule([]() {}, ping_priority);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        iom.stop();
+        stats = iom.getPriorityStats(ping_priority);
+        if (!prioritized)
+        {
+            // FIFO时慢任务与ping混在normal中，只能看整体分布
+            std::cout << "fifo     normal  p50=" << stats.p50 << "us p99=" << stats.p99
+                      << "us max=" << stats.max << "us" << std::endl;
+        }
+        else
+        {
+            std::cout << "priority realtime p50=" << stats.p50 << "us p99=" << stats.p99
+                      << "us max=" << stats.max << "us" << std::endl;
+        }
+        iom.dump(std::cout) << std::endl;
+    }
+    return stats;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_weighted(CIM::Scheduler::GLOBAL);
+    test_weighted(CIM::Scheduler::WORK_STEALING);
+    test_deadline();
+    test_resume_priority(CIM::Scheduler::GLOBAL);
+    test_resume_priority(CIM::Scheduler::WORK_STEALING);
+
+    auto fifo = run_latency(false);
+    auto prio = run_latency(true);
+    // 积压的慢任务总计约300ms，FIFO下ping要排在它们后面；带优先级时最多等待一个正在执行的慢任务
+    CIM_ASSERT2(prio.p99 < fifo.p99, "priority p99 not better than fifo");
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "tcp_server.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include "util.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * TcpServer reuseport 模式
+ *
+ * 子进程中的客户端线程不断建立短连接（发 1 字节、收 1 字节、RST 关闭），模拟重连风暴，
+ * 比较每秒完成的连接数：
+ * - classic：单个监听socket，accept_worker 接收后调度到 io_worker
+ * - reuseport：io_worker 每线程一个 SO_REUSEPORT 监听socket，在 io_worker 上 accept4 排空并处理
+ * - cbpf：reuseport + 按收包CPU选择监听socket的BPF程序（线程固定在CPU 0）
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const int kIoThreads = 4;    // io_worker 线程数
+static const int kClients = 8;      // 客户端线程数
+static const int kPerClient = 1500; // 每个客户端线程的连接数
+
+class OnceServer : public CIM::TcpServer
+{
+public:
+    OnceServer(CIM::IOManager *io, CIM::IOManager *accept)
+        : CIM::TcpServer(io, io, accept)
+    {
+    }
+
+    std::atomic<int> handled{0};
+    std::atomic<int> perThread[kIoThreads];
+
+protected:
+    void handleClient(CIM::Socket::ptr client) override
+    {
+        const std::vector<pid_t> &ids = m_ioWorker->getThreadIds();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (ids[i] == CIM::GetThreadId())
+            {
+                ++perThread[i];
+            }
+        }
+        char c;
+        if (client->recv(&c, 1) == 1)
+        {
+            client->send(&c, 1);
+        }
+        ++handled;
+    }
+};
+
+static void run_clients(uint16_t port, int go)
+{
+    char c;
+    if (::read(go, &c, 1) != 1)
+    {
+        _exit(1);
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kClients; ++i)
+    {
+        threads.emplace_back([port]()
+                             {
+                                 sockaddr_in addr = {};
+                                 addr.sin_family = AF_INET;
+                                 addr.sin_port = htons(port);
+                                 addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                                 for (int n = 0; n < kPerClient; ++n)
+                                 {
+                                     int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                                     if (::connect(fd, (sockaddr *)&addr, sizeof(addr)))
+                                     {
+                                         _exit(2);
+                                     }
+                                     char buf = 'x';
+                                     if (::send(fd, &buf, 1, 0) != 1 || ::recv(fd, &buf, 1, 0) != 1)
+                                     {
+                                         _exit(3);
+                                     }
+                                     // RST关闭，不留TIME_WAIT占用临时端口
+                                     linger lg = {1, 0};
+                                     ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                                     ::close(fd);
+                                 } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    _exit(0);
+}
+
+static uint16_t pick_port()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CIM_ASSERT(::bind(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, (sockaddr *)&addr, &len);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void bench(const std::string &mode)
+{
+    uint16_t port = pick_port();
+    int go[2];
+    CIM_ASSERT(pipe(go) == 0);
+    // 先fork客户端，子进程不继承任何调度线程
+    pid_t pid = fork();
+    CIM_ASSERT(pid >= 0);
+    if (pid == 0)
+    {
+        ::close(go[1]);
+        run_clients(port, go[0]);
+    }
+    ::close(go[0]);
+
+    const int total = kClients * kPerClient;
+    double seconds = 0;
+    std::vector<int> dist;
+    {
+        CIM::ThreadAffinity affinity;
+        if (mode == "cbpf")
+        {
+            affinity = CIM::ThreadAffinity::Create("0", -1, true);
+        }
+        CIM::IOManager io(kIoThreads, false, "io-" + mode, CIM::Scheduler::GLOBAL, affinity);
+        CIM::IOManager accept(1, false, "accept-" + mode);
+        std::shared_ptr<OnceServer> server(new OnceServer(&io, &accept));
+        for (auto &i : server->perThread)
+        {
+            i = 0;
+        }
+        if (mode != "classic")
+        {
+            server->setReusePort(true, mode == "cbpf" ? "cbpf" : "none");
+        }
+        std::vector<CIM::Address::ptr> addrs;
+        std::vector<CIM::Address::ptr> fails;
+        addrs.push_back(CIM::Address::LookupAny("127.0.0.1:" + std::to_string(port)));
+        CIM_ASSERT(server->bind(addrs, fails));
+        CIM_ASSERT(server->getSocks().size() == (mode == "classic" ? 1u : (size_t)kIoThreads));
+        for (auto &sock : server->getSocks())
+        {
+            // 监听socket在主线程创建，未经过hook，需登记到FdManager
+            CIM::FdMgr::GetInstance()->get(sock->getSocket(), true);
+        }
+        CIM_ASSERT(server->start());
+
+        auto start = Clock::now();
+        CIM_ASSERT(::write(go[1], "g", 1) == 1);
+        auto deadline = start + std::chrono::seconds(60);
+        while (server->handled < total && Clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        CIM_ASSERT2(server->handled == total, "handled=" + std::to_string(server->handled));
+        for (auto &i : server->perThread)
+        {
+            dist.push_back(i);
+        }
+        server->stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ::close(go[1]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CIM_ASSERT2(WIFEXITED(status) && WEXITSTATUS(status) == 0, "client status=" + std::to_string(status));
+
+    std::cout << std::setw(9) << mode << " connections=" << total
+              << " conn/s=" << std::fixed << std::setprecision(0) << total / seconds << " per_thread=";
+    for (size_t i = 0; i < dist.size(); ++i)
+    {
+        std::cout << (i ? "/" : "") << dist[i];
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::FATAL);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    bench("classic");
+    bench("reuseport");
+    bench("cbpf");
+    return 0;
+}
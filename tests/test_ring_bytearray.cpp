@@ -0,0 +1,401 @@
+#include "macro.hpp"
+#include "byte_array.hpp"
+#include "ring_byte_array.hpp"
+#include <vector>
+#include <iostream>
+#include <chrono>
+
+static auto g_logger = CIM_LOG_ROOT();
+
+static double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void test_basic_types()
+{
+    CIM_LOG_INFO(g_logger) << "Test basic types";
+
+#define XX(type, len, write_fun, read_fun, base_len)                  \
+    {                                                                 \
+        std::vector<type> vec;                                        \
+        for (int i = 0; i < len; ++i)                                 \
+        {                                                             \
+            vec.push_back(rand());                                    \
+        }                                                             \
+        CIM::RingByteArray::ptr ba(new CIM::RingByteArray(base_len)); \
+        for (auto &it : vec)                                          \
+        {                                                             \
+            ba->write_fun(it);                                        \
+        }                                                             \
+        ba->setPosition(0);                                           \
+        for (size_t i = 0; i < vec.size(); ++i)                       \
+        {                                                             \
+            type v = ba->read_fun();                                  \
+            CIM_ASSERT(v == vec[i]);                                  \
+        }                                                             \
+        CIM_ASSERT(ba->getReadSize() == 0);                           \
+    }
+
+    XX(int8_t, 100, writeFint8, readFint8, 1);
+    XX(int8_t, 100, writeFuint8, readFuint8, 1);
+    XX(int16_t, 100, writeFint16, readFint16, 1);
+    XX(int16_t, 100, writeFuint16, readFuint16, 1);
+    XX(int32_t, 100, writeFint32, readFint32, 1);
+    XX(int32_t, 100, writeFuint32, readFuint32, 1);
+    XX(int64_t, 100, writeFint64, readFint64, 1);
+    XX(int64_t, 100, writeFuint64, readFuint64, 1);
+
+    XX(int32_t, 100, writeInt32, readInt32, 1);
+    XX(int32_t, 100, writeUint32, readUint32, 1);
+    XX(int64_t, 100, writeInt64, readInt64, 1);
+    XX(int64_t, 100, writeUint64, readUint64, 1);
+
+#undef XX
+}
+
+void test_strings_and_edges()
+{
+    CIM_LOG_INFO(g_logger) << "Test strings and edge cases";
+
+    CIM::RingByteArray::ptr ba(new CIM::RingByteArray(8));
+    std::string str = "Hello, World! 你好世界！";
+    ba->writeStringF16(str);
+    ba->writeStringF32(str);
+    ba->writeStringF64(str);
+    ba->writeStringVint(str);
+    ba->writeStringVint("");
+    ba->writeFloat(3.1415926f);
+    ba->writeDouble(3.141592653589793);
+    ba->writeInt32(-1);
+    ba->writeInt64(-10000000000LL);
+    ba->writeFuint64(UINT64_MAX);
+    ba->writeUint64(UINT64_MAX);
+    ba->setPosition(0);
+    CIM_ASSERT(ba->readString16() == str);
+    CIM_ASSERT(ba->readString32() == str);
+    CIM_ASSERT(ba->readString64() == str);
+    CIM_ASSERT(ba->readStringVint() == str);
+    CIM_ASSERT(ba->readStringVint().empty());
+    CIM_ASSERT(ba->readFloat() == 3.1415926f);
+    CIM_ASSERT(ba->readDouble() == 3.141592653589793);
+    CIM_ASSERT(ba->readInt32() == -1);
+    CIM_ASSERT(ba->readInt64() == -10000000000LL);
+    CIM_ASSERT(ba->readFuint64() == UINT64_MAX);
+    CIM_ASSERT(ba->readUint64() == UINT64_MAX);
+    CIM_ASSERT(ba->getReadSize() == 0);
+
+    bool thrown = false;
+    try
+    {
+        ba->readFuint8();
+    }
+    catch (std::out_of_range &)
+    {
+        thrown = true;
+    }
+    CIM_ASSERT(thrown);
+
+    // 字节序
+    CIM::RingByteArray le(16);
+    le.setIsLittleEndian(true);
+    le.writeFint32(0x12345678);
+    le.setPosition(0);
+    CIM_ASSERT(le.toString() == std::string("\x78\x56\x34\x12", 4));
+    CIM_ASSERT(le.readFint32() == 0x12345678);
+
+    // 文件读写
+    ba->setPosition(0);
+    CIM_ASSERT(ba->writeToFile("/tmp/test_ring_bytearray.data"));
+    CIM::RingByteArray::ptr ba2(new CIM::RingByteArray(1));
+    CIM_ASSERT(ba2->readFromFile("/tmp/test_ring_bytearray.data"));
+    ba2->setPosition(0);
+    CIM_ASSERT(ba->toString() == ba2->toString());
+    CIM_ASSERT(!ba->toHexString().empty());
+}
+
+void test_ring_wrap()
+{
+    CIM_LOG_INFO(g_logger) << "Test ring wrap and consume";
+
+    // 写读交替并consume，数据跨越环尾，容量保持不变
+    CIM::RingByteArray ba(64);
+    uint32_t next_write = 0;
+    uint32_t next_read = 0;
+    for (int round = 0; round < 1000; ++round)
+    {
+        int n = 1 + rand() % 10;
+        for (int i = 0; i < n && ba.getDataSize() + 4 <= 64; ++i)
+        {
+            ba.setPosition(ba.getDataSize());
+            ba.writeFuint32(next_write++);
+        }
+        ba.setPosition(0);
+        int m = rand() % (ba.getDataSize() / 4 + 1);
+        for (int i = 0; i < m; ++i)
+        {
+            CIM_ASSERT(ba.readFuint32() == next_read++);
+        }
+        ba.consume();
+        CIM_ASSERT(ba.getPosition() == 0);
+    }
+    CIM_ASSERT(ba.getCapacity() == 64);
+
+    // 跨越环尾的数据最多两个iovec
+    ba.setPosition(0);
+    std::vector<iovec> iovs;
+    uint64_t len = ba.getReadBuffers(iovs);
+    CIM_ASSERT(len == ba.getDataSize());
+    CIM_ASSERT(iovs.size() <= 2);
+    size_t total = 0;
+    for (auto &i : iovs)
+    {
+        total += i.iov_len;
+    }
+    CIM_ASSERT(total == len);
+
+    // 跨越环尾时扩容，数据顺序保持
+    while (ba.getReadSize() < 64 - 4)
+    {
+        ba.setPosition(ba.getDataSize());
+        ba.writeFuint32(next_write++);
+        ba.setPosition(0);
+    }
+    ba.setPosition(ba.getDataSize());
+    for (int i = 0; i < 100; ++i)
+    {
+        ba.writeFuint32(next_write++);
+    }
+    CIM_ASSERT(ba.getCapacity() > 64);
+    ba.setPosition(0);
+    while (ba.getReadSize())
+    {
+        CIM_ASSERT(ba.readFuint32() == next_read++);
+    }
+    CIM_ASSERT(next_read == next_write);
+
+    // getWriteBuffers后按ByteArray的约定由调用者移动position
+    ba.clear();
+    iovs.clear();
+    CIM_ASSERT(ba.getWriteBuffers(iovs, 10) == 10);
+    memcpy(iovs[0].iov_base, "0123456789", 10);
+    ba.setPosition(10);
+    ba.setPosition(0);
+    CIM_ASSERT(ba.toString() == "0123456789");
+}
+
+void test_slice_and_reserve()
+{
+    CIM_LOG_INFO(g_logger) << "Test slice and reserve";
+
+    CIM::RingByteArray::ptr ba(new CIM::RingByteArray(16));
+    ba->writeStringWithoutLength("header");
+    ba->writeFuint32(42);
+    ba->writeStringVint("body");
+
+    // 切片共享底层内存
+    CIM::RingByteArray::ptr s = ba->slice(6, ba->getDataSize() - 6);
+    CIM_ASSERT(s->getPosition() == 0);
+    std::vector<iovec> a, b;
+    ba->getReadBuffers(a, 4, 6);
+    s->getReadBuffers(b, 4);
+    CIM_ASSERT(a[0].iov_base == b[0].iov_base);
+    CIM_ASSERT(s->readFuint32() == 42);
+    CIM_ASSERT(s->readStringVint() == "body");
+
+    // 原对象写入不影响已有切片（写时复制）
+    CIM::RingByteArray::ptr h = ba->slice(0, 6);
+    ba->setPosition(0);
+    ba->writeStringWithoutLength("HEADER");
+    CIM_ASSERT(h->toString() == "header");
+    ba->setPosition(0);
+    CIM_ASSERT(ba->toString().substr(0, 6) == "HEADER");
+
+    // 切片写入不影响原对象
+    h->setPosition(0);
+    h->writeStringWithoutLength("xx");
+    h->setPosition(0);
+    CIM_ASSERT(h->toString() == "xxader");
+    ba->setPosition(0);
+    CIM_ASSERT(ba->toString().substr(0, 6) == "HEADER");
+
+    bool thrown = false;
+    try
+    {
+        ba->slice(1, ba->getDataSize());
+    }
+    catch (std::out_of_range &)
+    {
+        thrown = true;
+    }
+    CIM_ASSERT(thrown);
+
+    // reserve一次分配，之后写入不再扩容
+    CIM::RingByteArray r(1);
+    r.reserve(100000);
+    size_t cap = r.getCapacity();
+    CIM_ASSERT(cap >= 100000);
+    for (int i = 0; i < 25000; ++i)
+    {
+        r.writeFuint32(i);
+    }
+    CIM_ASSERT(r.getCapacity() == cap);
+}
+
+/**
+ * @brief 与test_bytearray相同的用例，分别跑ByteArray与RingByteArray
+ */
+template <class BA>
+static double bench_types(size_t base_len, int n)
+{
+    double start = now_ms();
+    BA ba(base_len);
+    for (int i = 0; i < n; ++i)
+    {
+        ba.writeFint32(i);
+        ba.writeUint64((uint64_t)i * 2654435761u);
+        ba.writeInt32(-i);
+        ba.writeFuint16((uint16_t)i);
+    }
+    ba.setPosition(0);
+    for (int i = 0; i < n; ++i)
+    {
+        CIM_ASSERT(ba.readFint32() == i);
+        CIM_ASSERT(ba.readUint64() == (uint64_t)i * 2654435761u);
+        CIM_ASSERT(ba.readInt32() == -i);
+        CIM_ASSERT(ba.readFuint16() == (uint16_t)i);
+    }
+    return now_ms() - start;
+}
+
+template <class BA>
+static double bench_seek(size_t base_len, int n)
+{
+    BA ba(base_len);
+    std::string data(4 << 20, 'x');
+    ba.write(data.c_str(), data.size());
+    double start = now_ms();
+    uint64_t sum = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        ba.setPosition((size_t)rand() % (data.size() - 8));
+        sum += ba.readFuint8();
+    }
+    CIM_ASSERT(sum == (uint64_t)n * 'x');
+    return now_ms() - start;
+}
+
+template <class BA>
+static double bench_read_buffers(size_t base_len, int n, size_t &iovs)
+{
+    BA ba(base_len);
+    std::string data(1 << 20, 'x');
+    ba.write(data.c_str(), data.size());
+    ba.setPosition(0);
+    double start = now_ms();
+    std::vector<iovec> buffers;
+    for (int i = 0; i < n; ++i)
+    {
+        buffers.clear();
+        CIM_ASSERT(ba.getReadBuffers(buffers, data.size()) == data.size());
+    }
+    iovs = buffers.size();
+    return now_ms() - start;
+}
+
+/**
+ * @brief 模拟RockMessageDecoder：从连接读缓冲中拆出消息体并解析
+ * @details ByteArray每条消息新建对象并拷贝消息体；RingByteArray在读缓冲上切片
+ */
+static void bench_decode(int n, double &ba_ms, double &ring_ms)
+{
+    // 一条消息的报文体：类型 + 序号 + 200字节内容
+    CIM::RingByteArray tmp;
+    tmp.writeFuint8(1);
+    tmp.writeUint32(7);
+    tmp.writeStringVint(std::string(200, 'p'));
+    tmp.setPosition(0);
+    const std::string wire = tmp.toString();
+
+    double start = now_ms();
+    for (int i = 0; i < n; ++i)
+    {
+        CIM::ByteArray::ptr msg(new CIM::ByteArray);
+        msg->write(wire.c_str(), wire.size());
+        msg->setPosition(0);
+        CIM_ASSERT(msg->readFuint8() == 1);
+        CIM_ASSERT(msg->readUint32() == 7);
+        CIM_ASSERT(msg->readStringVint().size() == 200);
+    }
+    ba_ms = now_ms() - start;
+
+    CIM::RingByteArray stream(1 << 16);
+    start = now_ms();
+    for (int i = 0; i < n; ++i)
+    {
+        stream.setPosition(stream.getDataSize());
+        stream.write(wire.c_str(), wire.size());
+        CIM::RingByteArray::ptr msg = stream.slice(0, wire.size());
+        CIM_ASSERT(msg->readFuint8() == 1);
+        CIM_ASSERT(msg->readUint32() == 7);
+        CIM_ASSERT(msg->readStringVint().size() == 200);
+        msg.reset();
+        stream.setPosition(wire.size());
+        stream.consume();
+    }
+    CIM_ASSERT(stream.getCapacity() == (1 << 16));
+    ring_ms = now_ms() - start;
+}
+
+void bench()
+{
+    const int n = 200000;
+    std::cout << "types  n=" << n
+              << " ByteArray(4096)=" << bench_types<CIM::ByteArray>(4096, n) << "ms"
+              << " Ring(4096)=" << bench_types<CIM::RingByteArray>(4096, n) << "ms" << std::endl;
+
+    // 小节点下ByteArray的变长读写按节点逐字节推进，耗时随数据量平方增长，这里缩小规模
+    const int small_n = n / 20;
+    std::cout << "types  n=" << small_n
+              << " ByteArray(16)=" << bench_types<CIM::ByteArray>(16, small_n) << "ms"
+              << " Ring(16)=" << bench_types<CIM::RingByteArray>(16, small_n) << "ms" << std::endl;
+
+    const int seeks = 20000;
+    std::cout << "seek   4MiB n=" << seeks
+              << " ByteArray=" << bench_seek<CIM::ByteArray>(4096, seeks) << "ms"
+              << " Ring=" << bench_seek<CIM::RingByteArray>(4096, seeks) << "ms" << std::endl;
+
+    size_t ba_iovs = 0, ring_iovs = 0;
+    double ba_ms = bench_read_buffers<CIM::ByteArray>(4096, 2000, ba_iovs);
+    double ring_ms = bench_read_buffers<CIM::RingByteArray>(4096, 2000, ring_iovs);
+    std::cout << "iovec  1MiB n=2000 ByteArray=" << ba_ms << "ms(" << ba_iovs << " iovs)"
+              << " Ring=" << ring_ms << "ms(" << ring_iovs << " iovs)" << std::endl;
+
+    bench_decode(n, ba_ms, ring_ms);
+    std::cout << "decode n=" << n << " ByteArray=" << ba_ms << "ms Ring(slice)=" << ring_ms << "ms" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    srand(time(NULL));
+
+    try
+    {
+        test_basic_types();
+        test_strings_and_edges();
+        test_ring_wrap();
+        test_slice_and_reserve();
+        bench();
+
+        CIM_LOG_INFO(g_logger) << "All tests passed!";
+    }
+    catch (...)
+    {
+        CIM_LOG_ERROR(g_logger) << "Test failed!";
+        return 1;
+    }
+
+    return 0;
+}
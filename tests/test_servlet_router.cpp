@@ -0,0 +1,267 @@
+#include "macro.hpp"
+#include "http_servlet.hpp"
+#include <chrono>
+#include <atomic>
+#include <fnmatch.h>
+#include <iostream>
+#include <thread>
+
+/**
+ * ServletDispatch 压缩前缀树路由
+ *
+ * 1. 精确路径、路径参数、按方法区分、前缀通配、fnmatch通配的匹配结果和优先级
+ * 2. 修改路由后快照失效，下一次查找看到新路由；没有读者时旧快照随修改立即释放，
+ *    并发查找时反复增删路由，旧快照不会一直积压
+ * 3. 基准：约150个/api/v1/路由加/wss/\*等通配，对比原 unordered_map+读写锁+fnmatch 的查找耗时
+ */
+
+using namespace CIM::http;
+typedef std::chrono::steady_clock Clock;
+
+static Servlet::ptr make_servlet(const std::string &name)
+{
+    return std::make_shared<FunctionServlet>([name](HttpRequest::ptr, HttpResponse::ptr rsp, HttpSession::ptr)
+                                             {
+        rsp->setBody(name);
+        return 0; });
+}
+
+static void test_match()
+{
+    ServletDispatch::ptr sd(new ServletDispatch);
+    auto login = make_servlet("login");
+    auto group = make_servlet("group");
+    auto group_members = make_servlet("group_members");
+    auto group_create = make_servlet("group_create");
+    auto get_user = make_servlet("get_user");
+    auto post_user = make_servlet("post_user");
+    auto api = make_servlet("api");
+    auto api_v1 = make_servlet("api_v1");
+    auto wss = make_servlet("wss");
+    auto js = make_servlet("js");
+
+    sd->addServlet("/api/v1/auth/login", login);
+    sd->addServlet("/api/v1/group/:id", group);
+    sd->addServlet("/api/v1/group/:id/members", group_members);
+    sd->addServlet("/api/v1/group/create", group_create);
+    sd->addServlet(HttpMethod::GET, "/api/v1/user", get_user);
+    sd->addServlet(HttpMethod::POST, "/api/v1/user", post_user);
+    sd->addGlobServlet("/api/*", api);
+    sd->addGlobServlet("/api/v1/*", api_v1);
+    sd->addGlobServlet("/wss/*", wss);
+    sd->addGlobServlet("/static/*.js", js);
+
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/auth/login") == login);
+    // 静态路径优先于路径参数
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/group/create") == group_create);
+
+    HttpRequest::ptr req(new HttpRequest);
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::GET, "/api/v1/group/42", req) == group);
+    CIM_ASSERT(req->getParam("id") == "42");
+    req.reset(new HttpRequest);
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::GET, "/api/v1/group/7/members", req) == group_members);
+    CIM_ASSERT(req->getParam("id") == "7");
+    // 参数不能为空，剩余部分不匹配时回退到通配，不留下参数
+    req.reset(new HttpRequest);
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::GET, "/api/v1/group/7/other", req) == api_v1);
+    CIM_ASSERT(req->getParam("id").empty());
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/group/") == api_v1);
+
+    // 按方法区分，方法不匹配时回退到通配
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::GET, "/api/v1/user") == get_user);
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::POST, "/api/v1/user") == post_user);
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::DELETE, "/api/v1/user") == api_v1);
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/user") == api_v1);
+
+    // 前缀通配越长越优先，*匹配包括'/'的任意后缀
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/unknown/path") == api_v1);
+    CIM_ASSERT(sd->getMatchedServlet("/api/v2/x") == api);
+    CIM_ASSERT(sd->getMatchedServlet("/wss/") == wss);
+    CIM_ASSERT(sd->getMatchedServlet("/wss/a/b?c") == wss);
+    CIM_ASSERT(sd->getMatchedServlet("/wss") == sd->getDefault());
+    CIM_ASSERT(sd->getMatchedServlet("/static/js/app.js") == js);
+    CIM_ASSERT(sd->getMatchedServlet("/static/app.css") == sd->getDefault());
+    CIM_ASSERT(sd->getMatchedServlet("/") == sd->getDefault());
+    CIM_ASSERT(sd->getMatchedServlet("") == sd->getDefault());
+
+    // 修改路由后重新编译
+    sd->delGlobServlet("/api/v1/*");
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/unknown/path") == api);
+    sd->delServlet("/api/v1/group/:id");
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/group/42") == api);
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/group/42/members") == group_members);
+    sd->delServlet(HttpMethod::GET, "/api/v1/user");
+    CIM_ASSERT(sd->getMatchedServlet(HttpMethod::GET, "/api/v1/user") == api);
+    sd->addServlet("/api/v1/auth/login", group);
+    CIM_ASSERT(sd->getMatchedServlet("/api/v1/auth/login") == group);
+
+    std::map<std::string, IServletCreator::ptr> infos;
+    sd->listAllServletCreator(infos);
+    CIM_ASSERT(infos.count("POST /api/v1/user") == 1);
+    std::cout << "router match ok" << std::endl;
+}
+
+static void test_reclaim()
+{
+    ServletDispatch::ptr sd(new ServletDispatch);
+    auto slt = make_servlet("x");
+    auto keep = make_servlet("keep");
+    sd->addServlet("/keep", keep);
+
+    // 旧快照持有creator，creator持有servlet：快照释放后只剩这里的引用
+    sd->addServlet("/x", slt);
+    CIM_ASSERT(sd->getMatchedServlet("/x") == slt);
+    sd->delServlet("/x");
+    CIM_ASSERT(slt.use_count() == 1);
+
+    // 读者不断查找时反复增删路由
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t)
+    {
+        readers.emplace_back([&]()
+                             {
+                                 while (!stop)
+                                 {
+                                     CIM_ASSERT(sd->getMatchedServlet("/keep") == keep);
+                                 } });
+    }
+    long max_refs = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        sd->addServlet("/x", slt);
+        sd->getMatchedServlet("/x");
+        sd->delServlet("/x");
+        // 只有读者还登记着更早的纪元时旧快照才保留
+        max_refs = std::max(max_refs, slt.use_count() - 1);
+    }
+    stop = true;
+    for (auto &t : readers)
+    {
+        t.join();
+    }
+    // 读者都已退出，下一次修改释放剩余的旧快照
+    sd->delServlet("/none");
+    CIM_ASSERT2(slt.use_count() == 1, "use_count=" + std::to_string(slt.use_count()));
+    std::cout << "router reclaim ok: max retained=" << max_refs << std::endl;
+}
+
+/**
+ * @brief 原ServletDispatch的查找方式
+ */
+class LegacyDispatch
+{
+public:
+    void addServlet(const std::string &uri, Servlet::ptr slt)
+    {
+        CIM::RWMutex::WriteLock lock(m_mutex);
+        m_datas[uri] = std::make_shared<HoldServletCreator>(slt);
+    }
+
+    void addGlobServlet(const std::string &uri, Servlet::ptr slt)
+    {
+        CIM::RWMutex::WriteLock lock(m_mutex);
+        m_globs.push_back(std::make_pair(uri, std::make_shared<HoldServletCreator>(slt)));
+    }
+
+    Servlet::ptr getMatchedServlet(const std::string &uri)
+    {
+        CIM::RWMutex::ReadLock lock(m_mutex);
+        auto mit = m_datas.find(uri);
+        if (mit != m_datas.end())
+        {
+            return mit->second->get();
+        }
+        for (auto it = m_globs.begin(); it != m_globs.end(); ++it)
+        {
+            if (!fnmatch(it->first.c_str(), uri.c_str(), 0))
+            {
+                return it->second->get();
+            }
+        }
+        return m_default;
+    }
+
+private:
+    std::unordered_map<std::string, IServletCreator::ptr> m_datas;
+    std::vector<std::pair<std::string, IServletCreator::ptr>> m_globs;
+    Servlet::ptr m_default;
+    CIM::RWMutex m_mutex;
+};
+
+static const char *s_modules[] = {"auth", "user", "contact", "group", "talk", "message",
+                                  "emoticon", "article", "organize", "common", "upload", "search"};
+static const char *s_actions[] = {"list", "detail", "create", "update", "delete", "search",
+                                  "setting", "online-status", "apply/list", "apply/create",
+                                  "apply/agree", "apply/decline", "member/list"};
+
+static void bench(int n, int threads)
+{
+    ServletDispatch sd;
+    LegacyDispatch legacy;
+    std::vector<std::string> hits;
+    for (auto m : s_modules)
+    {
+        for (auto a : s_actions)
+        {
+            // 与api模块一样，每个路由一个servlet
+            std::string uri = std::string("/api/v1/") + m + "/" + a;
+            auto slt = make_servlet(uri);
+            sd.addServlet(uri, slt);
+            legacy.addServlet(uri, slt);
+            hits.push_back(uri);
+        }
+    }
+    const char *globs[] = {"/api/v1/upload/multipart/*", "/static/*", "/favicon*", "/wss/*"};
+    for (auto g : globs)
+    {
+        auto slt = make_servlet(g);
+        sd.addGlobServlet(g, slt);
+        legacy.addGlobServlet(g, slt);
+    }
+    // 精确未命中的请求：命中通配或返回默认servlet
+    std::vector<std::string> misses = {"/wss/default.io", "/wss/default.io?token=abc",
+                                       "/api/v1/upload/multipart/init", "/static/js/app.js",
+                                       "/api/v1/not/found", "/index.html"};
+
+    auto run = [&](const std::vector<std::string> &paths, bool compiled)
+    {
+        std::vector<std::thread> ts;
+        std::vector<size_t> sums(threads);
+        auto start = Clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            ts.emplace_back([&, t]()
+                            {
+                size_t sum = 0;
+                for (int i = 0; i < n; ++i)
+                {
+                    const std::string &p = paths[(i + t) % paths.size()];
+                    Servlet::ptr s = compiled ? sd.getMatchedServlet(p) : legacy.getMatchedServlet(p);
+                    sum += (size_t)s.get() & 1;
+                }
+                sums[t] = sum; });
+        }
+        for (auto &t : ts)
+        {
+            t.join();
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)n * threads);
+    };
+
+    std::cout << "routes=" << hits.size() << " globs=" << sizeof(globs) / sizeof(globs[0])
+              << " threads=" << threads << " n=" << n
+              << " hit: legacy=" << run(hits, false) << "ns radix=" << run(hits, true) << "ns"
+              << " miss: legacy=" << run(misses, false) << "ns radix=" << run(misses, true) << "ns"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    test_match();
+    test_reclaim();
+    bench(1000000, 1);
+    bench(1000000, 4);
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
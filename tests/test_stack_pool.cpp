@@ -0,0 +1,91 @@
+#include "macro.hpp"
+#include "coroutine.hpp"
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+static auto g_logger = CIM_LOG_ROOT();
+
+static void print_stats(const char *tag)
+{
+    CIM::StackPoolStats st = CIM::StackPool::GetStats();
+    CIM_LOG_INFO(g_logger) << tag
+                           << " live=" << st.live
+                           << " pooled=" << st.pooled
+                           << " reserved=" << st.bytes_reserved
+                           << " mapped=" << st.bytes_mapped
+                           << " resident=" << st.bytes_resident;
+}
+
+// 复用: 归还后再次分配应拿到同一块栈
+void test_reuse()
+{
+    void *a = CIM::StackPool::Alloc(128 * 1024);
+    CIM::StackPool::Dealloc(a, 128 * 1024);
+    void *b = CIM::StackPool::Alloc(128 * 1024);
+    CIM_ASSERT(a == b);
+    CIM::StackPool::Dealloc(b, 128 * 1024);
+    print_stats("reuse");
+}
+
+// 高水位: 超出部分的物理内存被归还
+void test_high_water()
+{
+    std::vector<void *> stacks;
+    for (int i = 0; i < 200; ++i)
+    {
+        stacks.push_back(CIM::StackPool::Alloc(64 * 1024));
+    }
+    print_stats("alloc 200");
+    for (auto p : stacks)
+    {
+        CIM::StackPool::Dealloc(p, 64 * 1024);
+    }
+    print_stats("dealloc 200");
+}
+
+// 常驻: 映射但未写入的栈不计入常驻内存，写入的页才计入
+void test_resident()
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    CIM::StackPoolStats before = CIM::StackPool::GetStats();
+    char *p = (char *)CIM::StackPool::Alloc(256 * 1024);
+    CIM::StackPoolStats mapped = CIM::StackPool::GetStats();
+    CIM_ASSERT(mapped.bytes_mapped - before.bytes_mapped == 256 * 1024);
+    CIM_ASSERT(mapped.bytes_resident == before.bytes_resident);
+    // 栈从高地址向下使用，写入顶部4页
+    memset(p + 256 * 1024 - 4 * page, 1, 4 * page);
+    CIM::StackPoolStats touched = CIM::StackPool::GetStats();
+    CIM_ASSERT(touched.bytes_resident - before.bytes_resident == 4 * page);
+    CIM::StackPool::Dealloc(p, 256 * 1024);
+    print_stats("resident");
+}
+
+// 短生命周期协程创建/销毁耗时
+void bench_coroutine()
+{
+    CIM::Coroutine::GetThis();
+    const int N = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+    {
+        CIM::Coroutine::ptr co(new CIM::Coroutine([]() {}, 0, true));
+        co->call();
+    }
+    auto end = std::chrono::steady_clock::now();
+    CIM_LOG_INFO(g_logger) << "create+run+destroy " << N << " coroutines: "
+                           << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() * 1000.0 / N
+                           << " ns/coroutine";
+    print_stats("bench");
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::INFO);
+    test_reuse();
+    test_high_water();
+    test_resident();
+    bench_coroutine();
+    return 0;
+}
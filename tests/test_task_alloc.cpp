@@ -0,0 +1,118 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+/**
+ * 统计每个被调度任务引起的堆分配次数
+ *
+ * 通过替换全局 operator new 计数，调度捕获 shared_ptr + 整数的 lambda
+ * （与 TcpServer::startAccept 投递 handleClient 的 std::bind 大小相当），
+ * 统计从投递到全部执行完成期间的分配次数。
+ * - burst: 工作线程内一次性连续 schedule N 个任务，队列节点来不及回收
+ * - chain: 每个任务执行时再 schedule 下一个任务，即稳态下的投递/执行
+ */
+
+static std::atomic<long long> g_alloc_count{0};
+static std::atomic<bool> g_counting{false};
+
+void *operator new(size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        ++g_alloc_count;
+    }
+    void *p = malloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static const int N = 100000;
+static std::atomic<int> g_done{0};
+
+struct Payload
+{
+    int value = 0;
+};
+
+static void producer()
+{
+    auto payload = std::make_shared<Payload>();
+    CIM::Scheduler *s = CIM::Scheduler::GetThis();
+
+    g_alloc_count = 0;
+    g_counting = true;
+    for (int i = 0; i < N; ++i)
+    {
+        s->schedule([payload, i]()
+                    { payload->value += i; ++g_done; });
+    }
+}
+
+static void chain_step(std::shared_ptr<Payload> payload, int i)
+{
+    payload->value += i;
+    ++g_done;
+    if (i + 1 < N)
+    {
+        CIM::Scheduler::GetThis()->schedule([payload, i]()
+                                            { chain_step(payload, i + 1); });
+    }
+}
+
+static void chain()
+{
+    auto payload = std::make_shared<Payload>();
+    // 先完成一轮预热，使队列节点与协程池进入稳态
+    for (int i = 0; i < 16; ++i)
+    {
+        CIM::Scheduler::GetThis()->schedule([]() {});
+    }
+    CIM::Scheduler::GetThis()->schedule([payload]()
+                                        {
+                                            g_alloc_count = 0;
+                                            g_counting = true;
+                                            chain_step(payload, 0); });
+}
+
+static void run(CIM::Scheduler::QueueMode mode, void (*fn)(), const char *name)
+{
+    g_done = 0;
+    CIM::IOManager iom(1, false, "alloc", mode);
+    iom.schedule(fn);
+    while (g_done < N)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    g_counting = false;
+    std::cout << std::setw(6) << name << std::setw(12) << CIM::Scheduler::QueueModeToString(mode)
+              << " allocations/task = " << (double)g_alloc_count / N << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::WARN);
+    run(CIM::Scheduler::GLOBAL, &producer, "burst");
+    run(CIM::Scheduler::WORK_STEALING, &producer, "burst");
+    run(CIM::Scheduler::GLOBAL, &chain, "chain");
+    run(CIM::Scheduler::WORK_STEALING, &chain, "chain");
+    return 0;
+}
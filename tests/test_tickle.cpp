@@ -0,0 +1,110 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * IOManager 唤醒开销：模拟 WebSocket 广播(fan-out)
+ *
+ * 外部发布线程以约 100k msg/s 的速率轮流向 M 个会话写入小消息，
+ * 每个会话在 IOManager 上以协程阻塞读取（hook的recv）。统计期间 tickle 的调用次数
+ * 与实际的 eventfd 读写次数：改用 eventfd 前每次调用都会写一次管道并逐字节读出，
+ * 调用次数即为原来的唤醒系统调用次数。
+ */
+
+static const int M = 200;             // 会话数
+static const int kRate = 100000;      // 目标消息速率(msg/s)
+static const int kSeconds = 2;        // 持续时间
+static const size_t kMsgSize = 16;    // 消息大小
+
+static std::atomic<uint64_t> g_received{0};
+
+static void session(int fd)
+{
+    char buf[4096];
+    while (true)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        g_received += n / kMsgSize;
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    std::vector<int> publishers;
+    CIM::IOManager::TickleStats stats;
+    double elapsed = 0;
+    uint64_t sent = 0;
+    {
+        CIM::IOManager iom(threads, false, "fanout");
+        for (int i = 0; i < M; ++i)
+        {
+            int sv[2];
+            CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+            publishers.push_back(sv[0]);
+            // socketpair 未经过hook，需登记到FdManager，读端才会以非阻塞+协程等待的方式工作
+            CIM::FdMgr::GetInstance()->get(sv[1], true);
+            iom.schedule(std::bind(&session, sv[1]));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        CIM::IOManager::TickleStats before = iom.getTickleStats();
+        char msg[kMsgSize] = "broadcast-msg";
+        // 每轮向全部会话各发送一条消息，按目标速率控制轮次间隔
+        const auto round_interval = std::chrono::nanoseconds(1000000000LL * M / kRate);
+        auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        auto end = start + std::chrono::seconds(kSeconds);
+        while (std::chrono::steady_clock::now() < end)
+        {
+            for (int fd : publishers)
+            {
+                if (::send(fd, msg, sizeof(msg), MSG_DONTWAIT) == (ssize_t)sizeof(msg))
+                {
+                    ++sent;
+                }
+            }
+            next += round_interval;
+            std::this_thread::sleep_until(next);
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        CIM::IOManager::TickleStats after = iom.getTickleStats();
+        stats.calls = after.calls - before.calls;
+        stats.coalesced = after.coalesced - before.coalesced;
+        stats.writes = after.writes - before.writes;
+        stats.reads = after.reads - before.reads;
+
+        for (int fd : publishers)
+        {
+            ::close(fd);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "threads=" << threads << " sessions=" << M
+              << " sent=" << sent / elapsed << "msg/s"
+              << " received=" << g_received / elapsed << "msg/s" << std::endl
+              << "  tickle calls (pipe write+read syscalls before) = " << stats.calls / elapsed << "/s" << std::endl
+              << "  coalesced                                    = " << stats.coalesced / elapsed << "/s" << std::endl
+              << "  eventfd writes                               = " << stats.writes / elapsed << "/s" << std::endl
+              << "  eventfd reads                                = " << stats.reads / elapsed << "/s" << std::endl;
+    CIM_ASSERT(g_received == sent);
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "config.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * 定时器：时间轮 vs std::set
+ *
+ * 1. 正确性（两种实现都跑）：工作线程/外部线程添加的一次性定时器按时触发、取消的不触发、
+ *    周期定时器、refresh/reset、跨越第0层的远期定时器、条件定时器
+ * 2. 性能：常驻大量长超时定时器（空闲连接）的同时，多个工作线程反复 addConditionTimer + cancel
+ *    （每次hook的IO超时都是这一对操作），比较吞吐
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static int64_t elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+static void set_timer_type(const std::string &type)
+{
+    CIM::Config::Lookup<std::string>("timer.type")->setValue(type);
+}
+
+static void wait_for(std::atomic<int> &counter, int value)
+{
+    auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (counter < value && Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CIM_ASSERT2(counter >= value, "counter=" + std::to_string(counter) + " expect=" + std::to_string(value));
+}
+
+static void test_correctness(const std::string &type)
+{
+    set_timer_type(type);
+    CIM::IOManager iom(2, false, "timer-" + type);
+    CIM_ASSERT(iom.isTimerWheel() == (type == "wheel"));
+
+    const int kTimers = 300;
+    std::atomic<int> fired{0};
+    std::atomic<int> cancelled_fired{0};
+    std::atomic<int> early{0};
+    std::atomic<int64_t> max_late{0};
+    std::atomic<int> added{0};
+
+    auto add_batch = [&](int seed)
+    {
+        for (int i = 0; i < kTimers / 3; ++i)
+        {
+            int delay = (i * 37 + seed * 11) % 600 + 1;
+            Clock::time_point start = Clock::now();
+            auto timer = iom.addTimer(delay, [&, start, delay]()
+                                      {
+                                          int64_t cost = elapsed_ms(start);
+                                          if (cost + 1 < delay)
+                                          {
+                                              ++early;
+                                          }
+                                          int64_t late = cost - delay;
+                                          int64_t prev = max_late;
+                                          while (late > prev && !max_late.compare_exchange_weak(prev, late))
+                                          {
+                                          }
+                                          ++fired; });
+            if (i % 3 == 0)
+            {
+                // 取消一部分，它们的回调不应再执行
+                auto victim = iom.addTimer(delay, [&cancelled_fired]()
+                                           { ++cancelled_fired; });
+                CIM_ASSERT(victim->cancel());
+                CIM_ASSERT(!victim->cancel());
+            }
+            (void)timer;
+        }
+        ++added;
+    };
+
+    // 工作线程上的协程写入各自的分片，外部线程写入共享分片
+    iom.schedule(std::bind(add_batch, 1));
+    iom.schedule(std::bind(add_batch, 2));
+    add_batch(3);
+    wait_for(added, 3);
+    wait_for(fired, kTimers);
+    CIM_ASSERT(cancelled_fired == 0);
+    CIM_ASSERT2(early == 0, "early=" + std::to_string(early));
+    CIM_ASSERT2(max_late < 100, "max_late=" + std::to_string(max_late));
+
+    // 周期定时器
+    std::atomic<int> ticks{0};
+    auto recurring = iom.addTimer(20, [&ticks]()
+                                  { ++ticks; },
+                                  true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(210));
+    CIM_ASSERT(recurring->cancel());
+    int ticks_at_cancel = ticks;
+    CIM_ASSERT2(ticks_at_cancel >= 5 && ticks_at_cancel <= 11, "ticks=" + std::to_string(ticks_at_cancel));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CIM_ASSERT(ticks == ticks_at_cancel);
+
+    // refresh：在工作线程上刷新外部线程添加的定时器（时间轮下会迁移到该线程的分片）
+    std::atomic<int> refreshed{0};
+    Clock::time_point start = Clock::now();
+    std::atomic<int64_t> refreshed_at{0};
+    auto timer = iom.addTimer(100, [&]()
+                              {
+                                  refreshed_at = elapsed_ms(start);
+                                  ++refreshed; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    std::atomic<int> done{0};
+    iom.schedule([&]()
+                 {
+                     CIM_ASSERT(timer->refresh());
+                     ++done; });
+    wait_for(done, 1);
+    wait_for(refreshed, 1);
+    CIM_ASSERT2(refreshed_at >= 155, "refreshed_at=" + std::to_string(refreshed_at));
+    CIM_ASSERT(!timer->refresh());
+
+    // reset：从现在起改为30ms
+    std::atomic<int> reset_fired{0};
+    timer = iom.addTimer(1000, [&reset_fired]()
+                         { ++reset_fired; });
+    start = Clock::now();
+    CIM_ASSERT(timer->reset(30, true));
+    wait_for(reset_fired, 1);
+    CIM_ASSERT2(elapsed_ms(start) < 200, "reset late");
+
+    // 远期定时器：超过第0层256ms的跨度，需要级联
+    std::atomic<int> far_fired{0};
+    std::atomic<int> far_early{0};
+    start = Clock::now();
+    const int far_delays[] = {300, 700, 1300};
+    for (int delay : far_delays)
+    {
+        iom.addTimer(delay, [&, delay]()
+                     {
+                         if (elapsed_ms(start) + 1 < delay)
+                         {
+                             ++far_early;
+                         }
+                         ++far_fired; });
+    }
+    wait_for(far_fired, 3);
+    CIM_ASSERT(far_early == 0);
+
+    // 条件定时器：条件对象释放后不执行回调
+    std::atomic<int> cond_fired{0};
+    {
+        std::shared_ptr<int> alive(new int(0));
+        std::shared_ptr<int> dead(new int(0));
+        iom.addConditionTimer(10, [&cond_fired]()
+                              { ++cond_fired; },
+                              alive);
+        iom.addConditionTimer(10, [&cond_fired]()
+                              { cond_fired += 100; },
+                              dead);
+        dead.reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    }
+    CIM_ASSERT(cond_fired == 1);
+    CIM_ASSERT(!iom.hasTimer());
+
+    std::cout << type << " correctness ok: max_late=" << max_late << "ms recurring_ticks=" << ticks_at_cancel
+              << " refreshed_at=" << refreshed_at << "ms" << std::endl;
+}
+
+static double bench(const std::string &type, int threads, int resident, int ops_per_task)
+{
+    set_timer_type(type);
+    std::atomic<int> done{0};
+    double seconds = 0;
+    {
+        CIM::IOManager iom(threads, false, "bench-" + type);
+        // 常驻的长超时定时器，模拟大量空闲连接的读超时
+        std::vector<CIM::Timer::ptr> idle;
+        idle.reserve(resident);
+        for (int i = 0; i < resident; ++i)
+        {
+            idle.push_back(iom.addTimer(60000 + i % 5000, []() {}));
+        }
+
+        std::shared_ptr<int> cond(new int(0));
+        std::weak_ptr<int> weak_cond(cond);
+        auto start = Clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            iom.schedule([&, weak_cond]()
+                         {
+                             for (int i = 0; i < ops_per_task; ++i)
+                             {
+                                 auto timer = iom.addConditionTimer(5000 + i % 1000, []() {}, weak_cond);
+                                 timer->cancel();
+                             }
+                             ++done; });
+        }
+        wait_for(done, threads);
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (auto &timer : idle)
+        {
+            timer->cancel();
+        }
+    }
+    return threads * (double)ops_per_task / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_correctness("set");
+    test_correctness("wheel");
+
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    const int kResident = 100000;
+    const int kOps = 200000;
+    double set_ops = bench("set", threads, kResident, kOps);
+    double wheel_ops = bench("wheel", threads, kResident, kOps);
+    std::cout << std::fixed << std::setprecision(0)
+              << "threads=" << threads << " resident=" << kResident
+              << " addConditionTimer+cancel: set=" << set_ops << "/s wheel=" << wheel_ops << "/s" << std::endl;
+    set_timer_type("wheel");
+    return 0;
+}
@@ -0,0 +1,332 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "hook.hpp"
+#include "fd_manager.hpp"
+#include "util.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * IOManager io_uring 后端
+ *
+ * 1. 正确性：SO_RCVTIMEO 超时、截止时间模式超时、阻塞读时另一协程 close、connect 失败
+ *    提交延迟：提交请求的线程随后执行耗时任务时，请求仍立即发给内核，由空闲线程完成
+ * 2. 模拟 ws_worker：8 线程 IOManager 上 M 个会话做小消息请求-应答，客户端在子进程中，
+ *    统计服务端每条消息的 IO 相关系统调用：
+ *    read/write 类（/proc/self/io 的 syscr/syscw，含 eventfd）+ epoll_wait + epoll_ctl + io_uring_enter
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const int M = 64;          // 会话数
+static const int kRounds = 500;   // 每个会话的消息数
+static const size_t kMsgSize = 32; // 消息大小
+
+static int64_t elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+static void test_correctness()
+{
+    CIM::IOManager iom(2, false, "uring", CIM::Scheduler::GLOBAL, CIM::ThreadAffinity(), CIM::IOManager::URING);
+    CIM_ASSERT(iom.isUring());
+
+    int timed[2];
+    int idle[2];
+    int closed[2];
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, timed) == 0);
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, idle) == 0);
+    CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, closed) == 0);
+    // socketpair 未经过hook，需登记到FdManager
+    CIM::FdMgr::GetInstance()->get(timed[1], true)->setTimeout(SO_RCVTIMEO, 100);
+    CIM::FdMgr::GetInstance()->get(idle[1], true)->setIdleTimeout(200);
+    CIM::FdMgr::GetInstance()->get(closed[1], true);
+
+    std::atomic<int> done{0};
+    std::atomic<int64_t> timed_cost{0}, idle_cost{0};
+    std::atomic<int> timed_errno{0}, idle_errno{0}, closed_errno{0}, connect_errno{0};
+    auto start = Clock::now();
+    iom.schedule([&]()
+                 {
+                     char buf[16];
+                     ssize_t n = recv(timed[1], buf, sizeof(buf), 0);
+                     timed_errno = n < 0 ? errno : 0;
+                     timed_cost = elapsed_ms(start);
+                     ++done; });
+    iom.schedule([&]()
+                 {
+                     char buf[16];
+                     ssize_t n = read(idle[1], buf, sizeof(buf));
+                     idle_errno = n < 0 ? errno : 0;
+                     idle_cost = elapsed_ms(start);
+                     ++done; });
+    iom.schedule([&]()
+                 {
+                     char buf[16];
+                     ssize_t n = recv(closed[1], buf, sizeof(buf), 0);
+                     closed_errno = n < 0 ? errno : 0;
+                     ++done; });
+    iom.schedule([&]()
+                 {
+                     // 另一协程阻塞在读上时关闭fd，hook的close通过cancelAll取消进行中的请求
+                     usleep(50 * 1000);
+                     close(closed[1]);
+                     ++done; });
+    iom.schedule([&]()
+                 {
+                     // 回环上未监听的端口
+                     int fd = socket(AF_INET, SOCK_STREAM, 0);
+                     sockaddr_in addr = {};
+                     addr.sin_family = AF_INET;
+                     addr.sin_port = htons(1);
+                     addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                     int rt = connect(fd, (sockaddr *)&addr, sizeof(addr));
+                     connect_errno = rt < 0 ? errno : 0;
+                     close(fd);
+                     ++done; });
+
+    while (done < 5)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CIM_ASSERT2(timed_errno == ETIMEDOUT, "errno=" + std::to_string(timed_errno));
+    CIM_ASSERT2(timed_cost >= 95 && timed_cost < 300, "cost=" + std::to_string(timed_cost));
+    CIM_ASSERT2(idle_errno == ETIMEDOUT, "errno=" + std::to_string(idle_errno));
+    CIM_ASSERT2(idle_cost >= 190, "cost=" + std::to_string(idle_cost));
+    CIM_ASSERT2(closed_errno == EBADF, "errno=" + std::to_string(closed_errno));
+    CIM_ASSERT2(connect_errno == ECONNREFUSED, "errno=" + std::to_string(connect_errno));
+    std::cout << "uring correctness ok: rcvtimeo=" << timed_cost << "ms idle=" << idle_cost << "ms" << std::endl;
+
+    for (int fd : {timed[0], timed[1], idle[0], idle[1], closed[0]})
+    {
+        // 主线程未启用hook，close不会清理FdCtx
+        CIM::FdMgr::GetInstance()->del(fd);
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief 2线程IOManager，协程先在本线程排入一个500ms的忙任务再阻塞recv，对端20ms后发送。
+ *        SQE若等到本线程进入idle才提交，recv要在忙任务结束后才返回
+ */
+static void test_submit_latency(CIM::IOManager::Backend backend)
+{
+    CIM::IOManager iom(2, false, "lat", CIM::Scheduler::GLOBAL, CIM::ThreadAffinity(), backend);
+    int64_t worst = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        int sv[2];
+        CIM_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+        CIM::FdMgr::GetInstance()->get(sv[1], true);
+        // 等两个线程都进入idle
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::atomic<int64_t> cost{-1};
+        std::atomic<bool> busy_done{false};
+        auto start = Clock::now();
+        iom.schedule([&]()
+                     {
+                         CIM::Scheduler::GetThis()->schedule([&]()
+                                                             {
+                                                                 auto s = Clock::now();
+                                                                 while (Clock::now() - s < std::chrono::milliseconds(500))
+                                                                 {
+                                                                 }
+                                                                 busy_done = true; },
+                                                             CIM::GetThreadId());
+                         char buf[8];
+                         ssize_t n = recv(sv[1], buf, sizeof(buf), 0);
+                         CIM_ASSERT(n == 1);
+                         cost = elapsed_ms(start); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CIM_ASSERT(::send(sv[0], "x", 1, 0) == 1);
+        while (cost < 0 || !busy_done)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        worst = std::max<int64_t>(worst, cost);
+        CIM::FdMgr::GetInstance()->del(sv[1]);
+        ::close(sv[0]);
+        ::close(sv[1]);
+    }
+    CIM_ASSERT2(worst < 200, "worst=" + std::to_string(worst));
+    std::cout << "submit latency ok: " << CIM::IOManager::BackendToString(backend)
+              << " worst=" << worst << "ms (data sent at 20ms)" << std::endl;
+}
+
+/**
+ * @brief 读取本进程 /proc/self/io 中 read/write 类系统调用次数之和
+ */
+static uint64_t rw_syscalls()
+{
+    std::ifstream in("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    uint64_t total = 0;
+    while (in >> key >> value)
+    {
+        if (key == "syscr:" || key == "syscw:")
+        {
+            total += value;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief 子进程中的客户端：M 个线程各自阻塞地发送消息并等待应答
+ */
+static void run_clients(uint16_t port)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < M; ++i)
+    {
+        threads.emplace_back([port]()
+                             {
+                                 int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                                 sockaddr_in addr = {};
+                                 addr.sin_family = AF_INET;
+                                 addr.sin_port = htons(port);
+                                 addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                                 if (::connect(fd, (sockaddr *)&addr, sizeof(addr)))
+                                 {
+                                     _exit(1);
+                                 }
+                                 char buf[kMsgSize] = "ws-frame";
+                                 for (int r = 0; r < kRounds; ++r)
+                                 {
+                                     size_t got = 0;
+                                     if (::send(fd, buf, kMsgSize, 0) != (ssize_t)kMsgSize)
+                                     {
+                                         _exit(2);
+                                     }
+                                     while (got < kMsgSize)
+                                     {
+                                         ssize_t n = ::recv(fd, buf + got, kMsgSize - got, 0);
+                                         if (n <= 0)
+                                         {
+                                             _exit(3);
+                                         }
+                                         got += n;
+                                     }
+                                 }
+                                 ::close(fd); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    _exit(0);
+}
+
+static void session(int fd, std::atomic<int> *closed)
+{
+    char buf[256];
+    while (true)
+    {
+        // read/writev 在 /proc/self/io 中计数，且都走 io_uring 路径
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            break;
+        }
+        iovec iov = {buf, (size_t)n};
+        writev(fd, &iov, 1);
+    }
+    close(fd);
+    ++*closed;
+}
+
+static void bench(CIM::IOManager::Backend backend)
+{
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CIM_ASSERT(::bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    CIM_ASSERT(::listen(listen_fd, 1024) == 0);
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd, (sockaddr *)&addr, &len);
+    uint16_t port = ntohs(addr.sin_port);
+
+    // 先fork客户端，子进程不继承任何调度线程
+    pid_t pid = fork();
+    CIM_ASSERT(pid >= 0);
+    if (pid == 0)
+    {
+        run_clients(port);
+    }
+
+    std::atomic<int> closed{0};
+    double seconds = 0;
+    uint64_t syscalls[4] = {0, 0, 0, 0};
+    {
+        CIM::IOManager iom(8, false, "ws", CIM::Scheduler::GLOBAL, CIM::ThreadAffinity(), backend);
+        CIM::FdMgr::GetInstance()->get(listen_fd, true);
+        uint64_t rw = rw_syscalls();
+        CIM::IOManager::EpollStats epoll_before = iom.getEpollStats();
+        CIM::IOManager::UringStats uring_before = iom.getUringStats();
+        auto start = Clock::now();
+        iom.schedule([&]()
+                     {
+                         for (int i = 0; i < M; ++i)
+                         {
+                             int fd = accept(listen_fd, nullptr, nullptr);
+                             CIM_ASSERT(fd >= 0);
+                             CIM::IOManager::GetThis()->schedule(std::bind(&session, fd, &closed));
+                         } });
+        while (closed < M)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        CIM::IOManager::EpollStats epoll_after = iom.getEpollStats();
+        CIM::IOManager::UringStats uring_after = iom.getUringStats();
+        syscalls[0] = rw_syscalls() - rw;
+        syscalls[1] = epoll_after.waits - epoll_before.waits;
+        syscalls[2] = epoll_after.ctls - epoll_before.ctls;
+        syscalls[3] = uring_after.enters - uring_before.enters;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CIM_ASSERT2(WIFEXITED(status) && WEXITSTATUS(status) == 0, "client status=" + std::to_string(status));
+    CIM::FdMgr::GetInstance()->del(listen_fd);
+    ::close(listen_fd);
+
+    double messages = (double)M * kRounds;
+    uint64_t total = syscalls[0] + syscalls[1] + syscalls[2] + syscalls[3];
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(6) << CIM::IOManager::BackendToString(backend)
+              << " messages=" << (uint64_t)messages
+              << " syscalls/msg=" << total / messages
+              << " (rw=" << syscalls[0] / messages
+              << " epoll_wait=" << syscalls[1] / messages
+              << " epoll_ctl=" << syscalls[2] / messages
+              << " io_uring_enter=" << syscalls[3] / messages << ")"
+              << std::setprecision(0) << " msg/s=" << messages / seconds << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::ERROR);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_correctness();
+    test_submit_latency(CIM::IOManager::EPOLL);
+    test_submit_latency(CIM::IOManager::URING);
+    bench(CIM::IOManager::EPOLL);
+    bench(CIM::IOManager::URING);
+    return 0;
+}
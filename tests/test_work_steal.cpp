@@ -0,0 +1,83 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+/**
+ * 调度队列性能对比：全局共享队列 vs 工作窃取队列
+ *
+ * 每轮投递 PRODUCERS 个生产者任务，每个生产者在工作线程内再 schedule
+ * TASKS_PER_PRODUCER 个空任务（模拟 IO 回调里继续投递任务的场景），
+ * 统计全部任务执行完毕的耗时与吞吐量。
+ */
+
+static auto g_logger = CIM_LOG_ROOT();
+
+static const int PRODUCERS = 64;
+static const int TASKS_PER_PRODUCER = 20000;
+
+static std::atomic<long long> g_done{0};
+
+static void leaf_task()
+{
+    ++g_done;
+}
+
+static void producer_task()
+{
+    CIM::Scheduler *s = CIM::Scheduler::GetThis();
+    for (int i = 0; i < TASKS_PER_PRODUCER; ++i)
+    {
+        s->schedule(&leaf_task);
+    }
+    ++g_done;
+}
+
+static double run_bench(size_t threads, CIM::Scheduler::QueueMode mode)
+{
+    const long long total = PRODUCERS + (long long)PRODUCERS * TASKS_PER_PRODUCER;
+    g_done = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        CIM::IOManager iom(threads, false, "bench", mode);
+        for (int i = 0; i < PRODUCERS; ++i)
+        {
+            iom.schedule(&producer_task);
+        }
+        while (g_done < total)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    return total * 1000.0 / ms;
+}
+
+int main(int argc, char **argv)
+{
+    g_logger->setLevel(CIM::Level::WARN);
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::WARN);
+
+    std::cout << "tasks/round = " << PRODUCERS + PRODUCERS * TASKS_PER_PRODUCER << std::endl;
+    std::cout << std::setw(8) << "threads"
+              << std::setw(20) << "global(tasks/s)"
+              << std::setw(20) << "work_steal(tasks/s)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    size_t thread_list[] = {1, 4, 16, 64};
+    for (size_t threads : thread_list)
+    {
+        double g = run_bench(threads, CIM::Scheduler::GLOBAL);
+        double w = run_bench(threads, CIM::Scheduler::WORK_STEALING);
+        std::cout << std::setw(8) << threads
+                  << std::setw(20) << std::fixed << std::setprecision(0) << g
+                  << std::setw(20) << w
+                  << std::setw(10) << std::setprecision(2) << w / g << std::endl;
+    }
+    return 0;
+}
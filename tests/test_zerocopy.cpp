@@ -0,0 +1,298 @@
+#include "macro.hpp"
+#include "iomanager.hpp"
+#include "socket_stream.hpp"
+#include "config.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * SocketStream::writev
+ *
+ * 1. 正确性：报文头(无owner) + 负载(有owner)多次写出，接收端逐字节校验
+ * 2. 零拷贝：达到阈值的writev在完成通知前持有负载，完成后由之后的writev回收；
+ *    发送未完成时关闭，close先等待完成通知再释放负载
+ * 3. 吞吐：1KiB / 64KiB / 1MiB 负载，比较
+ *    - copy：头部和负载拼成一个字符串后writeFixSize(原HttpSession::sendResponse的做法)
+ *    - writev：头部和负载两个片段一次sendmsg，不拷贝
+ *    - zerocopy：writev + MSG_ZEROCOPY(回环地址上内核会退化为拷贝，结果仅供对照)
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+/// 配置项在socket_stream.cpp中注册，静态初始化顺序不确定，使用时再查找
+static void set_threshold(uint64_t v)
+{
+    auto var = CIM::Config::Lookup<uint64_t>("socket_stream.zerocopy_threshold");
+    CIM_ASSERT(var);
+    var->setValue(v);
+}
+
+/// 建立一对回环TCP连接，返回的两个Socket在IOManager的协程中使用
+static void make_pair(CIM::IOManager &iom, CIM::SocketStream::ptr &writer, CIM::SocketStream::ptr &reader)
+{
+    std::atomic<bool> done{false};
+    iom.schedule([&]()
+                 {
+                     auto addr = CIM::Address::LookupAnyIpAddress("127.0.0.1");
+                     CIM::Socket::ptr listener = CIM::Socket::CreateTCP(addr);
+                     CIM_ASSERT(listener->bind(addr) && listener->listen());
+                     CIM::Address::ptr local = listener->getLocalAddress();
+                     CIM::Socket::ptr client = CIM::Socket::CreateTCP(local);
+                     iom.schedule([client, local]()
+                                  { CIM_ASSERT(client->connect(local)); });
+                     CIM::Socket::ptr server = listener->accept();
+                     CIM_ASSERT(server);
+                     while (!client->isConnected())
+                     {
+                         usleep(1000);
+                     }
+                     writer.reset(new CIM::SocketStream(client));
+                     reader.reset(new CIM::SocketStream(server));
+                     listener->close();
+                     done = true; });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static std::string make_head(size_t body)
+{
+    return "HTTP/1.1 200 OK\r\ncontent-type: application/json\r\ncontent-length: " +
+           std::to_string(body) + "\r\n\r\n";
+}
+
+static void test_correctness()
+{
+    CIM::IOManager iom(2, false, "zc");
+    CIM::SocketStream::ptr writer, reader;
+    make_pair(iom, writer, reader);
+
+    const size_t sizes[] = {0, 1, 100, 4096, 65535, 65536, 200000, 1 << 20};
+    size_t expect = 0;
+    for (size_t n : sizes)
+    {
+        expect += make_head(n).size() + n;
+    }
+
+    std::atomic<bool> ok{false};
+    std::atomic<int> finished{0};
+    iom.schedule([&]()
+                 {
+                     for (size_t n : sizes)
+                     {
+                         std::shared_ptr<std::string> body = std::make_shared<std::string>(n, 0);
+                         for (size_t i = 0; i < n; ++i)
+                         {
+                             (*body)[i] = (char)(i * 7 + n);
+                         }
+                         std::string head = make_head(n);
+                         std::vector<CIM::BufferSlice> slices;
+                         slices.push_back(CIM::BufferSlice(head.data(), head.size()));
+                         slices.push_back(CIM::BufferSlice(body->data(), body->size(), body));
+                         CIM_ASSERT(writer->writev(slices) == (int)(head.size() + n));
+                     }
+                     ++finished; });
+    iom.schedule([&]()
+                 {
+                     std::string got(expect, 0);
+                     CIM_ASSERT(reader->readFixSize(&got[0], expect) == (int)expect);
+                     size_t pos = 0;
+                     bool match = true;
+                     for (size_t n : sizes)
+                     {
+                         std::string head = make_head(n);
+                         match = match && got.compare(pos, head.size(), head) == 0;
+                         pos += head.size();
+                         for (size_t i = 0; i < n; ++i)
+                         {
+                             match = match && got[pos + i] == (char)(i * 7 + n);
+                         }
+                         pos += n;
+                     }
+                     ok = match;
+                     ++finished; });
+    while (finished < 2)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CIM_ASSERT(ok);
+    std::cout << "correctness: messages=" << sizeof(sizes) / sizeof(sizes[0]) << " bytes=" << expect << std::endl;
+}
+
+static void test_zerocopy_lifetime()
+{
+    CIM::IOManager iom(2, false, "zc");
+    CIM::SocketStream::ptr writer, reader;
+    make_pair(iom, writer, reader);
+    set_threshold(64 * 1024);
+
+    std::atomic<bool> done{false};
+    iom.schedule([&]()
+                 {
+                     const size_t n = 1 << 20;
+                     std::shared_ptr<std::string> body = std::make_shared<std::string>(n, 'z');
+                     std::vector<CIM::BufferSlice> slices;
+                     slices.push_back(CIM::BufferSlice(body->data(), body->size(), body));
+
+                     // 接收端先排空，内核上报完成后才能回收
+                     std::atomic<bool> drained{false};
+                     iom.schedule([&]()
+                                  {
+                                      std::string buf(n + 1, 0);
+                                      CIM_ASSERT(reader->readFixSize(&buf[0], n + 1) == (int)(n + 1));
+                                      drained = true; });
+                     CIM_ASSERT(writer->writev(slices) == (int)n);
+                     slices.clear();
+                     size_t pending = writer->getZeroCopyPending();
+                     long refs = body.use_count();
+                     if (!pending)
+                     {
+                         std::cout << "zerocopy: unavailable on this socket, skip lifetime check" << std::endl;
+                     }
+                     else
+                     {
+                         // 发送完成前片段仍被持有
+                         CIM_ASSERT(pending == n && refs == 2);
+                     }
+                     std::vector<CIM::BufferSlice> tail;
+                     tail.push_back(CIM::BufferSlice("x", 1));
+                     CIM_ASSERT(writer->writev(tail) == 1);
+                     while (!drained)
+                     {
+                         usleep(1000);
+                     }
+                     // 空的writev只回收完成通知
+                     for (int i = 0; i < 1000 && writer->getZeroCopyPending(); ++i)
+                     {
+                         usleep(1000);
+                         CIM_ASSERT(writer->writev(std::vector<CIM::BufferSlice>()) == 0);
+                     }
+                     if (pending)
+                     {
+                         CIM_ASSERT(writer->getZeroCopyPending() == 0 && body.use_count() == 1);
+                         std::cout << "zerocopy: pending=" << pending << " refs_before=" << refs
+                                   << " refs_after=" << body.use_count() << std::endl;
+                     }
+                     done = true; });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void test_zerocopy_close()
+{
+    CIM::IOManager iom(2, false, "zc-close");
+    CIM::SocketStream::ptr writer, reader;
+    make_pair(iom, writer, reader);
+    set_threshold(64 * 1024);
+
+    std::atomic<bool> done{false};
+    iom.schedule([&]()
+                 {
+                     const size_t n = 1 << 20;
+                     std::shared_ptr<std::string> body = std::make_shared<std::string>(n, 'c');
+                     std::vector<CIM::BufferSlice> slices;
+                     slices.push_back(CIM::BufferSlice(body->data(), body->size(), body));
+                     iom.schedule([&, n]()
+                                  {
+                                      std::string buf(n, 0);
+                                      CIM_ASSERT(reader->readFixSize(&buf[0], n) == (int)n); });
+                     CIM_ASSERT(writer->writev(slices) == (int)n);
+                     slices.clear();
+                     bool pending = writer->getZeroCopyPending() > 0;
+                     // 接收端读完后内核才上报完成，close期间等待而不是直接释放
+                     writer->close();
+                     CIM_ASSERT(writer->getZeroCopyPending() == 0);
+                     std::cout << "zerocopy close: pending=" << pending << " refs_after=" << body.use_count()
+                               << std::endl;
+                     if (pending)
+                     {
+                         CIM_ASSERT(body.use_count() == 1);
+                     }
+                     done = true; });
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static double bench(const std::string &mode, size_t n, size_t total)
+{
+    CIM::IOManager iom(2, false, "zc-bench");
+    CIM::SocketStream::ptr writer, reader;
+    make_pair(iom, writer, reader);
+    set_threshold(mode == "zerocopy" ? 64 * 1024 : 0);
+
+    std::string head = make_head(n);
+    size_t count = total / (head.size() + n);
+    size_t bytes = count * (head.size() + n);
+    std::atomic<int> finished{0};
+    auto start = Clock::now();
+    iom.schedule([&]()
+                 {
+                     std::shared_ptr<std::string> body = std::make_shared<std::string>(n, 'b');
+                     for (size_t i = 0; i < count; ++i)
+                     {
+                         if (mode == "copy")
+                         {
+                             std::string data = head + *body;
+                             CIM_ASSERT(writer->writeFixSize(data.data(), data.size()) == (int)data.size());
+                         }
+                         else
+                         {
+                             std::vector<CIM::BufferSlice> slices;
+                             slices.push_back(CIM::BufferSlice(head.data(), head.size()));
+                             slices.push_back(CIM::BufferSlice(body->data(), body->size(), body));
+                             CIM_ASSERT(writer->writev(slices) == (int)(head.size() + n));
+                         }
+                     }
+                     ++finished; });
+    iom.schedule([&]()
+                 {
+                     std::vector<char> buf(256 * 1024);
+                     size_t left = bytes;
+                     while (left)
+                     {
+                         int rt = reader->read(&buf[0], std::min(left, buf.size()));
+                         CIM_ASSERT(rt > 0);
+                         left -= rt;
+                     }
+                     ++finished; });
+    while (finished < 2)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return bytes / seconds / (1024 * 1024);
+}
+
+int main(int argc, char **argv)
+{
+    CIM_LOG_NAME("system")->setLevel(CIM::Level::FATAL);
+    CIM_LOG_ROOT()->setLevel(CIM::Level::ERROR);
+
+    test_correctness();
+    test_zerocopy_lifetime();
+    test_zerocopy_close();
+
+    const size_t sizes[] = {1024, 64 * 1024, 1024 * 1024};
+    for (size_t n : sizes)
+    {
+        size_t total = n == 1024 ? (32u << 20) : (256u << 20);
+        std::cout << "payload=" << std::setw(7) << n;
+        for (const char *mode : {"copy", "writev", "zerocopy"})
+        {
+            std::cout << " " << mode << "=" << std::fixed << std::setprecision(0)
+                      << bench(mode, n, total) << "MiB/s";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}